@@ -0,0 +1,1733 @@
+#include "common.h"
+#include "utils.h"
+#include "archive.h"
+
+#include <mutex>
+#include <deque>
+#include <condition_variable>
+#include <functional>
+
+//--
+
+static const uint32_t ARCHIVE_READ_BUFFER_SIZE = 256 * 1024;
+static const uint32_t ARCHIVE_WRITE_BUFFER_SIZE = 1024 * 1024;
+static const uint32_t ARCHIVE_PIPE_LIMIT = 8 * 1024 * 1024;
+static const uint32_t INFLATE_WINDOW_SIZE = 32 * 1024;
+static const uint32_t INFLATE_OUTPUT_SIZE = 256 * 1024;
+
+typedef std::function<bool(const uint8_t* data, uint64_t size)> ArchiveSink;
+
+//--
+
+static uint32_t Crc32Table[256];
+
+static void InitCrc32Table()
+{
+	static std::once_flag once;
+	std::call_once(once, []() {
+		for (uint32_t i = 0; i < 256; ++i)
+		{
+			uint32_t crc = i;
+			for (uint32_t j = 0; j < 8; ++j)
+				crc = (crc & 1) ? (0xEDB88320 ^ (crc >> 1)) : (crc >> 1);
+			Crc32Table[i] = crc;
+		}
+	});
+}
+
+static uint32_t Crc32(uint32_t crc, const uint8_t* data, uint64_t size)
+{
+	crc = ~crc;
+	for (uint64_t i = 0; i < size; ++i)
+		crc = Crc32Table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+	return ~crc;
+}
+
+//--
+
+class IArchiveSource
+{
+public:
+	virtual ~IArchiveSource() {};
+	virtual uint64_t read(uint8_t* data, uint64_t size) = 0; // returns 0 at the end of data
+};
+
+class ArchiveFileSource : public IArchiveSource
+{
+public:
+	ArchiveFileSource(std::ifstream& file)
+		: m_file(file)
+	{}
+
+	virtual uint64_t read(uint8_t* data, uint64_t size) override final
+	{
+		m_file.read((char*)data, size);
+		return m_file.gcount();
+	}
+
+private:
+	std::ifstream& m_file;
+};
+
+class ArchivePipe : public IArchiveSource
+{
+public:
+	bool push(const uint8_t* data, uint64_t size)
+	{
+		std::unique_lock<std::mutex> lock(m_lock);
+
+		m_cond.wait(lock, [this]() { return m_aborted || m_queuedSize < ARCHIVE_PIPE_LIMIT; });
+		if (m_aborted)
+			return false;
+
+		m_chunks.emplace_back(data, data + size);
+		m_queuedSize += size;
+		m_cond.notify_all();
+		return true;
+	}
+
+	void close()
+	{
+		std::unique_lock<std::mutex> lock(m_lock);
+		m_closed = true;
+		m_cond.notify_all();
+	}
+
+	void abort()
+	{
+		std::unique_lock<std::mutex> lock(m_lock);
+		m_aborted = true;
+		m_chunks.clear();
+		m_queuedSize = 0;
+		m_cond.notify_all();
+	}
+
+	virtual uint64_t read(uint8_t* data, uint64_t size) override final
+	{
+		std::unique_lock<std::mutex> lock(m_lock);
+
+		m_cond.wait(lock, [this]() { return m_aborted || m_closed || !m_chunks.empty(); });
+
+		uint64_t numRead = 0;
+		while (numRead < size && !m_chunks.empty())
+		{
+			auto& chunk = m_chunks.front();
+
+			const auto count = std::min<uint64_t>(size - numRead, chunk.size() - m_chunkPos);
+			memcpy(data + numRead, chunk.data() + m_chunkPos, count);
+			numRead += count;
+			m_chunkPos += count;
+
+			if (m_chunkPos == chunk.size())
+			{
+				m_queuedSize -= chunk.size();
+				m_chunks.pop_front();
+				m_chunkPos = 0;
+			}
+		}
+
+		m_cond.notify_all();
+		return numRead;
+	}
+
+private:
+	std::mutex m_lock;
+	std::condition_variable m_cond;
+	std::deque<std::vector<uint8_t>> m_chunks;
+	uint64_t m_chunkPos = 0;
+	uint64_t m_queuedSize = 0;
+	bool m_closed = false;
+	bool m_aborted = false;
+};
+
+//--
+
+// buffered byte and bit reader over the archive source, hashes all the data that goes through it
+class ArchiveInput
+{
+public:
+	ArchiveInput(IArchiveSource& source)
+		: m_source(source)
+	{
+		m_buffer.resize(ARCHIVE_READ_BUFFER_SIZE);
+		Sha256Initialise(&m_hash);
+	}
+
+	bool peek(uint8_t* data, uint32_t size)
+	{
+		while (m_end - m_pos < size)
+			if (!fill())
+				return false;
+
+		memcpy(data, m_buffer.data() + m_pos, size);
+		return true;
+	}
+
+	bool readByte(uint8_t& outByte)
+	{
+		// whole bytes left in the bit buffer after aligning go first
+		if (m_bitCount >= 8)
+		{
+			if (m_bitCount <= m_bitOverrun)
+				return false; // only padding left
+
+			outByte = (uint8_t)m_bitBuffer;
+			m_bitBuffer >>= 8;
+			m_bitCount -= 8;
+			return true;
+		}
+
+		if (m_pos == m_end && !fill())
+			return false;
+
+		outByte = m_buffer[m_pos++];
+		return true;
+	}
+
+	bool readBytes(uint8_t* data, uint64_t size)
+	{
+		while (size > 0 && m_bitCount >= 8)
+		{
+			if (!readByte(*data++))
+				return false;
+			size -= 1;
+		}
+
+		while (size > 0)
+		{
+			if (m_pos == m_end && !fill())
+				return false;
+
+			const auto count = std::min<uint64_t>(size, m_end - m_pos);
+			memcpy(data, m_buffer.data() + m_pos, count);
+			m_pos += count;
+			data += count;
+			size -= count;
+		}
+
+		return true;
+	}
+
+	bool readInto(uint64_t size, const ArchiveSink& sink)
+	{
+		while (size > 0 && m_bitCount >= 8)
+		{
+			uint8_t byte = 0;
+			if (!readByte(byte) || !sink(&byte, 1))
+				return false;
+			size -= 1;
+		}
+
+		while (size > 0)
+		{
+			if (m_pos == m_end && !fill())
+				return false;
+
+			const auto count = std::min<uint64_t>(size, m_end - m_pos);
+			if (!sink(m_buffer.data() + m_pos, count))
+				return false;
+
+			m_pos += count;
+			size -= count;
+		}
+
+		return true;
+	}
+
+	uint64_t readSome(uint8_t* data, uint64_t size)
+	{
+		if (m_pos == m_end && !fill())
+			return 0;
+
+		const auto count = std::min<uint64_t>(size, m_end - m_pos);
+		memcpy(data, m_buffer.data() + m_pos, count);
+		m_pos += count;
+		return count;
+	}
+
+	bool skip(uint64_t size)
+	{
+		return readInto(size, [](const uint8_t*, uint64_t) { return true; });
+	}
+
+	bool readU16(uint16_t& outValue)
+	{
+		uint8_t data[2];
+		if (!readBytes(data, 2))
+			return false;
+		outValue = data[0] | (data[1] << 8);
+		return true;
+	}
+
+	bool readU32(uint32_t& outValue)
+	{
+		uint8_t data[4];
+		if (!readBytes(data, 4))
+			return false;
+		outValue = data[0] | (data[1] << 8) | (data[2] << 16) | ((uint32_t)data[3] << 24);
+		return true;
+	}
+
+	bool readU64(uint64_t& outValue)
+	{
+		uint32_t low = 0, high = 0;
+		if (!readU32(low) || !readU32(high))
+			return false;
+		outValue = low | ((uint64_t)high << 32);
+		return true;
+	}
+
+	// read whatever is left so the producer is never blocked and the hash covers everything
+	void drain()
+	{
+		m_pos = m_end;
+		while (fill())
+			m_pos = m_end;
+	}
+
+	std::string hash()
+	{
+		SHA256_HASH digest;
+		Sha256Finalise(&m_hash, &digest);
+		return BytesToHexString(&digest.bytes[0], sizeof(digest.bytes));
+	}
+
+	//--
+
+	// make sure at least given number of bits are in the bit buffer, at the end of the data it's padded with zeros
+	inline void needBits(uint32_t count)
+	{
+		while (m_bitCount < count)
+		{
+			if (m_pos == m_end && !fill())
+			{
+				m_bitOverrun += 8;
+				m_bitCount += 8;
+				continue;
+			}
+
+			m_bitBuffer |= (uint64_t)m_buffer[m_pos++] << m_bitCount;
+			m_bitCount += 8;
+		}
+	}
+
+	inline uint32_t bits(uint32_t count)
+	{
+		if (count == 0)
+			return 0;
+
+		needBits(count);
+		const auto ret = (uint32_t)(m_bitBuffer & ((1ULL << count) - 1));
+		m_bitBuffer >>= count;
+		m_bitCount -= count;
+		return ret;
+	}
+
+	inline uint32_t peekBits(uint32_t count)
+	{
+		needBits(count);
+		return (uint32_t)(m_bitBuffer & ((1ULL << count) - 1));
+	}
+
+	inline void consumeBits(uint32_t count)
+	{
+		m_bitBuffer >>= count;
+		m_bitCount -= count;
+	}
+
+	inline void alignToByte()
+	{
+		const auto extra = m_bitCount & 7;
+		m_bitBuffer >>= extra;
+		m_bitCount -= extra;
+	}
+
+	// did we read past the end of data while decoding bits
+	inline bool overrun() const
+	{
+		return m_bitOverrun > 0 && m_bitCount < m_bitOverrun;
+	}
+
+private:
+	IArchiveSource& m_source;
+
+	std::vector<uint8_t> m_buffer;
+	uint64_t m_pos = 0;
+	uint64_t m_end = 0;
+
+	uint64_t m_bitBuffer = 0;
+	uint32_t m_bitCount = 0;
+	uint32_t m_bitOverrun = 0;
+
+	Sha256Context m_hash;
+
+	bool fill()
+	{
+		if (m_pos > 0 && m_pos < m_end)
+			memmove(m_buffer.data(), m_buffer.data() + m_pos, m_end - m_pos);
+
+		m_end -= m_pos;
+		m_pos = 0;
+
+		const auto numRead = m_source.read(m_buffer.data() + m_end, m_buffer.size() - m_end);
+		if (numRead == 0)
+			return false;
+
+		Sha256Update(&m_hash, m_buffer.data() + m_end, numRead);
+		m_end += numRead;
+		return true;
+	}
+};
+
+//--
+
+struct InflateHuffman
+{
+	static const uint32_t FAST_BITS = 9;
+
+	uint16_t fast[1 << FAST_BITS]; // (symbol << 4) | length
+	uint16_t counts[16];
+	uint16_t symbols[288];
+};
+
+static bool BuildHuffman(InflateHuffman& h, const uint8_t* lengths, uint32_t numSymbols)
+{
+	memset(h.fast, 0, sizeof(h.fast));
+	memset(h.counts, 0, sizeof(h.counts));
+
+	for (uint32_t i = 0; i < numSymbols; ++i)
+		h.counts[lengths[i]] += 1;
+
+	h.counts[0] = 0;
+
+	// check for over subscribed set of lengths
+	int left = 1;
+	for (uint32_t len = 1; len < 16; ++len)
+	{
+		left <<= 1;
+		left -= h.counts[len];
+		if (left < 0)
+			return false;
+	}
+
+	uint16_t offsets[16];
+	offsets[1] = 0;
+	for (uint32_t len = 1; len < 15; ++len)
+		offsets[len + 1] = offsets[len] + h.counts[len];
+
+	for (uint32_t i = 0; i < numSymbols; ++i)
+		if (lengths[i])
+			h.symbols[offsets[lengths[i]]++] = (uint16_t)i;
+
+	// fast lookup table for short codes, codes are stored bit reversed in the stream
+	uint32_t nextCode[16];
+	uint32_t code = 0;
+	for (uint32_t len = 1; len < 16; ++len)
+	{
+		code = (code + h.counts[len - 1]) << 1;
+		nextCode[len] = code;
+	}
+
+	for (uint32_t i = 0; i < numSymbols; ++i)
+	{
+		const auto len = lengths[i];
+		if (len == 0 || len > InflateHuffman::FAST_BITS)
+			continue;
+
+		const auto symbolCode = nextCode[len]++;
+
+		uint32_t reversed = 0;
+		for (uint32_t j = 0; j < len; ++j)
+			reversed |= ((symbolCode >> j) & 1) << (len - 1 - j);
+
+		for (uint32_t j = reversed; j < (1U << InflateHuffman::FAST_BITS); j += (1U << len))
+			h.fast[j] = (uint16_t)((i << 4) | len);
+	}
+
+	return true;
+}
+
+static int DecodeSymbol(ArchiveInput& in, const InflateHuffman& h)
+{
+	const auto entry = h.fast[in.peekBits(InflateHuffman::FAST_BITS)];
+	if (entry)
+	{
+		in.consumeBits(entry & 15);
+		return entry >> 4;
+	}
+
+	// canonical decoding, bit by bit
+	int code = 0;
+	int first = 0;
+	int index = 0;
+	for (uint32_t len = 1; len < 16; ++len)
+	{
+		code |= in.bits(1);
+		const int count = h.counts[len];
+		if (code - count < first)
+			return h.symbols[index + (code - first)];
+		index += count;
+		first += count;
+		first <<= 1;
+		code <<= 1;
+	}
+
+	return -1;
+}
+
+static const uint16_t INFLATE_LENGTH_BASE[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+static const uint8_t INFLATE_LENGTH_EXTRA[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+static const uint16_t INFLATE_DIST_BASE[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+static const uint8_t INFLATE_DIST_EXTRA[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+// raw deflate stream decoder, reads from input until the final block and pushes decompressed data to the sink
+class Inflater
+{
+public:
+	Inflater(ArchiveInput& input, const ArchiveSink& sink)
+		: m_input(input)
+		, m_sink(sink)
+	{
+		m_window.resize(INFLATE_WINDOW_SIZE + INFLATE_OUTPUT_SIZE);
+	}
+
+	bool run()
+	{
+		for (;;)
+		{
+			const auto last = m_input.bits(1);
+			const auto type = m_input.bits(2);
+
+			bool valid = false;
+			if (type == 0)
+				valid = stored();
+			else if (type == 1)
+				valid = fixed();
+			else if (type == 2)
+				valid = dynamic();
+
+			if (!valid || m_input.overrun())
+			{
+				LogError() << "Invalid or truncated deflate stream";
+				return false;
+			}
+
+			if (last)
+				break;
+		}
+
+		m_input.alignToByte();
+		return flush(true);
+	}
+
+	inline uint64_t totalOutput() const { return m_totalOutput; }
+
+private:
+	ArchiveInput& m_input;
+	const ArchiveSink& m_sink;
+
+	std::vector<uint8_t> m_window; // history + pending output
+	uint32_t m_pos = 0; // write position in the window
+	uint32_t m_flushed = 0; // data before this position was already sent to sink
+	uint64_t m_totalOutput = 0;
+
+	InflateHuffman m_lengthCodes;
+	InflateHuffman m_distanceCodes;
+
+	bool flush(bool all)
+	{
+		if (m_pos > m_flushed)
+		{
+			if (!m_sink(m_window.data() + m_flushed, m_pos - m_flushed))
+				return false;
+			m_flushed = m_pos;
+		}
+
+		// keep only the history needed for back references
+		if (!all && m_pos > INFLATE_WINDOW_SIZE)
+		{
+			memmove(m_window.data(), m_window.data() + m_pos - INFLATE_WINDOW_SIZE, INFLATE_WINDOW_SIZE);
+			m_pos = INFLATE_WINDOW_SIZE;
+			m_flushed = INFLATE_WINDOW_SIZE;
+		}
+
+		return true;
+	}
+
+	inline bool ensureSpace(uint32_t size)
+	{
+		if (m_pos + size > m_window.size())
+			return flush(false);
+		return true;
+	}
+
+	bool stored()
+	{
+		m_input.alignToByte();
+
+		uint16_t len = 0, nlen = 0;
+		if (!m_input.readU16(len) || !m_input.readU16(nlen))
+			return false;
+
+		if (len != (uint16_t)~nlen)
+			return false;
+
+		uint32_t left = len;
+		while (left > 0)
+		{
+			if (!ensureSpace(1))
+				return false;
+
+			const auto count = std::min<uint32_t>(left, (uint32_t)m_window.size() - m_pos);
+			if (!m_input.readBytes(m_window.data() + m_pos, count))
+				return false;
+
+			m_pos += count;
+			m_totalOutput += count;
+			left -= count;
+		}
+
+		return true;
+	}
+
+	bool fixed()
+	{
+		static InflateHuffman FixedLengths, FixedDistances;
+		static std::once_flag once;
+		std::call_once(once, []() {
+			uint8_t lengths[288];
+			for (uint32_t i = 0; i < 144; ++i) lengths[i] = 8;
+			for (uint32_t i = 144; i < 256; ++i) lengths[i] = 9;
+			for (uint32_t i = 256; i < 280; ++i) lengths[i] = 7;
+			for (uint32_t i = 280; i < 288; ++i) lengths[i] = 8;
+			BuildHuffman(FixedLengths, lengths, 288);
+
+			for (uint32_t i = 0; i < 30; ++i) lengths[i] = 5;
+			BuildHuffman(FixedDistances, lengths, 30);
+		});
+
+		return codes(FixedLengths, FixedDistances);
+	}
+
+	bool dynamic()
+	{
+		static const uint8_t ORDER[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+		const auto numLengths = m_input.bits(5) + 257;
+		const auto numDistances = m_input.bits(5) + 1;
+		const auto numCodes = m_input.bits(4) + 4;
+		if (numLengths > 286 || numDistances > 30)
+			return false;
+
+		uint8_t lengths[320];
+		memset(lengths, 0, sizeof(lengths));
+
+		for (uint32_t i = 0; i < numCodes; ++i)
+			lengths[ORDER[i]] = (uint8_t)m_input.bits(3);
+
+		InflateHuffman lengthCodeCodes;
+		if (!BuildHuffman(lengthCodeCodes, lengths, 19))
+			return false;
+
+		memset(lengths, 0, sizeof(lengths));
+
+		uint32_t index = 0;
+		while (index < numLengths + numDistances)
+		{
+			const auto symbol = DecodeSymbol(m_input, lengthCodeCodes);
+			if (symbol < 0)
+				return false;
+
+			if (symbol < 16)
+			{
+				lengths[index++] = (uint8_t)symbol;
+				continue;
+			}
+
+			uint8_t value = 0;
+			uint32_t repeat = 0;
+			if (symbol == 16)
+			{
+				if (index == 0)
+					return false;
+				value = lengths[index - 1];
+				repeat = 3 + m_input.bits(2);
+			}
+			else if (symbol == 17)
+			{
+				repeat = 3 + m_input.bits(3);
+			}
+			else
+			{
+				repeat = 11 + m_input.bits(7);
+			}
+
+			if (index + repeat > numLengths + numDistances)
+				return false;
+
+			while (repeat--)
+				lengths[index++] = value;
+		}
+
+		if (lengths[256] == 0)
+			return false;
+
+		if (!BuildHuffman(m_lengthCodes, lengths, numLengths))
+			return false;
+
+		if (!BuildHuffman(m_distanceCodes, lengths + numLengths, numDistances))
+			return false;
+
+		return codes(m_lengthCodes, m_distanceCodes);
+	}
+
+	bool codes(const InflateHuffman& lengthCodes, const InflateHuffman& distanceCodes)
+	{
+		for (;;)
+		{
+			auto symbol = DecodeSymbol(m_input, lengthCodes);
+			if (symbol < 0)
+				return false;
+
+			if (symbol < 256)
+			{
+				if (!ensureSpace(1))
+					return false;
+
+				m_window[m_pos++] = (uint8_t)symbol;
+				m_totalOutput += 1;
+				continue;
+			}
+
+			if (symbol == 256)
+				return true;
+
+			symbol -= 257;
+			if (symbol >= 29)
+				return false;
+
+			const auto length = INFLATE_LENGTH_BASE[symbol] + m_input.bits(INFLATE_LENGTH_EXTRA[symbol]);
+
+			const auto distanceSymbol = DecodeSymbol(m_input, distanceCodes);
+			if (distanceSymbol < 0 || distanceSymbol >= 30)
+				return false;
+
+			const auto distance = INFLATE_DIST_BASE[distanceSymbol] + m_input.bits(INFLATE_DIST_EXTRA[distanceSymbol]);
+			if (distance > m_pos || distance > m_totalOutput)
+				return false;
+
+			if (!ensureSpace(length))
+				return false;
+
+			// overlapping copy, byte by byte
+			auto* write = m_window.data() + m_pos;
+			const auto* read = write - distance;
+			for (uint32_t i = 0; i < length; ++i)
+				write[i] = read[i];
+
+			m_pos += length;
+			m_totalOutput += length;
+		}
+	}
+};
+
+//--
+
+// writes extracted entries to disk, all paths are validated to stay inside the target directory
+class ArchiveOutput
+{
+public:
+	ArchiveOutput(const fs::path& targetPath)
+		: m_targetPath(targetPath)
+	{
+		m_writeBuffer.resize(ARCHIVE_WRITE_BUFFER_SIZE);
+	}
+
+	~ArchiveOutput()
+	{
+		closeFile();
+	}
+
+	inline uint32_t numFiles() const { return m_numFiles; }
+	inline uint64_t numBytes() const { return m_numBytes; }
+
+	bool resolvePath(std::string_view name, fs::path& outPath)
+	{
+		std::vector<std::string> parts;
+		if (!SplitEntryName(name, parts))
+			return false;
+
+		return buildPath(name, parts, outPath);
+	}
+
+	bool directory(std::string_view name)
+	{
+		fs::path path;
+		if (!resolvePath(name, path))
+			return false;
+
+		return CreateDirectories(path);
+	}
+
+	bool beginFile(std::string_view name)
+	{
+		closeFile();
+
+		fs::path path;
+		if (!resolvePath(name, path))
+			return false;
+
+		if (path == m_targetPath)
+		{
+			LogError() << "Archive entry '" << name << "' has no file name";
+			return false;
+		}
+
+		if (!CreateDirectories(path.parent_path()))
+			return false;
+
+		// never write through a link created by an earlier entry
+		std::error_code ec;
+		if (fs::is_symlink(fs::symlink_status(path, ec)))
+			fs::remove(path, ec);
+
+		m_file.rdbuf()->pubsetbuf(m_writeBuffer.data(), m_writeBuffer.size());
+		m_file.open(path, std::ios::out | std::ios::binary | std::ios::trunc);
+		if (!m_file.is_open())
+		{
+			LogError() << "Unable to create file " << path;
+			return false;
+		}
+
+		m_filePath = path;
+		m_numFiles += 1;
+		return true;
+	}
+
+	bool writeFile(const uint8_t* data, uint64_t size)
+	{
+		m_file.write((const char*)data, size);
+		m_numBytes += size;
+		return !m_file.fail();
+	}
+
+	bool closeFile()
+	{
+		if (!m_file.is_open())
+			return true;
+
+		m_file.close();
+		if (m_file.fail())
+		{
+			LogError() << "Failed to write file " << m_filePath;
+			m_file.clear();
+			return false;
+		}
+
+		return true;
+	}
+
+	bool symlink(std::string_view name, std::string_view target)
+	{
+		std::vector<std::string> parts;
+		if (!SplitEntryName(name, parts))
+			return false;
+
+		if (parts.empty())
+		{
+			LogError() << "Archive entry '" << name << "' has no file name";
+			return false;
+		}
+
+		// target is relative to the directory of the link and must stay inside the target directory
+		std::vector<std::string> targetParts(parts.begin(), parts.end() - 1);
+		if (!ResolveLinkTarget(target, targetParts))
+		{
+			LogError() << "Archive entry '" << name << "' is a link to '" << target << "' that points outside the target directory";
+			return false;
+		}
+
+		fs::path path;
+		if (!buildPath(name, parts, path))
+			return false;
+
+		if (!CreateDirectories(path.parent_path()))
+			return false;
+
+		// the checked directories may now be reached through the link
+		m_checkedDirectories.clear();
+
+		// link is created with the normalized target so any ".." only goes through real directories
+		std::error_code ec;
+		fs::remove(path, ec);
+		fs::create_symlink(fs::u8path(MakeLinkText(parts, targetParts)), path, ec);
+		if (!ec)
+			return true;
+
+		// fallback for systems with no symlinks - copy the target file
+		fs::path targetPath;
+		if (buildPath(name, targetParts, targetPath) && fs::is_regular_file(targetPath, ec))
+		{
+			fs::copy_file(targetPath, path, fs::copy_options::overwrite_existing, ec);
+			if (!ec)
+				return true;
+		}
+
+		LogWarning() << "Unable to create symbolic link " << path << " pointing to '" << target << "'";
+		return true;
+	}
+
+	bool hardlink(std::string_view name, std::string_view target)
+	{
+		fs::path path, targetPath;
+		if (!resolvePath(name, path) || !resolvePath(target, targetPath))
+			return false;
+
+		// hard link to a symbolic link is a copy of the link, its target must be checked again from the new place
+		std::error_code ec;
+		if (fs::is_symlink(fs::symlink_status(targetPath, ec)))
+		{
+			const auto linkText = fs::read_symlink(targetPath, ec);
+			if (ec)
+			{
+				LogError() << "Unable to read symbolic link " << targetPath;
+				return false;
+			}
+
+			return symlink(name, linkText.generic_u8string());
+		}
+
+		fs::remove(path, ec);
+		fs::create_hard_link(targetPath, path, ec);
+		if (ec)
+		{
+			fs::copy_file(targetPath, path, fs::copy_options::overwrite_existing, ec);
+			if (ec)
+			{
+				LogError() << "Unable to link " << path << " to " << targetPath;
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	// only the executable bits are carried over, the rest follows the defaults for created files
+	void permissions(std::string_view name, uint32_t mode)
+	{
+#ifndef _WIN32
+		if (0 == (mode & 0111))
+			return;
+
+		fs::path path;
+		if (!resolvePath(name, path))
+			return;
+
+		std::error_code ec;
+		fs::permissions(path, (fs::perms)(mode & 0111), fs::perm_options::add, ec);
+#endif
+	}
+
+	bool convertToSymlink(std::string_view name)
+	{
+		fs::path path;
+		if (!resolvePath(name, path))
+			return false;
+
+		std::string target;
+		if (!LoadFileToString(path, target))
+			return false;
+
+		return symlink(name, target);
+	}
+
+private:
+	fs::path m_targetPath;
+	std::unordered_set<std::string> m_checkedDirectories; // directories known not to be symbolic links
+
+	std::ofstream m_file;
+	fs::path m_filePath;
+	std::vector<char> m_writeBuffer;
+
+	uint32_t m_numFiles = 0;
+	uint64_t m_numBytes = 0;
+
+	// split entry name into path components, fails for names that point outside the target directory
+	static bool SplitEntryName(std::string_view name, std::vector<std::string>& outParts)
+	{
+		const auto genericName = ReplaceAll(name, "\\", "/");
+
+		std::vector<std::string_view> parts;
+		SplitString(genericName, "/", parts);
+
+		for (const auto part : parts)
+		{
+			if (part.empty() || part == ".")
+				continue;
+
+			if (part == ".." || part.find(':') != std::string_view::npos)
+			{
+				LogError() << "Archive entry '" << name << "' points outside the target directory";
+				return false;
+			}
+
+			outParts.push_back(std::string(part));
+		}
+
+		return true;
+	}
+
+	// apply link target to the components of the link's directory, fails for absolute targets and targets going above the target directory
+	static bool ResolveLinkTarget(std::string_view target, std::vector<std::string>& inOutParts)
+	{
+		const auto genericTarget = ReplaceAll(target, "\\", "/");
+		if (genericTarget.empty() || genericTarget[0] == '/' || genericTarget.find(':') != std::string::npos)
+			return false;
+
+		std::vector<std::string_view> parts;
+		SplitString(genericTarget, "/", parts);
+
+		for (const auto part : parts)
+		{
+			if (part.empty() || part == ".")
+				continue;
+
+			if (part == "..")
+			{
+				if (inOutParts.empty())
+					return false;
+
+				inOutParts.pop_back();
+				continue;
+			}
+
+			inOutParts.push_back(std::string(part));
+		}
+
+		return true;
+	}
+
+	// relative link text from the directory of the link to the resolved target, only the leading components can be ".."
+	static std::string MakeLinkText(const std::vector<std::string>& linkParts, const std::vector<std::string>& targetParts)
+	{
+		const auto linkDirectoryLength = linkParts.size() - 1;
+
+		size_t common = 0;
+		while (common < linkDirectoryLength && common < targetParts.size() && linkParts[common] == targetParts[common])
+			common += 1;
+
+		std::string ret;
+		for (size_t i = common; i < linkDirectoryLength; ++i)
+			ret += "../";
+
+		for (size_t i = common; i < targetParts.size(); ++i)
+		{
+			ret += targetParts[i];
+			ret += "/";
+		}
+
+		if (ret.empty())
+			return ".";
+
+		ret.pop_back();
+		return ret;
+	}
+
+	// path of the entry inside the target directory, NOTE: none of the directories on the way may be a symbolic link (earlier entry could redirect the writes)
+	bool buildPath(std::string_view name, const std::vector<std::string>& parts, fs::path& outPath)
+	{
+		outPath = m_targetPath;
+
+		for (size_t i = 0; i < parts.size(); ++i)
+		{
+			outPath /= fs::u8path(parts[i]);
+
+			if (i + 1 < parts.size())
+			{
+				auto key = outPath.u8string();
+				if (!m_checkedDirectories.count(key))
+				{
+					std::error_code ec;
+					if (fs::is_symlink(fs::symlink_status(outPath, ec)))
+					{
+						LogError() << "Archive entry '" << name << "' is placed under symbolic link " << outPath.make_preferred() << ", refusing to write through it";
+						return false;
+					}
+
+					m_checkedDirectories.insert(std::move(key));
+				}
+			}
+		}
+
+		outPath = outPath.make_preferred();
+		return true;
+	}
+};
+
+//--
+
+static uint64_t ParseTarNumber(const uint8_t* data, uint32_t size)
+{
+	// base-256 encoding for large values
+	if (data[0] & 0x80)
+	{
+		uint64_t ret = data[0] & 0x7F;
+		for (uint32_t i = 1; i < size; ++i)
+			ret = (ret << 8) | data[i];
+		return ret;
+	}
+
+	uint64_t ret = 0;
+	for (uint32_t i = 0; i < size; ++i)
+	{
+		if (data[i] >= '0' && data[i] <= '7')
+			ret = (ret << 3) | (data[i] - '0');
+		else if (data[i] == 0 || (data[i] == ' ' && ret))
+			break;
+	}
+
+	return ret;
+}
+
+static std::string ParseTarString(const uint8_t* data, uint32_t size)
+{
+	uint32_t length = 0;
+	while (length < size && data[length])
+		length += 1;
+
+	return std::string((const char*)data, length);
+}
+
+// push based tar parser, data can come in any chunks (ie. directly from the inflater)
+class TarParser
+{
+public:
+	TarParser(ArchiveOutput& output)
+		: m_output(output)
+	{}
+
+	bool write(const uint8_t* data, uint64_t size)
+	{
+		while (size > 0)
+		{
+			if (m_finished)
+				return true; // trailing padding
+
+			if (m_dataLeft > 0)
+			{
+				const auto count = std::min<uint64_t>(size, m_dataLeft);
+				if (!entryData(data, count))
+					return false;
+
+				data += count;
+				size -= count;
+				m_dataLeft -= count;
+
+				if (m_dataLeft == 0 && !entryEnd())
+					return false;
+
+				continue;
+			}
+
+			if (m_paddingLeft > 0)
+			{
+				const auto count = std::min<uint64_t>(size, m_paddingLeft);
+				data += count;
+				size -= count;
+				m_paddingLeft -= count;
+				continue;
+			}
+
+			const auto count = std::min<uint64_t>(size, 512 - m_headerSize);
+			memcpy(m_header + m_headerSize, data, count);
+			m_headerSize += (uint32_t)count;
+			data += count;
+			size -= count;
+
+			if (m_headerSize == 512)
+			{
+				m_headerSize = 0;
+				if (!header())
+					return false;
+			}
+		}
+
+		return true;
+	}
+
+	bool finish()
+	{
+		if (m_dataLeft > 0 || m_headerSize > 0)
+		{
+			LogError() << "Tar archive is truncated";
+			return false;
+		}
+
+		return m_output.closeFile();
+	}
+
+private:
+	ArchiveOutput& m_output;
+
+	uint8_t m_header[512];
+	uint32_t m_headerSize = 0;
+
+	uint64_t m_dataLeft = 0;
+	uint64_t m_paddingLeft = 0;
+	bool m_finished = false;
+
+	char m_type = 0;
+	std::string m_name;
+	std::string m_linkName;
+	uint32_t m_mode = 0;
+	std::string m_meta; // data of the pax/long name entries
+
+	std::string m_nextName; // from pax or GNU long name headers
+	std::string m_nextLinkName;
+
+	bool header()
+	{
+		bool empty = true;
+		for (uint32_t i = 0; i < 512; ++i)
+			if (m_header[i])
+				empty = false;
+
+		if (empty)
+		{
+			m_finished = true; // end of archive marker
+			return true;
+		}
+
+		uint32_t checksum = 0;
+		for (uint32_t i = 0; i < 512; ++i)
+			checksum += (i >= 148 && i < 156) ? ' ' : m_header[i];
+
+		if (checksum != ParseTarNumber(m_header + 148, 8))
+		{
+			LogError() << "Tar archive header checksum mismatch";
+			return false;
+		}
+
+		m_type = (char)m_header[156];
+		m_mode = (uint32_t)ParseTarNumber(m_header + 100, 8);
+		m_name = ParseTarString(m_header, 100);
+		m_linkName = ParseTarString(m_header + 157, 100);
+
+		if (0 == memcmp(m_header + 257, "ustar", 5))
+		{
+			const auto prefix = ParseTarString(m_header + 345, 155);
+			if (!prefix.empty())
+				m_name = prefix + "/" + m_name;
+		}
+
+		if (!m_nextName.empty() && m_type != 'x' && m_type != 'L' && m_type != 'K')
+		{
+			m_name = m_nextName;
+			m_nextName.clear();
+		}
+
+		if (!m_nextLinkName.empty() && m_type != 'x' && m_type != 'L' && m_type != 'K')
+		{
+			m_linkName = m_nextLinkName;
+			m_nextLinkName.clear();
+		}
+
+		const auto size = ParseTarNumber(m_header + 124, 12);
+		m_dataLeft = size;
+		m_paddingLeft = (512 - (size % 512)) % 512;
+		m_meta.clear();
+
+		if (m_type == '0' || m_type == 0 || m_type == '7')
+		{
+			if (EndsWith(m_name, "/"))
+			{
+				if (!m_output.directory(m_name))
+					return false;
+				m_type = '5';
+			}
+			else if (!m_output.beginFile(m_name))
+			{
+				return false;
+			}
+		}
+		else if (m_type == '5')
+		{
+			if (!m_output.directory(m_name))
+				return false;
+		}
+
+		if (m_dataLeft == 0)
+			return entryEnd();
+
+		return true;
+	}
+
+	bool entryData(const uint8_t* data, uint64_t size)
+	{
+		if (m_type == '0' || m_type == 0 || m_type == '7')
+			return m_output.writeFile(data, size);
+
+		if (m_type == 'x' || m_type == 'L' || m_type == 'K')
+			m_meta.append((const char*)data, size);
+
+		return true; // other entries are skipped
+	}
+
+	bool entryEnd()
+	{
+		switch (m_type)
+		{
+		case '0':
+		case 0:
+		case '7':
+			if (!m_output.closeFile())
+				return false;
+			m_output.permissions(m_name, m_mode);
+			break;
+
+		case '1':
+			return m_output.hardlink(m_name, m_linkName);
+
+		case '2':
+			return m_output.symlink(m_name, m_linkName);
+
+		case 'L':
+			m_nextName = ParseTarString((const uint8_t*)m_meta.data(), (uint32_t)m_meta.size());
+			break;
+
+		case 'K':
+			m_nextLinkName = ParseTarString((const uint8_t*)m_meta.data(), (uint32_t)m_meta.size());
+			break;
+
+		case 'x':
+			parsePax();
+			break;
+		}
+
+		return true;
+	}
+
+	void parsePax()
+	{
+		// "<length> <key>=<value>\n" records
+		std::string_view txt(m_meta);
+		while (!txt.empty())
+		{
+			const auto space = txt.find(' ');
+			if (space == std::string_view::npos)
+				break;
+
+			const auto length = (size_t)atoi(std::string(txt.substr(0, space)).c_str());
+			if (length <= space || length > txt.size())
+				break;
+
+			const auto record = txt.substr(space + 1, length - space - 2); // without the new line
+			txt = txt.substr(length);
+
+			const auto key = PartBefore(record, "=");
+			const auto value = PartAfter(record, "=");
+			if (key == "path")
+				m_nextName = std::string(value);
+			else if (key == "linkpath")
+				m_nextLinkName = std::string(value);
+		}
+	}
+};
+
+//--
+
+static bool ExtractTar(ArchiveInput& input, ArchiveOutput& output)
+{
+	TarParser parser(output);
+
+	std::vector<uint8_t> buffer(ARCHIVE_READ_BUFFER_SIZE);
+	for (;;)
+	{
+		const auto size = input.readSome(buffer.data(), buffer.size());
+		if (size == 0)
+			break;
+
+		if (!parser.write(buffer.data(), size))
+			return false;
+	}
+
+	return parser.finish();
+}
+
+static bool ExtractGzipTar(ArchiveInput& input, ArchiveOutput& output)
+{
+	uint8_t header[10];
+	if (!input.readBytes(header, 10) || header[0] != 0x1F || header[1] != 0x8B || header[2] != 8)
+	{
+		LogError() << "Invalid gzip header";
+		return false;
+	}
+
+	const auto flags = header[3];
+	if (flags & 4) // FEXTRA
+	{
+		uint16_t extraSize = 0;
+		if (!input.readU16(extraSize) || !input.skip(extraSize))
+			return false;
+	}
+
+	for (uint32_t flag : { 8, 16 }) // FNAME, FCOMMENT
+	{
+		if (flags & flag)
+		{
+			uint8_t ch = 1;
+			while (ch)
+				if (!input.readByte(ch))
+					return false;
+		}
+	}
+
+	if (flags & 2) // FHCRC
+		input.skip(2);
+
+	TarParser parser(output);
+	uint32_t crc = 0;
+	ArchiveSink sink = [&parser, &crc](const uint8_t* data, uint64_t size) {
+		crc = Crc32(crc, data, size);
+		return parser.write(data, size);
+	};
+
+	Inflater inflater(input, sink);
+	if (!inflater.run())
+		return false;
+
+	uint32_t storedCrc = 0, storedSize = 0;
+	if (!input.readU32(storedCrc) || !input.readU32(storedSize))
+		return false;
+
+	if (storedCrc != crc || storedSize != (uint32_t)inflater.totalOutput())
+	{
+		LogError() << "Gzip stream checksum mismatch";
+		return false;
+	}
+
+	return parser.finish();
+}
+
+//--
+
+static const uint32_t ZIP_LOCAL_HEADER = 0x04034b50;
+static const uint32_t ZIP_CENTRAL_HEADER = 0x02014b50;
+static const uint32_t ZIP_DATA_DESCRIPTOR = 0x08074b50;
+static const uint32_t ZIP_END_OF_CENTRAL_DIRECTORY = 0x06054b50;
+static const uint32_t ZIP64_END_OF_CENTRAL_DIRECTORY = 0x06064b50;
+static const uint32_t ZIP64_END_OF_CENTRAL_DIRECTORY_LOCATOR = 0x07064b50;
+
+static bool ExtractZipEntry(ArchiveInput& input, ArchiveOutput& output)
+{
+	uint8_t header[26];
+	if (!input.readBytes(header, sizeof(header)))
+		return false;
+
+	const auto read16 = [&header](uint32_t offset) { return (uint16_t)(header[offset] | (header[offset + 1] << 8)); };
+	const auto read32 = [&header](uint32_t offset) { return (uint32_t)(header[offset] | (header[offset + 1] << 8) | (header[offset + 2] << 16) | ((uint32_t)header[offset + 3] << 24)); };
+
+	const auto flags = read16(2);
+	const auto method = read16(4);
+	uint32_t crc = read32(10);
+	uint64_t compressedSize = read32(14);
+	uint64_t uncompressedSize = read32(18);
+	const auto nameLength = read16(22);
+	const auto extraLength = read16(24);
+
+	std::string name(nameLength, 0);
+	if (!input.readBytes((uint8_t*)name.data(), nameLength))
+		return false;
+
+	std::vector<uint8_t> extra(extraLength);
+	if (!input.readBytes(extra.data(), extraLength))
+		return false;
+
+	// zip64 sizes
+	bool zip64 = false;
+	for (uint32_t pos = 0; pos + 4 <= extraLength; )
+	{
+		const auto id = extra[pos] | (extra[pos + 1] << 8);
+		const auto size = extra[pos + 2] | (extra[pos + 3] << 8);
+		if (id == 1 && size >= 16 && pos + 4 + 16 <= extraLength)
+		{
+			uint64_t values[2] = { 0, 0 };
+			memcpy(values, extra.data() + pos + 4, 16);
+			uncompressedSize = values[0];
+			compressedSize = values[1];
+			zip64 = true;
+		}
+		pos += 4 + size;
+	}
+
+	if (flags & 1)
+	{
+		LogError() << "Encrypted zip entry '" << name << "' is not supported";
+		return false;
+	}
+
+	const bool hasDescriptor = (flags & 8) != 0;
+	if (method == 0 && hasDescriptor && compressedSize == 0)
+	{
+		LogError() << "Stored zip entry '" << name << "' with unknown size can't be streamed";
+		return false;
+	}
+
+	if (method != 0 && method != 8)
+	{
+		LogError() << "Zip entry '" << name << "' uses unsupported compression method " << method;
+		return false;
+	}
+
+	const bool isDirectory = EndsWith(name, "/");
+	if (isDirectory)
+	{
+		if (!output.directory(name))
+			return false;
+	}
+	else if (!output.beginFile(name))
+	{
+		return false;
+	}
+
+	uint32_t computedCrc = 0;
+	ArchiveSink sink = [&output, &computedCrc, isDirectory](const uint8_t* data, uint64_t size) {
+		computedCrc = Crc32(computedCrc, data, size);
+		return isDirectory || output.writeFile(data, size);
+	};
+
+	uint64_t writtenSize = 0;
+	if (method == 0)
+	{
+		if (!input.readInto(compressedSize, sink))
+			return false;
+		writtenSize = compressedSize;
+	}
+	else
+	{
+		Inflater inflater(input, sink);
+		if (!inflater.run())
+			return false;
+		writtenSize = inflater.totalOutput();
+	}
+
+	if (!output.closeFile())
+		return false;
+
+	if (hasDescriptor)
+	{
+		uint32_t value = 0;
+		if (!input.readU32(value))
+			return false;
+
+		if (value == ZIP_DATA_DESCRIPTOR && !input.readU32(value))
+			return false;
+
+		crc = value;
+
+		if (zip64)
+		{
+			if (!input.readU64(compressedSize) || !input.readU64(uncompressedSize))
+				return false;
+		}
+		else
+		{
+			uint32_t compressed = 0, uncompressed = 0;
+			if (!input.readU32(compressed) || !input.readU32(uncompressed))
+				return false;
+			uncompressedSize = uncompressed;
+		}
+	}
+
+	if (computedCrc != crc || writtenSize != uncompressedSize)
+	{
+		LogError() << "Zip entry '" << name << "' is corrupted (checksum mismatch)";
+		return false;
+	}
+
+	return true;
+}
+
+static bool ProcessZipCentralEntry(ArchiveInput& input, ArchiveOutput& output)
+{
+	uint8_t header[42];
+	if (!input.readBytes(header, sizeof(header)))
+		return false;
+
+	const auto madeBy = header[1]; // host system
+	const auto nameLength = header[24] | (header[25] << 8);
+	const auto extraLength = header[26] | (header[27] << 8);
+	const auto commentLength = header[28] | (header[29] << 8);
+	const auto externalAttributes = (uint32_t)(header[34] | (header[35] << 8) | (header[36] << 16) | ((uint32_t)header[37] << 24));
+
+	std::string name(nameLength, 0);
+	if (!input.readBytes((uint8_t*)name.data(), nameLength))
+		return false;
+
+	if (!input.skip(extraLength + commentLength))
+		return false;
+
+	// unix file modes are only known in the central directory
+	if (madeBy == 3 && !EndsWith(name, "/"))
+	{
+		const auto mode = externalAttributes >> 16;
+		if ((mode & 0170000) == 0120000)
+			return output.convertToSymlink(name);
+
+		output.permissions(name, mode);
+	}
+
+	return true;
+}
+
+static bool ExtractZip(ArchiveInput& input, ArchiveOutput& output)
+{
+	for (;;)
+	{
+		uint32_t signature = 0;
+		if (!input.readU32(signature))
+		{
+			LogError() << "Zip archive is truncated";
+			return false;
+		}
+
+		if (signature == ZIP_LOCAL_HEADER)
+		{
+			if (!ExtractZipEntry(input, output))
+				return false;
+		}
+		else if (signature == ZIP_CENTRAL_HEADER)
+		{
+			if (!ProcessZipCentralEntry(input, output))
+				return false;
+		}
+		else if (signature == ZIP_END_OF_CENTRAL_DIRECTORY || signature == ZIP64_END_OF_CENTRAL_DIRECTORY || signature == ZIP64_END_OF_CENTRAL_DIRECTORY_LOCATOR)
+		{
+			return true;
+		}
+		else
+		{
+			LogError() << "Unexpected data in zip archive";
+			return false;
+		}
+	}
+}
+
+//--
+
+static bool ExtractArchive(ArchiveInput& input, const fs::path& targetPath)
+{
+	InitCrc32Table();
+
+	if (!CreateDirectories(targetPath))
+		return false;
+
+	uint8_t magic[4];
+	memset(magic, 0, sizeof(magic));
+	input.peek(magic, 4);
+
+	ArchiveOutput output(targetPath);
+
+	bool valid = false;
+	if (magic[0] == 'P' && magic[1] == 'K' && magic[2] == 3 && magic[3] == 4)
+	{
+		valid = ExtractZip(input, output);
+	}
+	else if (magic[0] == 0x1F && magic[1] == 0x8B)
+	{
+		valid = ExtractGzipTar(input, output);
+	}
+	else
+	{
+		uint8_t header[512];
+		if (input.peek(header, 512) && 0 == memcmp(header + 257, "ustar", 5))
+			valid = ExtractTar(input, output);
+		else
+			LogError() << "Unknown archive format";
+	}
+
+	output.closeFile();
+
+	if (valid)
+		LogInfo() << "Extracted " << output.numFiles() << " files (" << (output.numBytes() >> 10) << " KB) to " << targetPath;
+
+	return valid;
+}
+
+bool Archive_ExtractFile(const fs::path& archivePath, const fs::path& targetPath, std::string* outArchiveHash)
+{
+	std::ifstream file(archivePath, std::ios::in | std::ios::binary);
+	if (!file.is_open())
+	{
+		LogError() << "Unable to open archive " << archivePath;
+		return false;
+	}
+
+	ArchiveFileSource source(file);
+	ArchiveInput input(source);
+
+	if (!ExtractArchive(input, targetPath))
+	{
+		LogError() << "Failed to extract archive " << archivePath;
+		return false;
+	}
+
+	input.drain();
+
+	if (outArchiveHash)
+		*outArchiveHash = input.hash();
+
+	return true;
+}
+
+//--
+
+ArchiveStreamExtractor::ArchiveStreamExtractor(const fs::path& targetPath)
+	: m_pipe(std::make_unique<ArchivePipe>())
+{
+	m_thread = std::thread([this, targetPath]() {
+		ArchiveInput input(*m_pipe);
+
+		m_valid = ExtractArchive(input, targetPath);
+		if (m_valid)
+		{
+			input.drain();
+			m_hash = input.hash();
+		}
+		else
+		{
+			m_pipe->abort();
+		}
+	});
+}
+
+ArchiveStreamExtractor::~ArchiveStreamExtractor()
+{
+	if (!m_finished)
+	{
+		m_pipe->abort();
+		m_thread.join();
+	}
+}
+
+bool ArchiveStreamExtractor::write(const uint8_t* data, uint64_t size)
+{
+	return m_pipe->push(data, size);
+}
+
+bool ArchiveStreamExtractor::finish(std::string* outArchiveHash)
+{
+	if (!m_finished)
+	{
+		m_pipe->close();
+		m_thread.join();
+		m_finished = true;
+	}
+
+	if (outArchiveHash)
+		*outArchiveHash = m_hash;
+
+	return m_valid;
+}
+
+//--
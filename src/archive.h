@@ -0,0 +1,37 @@
+#pragma once
+
+#include <thread>
+
+//--
+
+class ArchivePipe;
+
+// extract archive (zip with stored/deflated entries, tar, tar.gz) into the target directory
+// returns false if the archive is not supported or broken, optionally returns the SHA256 of the whole archive
+extern bool Archive_ExtractFile(const fs::path& archivePath, const fs::path& targetPath, std::string* outArchiveHash = nullptr);
+
+//--
+
+// streaming extraction - archive data is pushed as it arrives (ie. from a download) and extracted on a separate thread
+class ArchiveStreamExtractor
+{
+public:
+	ArchiveStreamExtractor(const fs::path& targetPath);
+	~ArchiveStreamExtractor();
+
+	// push more archive data, returns false if extraction already failed
+	bool write(const uint8_t* data, uint64_t size);
+
+	// signal end of data and wait for extraction to finish
+	bool finish(std::string* outArchiveHash = nullptr);
+
+private:
+	std::unique_ptr<ArchivePipe> m_pipe;
+	std::thread m_thread;
+
+	bool m_valid = false;
+	bool m_finished = false;
+	std::string m_hash;
+};
+
+//--
@@ -3,6 +3,7 @@
 #include "json.h"
 #include "aws.h"
 #include "xmlUtils.h"
+#include "httpClient.h"
 #include <assert.h>
 
 //--
@@ -112,8 +113,16 @@ bool AWSConfig::get(std::string path, const RequestArgs& args, std::string& outR
 	args.print(txt);
 	txt << "\"";
 
+	std::stringstream url;
+	url << endpoint;
+	url << path;
+	args.print(url);
+
+	HttpRequest request;
+	request.url = url.str();
+
 	std::stringstream result;
-	if (!RunWithArgsAndCaptureOutput(txt.str(), result))
+	if (!Http_SendOrRunCurl(request, txt.str(), result))
 	{
 		LogError() << "AWS request failed: " << path << ": " << result.str();
 		return false;
@@ -202,6 +211,13 @@ bool AWS_S3_ListLibraries(const AWSConfig& aws, PlatformType platform, std::vect
 			info.name = name;
 			info.version = TrimQuotes(tag);
 			info.url = BuildLibraryDownloadURL(aws, key);
+			info.size = strtoull(std::string(size).c_str(), nullptr, 10);
+
+			// ETag of multipart uploads is not a hash of the content ("<hash>-<parts>")
+			const auto md5 = ToLower(info.version);
+			if (md5.length() == 32 && md5.find_first_not_of("0123456789abcdef") == std::string::npos)
+				info.md5 = md5;
+
 			outFiles.push_back(info);
 		});
 
@@ -53,6 +53,8 @@ struct AWSLibraryInfo
 	std::string name; // just the file name (zlib)
 	std::string version; // ETag
 	std::string url; // download url (full, with endpoint name)
+	uint64_t size = 0; // size of the archive
+	std::string md5; // MD5 of the archive, known only if the ETag is a plain MD5 (object uploaded in one part), empty otherwise
 };
 
 extern bool AWS_S3_ListLibraries(const AWSConfig& aws, PlatformType platform, std::vector<AWSLibraryInfo>& outLibraries);
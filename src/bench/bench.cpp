@@ -0,0 +1,471 @@
+#include "common.h"
+#include "utils.h"
+#include "json.h"
+#include "xmlUtils.h"
+#include "codeParser.h"
+
+#include <chrono>
+#include <random>
+
+// microbenchmarks of the primitives used on the hot paths of the tool (hashing, compression, parsing, file writes)
+// all inputs are synthetic and deterministic so results from different commits can be compared
+
+//--
+
+namespace prv
+{
+	static volatile uint64_t GBenchmarkSink = 0; // results are written here so the work is not optimized away
+
+	struct BenchmarkSettings
+	{
+		uint32_t warmup = 3;
+		uint32_t repetitions = 15;
+		uint32_t minTimeMs = 10; // each repetition runs the function in a loop until it takes at least this long
+		uint32_t inputSizeKB = 256;
+		std::string filter;
+	};
+
+	struct BenchmarkResult
+	{
+		std::string name;
+		uint64_t bytesPerCall = 0;
+		uint64_t callsPerRepetition = 0;
+		double medianNs = 0.0; // per call
+		double p95Ns = 0.0;
+		double minNs = 0.0;
+	};
+
+	class BenchmarkHarness
+	{
+	public:
+		BenchmarkHarness(const BenchmarkSettings& settings)
+			: m_settings(settings)
+		{}
+
+		std::vector<BenchmarkResult> results;
+
+		// measure the function, bytes are the amount of data processed by single call (0 if throughput does not make sense)
+		void run(std::string_view name, uint64_t bytesPerCall, const std::function<uint64_t()>& func)
+		{
+			if (!m_settings.filter.empty() && name.find(m_settings.filter) == std::string_view::npos)
+				return;
+
+			// find out how many calls are needed to fill the minimal repetition time, this also warms up the caches
+			uint64_t numCalls = 1;
+			for (uint32_t i = 0; i < std::max<uint32_t>(1, m_settings.warmup); ++i)
+			{
+				for (;;)
+				{
+					const auto timeNs = measure(numCalls, func);
+					if (timeNs >= m_settings.minTimeMs * 1000000ULL || numCalls >= (1ULL << 30))
+						break;
+
+					numCalls *= 2;
+				}
+			}
+
+			std::vector<double> times;
+			for (uint32_t i = 0; i < m_settings.repetitions; ++i)
+				times.push_back(measure(numCalls, func) / (double)numCalls);
+
+			std::sort(times.begin(), times.end());
+
+			BenchmarkResult result;
+			result.name = std::string(name);
+			result.bytesPerCall = bytesPerCall;
+			result.callsPerRepetition = numCalls;
+			result.minNs = times.front();
+			result.medianNs = (times.size() & 1) ? times[times.size() / 2] : (times[times.size() / 2 - 1] + times[times.size() / 2]) * 0.5;
+			result.p95Ns = times[std::min<size_t>(times.size() - 1, (times.size() * 95 + 99) / 100 - 1)];
+
+			print(result);
+			results.push_back(result);
+		}
+
+		static void PrintHeader()
+		{
+			char txt[256];
+			snprintf(txt, sizeof(txt), "  %-36s %10s %14s %14s %12s", "Benchmark", "Calls", "Median [us]", "P95 [us]", "MB/s");
+			LogInfo() << txt;
+		}
+
+	private:
+		const BenchmarkSettings& m_settings;
+
+		static uint64_t measure(uint64_t numCalls, const std::function<uint64_t()>& func)
+		{
+			uint64_t sink = 0;
+
+			const auto start = std::chrono::steady_clock::now();
+			for (uint64_t i = 0; i < numCalls; ++i)
+				sink += func();
+			const auto end = std::chrono::steady_clock::now();
+
+			GBenchmarkSink += sink;
+			return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+		}
+
+		static void print(const BenchmarkResult& result)
+		{
+			char throughput[64] = "-";
+			if (result.bytesPerCall && result.medianNs > 0.0)
+				snprintf(throughput, sizeof(throughput), "%.1f", (result.bytesPerCall / (1024.0 * 1024.0)) / (result.medianNs / 1e9));
+
+			char txt[256];
+			snprintf(txt, sizeof(txt), "  %-36s %10llu %14.3f %14.3f %12s", result.name.c_str(), (unsigned long long)result.callsPerRepetition,
+				result.medianNs / 1000.0, result.p95Ns / 1000.0, throughput);
+			LogInfo() << txt;
+		}
+	};
+
+	//--
+
+	static std::vector<uint8_t> GenerateBinaryData(uint32_t size, uint32_t seed)
+	{
+		// mix of repeated blocks and noise so the compression has something to do
+		std::mt19937 random(seed);
+
+		std::vector<uint8_t> ret;
+		ret.reserve(size);
+		while (ret.size() < size)
+		{
+			if (random() & 1)
+			{
+				const auto count = 16 + (random() % 64);
+				for (uint32_t i = 0; i < count; ++i)
+					ret.push_back((uint8_t)random());
+			}
+			else if (ret.size() > 256)
+			{
+				const auto offset = ret.size() - 1 - (random() % 256);
+				const auto count = 8 + (random() % 32);
+				for (uint32_t i = 0; i < count; ++i)
+					ret.push_back(ret[offset + (i % (ret.size() - offset))]);
+			}
+		}
+
+		ret.resize(size);
+		return ret;
+	}
+
+	static std::string GenerateSourceCode(uint32_t size)
+	{
+		std::stringstream f;
+		writeln(f, "#include \"build.h\"");
+		writeln(f, "#include \"object.h\"");
+		writeln(f, "");
+		writeln(f, "BEGIN_NAMESPACE_EX(bench)");
+
+		uint32_t index = 0;
+		while (f.tellp() < size)
+		{
+			writeln(f, "");
+			writelnf(f, "RTTI_BEGIN_TYPE_CLASS(BenchObject%u);", index);
+			writeln(f, "	RTTI_PROPERTY(m_value);");
+			writeln(f, "	RTTI_PROPERTY(m_name).editable(\"Name of the object\");");
+			writeln(f, "RTTI_END_TYPE();");
+			writeln(f, "");
+			writeln(f, "/* multi line comment");
+			writeln(f, "   with some text in it */");
+			writeln(f, "#if defined(BENCH_FEATURE)");
+			writelnf(f, "int BenchObject%u::compute(int x) const // single line comment", index);
+			writeln(f, "{");
+			writelnf(f, "	const char* txt = \"string with \\\"escapes\\\" %u\";", index);
+			writelnf(f, "	return x * %u + 0x%X + txt[0] + 'a' + 1.5e3f;", index, index * 7);
+			writeln(f, "}");
+			writeln(f, "#endif");
+			index += 1;
+		}
+
+		writeln(f, "");
+		writeln(f, "END_NAMESPACE_EX(bench)");
+		return f.str();
+	}
+
+	static std::string GenerateJson(uint32_t size)
+	{
+		std::stringstream f;
+		f << "[";
+
+		uint32_t index = 0;
+		while (f.tellp() < size)
+		{
+			if (index)
+				f << ",";
+
+			f << "{\"id\": " << index << ", \"name\": \"onion-library-" << index << "\", \"draft\": false, ";
+			f << "\"tag_name\": \"v1." << index << "\", \"assets\": [";
+			f << "{\"name\": \"lib_linux.zip\", \"size\": " << (index * 1234) << ", \"browser_download_url\": \"https://example.com/lib" << index << "/linux.zip\"},";
+			f << "{\"name\": \"lib_windows.zip\", \"size\": " << (index * 4321) << ", \"browser_download_url\": \"https://example.com/lib" << index << "/windows.zip\"}";
+			f << "]}";
+			index += 1;
+		}
+
+		f << "]";
+		return f.str();
+	}
+
+	static std::string GenerateManifest(uint32_t size)
+	{
+		std::stringstream f;
+		writeln(f, "<?xml version=\"1.0\" encoding=\"utf-8\" standalone=\"yes\" ?>");
+		writeln(f, "<Module guid=\"b7f258bb-bf38-4250-ae38-4a9754751d92\">");
+		writeln(f, "	<GlobalNamespace>bench</GlobalNamespace>");
+		writeln(f, "	<GlobalIncludePath>code/</GlobalIncludePath>");
+
+		uint32_t index = 0;
+		while (f.tellp() < size)
+		{
+			writeln(f, "	<Library>");
+			writelnf(f, "		<Name>bench_lib_%u</Name>", index);
+			writeln(f, "		<SourceRoot>.</SourceRoot>");
+			writeln(f, "		<Dependency>core_object</Dependency>");
+			writelnf(f, "		<Dependency>bench_lib_%u</Dependency>", index / 2);
+			writeln(f, "		<LibraryDependency>zlib</LibraryDependency>");
+			writeln(f, "		<Filter platform=\"windows\"><LibraryDependency>dx12</LibraryDependency></Filter>");
+			writeln(f, "	</Library>");
+			index += 1;
+		}
+
+		writeln(f, "</Module>");
+		return f.str();
+	}
+
+	static std::vector<std::string> GeneratePaths(uint32_t count)
+	{
+		std::vector<std::string> ret;
+		for (uint32_t i = 0; i < count; ++i)
+			ret.push_back("engine/code/group_" + std::to_string(i % 17) + "/project_" + std::to_string(i) + "/media/dir " + std::to_string(i) + "/file-name." + ((i & 1) ? "png" : "txt"));
+		return ret;
+	}
+
+	static uint64_t CountXmlNodes(const XMLNode* node)
+	{
+		uint64_t ret = 1;
+		for (const auto* child = node->first_node(); child; child = child->next_sibling())
+			ret += CountXmlNodes(child) + XMLNodeValue(child).length();
+		return ret;
+	}
+
+	//--
+
+	static void RunBenchmarks(BenchmarkHarness& harness, const BenchmarkSettings& settings, const fs::path& tempPath)
+	{
+		const auto inputSize = settings.inputSizeKB * 1024;
+
+		// hashing
+		{
+			const auto data = GenerateBinaryData(inputSize, 1);
+
+			harness.run("Crc64", data.size(), [&data]() {
+				return Crc64(data.data(), data.size());
+				});
+
+			harness.run("Sha256Calculate", data.size(), [&data]() {
+				SHA256_HASH hash;
+				Sha256Calculate(data.data(), data.size(), &hash);
+				return (uint64_t)hash.bytes[0];
+				});
+		}
+
+		// compression
+		{
+			const auto data = GenerateBinaryData(inputSize, 2);
+
+			std::vector<uint8_t> compressed;
+			CompressLZ4(data, compressed);
+
+			harness.run("CompressLZ4", data.size(), [&data]() {
+				std::vector<uint8_t> buffer;
+				CompressLZ4(data, buffer);
+				return (uint64_t)buffer.size();
+				});
+
+			harness.run("DecompressLZ4", data.size(), [&data, &compressed]() {
+				std::vector<uint8_t> buffer;
+				buffer.resize(data.size());
+				DecompressLZ4(compressed, buffer);
+				return (uint64_t)buffer.size();
+				});
+		}
+
+		// code parsing
+		{
+			const auto code = GenerateSourceCode(inputSize);
+
+			harness.run("CodeTokenizer::tokenize", code.size(), [&code]() {
+				CodeTokenizer tokenizer;
+				tokenizer.tokenize(code);
+				return (uint64_t)tokenizer.tokens.size();
+				});
+
+			harness.run("CodeTokenizer::process", code.size(), [&code]() {
+				CodeTokenizer tokenizer;
+				tokenizer.tokenize(code);
+				tokenizer.process("bench");
+				return (uint64_t)tokenizer.declarations.size();
+				});
+		}
+
+		// json
+		{
+			const auto json = GenerateJson(inputSize);
+
+			harness.run("SimpleJson::Parse", json.size(), [&json]() {
+				const auto root = SimpleJson::Parse(json);
+				return root ? (uint64_t)root->values().size() : 0;
+				});
+		}
+
+		// manifests
+		{
+			const auto manifest = GenerateManifest(inputSize);
+
+			harness.run("rapidxml::parse (manifest)", manifest.size(), [&manifest]() {
+				std::string txt = manifest; // parsing is destructive
+				XMLDoc doc;
+				doc.parse<0>((char*)txt.c_str());
+				return CountXmlNodes(doc.first_node("Module"));
+				});
+		}
+
+		// strings
+		{
+			const auto paths = GeneratePaths(1000);
+
+			uint64_t totalLength = 0;
+			for (const auto& path : paths)
+				totalLength += path.length();
+
+			harness.run("MakeSymbolName", totalLength, [&paths]() {
+				uint64_t ret = 0;
+				for (const auto& path : paths)
+					ret += MakeSymbolName(path).length();
+				return ret;
+				});
+
+			const auto code = GenerateSourceCode(inputSize);
+			harness.run("ReplaceAll", code.size(), [&code]() {
+				return (uint64_t)ReplaceAll(code, "RTTI_", "REFLECTION_").length();
+				});
+		}
+
+		// file writing, both the changed and the most common unchanged case (generated files that are the same)
+		{
+			const auto content = GenerateSourceCode(inputSize);
+			const auto path = tempPath / "save_test.cpp";
+
+			harness.run("SaveFileFromString (force)", content.size(), [&content, &path]() {
+				return (uint64_t)SaveFileFromString(path, content, true, false);
+				});
+
+			harness.run("SaveFileFromString (unchanged)", content.size(), [&content, &path]() {
+				return (uint64_t)SaveFileFromString(path, content, false, false);
+				});
+		}
+	}
+
+	static bool WriteResults(const fs::path& path, const BenchmarkSettings& settings, const std::vector<BenchmarkResult>& results)
+	{
+		std::stringstream f;
+		writeln(f, "{");
+		writelnf(f, "  \"inputSizeKB\": %u,", settings.inputSizeKB);
+		writelnf(f, "  \"repetitions\": %u,", settings.repetitions);
+		writeln(f, "  \"benchmarks\": [");
+
+		for (size_t i = 0; i < results.size(); ++i)
+		{
+			const auto& result = results[i];
+			const auto bytesPerSecond = (result.bytesPerCall && result.medianNs > 0.0) ? (result.bytesPerCall / (result.medianNs / 1e9)) : 0.0;
+
+			f << "    {";
+			f << "\"name\": \"" << result.name << "\", ";
+			f << "\"calls\": " << result.callsPerRepetition << ", ";
+			f << "\"bytes\": " << result.bytesPerCall << ", ";
+			f << "\"medianNs\": " << (uint64_t)result.medianNs << ", ";
+			f << "\"p95Ns\": " << (uint64_t)result.p95Ns << ", ";
+			f << "\"minNs\": " << (uint64_t)result.minNs << ", ";
+			f << "\"bytesPerSecond\": " << (uint64_t)bytesPerSecond;
+			f << "}" << ((i + 1 < results.size()) ? "," : "") << "\n";
+		}
+
+		writeln(f, "  ]");
+		writeln(f, "}");
+
+		return SaveFileFromString(path, f.str(), true);
+	}
+
+	static uint32_t GetNumberOption(const Commandline& cmdLine, std::string_view name, uint32_t defaultValue, uint32_t minValue)
+	{
+		if (!cmdLine.has(name))
+			return defaultValue;
+
+		return (uint32_t)std::max<int>(minValue, atoi(std::string(cmdLine.get(name)).c_str()));
+	}
+
+	static void PrintUsage()
+	{
+		LogInfo() << "onion_bench [options]";
+		LogInfo() << "";
+		LogInfo() << "  -filter=<text> - run only benchmarks with given text in the name";
+		LogInfo() << "  -warmup=<number> - warmup rounds before measuring (default 3)";
+		LogInfo() << "  -repetitions=<number> - measured repetitions, median and p95 are computed from them (default 15)";
+		LogInfo() << "  -minTime=<ms> - minimal duration of single repetition (default 10)";
+		LogInfo() << "  -size=<KB> - size of the synthetic inputs (default 256)";
+		LogInfo() << "  -json=<path> - write results as JSON";
+		LogInfo() << "";
+	}
+
+} // prv
+
+//--
+
+int main(int argc, char** argv)
+{
+	std::string args;
+	for (int i = 1; i < argc; ++i)
+	{
+		args += " ";
+		args += argv[i];
+	}
+
+	Commandline cmdLine;
+	if (!cmdLine.parse(args) || !cmdLine.commands.empty() || cmdLine.has("help"))
+	{
+		prv::PrintUsage();
+		return 1;
+	}
+
+	prv::BenchmarkSettings settings;
+	settings.warmup = prv::GetNumberOption(cmdLine, "warmup", settings.warmup, 1);
+	settings.repetitions = prv::GetNumberOption(cmdLine, "repetitions", settings.repetitions, 1);
+	settings.minTimeMs = prv::GetNumberOption(cmdLine, "minTime", settings.minTimeMs, 1);
+	settings.inputSizeKB = prv::GetNumberOption(cmdLine, "size", settings.inputSizeKB, 1);
+	settings.filter = cmdLine.get("filter");
+
+	const auto tempPath = fs::temp_directory_path() / "onion_bench";
+	if (!CreateDirectories(tempPath))
+	{
+		LogError() << "Unable to create temporary directory " << tempPath;
+		return 1;
+	}
+
+	LogInfo() << "Running benchmarks (" << settings.repetitions << " repetitions, " << settings.inputSizeKB << " KB inputs)";
+	prv::BenchmarkHarness::PrintHeader();
+
+	prv::BenchmarkHarness harness(settings);
+	prv::RunBenchmarks(harness, settings, tempPath);
+
+	std::error_code ec;
+	fs::remove_all(tempPath, ec);
+
+	if (cmdLine.has("json"))
+	{
+		if (!prv::WriteResults(fs::absolute(fs::path(cmdLine.get("json"))), settings, harness.results))
+			return 2;
+	}
+
+	return 0;
+}
+
+//--
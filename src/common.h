@@ -15,6 +15,7 @@
 #include <algorithm>
 #include <filesystem>
 #include <atomic>
+#include <functional>
 
 #include <assert.h>
 #include <string.h>
@@ -64,6 +65,7 @@ enum class GeneratorType : uint8_t {
     VisualStudio19,
     VisualStudio22,
     CMake,
+    Ninja,
 
     MAX,
 };
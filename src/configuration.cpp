@@ -5,6 +5,14 @@
 
 //--
 
+static bool IsCompilerLauncherAvailable(std::string_view name)
+{
+	ProcessRunResult result;
+	return RunProcess(std::string(name), { "--version" }, fs::current_path(), 10000, result);
+}
+
+//--
+
 Configuration::Configuration()
 {
 	platform = DefaultPlatform();
@@ -162,13 +170,148 @@ bool Configuration::ParseOptions(const Commandline& cmd, Configuration& cfg)
             cfg.generator = GeneratorType::CMake;
     }
 
-    // when using the CMake generator we can't really generate reflection and other shit at runtime :(
-    if (cfg.generator == GeneratorType::CMake || cmd.has("static"))
+    // when using the CMake/Ninja generator we can't really generate reflection and other shit at runtime :(
+    // the Ninja build reruns "onion make" by itself when any of the inputs changes
+    if (cfg.generator == GeneratorType::CMake || cfg.generator == GeneratorType::Ninja || cmd.has("static"))
     {
         LogInfo() << "Enabled static content generation";
         cfg.flagStaticBuild = true;
     }
 
+    // unity build
+    if (cmd.has("unity"))
+    {
+        LogInfo() << "Enabled unity build";
+        cfg.flagUnityBuild = true;
+    }
+
+    {
+        const auto& str = cmd.get("unityBatchSize");
+        if (!str.empty())
+            cfg.unityBatchSize = std::max<int>(0, atoi(std::string(str).c_str()));
+    }
+
+    // profile guided optimization, we only know how to do it with GCC/Clang
+    if (cmd.has("pgo"))
+    {
+        if (cfg.generator != GeneratorType::CMake && cfg.generator != GeneratorType::Ninja)
+        {
+            LogWarning() << "Profile guided optimization is only supported by the CMake and Ninja generators";
+        }
+        else if (cfg.platform == PlatformType::Windows || cfg.platform == PlatformType::UWP || cfg.platform == PlatformType::Wasm)
+        {
+            LogWarning() << "Profile guided optimization is not supported on platform '" << NameEnumOption(cfg.platform) << "'";
+        }
+        else
+        {
+            LogInfo() << "Enabled profile guided optimization";
+            cfg.flagPGO = true;
+        }
+    }
+
+    // compiler launcher
+    {
+        const auto& str = cmd.get("launcher");
+        if (str == "auto")
+        {
+            for (const auto* name : { "ccache", "sccache" })
+            {
+                if (IsCompilerLauncherAvailable(name))
+                {
+                    cfg.compilerLauncher = name;
+                    break;
+                }
+            }
+
+            if (cfg.compilerLauncher.empty())
+                LogWarning() << "No compiler cache (ccache, sccache) was found, building without compiler launcher";
+        }
+        else if (str == "ccache" || str == "sccache" || str == "distcc")
+        {
+            if (!IsCompilerLauncherAvailable(str))
+            {
+                LogError() << "Compiler launcher '" << str << "' was not found in PATH";
+                return false;
+            }
+
+            cfg.compilerLauncher = str;
+        }
+        else if (!str.empty() && str != "none")
+        {
+            LogError() << "Unknown compiler launcher '" << str << "', valid options are: ccache, sccache, distcc, auto, none";
+            return false;
+        }
+
+        if (!cfg.compilerLauncher.empty())
+            LogInfo() << "Using compiler launcher '" << cfg.compilerLauncher << "'";
+    }
+
+    // link time options, only for the GCC/Clang toolchains producing ELF binaries
+    if (cmd.has("linker") || cmd.has("splitDwarf") || cmd.has("gdbIndex") || cmd.has("compressDebugSections"))
+    {
+        if (cfg.platform != PlatformType::Linux && cfg.platform != PlatformType::Android)
+        {
+            LogWarning() << "Link time options (-linker, -splitDwarf, -gdbIndex, -compressDebugSections) are not supported on platform '" << NameEnumOption(cfg.platform) << "'";
+        }
+        else
+        {
+            const auto& linker = cmd.get("linker");
+            if (linker == "lld" || linker == "mold" || linker == "gold")
+            {
+                ProcessRunResult result;
+                const auto linkerExecutable = (linker == "mold") ? std::string("mold") : ("ld." + std::string(linker));
+                if (!RunProcess(linkerExecutable, { "--version" }, fs::current_path(), 10000, result))
+                {
+                    LogError() << "Linker '" << linkerExecutable << "' was not found in PATH";
+                    return false;
+                }
+
+                cfg.linker = linker;
+            }
+            else if (!linker.empty() && linker != "default")
+            {
+                LogError() << "Unknown linker '" << linker << "', valid options are: lld, mold, gold, default";
+                return false;
+            }
+
+            cfg.flagSplitDwarf = cmd.has("splitDwarf");
+            cfg.flagGdbIndex = cmd.has("gdbIndex");
+            cfg.flagCompressDebugSections = cmd.has("compressDebugSections");
+
+            if (cfg.flagGdbIndex && cfg.linker.empty())
+                LogWarning() << "Default linker (GNU ld) can't write the .gdb_index, use -linker=lld|mold|gold";
+
+            // shipping binaries keep the default linking unless asked for explicitly
+            const auto& configs = cmd.get("linkOptionsConfigs", "debug,checked,release,profile");
+
+            std::vector<std::string_view> configNames;
+            SplitString(configs, ",", configNames);
+
+            for (const auto& name : configNames)
+            {
+                bool found = false;
+                for (const auto type : CONFIGURATIONS)
+                {
+                    if (ToLower(NameEnumOption(type)) == ToLower(name))
+                    {
+                        cfg.linkOptionsConfigurationMask |= (1U << (int)type);
+                        found = true;
+                    }
+                }
+
+                if (!found)
+                {
+                    LogError() << "Unknown configuration '" << name << "' in -linkOptionsConfigs";
+                    return false;
+                }
+            }
+
+            LogInfo() << "Using link options '" << (cfg.linker.empty() ? "default" : cfg.linker) << "'"
+                << (cfg.flagSplitDwarf ? " split-dwarf" : "") << (cfg.flagGdbIndex ? " gdb-index" : "") << (cfg.flagCompressDebugSections ? " compressed-debug" : "")
+                << " in configurations '" << configs << "'";
+        }
+    }
+
     return true;
 }
 
@@ -247,6 +390,7 @@ bool Configuration::ParsePaths(const Commandline& cmd, Configuration& cfg)
     cfg.derivedConfigurationPathBase = (cfg.tempPath / cfg.mergedName()).make_preferred();
     cfg.derivedBinaryPathBase = (cfg.derivedConfigurationPathBase / "bin").make_preferred();
     cfg.derivedSolutionPathBase = (cfg.derivedConfigurationPathBase / "build").make_preferred();
+    cfg.derivedProfilePathBase = (cfg.derivedConfigurationPathBase / "pgo").make_preferred();
 
     return true;
 }
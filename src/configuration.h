@@ -20,8 +20,19 @@ struct Configuration
     fs::path derivedConfigurationPathBase; // where are all the configuration related things go (Z:\projects\core\.temp\windows.vs2022.static.dev\)
     fs::path derivedSolutionPathBase; // where are the generated solution files written go (Z:\projects\core\.temp\windows.vs2022.static.dev\build\)
     fs::path derivedBinaryPathBase; // "bin" folder when all crap is written (Z:\projects\core\.temp\windows.vs2022.static.dev\bin\)
+    fs::path derivedProfilePathBase; // profile guided optimization data, one folder per project (Z:\projects\core\.temp\linux.cmake.static.final\pgo\)
 
     bool flagStaticBuild = false; // build is "static" - no runtime code generation, all has to be pregenerated in the "generate" step
+    bool flagUnityBuild = false; // (-unity) group source files of projects into unity (jumbo) files, can be overridden per project
+    uint32_t unityBatchSize = 0; // (-unityBatchSize) target size of single unity file in KB, 0 - default
+    bool flagPGO = false; // (-pgo) profile guided optimization, "Profile" configuration is instrumented and "Final" is optimized with the collected profile
+    std::string compilerLauncher; // (-launcher) compiler launcher used to cache/distribute compilation (ccache, sccache, distcc), empty - none
+
+    std::string linker; // (-linker) faster linker used instead of the default one (lld, mold, gold), empty - default, ELF platforms only
+    bool flagSplitDwarf = false; // (-splitDwarf) debug information stays in the .dwo files and is not processed by the linker
+    bool flagGdbIndex = false; // (-gdbIndex) linker writes the .gdb_index section so the debugger does not have to build it on every start
+    bool flagCompressDebugSections = false; // (-compressDebugSections) debug sections of objects and binaries are compressed (smaller, slower to link)
+    uint32_t linkOptionsConfigurationMask = 0; // (-linkOptionsConfigs) configurations the link options above are used in, bit per ConfigurationType
 
     Configuration();
 
@@ -31,6 +42,9 @@ struct Configuration
     // linux.cmake.dev.release
     std::string mergedName() const;
 
+    // should the link time options (linker, split debug info, etc) be used in given configuration
+    inline bool usesLinkOptions(ConfigurationType type) const { return 0 != (linkOptionsConfigurationMask & (1U << (int)type)); }
+
     // path to platform configuration file (contains resolved modules and libraries)
     // Z:\projects\core\.temp\windows.config
 	fs::path platformConfigurationFile() const;
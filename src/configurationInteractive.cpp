@@ -2,12 +2,22 @@
 #include <stdio.h>
 #include <termios.h>
 #include <unistd.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+
+extern char** environ;
 #endif
 
+#include <chrono>
+
 #include "common.h"
 #include "configuration.h"
 #include "project.h"
 #include "utils.h"
+#include "profiler.h"
 
 //--
 
@@ -19,6 +29,7 @@
 #ifdef _MSC_VER
 #include <Windows.h>
 #include <conio.h>
+#include <psapi.h>
 
 static void ClearConsole()
 {
@@ -189,6 +200,9 @@ bool OpenDefaultFileEditor(const fs::path& path)
 
 bool RunWithArgs(std::string_view cmd, int* outCode /*= nullptr*/)
 {
+    PROFILE_SCOPE("RunWithArgs");
+    Profiler_AddCounter(ProfilerCounter::ProcessesSpawned);
+
     LogInfo() << "Running: '" << cmd << "'";
 
     auto code = std::system(std::string(cmd).c_str());
@@ -275,6 +289,9 @@ bool RunWithArgsInDirectoryAndCaptureOutput(const fs::path& dir, std::string_vie
 
 bool RunWithArgsAndCaptureOutput(std::string_view cmd, std::stringstream& outStr, int* outCode /*= nullptr*/)
 {
+    PROFILE_SCOPE("RunWithArgsAndCaptureOutput");
+    Profiler_AddCounter(ProfilerCounter::ProcessesSpawned);
+
     LogInfo() << "Running: '" << cmd << "'";
 
 #ifdef _WIN32
@@ -343,6 +360,346 @@ bool RunWithArgsAndCaptureOutputIntoLines(std::string_view cmd, std::vector<std:
     return true;
 }
 
+//--
+
+#ifdef _WIN32
+
+static std::wstring QuoteProcessArgument(const std::wstring& arg)
+{
+	if (!arg.empty() && arg.find_first_of(L" \t\"") == std::wstring::npos)
+		return arg;
+
+	std::wstring ret = L"\"";
+	for (const auto ch : arg)
+	{
+		if (ch == L'\"')
+			ret += L"\\\"";
+		else
+			ret += ch;
+	}
+	ret += L"\"";
+	return ret;
+}
+
+bool RunProcess(const fs::path& executable, const std::vector<std::string>& args, const fs::path& workingDirectory, uint64_t timeoutMs, ProcessRunResult& outResult,
+	const std::vector<std::pair<std::string, std::string>>& environment)
+{
+	PROFILE_SCOPE("RunProcess");
+	Profiler_AddCounter(ProfilerCounter::ProcessesSpawned);
+
+	const auto startTime = std::chrono::steady_clock::now();
+
+	SECURITY_ATTRIBUTES sa;
+	memset(&sa, 0, sizeof(sa));
+	sa.nLength = sizeof(sa);
+	sa.bInheritHandle = TRUE;
+
+	HANDLE readPipe = NULL, writePipe = NULL;
+	if (!CreatePipe(&readPipe, &writePipe, &sa, 0))
+	{
+		LogError() << "Failed to create output pipe for " << executable;
+		return false;
+	}
+	SetHandleInformation(readPipe, HANDLE_FLAG_INHERIT, 0);
+
+	std::wstring commandLine = QuoteProcessArgument(executable.wstring());
+	for (const auto& arg : args)
+		commandLine += L" " + QuoteProcessArgument(fs::path(arg).wstring());
+
+	STARTUPINFOW si;
+	memset(&si, 0, sizeof(si));
+	si.cb = sizeof(si);
+	si.dwFlags = STARTF_USESTDHANDLES;
+	si.hStdInput = GetStdHandle(STD_INPUT_HANDLE);
+	si.hStdOutput = writePipe;
+	si.hStdError = writePipe;
+
+	PROCESS_INFORMATION pi;
+	memset(&pi, 0, sizeof(pi));
+
+	// environment block: current environment with overrides
+	std::vector<wchar_t> environmentBlock;
+	if (!environment.empty())
+	{
+		if (auto* strings = GetEnvironmentStringsW())
+		{
+			for (const wchar_t* entry = strings; *entry; entry += wcslen(entry) + 1)
+			{
+				const std::wstring_view entryTxt(entry);
+				const auto separator = entryTxt.find(L'=', 1); // entries like "=C:=C:\\" start with '='
+
+				bool overridden = false;
+				for (const auto& it : environment)
+					overridden |= (separator != std::wstring_view::npos) && (0 == _wcsicmp(std::wstring(entryTxt.substr(0, separator)).c_str(), fs::path(it.first).wstring().c_str()));
+
+				if (!overridden)
+					environmentBlock.insert(environmentBlock.end(), entryTxt.begin(), entryTxt.end() + 1);
+			}
+
+			FreeEnvironmentStringsW(strings);
+		}
+
+		for (const auto& it : environment)
+		{
+			const auto entry = fs::path(it.first + "=" + it.second).wstring();
+			environmentBlock.insert(environmentBlock.end(), entry.c_str(), entry.c_str() + entry.length() + 1);
+		}
+
+		environmentBlock.push_back(0);
+	}
+
+	// job object makes sure child processes are killed as well
+	HANDLE job = CreateJobObjectW(NULL, NULL);
+
+	const auto workingDir = workingDirectory.wstring();
+	const DWORD flags = CREATE_SUSPENDED | (environmentBlock.empty() ? 0 : CREATE_UNICODE_ENVIRONMENT);
+	if (!CreateProcessW(NULL, commandLine.data(), NULL, NULL, TRUE, flags, environmentBlock.empty() ? NULL : environmentBlock.data(), workingDir.c_str(), &si, &pi))
+	{
+		LogError() << "Failed to start " << executable << ", error: " << GetLastError();
+		CloseHandle(readPipe);
+		CloseHandle(writePipe);
+		if (job) CloseHandle(job);
+		return false;
+	}
+
+	if (job)
+		AssignProcessToJobObject(job, pi.hProcess);
+	ResumeThread(pi.hThread);
+	CloseHandle(pi.hThread);
+	CloseHandle(writePipe);
+
+	outResult.started = true;
+
+	char buffer[4096];
+	for (;;)
+	{
+		DWORD available = 0;
+		if (PeekNamedPipe(readPipe, NULL, 0, NULL, &available, NULL) && available > 0)
+		{
+			DWORD numRead = 0;
+			if (ReadFile(readPipe, buffer, sizeof(buffer), &numRead, NULL) && numRead > 0)
+				outResult.output.append(buffer, numRead);
+			continue;
+		}
+
+		if (WaitForSingleObject(pi.hProcess, 10) == WAIT_OBJECT_0)
+		{
+			// drain what's left
+			DWORD numRead = 0;
+			while (PeekNamedPipe(readPipe, NULL, 0, NULL, &available, NULL) && available > 0 && ReadFile(readPipe, buffer, sizeof(buffer), &numRead, NULL) && numRead > 0)
+				outResult.output.append(buffer, numRead);
+			break;
+		}
+
+		const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime).count();
+		if (timeoutMs && (uint64_t)elapsed > timeoutMs)
+		{
+			outResult.timedOut = true;
+			if (job)
+				TerminateJobObject(job, 1);
+			else
+				TerminateProcess(pi.hProcess, 1);
+			WaitForSingleObject(pi.hProcess, INFINITE);
+			break;
+		}
+	}
+
+	DWORD exitCode = 1;
+	GetExitCodeProcess(pi.hProcess, &exitCode);
+	outResult.exitCode = (int)exitCode;
+
+	PROCESS_MEMORY_COUNTERS counters;
+	memset(&counters, 0, sizeof(counters));
+	if (GetProcessMemoryInfo(pi.hProcess, &counters, sizeof(counters)))
+		outResult.peakMemoryBytes = counters.PeakWorkingSetSize;
+
+	CloseHandle(pi.hProcess);
+	CloseHandle(readPipe);
+	if (job)
+		CloseHandle(job);
+
+	outResult.wallTimeMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime).count();
+	return !outResult.timedOut && outResult.exitCode == 0;
+}
+
+#else
+
+bool RunProcess(const fs::path& executable, const std::vector<std::string>& args, const fs::path& workingDirectory, uint64_t timeoutMs, ProcessRunResult& outResult,
+	const std::vector<std::pair<std::string, std::string>>& environment)
+{
+	PROFILE_SCOPE("RunProcess");
+	Profiler_AddCounter(ProfilerCounter::ProcessesSpawned);
+
+	const auto startTime = std::chrono::steady_clock::now();
+
+	// pipe must not leak into processes started in parallel from other threads
+	int fds[2];
+#ifdef __APPLE__
+	const auto pipeRet = pipe(fds);
+	if (pipeRet == 0)
+	{
+		fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+		fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+	}
+#else
+	const auto pipeRet = pipe2(fds, O_CLOEXEC);
+#endif
+	if (pipeRet != 0)
+	{
+		LogError() << "Failed to create output pipe for " << executable;
+		return false;
+	}
+
+	// prepare everything before forking, only async-signal-safe calls are allowed in the child
+	auto executableStr = executable.u8string();
+
+	// plain name ("git") - search in PATH
+	if (executableStr.find('/') == std::string::npos)
+	{
+		std::vector<std::string_view> searchPaths;
+		const auto* pathEnv = getenv("PATH");
+		SplitString(pathEnv ? pathEnv : "", ":", searchPaths);
+
+		for (const auto& searchPath : searchPaths)
+		{
+			const auto candidate = std::string(searchPath) + "/" + executableStr;
+			if (access(candidate.c_str(), X_OK) == 0)
+			{
+				executableStr = candidate;
+				break;
+			}
+		}
+	}
+	const auto workingDirStr = workingDirectory.u8string();
+
+	std::vector<char*> argv;
+	argv.push_back((char*)executableStr.c_str());
+	for (const auto& arg : args)
+		argv.push_back((char*)arg.c_str());
+	argv.push_back(nullptr);
+
+	std::vector<std::string> envStrings;
+	for (char** entry = environ; *entry; ++entry)
+	{
+		const std::string_view entryTxt(*entry);
+		const auto name = entryTxt.substr(0, entryTxt.find('='));
+
+		bool overridden = false;
+		for (const auto& it : environment)
+			overridden |= (name == it.first);
+
+		if (!overridden)
+			envStrings.emplace_back(entryTxt);
+	}
+
+	for (const auto& it : environment)
+		envStrings.push_back(it.first + "=" + it.second);
+
+	std::vector<char*> envp;
+	for (const auto& entry : envStrings)
+		envp.push_back((char*)entry.c_str());
+	envp.push_back(nullptr);
+
+	const auto pid = fork();
+	if (pid < 0)
+	{
+		LogError() << "Failed to start " << executable;
+		close(fds[0]);
+		close(fds[1]);
+		return false;
+	}
+
+	if (pid == 0)
+	{
+		setpgid(0, 0); // own process group so we can kill the whole tree
+		dup2(fds[1], STDOUT_FILENO);
+		dup2(fds[1], STDERR_FILENO);
+		close(fds[0]);
+		close(fds[1]);
+
+		if (chdir(workingDirStr.c_str()) != 0)
+			_exit(127);
+
+		execve(executableStr.c_str(), argv.data(), envp.data());
+		_exit(127);
+	}
+
+	setpgid(pid, pid);
+	close(fds[1]);
+	outResult.started = true;
+
+	int status = 0;
+	bool exited = false;
+	bool pipeClosed = false;
+	struct rusage usage;
+	memset(&usage, 0, sizeof(usage));
+
+	char buffer[4096];
+	while (!exited || !pipeClosed)
+	{
+		struct pollfd pfd;
+		pfd.fd = fds[0];
+		pfd.events = POLLIN;
+		pfd.revents = 0;
+
+		const auto ret = pipeClosed ? 0 : poll(&pfd, 1, 50);
+		if (ret > 0)
+		{
+			const auto numRead = read(fds[0], buffer, sizeof(buffer));
+			if (numRead > 0)
+				outResult.output.append(buffer, numRead);
+			else
+				pipeClosed = true;
+		}
+		else if (exited)
+		{
+			// process is done but the pipe is kept open by something it started, don't wait for it
+			break;
+		}
+
+		if (!exited)
+		{
+			if (wait4(pid, &status, WNOHANG, &usage) == pid)
+				exited = true;
+		}
+
+		const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime).count();
+		if (!exited && timeoutMs && (uint64_t)elapsed > timeoutMs)
+		{
+			outResult.timedOut = true;
+			kill(-pid, SIGKILL);
+			wait4(pid, &status, 0, &usage);
+			break;
+		}
+
+		if (pipeClosed && !exited)
+		{
+			if (wait4(pid, &status, 0, &usage) == pid)
+				exited = true;
+		}
+	}
+
+	close(fds[0]);
+
+	if (WIFEXITED(status))
+		outResult.exitCode = WEXITSTATUS(status);
+	else if (WIFSIGNALED(status))
+		outResult.exitCode = 128 + WTERMSIG(status);
+
+#ifdef __APPLE__
+	outResult.peakMemoryBytes = (uint64_t)usage.ru_maxrss; // bytes
+#else
+	outResult.peakMemoryBytes = (uint64_t)usage.ru_maxrss * 1024; // kilobytes
+#endif
+
+	outResult.wallTimeMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime).count();
+	return !outResult.timedOut && outResult.exitCode == 0;
+}
+
+#endif
+
+//--
+
 std::string GetExecutablePath()
 {
     char exepath[1024];
@@ -0,0 +1,105 @@
+#include "common.h"
+#include "utils.h"
+#include "contentStore.h"
+
+//--
+
+ContentStore::ContentStore(const fs::path& storePath)
+	: m_storePath(storePath)
+{}
+
+fs::path ContentStore::objectPath(std::string_view hash) const
+{
+	return (m_storePath / std::string(hash.substr(0, 2)) / std::string(hash)).make_preferred();
+}
+
+bool ContentStore::internFile(const fs::path& filePath, std::string* outHash, bool* outDeduplicated)
+{
+	std::string hash;
+	if (!Sha256OfFile(filePath, hash))
+	{
+		LogError() << "Unable to hash file " << filePath;
+		return false;
+	}
+
+	if (outHash)
+		*outHash = hash;
+	if (outDeduplicated)
+		*outDeduplicated = false;
+
+	const auto storedPath = objectPath(hash);
+
+	std::error_code ec;
+	if (!fs::is_regular_file(storedPath, ec))
+	{
+		// first time we see this content, the file itself becomes the object
+		if (!CreateDirectories(storedPath.parent_path()))
+			return false;
+
+		// if hard links are not possible (ie. different volumes) the file is just kept as is
+		fs::create_hard_link(filePath, storedPath, ec);
+		return true;
+	}
+
+	// already linked to the same object
+	if (fs::equivalent(filePath, storedPath, ec))
+		return true;
+
+	// replace the file with a link to existing object
+	const auto tempPath = fs::path(filePath.u8string() + ".link");
+	fs::create_hard_link(storedPath, tempPath, ec);
+	if (ec)
+		return true;
+
+	fs::rename(tempPath, filePath, ec);
+	if (ec)
+	{
+		fs::remove(tempPath, ec);
+		return true;
+	}
+
+	if (outDeduplicated)
+		*outDeduplicated = true;
+
+	return true;
+}
+
+bool ContentStore::internDirectory(const fs::path& directoryPath)
+{
+	uint32_t numFiles = 0;
+	uint32_t numDeduplicated = 0;
+	uint64_t savedBytes = 0;
+
+	// collect files first, interning modifies the directory
+	std::vector<std::pair<fs::path, uint64_t>> files;
+	try
+	{
+		for (const auto& entry : fs::recursive_directory_iterator(directoryPath))
+			if (!entry.is_symlink() && entry.is_regular_file())
+				files.emplace_back(entry.path(), entry.file_size());
+	}
+	catch (fs::filesystem_error& e)
+	{
+		LogError() << "Filesystem Error: " << e.what();
+		return false;
+	}
+
+	for (const auto& file : files)
+	{
+		bool deduplicated = false;
+		if (!internFile(file.first, nullptr, &deduplicated))
+			return false;
+
+		numFiles += 1;
+		if (deduplicated)
+		{
+			numDeduplicated += 1;
+			savedBytes += file.second;
+		}
+	}
+
+	LogInfo() << "Stored " << numFiles << " files from " << directoryPath << " in the content store, " << numDeduplicated << " were already present (" << (savedBytes >> 10) << " KB saved)";
+	return true;
+}
+
+//--
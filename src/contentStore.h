@@ -0,0 +1,27 @@
+#pragma once
+
+//--
+
+// content addressed file store, files are kept by the hash of their content and shared through hard links
+// identical files from different libraries/versions take space only once, NOTE: linked files must never be written to (deploy copies them)
+class ContentStore
+{
+public:
+	ContentStore(const fs::path& storePath);
+
+	inline const fs::path& path() const { return m_storePath; }
+
+	// move all regular files from given directory into the store and replace them with links to the stored objects
+	bool internDirectory(const fs::path& directoryPath);
+
+	// move single file into the store and replace it with a link to the stored object
+	bool internFile(const fs::path& filePath, std::string* outHash = nullptr, bool* outDeduplicated = nullptr);
+
+	// path to object with given hash
+	fs::path objectPath(std::string_view hash) const;
+
+private:
+	fs::path m_storePath;
+};
+
+//--
@@ -0,0 +1,258 @@
+#include "common.h"
+#include "utils.h"
+#include "dependencyGraph.h"
+
+//--
+
+DependencyGraph::DependencyGraph(uint32_t numNodes)
+{
+	reset(numNodes);
+}
+
+void DependencyGraph::reset(uint32_t numNodes)
+{
+	m_numNodes = numNodes;
+	m_numWords = (numNodes + 63) / 64;
+	m_built = false;
+
+	m_dependencies.clear();
+	m_dependencies.resize(numNodes);
+	m_dependents.clear();
+	m_dependents.resize(numNodes);
+	m_order.clear();
+	m_closures.clear();
+}
+
+void DependencyGraph::addEdge(uint32_t node, uint32_t dependency)
+{
+	assert(node < m_numNodes);
+	assert(dependency < m_numNodes);
+
+	if (PushBackUnique(m_dependencies[node], dependency))
+	{
+		m_dependents[dependency].push_back(node);
+		m_built = false;
+	}
+}
+
+bool DependencyGraph::build(std::vector<uint32_t>* outUnorderedNodes)
+{
+	// start with nodes that have no dependencies, a node is ready once all its dependencies are ordered
+	std::vector<uint32_t> numPendingDependencies(m_numNodes, 0);
+
+	m_order.clear();
+	m_order.reserve(m_numNodes);
+
+	for (uint32_t i = 0; i < m_numNodes; ++i)
+	{
+		numPendingDependencies[i] = (uint32_t)m_dependencies[i].size();
+		if (!numPendingDependencies[i])
+			m_order.push_back(i);
+	}
+
+	// the ordered list is also the queue
+	for (size_t head = 0; head < m_order.size(); ++head)
+	{
+		const auto node = m_order[head];
+		for (const auto dependent : m_dependents[node])
+			if (0 == --numPendingDependencies[dependent])
+				m_order.push_back(dependent);
+	}
+
+	if (m_order.size() != m_numNodes)
+	{
+		if (outUnorderedNodes)
+		{
+			outUnorderedNodes->clear();
+			for (uint32_t i = 0; i < m_numNodes; ++i)
+				if (numPendingDependencies[i])
+					outUnorderedNodes->push_back(i);
+		}
+
+		m_built = false;
+		return false;
+	}
+
+	// dependencies are always complete by the time a node is visited
+	m_closures.clear();
+	m_closures.resize((size_t)m_numNodes * m_numWords, 0);
+
+	for (const auto node : m_order)
+	{
+		auto* row = closure(node);
+		for (const auto dep : m_dependencies[node])
+		{
+			const auto* depRow = closure(dep);
+			for (uint32_t i = 0; i < m_numWords; ++i)
+				row[i] |= depRow[i];
+
+			row[dep / 64] |= 1ULL << (dep % 64);
+		}
+	}
+
+	m_built = true;
+	return true;
+}
+
+//--
+
+bool DependencyGraph::dependsOn(uint32_t node, uint32_t dependency) const
+{
+	assert(m_built);
+	return 0 != (closure(node)[dependency / 64] & (1ULL << (dependency % 64)));
+}
+
+void DependencyGraph::collectAllDependencies(uint32_t node, std::vector<uint32_t>& outNodes) const
+{
+	assert(m_built);
+
+	const auto* row = closure(node);
+	for (uint32_t i = 0; i < m_numWords; ++i)
+	{
+		auto bits = row[i];
+		for (uint32_t j = 0; bits; ++j, bits >>= 1)
+			if (bits & 1)
+				outNodes.push_back(i * 64 + j);
+	}
+}
+
+void DependencyGraph::collectAllDependents(const std::vector<uint32_t>& nodes, std::vector<uint32_t>& outNodes) const
+{
+	std::vector<bool> visited(m_numNodes, false);
+
+	std::vector<uint32_t> queue;
+	for (const auto node : nodes)
+	{
+		if (!visited[node])
+		{
+			visited[node] = true;
+			queue.push_back(node);
+		}
+	}
+
+	while (!queue.empty())
+	{
+		const auto node = queue.back();
+		queue.pop_back();
+
+		for (const auto dependent : m_dependents[node])
+		{
+			if (!visited[dependent])
+			{
+				visited[dependent] = true;
+				queue.push_back(dependent);
+			}
+		}
+	}
+
+	for (uint32_t i = 0; i < m_numNodes; ++i)
+		if (visited[i])
+			outNodes.push_back(i);
+}
+
+void DependencyGraph::computeDependencyDepths(uint32_t node, std::vector<uint32_t>& outDepths) const
+{
+	assert(m_built);
+
+	outDepths.clear();
+	outDepths.resize(m_numNodes, 0);
+
+	// visit users before their dependencies, only the part of the graph reachable from the node matters
+	for (auto it = m_order.rbegin(); it != m_order.rend(); ++it)
+	{
+		const auto current = *it;
+		if (current != node && !dependsOn(node, current))
+			continue;
+
+		for (const auto dep : m_dependencies[current])
+			outDepths[dep] = std::max<uint32_t>(outDepths[dep], outDepths[current] + 1);
+	}
+}
+
+void DependencyGraph::computeLevels(std::vector<uint32_t>& outLevels) const
+{
+	assert(m_built);
+
+	outLevels.clear();
+	outLevels.resize(m_numNodes, 0);
+
+	for (auto it = m_order.rbegin(); it != m_order.rend(); ++it)
+		for (const auto dep : m_dependencies[*it])
+			outLevels[dep] = std::max<uint32_t>(outLevels[dep], outLevels[*it] + 1);
+}
+
+//--
+
+NamePrefixIndex::NamePrefixIndex()
+{
+	clear();
+}
+
+void NamePrefixIndex::clear()
+{
+	m_nodes.clear();
+	m_nodes.emplace_back();
+}
+
+uint32_t NamePrefixIndex::findChild(uint32_t node, char ch) const
+{
+	const auto& children = m_nodes[node].children;
+
+	auto it = std::lower_bound(children.begin(), children.end(), ch, [](const auto& entry, char value) { return entry.first < value; });
+	if (it != children.end() && it->first == ch)
+		return it->second;
+
+	return 0; // root is never a child
+}
+
+void NamePrefixIndex::insert(std::string_view name, uint32_t value)
+{
+	uint32_t node = 0;
+	for (const auto ch : name)
+	{
+		auto child = findChild(node, ch);
+		if (!child)
+		{
+			child = (uint32_t)m_nodes.size();
+			m_nodes.emplace_back();
+
+			auto& children = m_nodes[node].children;
+			auto it = std::lower_bound(children.begin(), children.end(), ch, [](const auto& entry, char value) { return entry.first < value; });
+			children.insert(it, std::make_pair(ch, child));
+		}
+
+		node = child;
+	}
+
+	m_nodes[node].values.push_back(value);
+}
+
+void NamePrefixIndex::findByPrefix(std::string_view prefix, std::vector<uint32_t>& outValues) const
+{
+	uint32_t node = 0;
+	for (const auto ch : prefix)
+	{
+		node = findChild(node, ch);
+		if (!node)
+			return;
+	}
+
+	const auto firstValue = outValues.size();
+
+	std::vector<uint32_t> stack;
+	stack.push_back(node);
+	while (!stack.empty())
+	{
+		const auto& current = m_nodes[stack.back()];
+		stack.pop_back();
+
+		outValues.insert(outValues.end(), current.values.begin(), current.values.end());
+
+		for (const auto& child : current.children)
+			stack.push_back(child.second);
+	}
+
+	std::sort(outValues.begin() + firstValue, outValues.end());
+}
+
+//--
@@ -0,0 +1,94 @@
+#pragma once
+
+//--
+
+// directed graph of dependencies between nodes identified by dense indices (0 to size-1)
+// edges go from a node to its dependency, after building the topological order and the transitive closures (one bit set per node) are known
+// so all the queries below are answered without walking the graph again
+class DependencyGraph
+{
+public:
+	DependencyGraph(uint32_t numNodes = 0);
+
+	// remove all nodes and edges, all nodes have no dependencies afterwards
+	void reset(uint32_t numNodes);
+
+	// node depends on dependency, duplicated edges are ignored, invalidates the built state
+	void addEdge(uint32_t node, uint32_t dependency);
+
+	// compute topological order (Kahn's algorithm) and transitive closures
+	// fails if there are cycles, nodes that were not ordered (part of a cycle or depending on one) are returned in index order
+	bool build(std::vector<uint32_t>* outUnorderedNodes = nullptr);
+
+	//--
+
+	inline uint32_t size() const { return m_numNodes; }
+	inline bool built() const { return m_built; }
+
+	// direct dependencies/dependents, in order of adding
+	inline const std::vector<uint32_t>& dependencies(uint32_t node) const { return m_dependencies[node]; }
+	inline const std::vector<uint32_t>& dependents(uint32_t node) const { return m_dependents[node]; }
+
+	// all nodes, dependencies always come before the nodes that use them (valid after build)
+	inline const std::vector<uint32_t>& order() const { return m_order; }
+
+	//--
+
+	// does the node depend (directly or not) on the other node (valid after build)
+	bool dependsOn(uint32_t node, uint32_t dependency) const;
+
+	// collect all direct and indirect dependencies of a node, in index order (valid after build)
+	void collectAllDependencies(uint32_t node, std::vector<uint32_t>& outNodes) const;
+
+	// collect given nodes and all nodes that depend on them directly or not, in index order
+	void collectAllDependents(const std::vector<uint32_t>& nodes, std::vector<uint32_t>& outNodes) const;
+
+	// length of the longest path from the node to each of its dependencies, 0 for the node itself and nodes it does not depend on (valid after build)
+	void computeDependencyDepths(uint32_t node, std::vector<uint32_t>& outDepths) const;
+
+	// length of the longest path leading to each node from any other node, 0 for nodes nothing depends on (valid after build)
+	void computeLevels(std::vector<uint32_t>& outLevels) const;
+
+private:
+	uint32_t m_numNodes = 0;
+	uint32_t m_numWords = 0; // 64-bit words in each closure row
+	bool m_built = false;
+
+	std::vector<std::vector<uint32_t>> m_dependencies;
+	std::vector<std::vector<uint32_t>> m_dependents;
+	std::vector<uint32_t> m_order;
+	std::vector<uint64_t> m_closures; // for each node a bit set of all its dependencies
+
+	inline const uint64_t* closure(uint32_t node) const { return m_closures.data() + ((size_t)node * m_numWords); }
+	inline uint64_t* closure(uint32_t node) { return m_closures.data() + ((size_t)node * m_numWords); }
+};
+
+//--
+
+// prefix tree of names, used to resolve wildcard names ("core_*") without looking at every name
+class NamePrefixIndex
+{
+public:
+	NamePrefixIndex();
+
+	void clear();
+
+	// add name with a value (usually index of the named thing)
+	void insert(std::string_view name, uint32_t value);
+
+	// collect values of all names starting with given prefix, sorted
+	void findByPrefix(std::string_view prefix, std::vector<uint32_t>& outValues) const;
+
+private:
+	struct Node
+	{
+		std::vector<std::pair<char, uint32_t>> children; // sorted by character
+		std::vector<uint32_t> values; // values of names ending here
+	};
+
+	std::vector<Node> m_nodes; // first node is the root
+
+	uint32_t findChild(uint32_t node, char ch) const;
+};
+
+//--
@@ -0,0 +1,347 @@
+#include "common.h"
+#include "utils.h"
+#include "directoryScanner.h"
+#include "profiler.h"
+
+#if defined(__linux__)
+	#include <fcntl.h>
+	#include <unistd.h>
+	#include <dirent.h>
+	#include <sys/stat.h>
+	#include <sys/syscall.h>
+#elif !defined(_WIN32)
+	#include <dirent.h>
+	#include <sys/stat.h>
+#endif
+
+//--
+
+namespace prv
+{
+	static bool IsPathSeparator(char ch)
+	{
+		return ch == '/' || ch == '\\';
+	}
+
+#ifndef _WIN32
+	static bool IsDotEntry(const char* name)
+	{
+		return name[0] == '.' && (name[1] == 0 || (name[1] == '.' && name[2] == 0));
+	}
+
+	// resolve type of entry the file system did not tell us about (DT_UNKNOWN) or a symbolic link
+	static DirectoryEntryType QueryEntryType(int dirFd, const char* name)
+	{
+#if defined(__linux__) && defined(STATX_TYPE)
+		struct statx info;
+		if (0 != statx(dirFd, name, AT_STATX_SYNC_AS_STAT, STATX_TYPE, &info))
+			return DirectoryEntryType::Other;
+		const auto mode = info.stx_mode;
+#else
+		struct stat info;
+		if (0 != fstatat(dirFd, name, &info, 0))
+			return DirectoryEntryType::Other;
+		const auto mode = info.st_mode;
+#endif
+
+		if (S_ISDIR(mode))
+			return DirectoryEntryType::Directory;
+		if (S_ISREG(mode))
+			return DirectoryEntryType::File;
+		return DirectoryEntryType::Other;
+	}
+
+	static DirectoryEntryType EntryTypeFromDirent(int dirFd, unsigned char type, const char* name)
+	{
+		switch (type)
+		{
+			case DT_DIR: return DirectoryEntryType::Directory;
+			case DT_REG: return DirectoryEntryType::File;
+			case DT_LNK:
+			case DT_UNKNOWN: return QueryEntryType(dirFd, name);
+		}
+
+		return DirectoryEntryType::Other;
+	}
+#endif
+
+#if defined(__linux__)
+	// layout of records returned by getdents64, glibc does not expose it
+	struct LinuxDirent64
+	{
+		uint64_t d_ino;
+		int64_t d_off;
+		unsigned short d_reclen;
+		unsigned char d_type;
+		char d_name[1];
+	};
+#endif
+
+	static const uint32_t DIRECTORY_CACHE_MAGIC = 0x4C444E4F; // "ONDL"
+	static const uint32_t DIRECTORY_CACHE_VERSION = 1;
+
+	// directory modified so recently that another change within the resolution of the time stamp would go unnoticed is not cached
+	static const auto DIRECTORY_CACHE_TIME_MARGIN = std::chrono::seconds(2);
+
+} // prv
+
+//--
+
+bool ListDirectory(const fs::path& directoryPath, std::vector<DirectoryEntry>& outEntries)
+{
+	outEntries.clear();
+
+#if defined(__linux__)
+	const int fd = open(directoryPath.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if (fd < 0)
+	{
+		if (errno == ENOENT || errno == ENOTDIR)
+			return true;
+
+		LogError() << "Failed to open directory " << directoryPath << ": " << strerror(errno);
+		return false;
+	}
+
+	// big buffer so typical directories are read in one call
+	alignas(8) char buffer[32 * 1024];
+
+	bool valid = true;
+	for (;;)
+	{
+		const auto numBytes = syscall(SYS_getdents64, fd, buffer, sizeof(buffer));
+		if (numBytes == 0)
+			break;
+
+		if (numBytes < 0)
+		{
+			LogError() << "Failed to list directory " << directoryPath << ": " << strerror(errno);
+			valid = false;
+			break;
+		}
+
+		for (long pos = 0; pos < numBytes; )
+		{
+			const auto* entry = (const prv::LinuxDirent64*)(buffer + pos);
+			pos += entry->d_reclen;
+
+			if (prv::IsDotEntry(entry->d_name))
+				continue;
+
+			auto& info = outEntries.emplace_back();
+			info.name = entry->d_name;
+			info.type = prv::EntryTypeFromDirent(fd, entry->d_type, entry->d_name);
+		}
+	}
+
+	close(fd);
+	return valid;
+#elif defined(_WIN32)
+	// directory_iterator on Windows keeps the attributes returned by FindNextFile so there are no extra calls per entry
+	std::error_code ec;
+	fs::directory_iterator it(directoryPath, ec);
+	if (ec)
+	{
+		if (ec == std::errc::no_such_file_or_directory || ec == std::errc::not_a_directory)
+			return true;
+
+		LogError() << "Failed to list directory " << directoryPath << ": " << ec.message();
+		return false;
+	}
+
+	for (const auto& entry : it)
+	{
+		auto& info = outEntries.emplace_back();
+		info.name = entry.path().filename().u8string();
+
+		if (entry.is_directory(ec))
+			info.type = DirectoryEntryType::Directory;
+		else if (entry.is_regular_file(ec))
+			info.type = DirectoryEntryType::File;
+	}
+
+	return true;
+#else
+	auto* dir = opendir(directoryPath.c_str());
+	if (!dir)
+	{
+		if (errno == ENOENT || errno == ENOTDIR)
+			return true;
+
+		LogError() << "Failed to open directory " << directoryPath << ": " << strerror(errno);
+		return false;
+	}
+
+	while (const auto* entry = readdir(dir))
+	{
+		if (prv::IsDotEntry(entry->d_name))
+			continue;
+
+		auto& info = outEntries.emplace_back();
+		info.name = entry->d_name;
+		info.type = prv::EntryTypeFromDirent(dirfd(dir), entry->d_type, entry->d_name);
+	}
+
+	closedir(dir);
+	return true;
+#endif
+}
+
+std::string MakeRelativePathFast(const fs::path& path, const fs::path& basePath)
+{
+	const auto pathStr = path.u8string();
+	const auto baseStr = basePath.u8string();
+
+	auto baseLength = baseStr.length();
+	while (baseLength > 0 && prv::IsPathSeparator(baseStr[baseLength - 1]))
+		baseLength -= 1;
+
+	if (baseLength > 0 && pathStr.length() > baseLength + 1
+		&& prv::IsPathSeparator(pathStr[baseLength])
+		&& 0 == pathStr.compare(0, baseLength, baseStr, 0, baseLength))
+	{
+		return MakeGenericPath(std::string_view(pathStr).substr(baseLength + 1));
+	}
+
+	return MakeGenericPathEx(fs::relative(path, basePath));
+}
+
+//--
+
+DirectoryListingCache::DirectoryListingCache()
+{}
+
+void DirectoryListingCache::load(const fs::path& path)
+{
+	PROFILE_SCOPE("DirectoryListingCache::load");
+
+	std::lock_guard<std::mutex> lock(m_lock);
+	m_listings.clear();
+
+	std::vector<uint8_t> data;
+	if (!fs::is_regular_file(path) || !LoadFileToBuffer(path, data))
+		return;
+
+	BinaryReader reader(data.data(), data.size());
+	if (reader.readU32() != prv::DIRECTORY_CACHE_MAGIC || reader.readU32() != prv::DIRECTORY_CACHE_VERSION)
+	{
+		LogWarning() << "Directory cache at " << path << " is not valid, directories will be listed again";
+		return;
+	}
+
+	const auto numListings = reader.readU32();
+	for (uint32_t i = 0; i < numListings && reader.ok(); ++i)
+	{
+		const auto directoryPath = reader.readString();
+
+		Listing listing;
+		listing.timeStamp = (int64_t)reader.readU64();
+
+		const auto numEntries = reader.readU32();
+		for (uint32_t j = 0; j < numEntries && reader.ok(); ++j)
+		{
+			auto& entry = listing.entries.emplace_back();
+			entry.type = (DirectoryEntryType)reader.readU8();
+			entry.name = reader.readString();
+		}
+
+		m_listings[directoryPath] = std::move(listing);
+	}
+
+	if (!reader.ok())
+	{
+		LogWarning() << "Directory cache at " << path << " is not valid, directories will be listed again";
+		m_listings.clear();
+	}
+}
+
+bool DirectoryListingCache::save(const fs::path& path) const
+{
+	PROFILE_SCOPE("DirectoryListingCache::save");
+
+	std::lock_guard<std::mutex> lock(m_lock);
+
+	uint32_t numListings = 0;
+	for (const auto& it : m_listings)
+		if (it.second.used)
+			numListings += 1;
+
+	BinaryWriter writer;
+	writer.writeU32(prv::DIRECTORY_CACHE_MAGIC);
+	writer.writeU32(prv::DIRECTORY_CACHE_VERSION);
+	writer.writeU32(numListings);
+
+	for (const auto& it : m_listings)
+	{
+		if (!it.second.used)
+			continue;
+
+		writer.writeString(it.first);
+		writer.writeU64((uint64_t)it.second.timeStamp);
+		writer.writeU32((uint32_t)it.second.entries.size());
+
+		for (const auto& entry : it.second.entries)
+		{
+			writer.writeU8((uint8_t)entry.type);
+			writer.writeString(entry.name);
+		}
+	}
+
+	return SaveFileFromBuffer(path, writer.data, false, false);
+}
+
+bool DirectoryListingCache::list(const fs::path& directoryPath, std::vector<DirectoryEntry>& outEntries)
+{
+	// time stamp is taken BEFORE listing so a change made while we list is detected next time
+	std::error_code ec;
+	const auto timeStamp = fs::last_write_time(directoryPath, ec);
+	if (ec)
+	{
+		outEntries.clear();
+		return true; // does not exist, same as ListDirectory
+	}
+
+	const auto timeStampValue = (int64_t)timeStamp.time_since_epoch().count();
+	const auto key = directoryPath.u8string();
+
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+
+		auto it = m_listings.find(key);
+		if (it != m_listings.end() && it->second.timeStamp == timeStampValue)
+		{
+			it->second.used = true;
+			outEntries = it->second.entries;
+			m_numReused += 1;
+			return true;
+		}
+	}
+
+	if (!ListDirectory(directoryPath, outEntries))
+		return false;
+
+	m_numListed += 1;
+
+	if (timeStamp < fs::file_time_type::clock::now() - prv::DIRECTORY_CACHE_TIME_MARGIN)
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+
+		auto& listing = m_listings[key];
+		listing.timeStamp = timeStampValue;
+		listing.used = true;
+		listing.entries = outEntries;
+	}
+	else
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		m_listings.erase(key);
+	}
+
+	return true;
+}
+
+void DirectoryListingCache::printStats() const
+{
+	LogInfo() << "Directory cache: reused " << m_numReused.load() << " listing(s), listed " << m_numListed.load() << " directory(ies)";
+}
+
+//--
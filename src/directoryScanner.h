@@ -0,0 +1,66 @@
+#pragma once
+
+#include <mutex>
+
+//--
+
+enum class DirectoryEntryType : uint8_t
+{
+	File, // regular file
+	Directory,
+	Other, // sockets, pipes, devices, broken links
+};
+
+struct DirectoryEntry
+{
+	std::string name; // just the file name, no path
+	DirectoryEntryType type = DirectoryEntryType::Other;
+};
+
+// list content of a single directory without touching the files themselves (no stat per entry unless file system does not report the type)
+// on Linux this uses getdents64 directly, symbolic links are followed like fs::directory_entry::is_directory() does
+// returns true and empty list if the directory does not exist, false only on actual read errors
+extern bool ListDirectory(const fs::path& directoryPath, std::vector<DirectoryEntry>& outEntries);
+
+// compute path relative to base using only string operations, valid only when path was built by appending to the base path
+// falls back to fs::relative when path is not inside the base
+extern std::string MakeRelativePathFast(const fs::path& path, const fs::path& basePath);
+
+//--
+
+// persistent cache of directory listings, an entry is valid as long as the modification time of the directory did not change
+// (it changes whenever an entry is added, removed or renamed) so unchanged directories are served without listing them again
+// NOTE: thread safe, directories can be listed from multiple threads
+class DirectoryListingCache
+{
+public:
+	DirectoryListingCache();
+
+	// load previously saved cache, missing or invalid file just means empty cache
+	void load(const fs::path& path);
+
+	// save the directories used since the load, NOTE: directories not used this time are dropped
+	bool save(const fs::path& path) const;
+
+	// list directory, served from the cache if possible
+	bool list(const fs::path& directoryPath, std::vector<DirectoryEntry>& outEntries);
+
+	// print how many directories were reused
+	void printStats() const;
+
+private:
+	struct Listing
+	{
+		int64_t timeStamp = 0; // modification time of the directory when listed
+		bool used = false; // used since load, only those are saved
+		std::vector<DirectoryEntry> entries;
+	};
+
+	mutable std::mutex m_lock;
+	std::unordered_map<std::string, Listing> m_listings;
+
+	std::atomic<uint32_t> m_numReused = 0;
+	std::atomic<uint32_t> m_numListed = 0;
+};
+
+//--
@@ -184,6 +184,17 @@ std::unique_ptr<ExternalLibraryManifest> ExternalLibraryManifest::Load(const fs:
 
 //--
 
+// deployed files are clones or copies - the cached library files are hard links into the content store and anything writing to the deployed file must not change them
+static bool DeployLibraryFile(const fs::path& sourcePath, const fs::path& targetPath)
+{
+	// older deploys linked the file, break the link before checking timestamps (a link always looks up to date)
+	std::error_code ec;
+	if (fs::exists(targetPath, ec) && fs::equivalent(sourcePath, targetPath, ec))
+		fs::remove(targetPath, ec);
+
+	return CloneNewerFile(sourcePath, targetPath);
+}
+
 bool ExternalLibraryManifest::deployFilesToTarget(PlatformType platformType, ConfigurationType configuration, const fs::path& targetPath) const
 {
 	bool valid = true;
@@ -191,7 +202,7 @@ bool ExternalLibraryManifest::deployFilesToTarget(PlatformType platformType, Con
 	for (const auto& file : defaultPlatform.deployFiles)
 	{
 		const auto finalTargetPath = (targetPath / file.relativeDeployPath).make_preferred();
-		valid &= CopyNewerFile(file.absoluteSourcePath, finalTargetPath);
+		valid &= DeployLibraryFile(file.absoluteSourcePath, finalTargetPath);
 	}
 
 	for (const auto& platform : customPlatforms)
@@ -201,7 +212,7 @@ bool ExternalLibraryManifest::deployFilesToTarget(PlatformType platformType, Con
 			for (const auto& file : platform.deployFiles)
 			{
 				const auto finalTargetPath = (targetPath / file.relativeDeployPath).make_preferred();
-				valid &= CopyNewerFile(file.absoluteSourcePath, finalTargetPath);
+				valid &= DeployLibraryFile(file.absoluteSourcePath, finalTargetPath);
 			}
 		}
 	}
@@ -260,4 +271,75 @@ void ExternalLibraryManifest::collectIncludeDirectories(PlatformType platformTyp
 		outLibraryPaths->push_back(includePath);
 }
 
+//--
+
+void ExternalLibraryManifest::WritePlatform(BinaryWriter& writer, const ExternalLibraryPlatform& platform)
+{
+	writer.writeU8((uint8_t)platform.platform);
+	writer.writePaths(platform.libraryFiles);
+
+	writer.writeU32((uint32_t)platform.deployFiles.size());
+	for (const auto& file : platform.deployFiles)
+	{
+		writer.writePath(file.absoluteSourcePath);
+		writer.writeString(file.relativeDeployPath);
+	}
+
+	writer.writeStrings(platform.additionalSystemLibraries);
+	writer.writeStrings(platform.additionalSystemPackages);
+	writer.writeStrings(platform.additionalSystemFrameworks);
+}
+
+void ExternalLibraryManifest::ReadPlatform(BinaryReader& reader, ExternalLibraryPlatform& outPlatform)
+{
+	outPlatform.platform = (PlatformType)reader.readU8();
+	reader.readPaths(outPlatform.libraryFiles);
+
+	const auto numDeployFiles = reader.readU32();
+	for (uint32_t i = 0; i < numDeployFiles && reader.ok(); ++i)
+	{
+		auto& file = outPlatform.deployFiles.emplace_back();
+		file.absoluteSourcePath = reader.readPath();
+		file.relativeDeployPath = reader.readString();
+	}
+
+	reader.readStrings(outPlatform.additionalSystemLibraries);
+	reader.readStrings(outPlatform.additionalSystemPackages);
+	reader.readStrings(outPlatform.additionalSystemFrameworks);
+}
+
+void ExternalLibraryManifest::writeBinary(BinaryWriter& writer) const
+{
+	writer.writePath(rootPath);
+	writer.writeString(name);
+	writer.writeString(platform);
+	writer.writeString(hash);
+	writer.writePaths(allFiles);
+	writer.writePath(includePath);
+
+	WritePlatform(writer, defaultPlatform);
+
+	writer.writeU32((uint32_t)customPlatforms.size());
+	for (const auto& platform : customPlatforms)
+		WritePlatform(writer, platform);
+}
+
+bool ExternalLibraryManifest::readBinary(BinaryReader& reader)
+{
+	rootPath = reader.readPath();
+	name = reader.readString();
+	platform = reader.readString();
+	hash = reader.readString();
+	reader.readPaths(allFiles);
+	includePath = reader.readPath();
+
+	ReadPlatform(reader, defaultPlatform);
+
+	const auto numPlatforms = reader.readU32();
+	for (uint32_t i = 0; i < numPlatforms && reader.ok(); ++i)
+		ReadPlatform(reader, customPlatforms.emplace_back());
+
+	return reader.ok();
+}
+
 //--
\ No newline at end of file
@@ -4,6 +4,9 @@
 
 //--
 
+class BinaryWriter;
+class BinaryReader;
+
 struct ExternalLibraryDeployFile
 {
 	fs::path absoluteSourcePath;
@@ -46,11 +49,21 @@ struct ExternalLibraryManifest
 	void collectAdditionalSystemPackages(PlatformType platformType, std::unordered_set<std::string>* outPackages) const;
 	void collectAdditionalSystemFrameworks(PlatformType platformType, std::unordered_set<std::string>* outPackages) const;
 
+	// binary form of the loaded manifest, used by the manifest cache
+	void writeBinary(BinaryWriter& writer) const;
+	bool readBinary(BinaryReader& reader);
+
+	// include directory of the library, empty if it has none
+	inline const fs::path& includeDirectory() const { return includePath; }
+
 	//--
 
 private:
 	static bool LoadPlatform(const XMLNode* node, ExternalLibraryPlatform* outPlatform, ExternalLibraryManifest* outManifest);
 
+	static void WritePlatform(BinaryWriter& writer, const ExternalLibraryPlatform& platform);
+	static void ReadPlatform(BinaryReader& reader, ExternalLibraryPlatform& outPlatform);
+
 	fs::path includePath; // path to library's include folder
 
 	ExternalLibraryPlatform defaultPlatform;
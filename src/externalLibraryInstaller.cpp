@@ -3,6 +3,11 @@
 #include "utils.h"
 #include "externalLibrary.h"
 #include "externalLibraryInstaller.h"
+#include "httpClient.h"
+#include "archive.h"
+#include "contentStore.h"
+
+#include <chrono>
 
 //--
 
@@ -11,6 +16,118 @@ ILibrarySource::~ILibrarySource()
 
 //--
 
+static bool UnpackLibraryArchive(const fs::path& archivePath, const fs::path& unpackPath)
+{
+	if (Archive_ExtractFile(archivePath, unpackPath))
+		return true;
+
+	LogWarning() << "Built-in extraction of " << archivePath << " failed, falling back to tar";
+
+	std::error_code ec;
+	fs::remove_all(unpackPath, ec);
+	if (!CreateDirectories(unpackPath))
+		return false;
+
+	std::stringstream cmd;
+	cmd << "tar -xf ";
+	cmd << archivePath;
+	cmd << " -C ";
+	cmd << unpackPath;
+	return RunWithArgs(cmd.str());
+}
+
+// checks downloaded archive against the size and MD5 reported in the endpoint listing, hashed as the data arrives
+class LibraryDownloadCheck
+{
+public:
+	LibraryDownloadCheck(const AWSLibraryInfo& info)
+		: m_info(info)
+	{
+		Md5Initialise(&m_md5);
+	}
+
+	void update(const uint8_t* data, uint64_t size)
+	{
+		Md5Update(&m_md5, data, size);
+		m_size += size;
+	}
+
+	bool verify()
+	{
+		if (m_size != m_info.size)
+		{
+			LogError() << "Downloaded archive of third-party library '" << m_info.name << "' has " << m_size << " bytes but the endpoint lists " << m_info.size << " bytes";
+			return false;
+		}
+
+		if (m_info.md5.empty())
+		{
+			LogWarning() << "Endpoint does not list MD5 of third-party library '" << m_info.name << "' (multipart upload), only the size was verified";
+			return true;
+		}
+
+		MD5_HASH digest;
+		Md5Finalise(&m_md5, &digest);
+
+		const auto md5 = BytesToHexString(&digest.bytes[0], sizeof(digest.bytes));
+		if (md5 != m_info.md5)
+		{
+			LogError() << "Downloaded archive of third-party library '" << m_info.name << "' has MD5 " << md5 << " but the endpoint lists " << m_info.md5;
+			return false;
+		}
+
+		return true;
+	}
+
+private:
+	const AWSLibraryInfo& m_info;
+	Md5Context m_md5;
+	uint64_t m_size = 0;
+};
+
+static bool VerifyLibraryArchiveFile(const AWSLibraryInfo& info, const fs::path& archivePath)
+{
+	std::ifstream file(archivePath, std::ios::in | std::ios::binary);
+	if (!file.is_open())
+	{
+		LogError() << "Unable to open " << archivePath << " for verification";
+		return false;
+	}
+
+	LibraryDownloadCheck check(info);
+
+	std::vector<char> buffer(1 << 20);
+	while (file)
+	{
+		file.read(buffer.data(), buffer.size());
+		check.update((const uint8_t*)buffer.data(), (uint64_t)file.gcount());
+	}
+
+	return check.verify();
+}
+
+static bool StreamLibraryArchive(const AWSLibraryInfo& info, const fs::path& unpackPath)
+{
+	ArchiveStreamExtractor extractor(unpackPath);
+	LibraryDownloadCheck check(info);
+
+	const auto downloaded = Http_DownloadToSink(info.url, [&extractor, &check](const uint8_t* data, uint64_t size)
+		{
+			check.update(data, size);
+			return extractor.write(data, size);
+		});
+
+	std::string archiveHash;
+	const auto extracted = extractor.finish(&archiveHash);
+	if (!downloaded || !extracted || !check.verify())
+		return false;
+
+	LogInfo() << "Archive from '" << info.url << "' streamed, verified and extracted (SHA256: " << archiveHash << ")";
+	return true;
+}
+
+//--
+
 LibrarySourceAWSEndpoint::LibrarySourceAWSEndpoint()
 	: m_aws(false)
 {}
@@ -85,26 +202,47 @@ bool LibrarySourceAWSEndpoint::install(const LibraryInstaller& installer, std::s
 	// if we don't have the download file get it now
 	const auto cacheDownloadPath = installer.buildLibraryDownloadPath(info.name, info.version);
 
+	// when possible unpack the archive while it's being downloaded, no archive is stored in that case
+	bool streamed = false;
+	if (!fs::is_regular_file(cacheDownloadPath) && Http_CanHandleInProcess(info.url))
+	{
+		streamed = StreamLibraryArchive(info, cacheUnpackPath);
+		if (streamed)
+		{
+			LogSuccess() << "Third-part library '" << info.name << "' downloaded and unpacked";
+		}
+		else
+		{
+			LogWarning() << "Streaming install of third-part library '" << info.name << "' failed, library will be downloaded first";
+			std::error_code ec;
+			fs::remove_all(cacheUnpackPath, ec);
+		}
+	}
+
 	// download if not there
-	if (!fs::is_regular_file(cacheDownloadPath))
+	if (!streamed && !fs::is_regular_file(cacheDownloadPath))
 	{
 		// make sure library directory exists
 		if (!CreateDirectories(cacheDownloadPath.parent_path()))
 			return false;
 
-		// curl --silent -z onion.exe -L -O https://...
-		std::stringstream cmd;
-		cmd << "curl --silent -z ";
-		cmd << cacheDownloadPath;
-		cmd << " -L -o ";
-		cmd << cacheDownloadPath;
-		cmd << " ";
-		cmd << info.url;
-
-		if (!RunWithArgs(cmd.str()))
+		// download in-process if possible, reusing connection to the endpoint
+		if (!Http_CanHandleInProcess(info.url) || !Http_Download(info.url, cacheDownloadPath, true))
 		{
-			LogError() << "Failed to download file from '" << info.url;
-			return false;
+			// curl --silent -z onion.exe -L -O https://...
+			std::stringstream cmd;
+			cmd << "curl --silent -z ";
+			cmd << cacheDownloadPath;
+			cmd << " -L -o ";
+			cmd << cacheDownloadPath;
+			cmd << " ";
+			cmd << info.url;
+
+			if (!RunWithArgs(cmd.str()))
+			{
+				LogError() << "Failed to download file from '" << info.url;
+				return false;
+			}
 		}
 
 		if (!fs::is_regular_file(cacheDownloadPath))
@@ -115,24 +253,29 @@ bool LibrarySourceAWSEndpoint::install(const LibraryInstaller& installer, std::s
 
 		LogSuccess() << "Third-part library '" << info.name << "' downloaded";
 	}
-	else
+	else if (!streamed)
 	{
 		LogSuccess() << "Third-part library '" << info.name << "' already downloaded";
 	}
 
+	// never unpack archive that does not match the listing, remove it so it's downloaded again next time
+	if (!streamed && !VerifyLibraryArchiveFile(info, cacheDownloadPath))
+	{
+		LogError() << "Third-part library '" << info.name << "' failed verification, removing " << cacheDownloadPath;
+
+		std::error_code ec;
+		fs::remove(cacheDownloadPath, ec);
+		return false;
+	}
+
 	// unpack
+	if (!streamed)
 	{
 		// make sure library directory exists
 		if (!CreateDirectories(cacheUnpackPath))
 			return false;
 
-		std::stringstream cmd;
-		cmd << "tar -xvf ";
-		cmd << cacheDownloadPath;
-		cmd << " -C ";
-		cmd << cacheUnpackPath;
-
-		if (!RunWithArgs(cmd.str()))
+		if (!UnpackLibraryArchive(cacheDownloadPath, cacheUnpackPath))
 		{
 			LogError() << "Third-part library '" << info.name << "' failed to unpack to " << cacheUnpackPath;
 			return false;
@@ -141,6 +284,13 @@ bool LibrarySourceAWSEndpoint::install(const LibraryInstaller& installer, std::s
 		LogSuccess() << "Third-part library '" << info.name << "' unpacked";
 	}
 
+	// share identical files with other libraries and versions through the content store
+	{
+		ContentStore store(installer.buildContentStorePath());
+		if (!store.internDirectory(cacheUnpackPath))
+			LogWarning() << "Third-part library '" << info.name << "' could not be added to the content store, files will not be shared";
+	}
+
 	// verify
 	const auto libraryManifestPath = installer.buildLibraryManifestPath(info.name, info.version);
 	{
@@ -272,13 +422,7 @@ bool LibrarySourcePhysicalPackedDirectory::install(const LibraryInstaller& insta
 		if (!CreateDirectories(cacheUnpackPath))
 			return false;
 
-		std::stringstream cmd;
-		cmd << "tar -xvf ";
-		cmd << cacheDownloadPath;
-		cmd << " -C ";
-		cmd << cacheUnpackPath;
-
-		if (!RunWithArgs(cmd.str()))
+		if (!UnpackLibraryArchive(cacheDownloadPath, cacheUnpackPath))
 		{
 			LogError() << "Third-part library '" << info.name << "' failed to unpack to " << cacheUnpackPath;
 			return false;
@@ -287,6 +431,13 @@ bool LibrarySourcePhysicalPackedDirectory::install(const LibraryInstaller& insta
 		LogSuccess() << "Third-part library '" << info.name << "' unpacked";
 	}
 
+	// share identical files with other libraries and versions through the content store
+	{
+		ContentStore store(installer.buildContentStorePath());
+		if (!store.internDirectory(cacheUnpackPath))
+			LogWarning() << "Third-part library '" << info.name << "' could not be added to the content store, files will not be shared";
+	}
+
 	// verify
 	const auto libraryManifestPath = installer.buildLibraryManifestPath(info.name, info.version);
 	{
@@ -427,6 +578,11 @@ fs::path LibraryInstaller::buildLibraryDownloadPath(std::string_view name, std::
 	return fs::path(str.str()).make_preferred();
 }
 
+fs::path LibraryInstaller::buildContentStorePath() const
+{
+	return (m_cachePath / "objects").make_preferred();
+}
+
 fs::path LibraryInstaller::buildLibraryUnpackPath(std::string_view name, std::string_view version) const
 {
 	std::stringstream str;
@@ -486,4 +642,70 @@ bool LibraryInstaller::install(std::string_view name, fs::path* outInstalledPath
 	return false;
 }
 
+bool LibraryInstaller::installMany(const std::vector<std::string>& names, uint32_t maxJobs, std::vector<LibraryInstallResult>& outResults) const
+{
+	outResults.clear();
+	outResults.resize(names.size());
+
+	// same library may be requested more than once, install it only once
+	std::vector<size_t> uniqueIndices;
+	std::unordered_map<std::string, size_t> firstIndex;
+	for (size_t i = 0; i < names.size(); ++i)
+	{
+		outResults[i].name = names[i];
+		if (firstIndex.emplace(names[i], i).second)
+			uniqueIndices.push_back(i);
+	}
+
+	const auto numJobs = std::max<uint32_t>(1, std::min<uint32_t>(maxJobs, (uint32_t)uniqueIndices.size()));
+	LogInfo() << "Installing " << (uint32_t)uniqueIndices.size() << " third-party libraries using " << numJobs << " job(s)";
+
+	std::atomic<uint32_t> numFinished = 0;
+	RunParallel((uint32_t)uniqueIndices.size(), numJobs, [&](uint32_t index)
+		{
+			auto& result = outResults[uniqueIndices[index]];
+
+			// first error printed while installing is usually the cause, the following ones are the consequences
+			const auto startTime = std::chrono::steady_clock::now();
+			{
+				LogErrorCapture errors;
+				result.valid = install(result.name, &result.installedPath, &result.installedVersion, &result.requiredSystemPackages);
+
+				if (!result.valid)
+					result.error = errors.errors().empty() ? std::string("no library source could provide it") : errors.errors().front();
+			}
+			result.time = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+			const auto finished = ++numFinished;
+			if (result.valid)
+				LogInfo() << "[" << finished << "/" << (uint32_t)uniqueIndices.size() << "] Third-party library '" << result.name << "' ready (" << (uint32_t)(result.time * 1000.0) << " ms)";
+			else
+				LogError() << "[" << finished << "/" << (uint32_t)uniqueIndices.size() << "] Third-party library '" << result.name << "' failed to install";
+		});
+
+	// copy results for duplicated requests
+	for (size_t i = 0; i < names.size(); ++i)
+	{
+		const auto source = firstIndex[names[i]];
+		if (source != i)
+			outResults[i] = outResults[source];
+	}
+
+	// summary of failures, always in the requested order
+	std::vector<const LibraryInstallResult*> failed;
+	for (const auto index : uniqueIndices)
+		if (!outResults[index].valid)
+			failed.push_back(&outResults[index]);
+
+	if (!failed.empty())
+	{
+		LogError() << (uint32_t)failed.size() << " of " << (uint32_t)uniqueIndices.size() << " third-party libraries failed to install:";
+		for (const auto* result : failed)
+			LogError() << "  " << result->name << ": " << result->error;
+		return false;
+	}
+
+	return true;
+}
+
 //--
@@ -74,6 +74,17 @@ private:
 
 //--
 
+struct LibraryInstallResult
+{
+	std::string name;
+	bool valid = false;
+	fs::path installedPath;
+	std::string installedVersion;
+	std::unordered_set<std::string> requiredSystemPackages;
+	double time = 0.0;
+	std::string error; // why the install failed (first error reported by the library source)
+};
+
 class LibraryInstaller
 {
 public:
@@ -88,9 +99,13 @@ public:
 	fs::path buildLibraryDownloadPath(std::string_view name, std::string_view version) const;
 	fs::path buildLibraryUnpackPath(std::string_view name, std::string_view version) const;
 	fs::path buildLibraryManifestPath(std::string_view name, std::string_view version) const;
+	fs::path buildContentStorePath() const;
 
 	bool install(std::string_view name, fs::path* outInstalledPath, std::string* outInstalledVersion, std::unordered_set<std::string>* outRequiredSystemPacakges) const;
 
+	// install many libraries at once, up to maxJobs libraries are downloaded/unpacked/validated at the same time, results are in the same order as names
+	bool installMany(const std::vector<std::string>& names, uint32_t maxJobs, std::vector<LibraryInstallResult>& outResults) const;
+
 protected:
 	PlatformType m_platform;
 	fs::path m_cachePath;
@@ -3,6 +3,8 @@
 #include "externalLibrary.h"
 #include "externalLibraryRepository.h"
 #include "moduleConfiguration.h"
+#include "manifestCache.h"
+#include "profiler.h"
 
 //--
 
@@ -39,6 +41,8 @@ static std::string MakeLibraryPath(PlatformType platform, std::string_view name)
 
 bool ExternalLibraryReposistory::deployFiles(ConfigurationType configuration, const fs::path& targetPath) const
 {
+	PROFILE_SCOPE("ExternalLibraryReposistory::deployFiles");
+
 	bool valid = true;
 
 	for (const auto* dep : m_libraries)
@@ -47,12 +51,14 @@ bool ExternalLibraryReposistory::deployFiles(ConfigurationType configuration, co
 	return valid;
 }
 
-bool ExternalLibraryReposistory::installConfiguredLibraries(const ModuleConfigurationManifest& config)
+bool ExternalLibraryReposistory::installConfiguredLibraries(const ModuleConfigurationManifest& config, ManifestCache* cache)
 {
+	PROFILE_SCOPE("ExternalLibraryReposistory::installConfiguredLibraries");
+
 	bool valid = true;
 
 	for (const auto& lib : config.libraries)
-		valid &= installLibrary(lib.name, lib.path);
+		valid &= installLibrary(lib.name, lib.path, cache);
 
 	return valid;
 }
@@ -66,7 +72,7 @@ const ExternalLibraryManifest* ExternalLibraryReposistory::findLibrary(std::stri
 	return nullptr;
 }
 
-bool ExternalLibraryReposistory::installLibrary(std::string_view name, const fs::path& path)
+bool ExternalLibraryReposistory::installLibrary(std::string_view name, const fs::path& path, ManifestCache* cache)
 {
 	// library already installed
 	{
@@ -82,7 +88,7 @@ bool ExternalLibraryReposistory::installLibrary(std::string_view name, const fs:
 	}
 
 	// load the manifest
-	auto manifest = ExternalLibraryManifest::Load(path);
+	auto manifest = cache ? cache->loadLibrary(path) : ExternalLibraryManifest::Load(path);
 	if (!manifest)
 	{
 		LogError() << "Library '" << name << " at " << path << " has INVALID manifest file";
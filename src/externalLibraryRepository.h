@@ -4,6 +4,7 @@
 
 struct ExternalLibraryManifest;
 struct ModuleConfigurationManifest;
+class ManifestCache;
 
 class ExternalLibraryReposistory
 {
@@ -13,8 +14,9 @@ public:
 
 	inline const std::vector<ExternalLibraryManifest*>& libraries() const { return m_libraries; }
 
-	bool installConfiguredLibraries(const ModuleConfigurationManifest& config);
-	bool installLibrary(std::string_view name, const fs::path& path);
+	// manifests are loaded from the cache if given
+	bool installConfiguredLibraries(const ModuleConfigurationManifest& config, ManifestCache* cache = nullptr);
+	bool installLibrary(std::string_view name, const fs::path& path, ManifestCache* cache = nullptr);
 
 	const ExternalLibraryManifest* findLibrary(std::string_view name) const;
 
@@ -1,6 +1,7 @@
 #include "common.h"
 #include "utils.h"
 #include "fileGenerator.h"
+#include "profiler.h"
 
 //--
 
@@ -15,6 +16,8 @@ GeneratedFile* FileGenerator::createFile(const fs::path& path)
 
 bool FileGenerator::saveFiles(bool print)
 {
+    PROFILE_SCOPE("FileGenerator::saveFiles");
+
     bool valid = true;
 
     std::atomic<uint32_t> numSavedFiles = 0;
@@ -21,6 +21,8 @@ class FileGenerator
 public:
     GeneratedFile* createFile(const fs::path& path);
 
+    inline const std::vector<GeneratedFile*>& generatedFiles() const { return files; }
+
     bool saveFiles(bool print=true);
 
 private:
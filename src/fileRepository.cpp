@@ -1,6 +1,7 @@
 #include "common.h"
 #include "utils.h"
 #include "fileRepository.h"
+#include "profiler.h"
 
 #ifndef _WIN32
 #ifndef _POSIX_SOURCE
@@ -294,6 +295,8 @@ FileRepository::~FileRepository()
 
 bool FileRepository::initialize(const fs::path& executablePath, const fs::path& extractedFilesPath)
 {
+	PROFILE_SCOPE("FileRepository::initialize");
+
 	// if we have loose files always use them
 	{
 		const auto testDirectory = fs::weakly_canonical((executablePath.parent_path() / ".." / "files").make_preferred());
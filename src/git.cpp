@@ -2,6 +2,7 @@
 #include "utils.h"
 #include "json.h"
 #include "git.h"
+#include "httpClient.h"
 
 //--
 
@@ -192,6 +193,20 @@ std::string GitHubConfig::GetRemoteRepo(const fs::path& path)
 
 //--
 
+static HttpRequest MakeGitHubRequest(std::string_view method, std::string_view url, const RequestArgs& args, const std::string& token)
+{
+	std::stringstream fullUrl;
+	fullUrl << url;
+	args.print(fullUrl);
+
+	HttpRequest request;
+	request.method = std::string(method);
+	request.url = fullUrl.str();
+	request.headers.emplace_back("Accept", "application/vnd.github.v3+json");
+	request.headers.emplace_back("Authorization", Http_BasicAuthorization(token));
+	return request;
+}
+
 SimpleJsonToken GitHubConfig::handleResult(std::string_view url, std::string_view result) const
 {
 	if (result.empty())
@@ -237,8 +252,10 @@ SimpleJsonToken GitHubConfig::get(std::string_view endpointName, const RequestAr
 	args.print(txt);
 	txt << "\"";
 
+	const auto request = MakeGitHubRequest("GET", url, args, token);
+
 	std::stringstream result;
-	if (!RunWithArgsAndCaptureOutput(txt.str(), result))
+	if (!Http_SendOrRunCurl(request, txt.str(), result))
 	{
 		LogError() << "GitHub API request failed: " << url << ": " << result.str();
 		return nullptr;
@@ -260,8 +277,10 @@ SimpleJsonToken GitHubConfig::del(std::string_view endpointName, const RequestAr
 	args.print(txt);
 	txt << "\"";
 
+	const auto request = MakeGitHubRequest("DELETE", url, args, token);
+
 	std::stringstream result;
-	if (!RunWithArgsAndCaptureOutput(txt.str(), result))
+	if (!Http_SendOrRunCurl(request, txt.str(), result))
 	{
 		LogError() << "GitHub API request failed: " << url << ": " << result.str();
 		return nullptr;
@@ -282,8 +301,11 @@ SimpleJsonToken GitHubConfig::post(std::string_view endpointName, const SimpleJs
 	txt << "-d " << EscapeArgument(json.toString()) << " ";
 	txt << url;
 
+	auto request = MakeGitHubRequest("POST", url, RequestArgs(), token);
+	request.body = json.toString();
+
 	std::stringstream result;
-	if (!RunWithArgsAndCaptureOutput(txt.str(), result))
+	if (!Http_SendOrRunCurl(request, txt.str(), result))
 	{
 		LogError() << "GitHub API request failed: " << url << ": " << result.str();
 		return nullptr;
@@ -304,8 +326,11 @@ SimpleJsonToken GitHubConfig::patch(std::string_view endpointName, const SimpleJ
 	txt << "-d " << EscapeArgument(json.toString()) << " ";
 	txt << url;
 
+	auto request = MakeGitHubRequest("PATCH", url, RequestArgs(), token);
+	request.body = json.toString();
+
 	std::stringstream result;
-	if (!RunWithArgsAndCaptureOutput(txt.str(), result))
+	if (!Http_SendOrRunCurl(request, txt.str(), result))
 	{
 		LogError() << "GitHub API request failed: " << url << ": " << result.str();
 		return nullptr;
@@ -330,8 +355,22 @@ SimpleJsonToken GitHubConfig::postFile(std::string_view endpointName, const Requ
 	txt << "\" ";
 	txt << "--data-binary @\"" << EscapeArgument(path.u8string()) << "\" ";
 
+	auto request = MakeGitHubRequest("POST", url, args, token);
+	request.headers.emplace_back("Content-Type", "application/zip");
+	if (Http_CanHandleInProcess(request.url))
+	{
+		std::vector<uint8_t> data;
+		if (!LoadFileToBuffer(path, data))
+		{
+			LogError() << "Unable to load file " << path << " for upload";
+			return nullptr;
+		}
+
+		request.body.assign((const char*)data.data(), data.size());
+	}
+
 	std::stringstream result;
-	if (!RunWithArgsAndCaptureOutput(txt.str(), result))
+	if (!Http_SendOrRunCurl(request, txt.str(), result))
 	{
 		LogError() << "GitHub API request failed: " << url << ": " << result.str();
 		return nullptr;
@@ -340,35 +379,93 @@ SimpleJsonToken GitHubConfig::postFile(std::string_view endpointName, const Requ
 	return handleResult(url, result.str());
 }
 
+bool GitHubConfig::getPages(std::string_view endpointName, const RequestArgs& args, int firstPage, int numPages, std::vector<SimpleJsonToken>& outPages) const
+{
+	const auto url = endpoint(endpointName);
+
+	std::vector<HttpRequest> requests;
+	for (int i = 0; i < numPages; ++i)
+	{
+		auto pageArgs = args;
+		pageArgs.setNumber("page", firstPage + i);
+		requests.push_back(MakeGitHubRequest("GET", url, pageArgs, token));
+	}
+
+	std::vector<HttpResponse> responses;
+	if (Http_CanHandleInProcess(url) && Http_SendPipelined(requests, responses))
+	{
+		for (size_t i = 0; i < responses.size(); ++i)
+		{
+			const auto page = handleResult(requests[i].url, responses[i].body);
+			if (!page)
+				return false;
+
+			outPages.push_back(page);
+		}
+
+		return true;
+	}
+
+	for (int i = 0; i < numPages; ++i)
+	{
+		auto pageArgs = args;
+		pageArgs.setNumber("page", firstPage + i);
+
+		const auto page = get(endpointName, pageArgs);
+		if (!page)
+			return false;
+
+		outPages.push_back(page);
+	}
+
+	return true;
+}
+
 //--
 
-bool GitApi_ListReleases(const GitHubConfig& git, std::vector<std::string>& outReleases)
+// number of pages of a listing requested at once, the pages past the end are just empty
+static const int GITHUB_PAGES_PER_BATCH = 4;
+
+// visit all pages of a listing until the first empty one
+static bool GitApi_VisitPages(const GitHubConfig& git, std::string_view endpointName, const std::function<bool(const SimpleJsonToken& page)>& func)
 {
-	int pageIndex = 1;
-	for (;;++pageIndex)
+	RequestArgs args;
+	args.setNumber("per_page", 100);
+
+	for (int firstPage = 1;; firstPage += GITHUB_PAGES_PER_BATCH)
 	{
-		RequestArgs args;
-		args.setNumber("per_page", 100);
-		args.setNumber("page", pageIndex);
+		std::vector<SimpleJsonToken> pages;
+		if (!git.getPages(endpointName, args, firstPage, GITHUB_PAGES_PER_BATCH, pages))
+			return false;
 
-		const auto result = git.get("tags", args);
-		if (!result)
+		for (const auto& page : pages)
 		{
-			LogError() << "GitHub API failed to get list of releases";
-			return false;
+			if (page.values().empty())
+				return true;
+
+			if (!func(page))
+				return false;
 		}
+	}
+}
 
-		if (result.values().empty())
+bool GitApi_ListReleases(const GitHubConfig& git, std::vector<std::string>& outReleases)
+{
+	const auto valid = GitApi_VisitPages(git, "tags", [&outReleases](const SimpleJsonToken& page)
 		{
-			LogInfo() << "Got empty result at page " << pageIndex << ", collected " << outReleases.size() << " release tags so far";
-			break;
-		}
+			for (const auto& tag : page.values())
+				if (const auto name = tag["tag_name"])
+					outReleases.push_back(name.str());
+			return true;
+		});
 
-		for (const auto& tag : result.values())
-			if (const auto name = tag["tag_name"])
-				outReleases.push_back(name.str());
+	if (!valid)
+	{
+		LogError() << "GitHub API failed to get list of releases";
+		return false;
 	}
 
+	LogInfo() << "Collected " << outReleases.size() << " release tags";
 	return true;
 }
 
@@ -396,81 +493,68 @@ bool GitApi_CopyReleaseInfo(const SimpleJsonToken& tag, GitReleaseInfo& outInfo)
 
 bool GitApi_GetAllReleaseInfos(const GitHubConfig& git, std::vector<GitReleaseInfo>& outInfos)
 {
-	int pageIndex = 1;
-	for (;; ++pageIndex)
-	{
-		RequestArgs args;
-		args.setNumber("per_page", 100);
-		args.setNumber("page", pageIndex);
-
-		const auto result = git.get("releases", args);
-		if (!result)
-		{
-			LogError() << "GitHub API failed to get list of releases";
-			return false;
-		}
-
-		if (result.values().empty())
-			break;
-
-		for (const auto& tag : result.values())
+	bool validInfos = true;
+	const auto valid = GitApi_VisitPages(git, "releases", [&outInfos, &validInfos](const SimpleJsonToken& page)
 		{
-			if (const auto name = tag["tag_name"])
+			for (const auto& tag : page.values())
 			{
-				GitReleaseInfo outInfo;
-				if (!GitApi_CopyReleaseInfo(tag, outInfo))
-					return false;
+				if (const auto name = tag["tag_name"])
+				{
+					GitReleaseInfo outInfo;
+					if (!GitApi_CopyReleaseInfo(tag, outInfo))
+					{
+						validInfos = false;
+						return false;
+					}
 
-				outInfos.push_back(outInfo);
+					outInfos.push_back(outInfo);
+				}
 			}
-		}
-	}
 
-	return true;
+			return true;
+		});
+
+	if (!valid && validInfos)
+		LogError() << "GitHub API failed to get list of releases";
+
+	return valid;
 }
 
 bool GitApi_GetHighestReleaseNumber(const GitHubConfig& git, std::string_view prefix, uint32_t versionParts, uint32_t& outNumber)
 {
-	int pageIndex = 1;
-	for (;; ++pageIndex)
-	{
-		RequestArgs args;
-		args.setNumber("per_page", 100);
-		args.setNumber("page", pageIndex);
-
-		const auto result = git.get("tags", args);
-		if (!result)
-		{
-			LogError() << "GitHub API failed to get list of releases";
-			return false;
-		}
-
-		if (result.values().empty())
-			break;
-		
-		for (const auto& tag : result.values())
+	const auto valid = GitApi_VisitPages(git, "tags", [prefix, versionParts, &outNumber](const SimpleJsonToken& page)
 		{
-			if (const auto name = tag["name"])
+			for (const auto& tag : page.values())
 			{
-				if (BeginsWith(name.str(), prefix))
+				if (const auto name = tag["name"])
 				{
-					std::vector<std::string_view> parts;
-					SplitString(name.str().c_str() + prefix.size(), ".", parts);
-
-					if (parts.size() == versionParts)
+					if (BeginsWith(name.str(), prefix))
 					{
-						uint32_t number = 0;
-						if (1 == sscanf_s(std::string(parts[versionParts-1]).c_str(), "%u", &number))
+						std::vector<std::string_view> parts;
+						SplitString(name.str().c_str() + prefix.size(), ".", parts);
+
+						if (parts.size() == versionParts)
 						{
-							if (number > outNumber)
+							uint32_t number = 0;
+							if (1 == sscanf_s(std::string(parts[versionParts-1]).c_str(), "%u", &number))
 							{
-								outNumber = number;
+								if (number > outNumber)
+								{
+									outNumber = number;
+								}
 							}
 						}
 					}
 				}
 			}
-		}
+
+			return true;
+		});
+
+	if (!valid)
+	{
+		LogError() << "GitHub API failed to get list of releases";
+		return false;
 	}
 
 	return true;
@@ -48,6 +48,9 @@ struct GitHubConfig
 	SimpleJsonToken del(std::string_view endpoint, const RequestArgs& args = RequestArgs()) const;
 	SimpleJsonToken postFile(std::string_view endpoint, const RequestArgs& args, const fs::path& path) const;
 
+	// get consecutive pages of a paginated listing ("page" argument is set for each), the requests are pipelined when possible
+	bool getPages(std::string_view endpoint, const RequestArgs& args, int firstPage, int numPages, std::vector<SimpleJsonToken>& outPages) const;
+
 	SimpleJsonToken handleResult(std::string_view url, std::string_view result) const;
 
 	//--
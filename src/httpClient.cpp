@@ -0,0 +1,1037 @@
+#include "common.h"
+#include "utils.h"
+#include "httpClient.h"
+
+#include <mutex>
+#include <chrono>
+
+#ifdef _WIN32
+	#include <winsock2.h>
+	#include <ws2tcpip.h>
+	typedef SOCKET HttpSocket;
+	#define INVALID_HTTP_SOCKET INVALID_SOCKET
+	#define CloseHttpSocket closesocket
+#else
+	#include <sys/types.h>
+	#include <sys/socket.h>
+	#include <sys/time.h>
+	#include <netdb.h>
+	#include <netinet/in.h>
+	#include <netinet/tcp.h>
+	#include <unistd.h>
+	typedef int HttpSocket;
+	#define INVALID_HTTP_SOCKET -1
+	#define CloseHttpSocket close
+#endif
+
+#ifdef MSG_NOSIGNAL
+	#define HTTP_SEND_FLAGS MSG_NOSIGNAL
+#else
+	#define HTTP_SEND_FLAGS 0
+#endif
+
+#ifdef ONION_HTTP_TLS
+	#include <openssl/ssl.h>
+	#include <openssl/err.h>
+	#include <openssl/x509v3.h>
+#endif
+
+//--
+
+static const uint32_t HTTP_TIMEOUT_SECONDS = 60;
+static const uint32_t HTTP_MAX_IDLE_CONNECTIONS_PER_HOST = 8;
+static const uint32_t HTTP_MAX_REDIRECTS = 5;
+static const uint32_t HTTP_READ_CHUNK = 64 * 1024;
+
+//--
+
+std::string_view HttpResponse::header(std::string_view name) const
+{
+	const auto it = headers.find(std::string(name));
+	if (it != headers.end())
+		return it->second;
+	return "";
+}
+
+//--
+
+struct HttpAddress
+{
+	bool secure = false; // https
+	std::string host;
+	std::string port = "80";
+	std::string path = "/";
+
+	inline std::string key() const { return (secure ? "https://" : "http://") + host + ":" + port; }
+	inline bool defaultPort() const { return port == (secure ? "443" : "80"); }
+};
+
+static bool ParseHttpURL(std::string_view url, HttpAddress& outAddress)
+{
+	std::string_view hostAndPath;
+	if (BeginsWith(url, "http://"))
+	{
+		hostAndPath = url.substr(7);
+	}
+#ifdef ONION_HTTP_TLS
+	else if (BeginsWith(url, "https://"))
+	{
+		hostAndPath = url.substr(8);
+		outAddress.secure = true;
+		outAddress.port = "443";
+	}
+#endif
+	else
+	{
+		return false;
+	}
+
+	const auto pathStart = hostAndPath.find('/');
+	if (pathStart != std::string_view::npos)
+	{
+		outAddress.path = std::string(hostAndPath.substr(pathStart));
+		hostAndPath = hostAndPath.substr(0, pathStart);
+	}
+
+	const auto portStart = hostAndPath.find(':');
+	if (portStart != std::string_view::npos)
+	{
+		outAddress.port = std::string(hostAndPath.substr(portStart + 1));
+		hostAndPath = hostAndPath.substr(0, portStart);
+	}
+
+	outAddress.host = std::string(hostAndPath);
+	return !outAddress.host.empty() && !outAddress.port.empty();
+}
+
+//--
+
+#ifdef ONION_HTTP_TLS
+
+// client side TLS shared by all connections, servers are verified against the system certificates (SSL_CERT_FILE/SSL_CERT_DIR are respected)
+// sessions are remembered per host so a new connection to the same host skips the full handshake
+class HttpTlsContext
+{
+public:
+	// NOTE: never destroyed, pooled connections still use it when the pool is destroyed at exit
+	static HttpTlsContext& GetInstance()
+	{
+		static auto* theInstance = new HttpTlsContext();
+		return *theInstance;
+	}
+
+	SSL* connect(HttpSocket socket, const HttpAddress& address)
+	{
+		if (!m_context)
+		{
+			LogError() << "TLS is not available, unable to connect to '" << address.key() << "'";
+			return nullptr;
+		}
+
+		auto* ssl = SSL_new(m_context);
+		if (!ssl)
+			return nullptr;
+
+		if (m_socketMethod)
+		{
+			auto* bio = BIO_new(m_socketMethod);
+			BIO_set_fd(bio, (int)socket, BIO_NOCLOSE);
+			SSL_set_bio(ssl, bio, bio);
+		}
+		else
+		{
+			SSL_set_fd(ssl, (int)socket);
+		}
+
+		SSL_set_tlsext_host_name(ssl, address.host.c_str());
+		SSL_set1_host(ssl, address.host.c_str());
+
+		{
+			std::lock_guard<std::mutex> lock(m_lock);
+
+			auto it = m_sessions.find(address.key());
+			if (it != m_sessions.end())
+				SSL_set_session(ssl, it->second);
+		}
+
+		ERR_clear_error();
+		if (1 != SSL_connect(ssl))
+		{
+			const auto verifyResult = SSL_get_verify_result(ssl);
+			if (verifyResult != X509_V_OK)
+			{
+				LogError() << "Certificate of '" << address.host << "' was not accepted: " << X509_verify_cert_error_string(verifyResult);
+			}
+			else
+			{
+				char txt[256];
+				ERR_error_string_n(ERR_get_error(), txt, sizeof(txt));
+				LogError() << "TLS handshake with '" << address.key() << "' failed: " << txt;
+			}
+
+			ERR_clear_error();
+			SSL_free(ssl);
+			return nullptr;
+		}
+
+		return ssl;
+	}
+
+	void storeSession(const std::string& key, SSL* ssl)
+	{
+		auto* session = SSL_get1_session(ssl);
+		if (!session)
+			return;
+
+		if (!SSL_SESSION_is_resumable(session))
+		{
+			SSL_SESSION_free(session);
+			return;
+		}
+
+		std::lock_guard<std::mutex> lock(m_lock);
+
+		auto& entry = m_sessions[key];
+		if (entry)
+			SSL_SESSION_free(entry);
+		entry = session;
+	}
+
+private:
+	SSL_CTX* m_context = nullptr;
+	BIO_METHOD* m_socketMethod = nullptr; // socket BIO that does not raise SIGPIPE, null if plain socket BIO is fine
+
+	std::mutex m_lock;
+	std::unordered_map<std::string, SSL_SESSION*> m_sessions;
+
+	HttpTlsContext()
+	{
+		m_context = SSL_CTX_new(TLS_client_method());
+		if (!m_context)
+		{
+			LogError() << "Failed to initialize TLS";
+			return;
+		}
+
+		SSL_CTX_set_min_proto_version(m_context, TLS1_2_VERSION);
+		SSL_CTX_set_verify(m_context, SSL_VERIFY_PEER, nullptr);
+		SSL_CTX_set_mode(m_context, SSL_MODE_AUTO_RETRY);
+
+		if (1 != SSL_CTX_set_default_verify_paths(m_context))
+			LogWarning() << "Unable to load system certificates, TLS connections will fail";
+
+#ifdef MSG_NOSIGNAL
+		// OpenSSL writes to the socket with plain write(), a server closing the connection would kill us with SIGPIPE
+		const auto* socketMethod = BIO_s_socket();
+		m_socketMethod = BIO_meth_new(BIO_get_new_index() | BIO_TYPE_SOURCE_SINK | BIO_TYPE_DESCRIPTOR, "onion socket");
+		BIO_meth_set_create(m_socketMethod, BIO_meth_get_create(socketMethod));
+		BIO_meth_set_destroy(m_socketMethod, BIO_meth_get_destroy(socketMethod));
+		BIO_meth_set_ctrl(m_socketMethod, BIO_meth_get_ctrl(socketMethod));
+		BIO_meth_set_read(m_socketMethod, BIO_meth_get_read(socketMethod));
+		BIO_meth_set_write(m_socketMethod, [](BIO* bio, const char* data, int size) -> int
+			{
+				int socket = -1;
+				BIO_get_fd(bio, &socket);
+				BIO_clear_retry_flags(bio);
+				return (int)::send(socket, data, size, HTTP_SEND_FLAGS);
+			});
+#endif
+	}
+};
+
+#endif
+
+//--
+
+struct HttpConnection
+{
+	HttpSocket socket = INVALID_HTTP_SOCKET;
+	std::string key;
+	std::string buffer; // received but not yet consumed data
+	size_t bufferPos = 0;
+	uint32_t numRequests = 0;
+
+#ifdef ONION_HTTP_TLS
+	SSL* ssl = nullptr; // only for https
+#endif
+
+	~HttpConnection()
+	{
+#ifdef ONION_HTTP_TLS
+		if (ssl)
+		{
+			// without a shutdown OpenSSL treats the session as broken and it could not be resumed by the next connection
+			SSL_set_quiet_shutdown(ssl, 1);
+			SSL_shutdown(ssl);
+			SSL_free(ssl);
+		}
+#endif
+
+		if (socket != INVALID_HTTP_SOCKET)
+			CloseHttpSocket(socket);
+	}
+
+	bool writeAll(std::string_view data)
+	{
+		while (!data.empty())
+		{
+#ifdef ONION_HTTP_TLS
+			const auto written = ssl
+				? SSL_write(ssl, data.data(), (int)std::min<size_t>(data.size(), 1U << 30))
+				: ::send(socket, data.data(), (int)std::min<size_t>(data.size(), 1U << 30), HTTP_SEND_FLAGS);
+#else
+			const auto written = ::send(socket, data.data(), (int)std::min<size_t>(data.size(), 1U << 30), HTTP_SEND_FLAGS);
+#endif
+			if (written <= 0)
+				return false;
+
+			data = data.substr(written);
+		}
+
+		return true;
+	}
+
+	bool readMore()
+	{
+		if (bufferPos > 0)
+		{
+			buffer.erase(0, bufferPos);
+			bufferPos = 0;
+		}
+
+		char temp[HTTP_READ_CHUNK];
+#ifdef ONION_HTTP_TLS
+		const auto received = ssl ? SSL_read(ssl, temp, sizeof(temp)) : ::recv(socket, temp, sizeof(temp), 0);
+#else
+		const auto received = ::recv(socket, temp, sizeof(temp), 0);
+#endif
+		if (received <= 0)
+			return false;
+
+		buffer.append(temp, received);
+		return true;
+	}
+
+	bool readLine(std::string& outLine)
+	{
+		for (;;)
+		{
+			const auto end = buffer.find("\r\n", bufferPos);
+			if (end != std::string::npos)
+			{
+				outLine = buffer.substr(bufferPos, end - bufferPos);
+				bufferPos = end + 2;
+				return true;
+			}
+
+			if (!readMore())
+				return false;
+		}
+	}
+
+	bool readBytes(uint64_t size, const std::function<bool(const uint8_t*, uint64_t)>& sink)
+	{
+		while (size > 0)
+		{
+			if (bufferPos == buffer.size())
+			{
+				if (!readMore())
+					return false;
+			}
+
+			const auto available = std::min<uint64_t>(size, buffer.size() - bufferPos);
+			if (!sink((const uint8_t*)buffer.data() + bufferPos, available))
+				return false;
+
+			bufferPos += available;
+			size -= available;
+		}
+
+		return true;
+	}
+
+	bool readUntilClosed(const std::function<bool(const uint8_t*, uint64_t)>& sink)
+	{
+		for (;;)
+		{
+			if (bufferPos < buffer.size())
+			{
+				if (!sink((const uint8_t*)buffer.data() + bufferPos, buffer.size() - bufferPos))
+					return false;
+
+				bufferPos = buffer.size();
+			}
+
+			if (!readMore())
+				return true;
+		}
+	}
+};
+
+//--
+
+class HttpConnectionPool
+{
+public:
+	HttpConnectionPool()
+	{
+#ifdef _WIN32
+		WSADATA data;
+		WSAStartup(MAKEWORD(2, 2), &data);
+#endif
+
+#ifdef ONION_HTTP_TLS
+		// OpenSSL cleans up at exit, initializing it first makes sure that happens after the pooled connections are closed
+		OPENSSL_init_ssl(0, nullptr);
+#endif
+	}
+
+	~HttpConnectionPool()
+	{
+		closeAll();
+	}
+
+	static HttpConnectionPool& GetInstance()
+	{
+		static HttpConnectionPool theInstance;
+		return theInstance;
+	}
+
+	HttpConnection* acquire(const HttpAddress& address, bool& outReused)
+	{
+		const auto key = address.key();
+
+		{
+			std::lock_guard<std::mutex> lock(m_lock);
+
+			auto& idle = m_idle[key];
+			if (!idle.empty())
+			{
+				auto* ret = idle.back();
+				idle.pop_back();
+				outReused = true;
+				return ret;
+			}
+		}
+
+		outReused = false;
+		return connect(address);
+	}
+
+	void release(HttpConnection* connection, bool keepAlive)
+	{
+#ifdef ONION_HTTP_TLS
+		if (connection->ssl)
+			HttpTlsContext::GetInstance().storeSession(connection->key, connection->ssl);
+#endif
+
+		if (keepAlive && connection->bufferPos == connection->buffer.size())
+		{
+			connection->buffer.clear();
+			connection->bufferPos = 0;
+
+			std::lock_guard<std::mutex> lock(m_lock);
+
+			auto& idle = m_idle[connection->key];
+			if (idle.size() < HTTP_MAX_IDLE_CONNECTIONS_PER_HOST)
+			{
+				idle.push_back(connection);
+				return;
+			}
+		}
+
+		delete connection;
+	}
+
+	void closeAll()
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+
+		for (auto& it : m_idle)
+			for (auto* connection : it.second)
+				delete connection;
+
+		m_idle.clear();
+	}
+
+private:
+	std::mutex m_lock;
+	std::unordered_map<std::string, std::vector<HttpConnection*>> m_idle;
+
+	static HttpConnection* connect(const HttpAddress& address)
+	{
+		addrinfo hints;
+		memset(&hints, 0, sizeof(hints));
+		hints.ai_family = AF_UNSPEC;
+		hints.ai_socktype = SOCK_STREAM;
+
+		addrinfo* result = nullptr;
+		if (0 != getaddrinfo(address.host.c_str(), address.port.c_str(), &hints, &result) || !result)
+		{
+			LogError() << "Unable to resolve HTTP host '" << address.host << "'";
+			return nullptr;
+		}
+
+		HttpSocket socketHandle = INVALID_HTTP_SOCKET;
+		for (auto* it = result; it; it = it->ai_next)
+		{
+			socketHandle = ::socket(it->ai_family, it->ai_socktype, it->ai_protocol);
+			if (socketHandle == INVALID_HTTP_SOCKET)
+				continue;
+
+			if (0 == ::connect(socketHandle, it->ai_addr, (int)it->ai_addrlen))
+				break;
+
+			CloseHttpSocket(socketHandle);
+			socketHandle = INVALID_HTTP_SOCKET;
+		}
+
+		freeaddrinfo(result);
+
+		if (socketHandle == INVALID_HTTP_SOCKET)
+		{
+			LogError() << "Unable to connect to HTTP host '" << address.key() << "'";
+			return nullptr;
+		}
+
+		int noDelay = 1;
+		setsockopt(socketHandle, IPPROTO_TCP, TCP_NODELAY, (const char*)&noDelay, sizeof(noDelay));
+
+#ifdef SO_NOSIGPIPE
+		int noSigPipe = 1;
+		setsockopt(socketHandle, SOL_SOCKET, SO_NOSIGPIPE, (const char*)&noSigPipe, sizeof(noSigPipe));
+#endif
+
+#ifdef _WIN32
+		DWORD timeout = HTTP_TIMEOUT_SECONDS * 1000;
+#else
+		timeval timeout;
+		timeout.tv_sec = HTTP_TIMEOUT_SECONDS;
+		timeout.tv_usec = 0;
+#endif
+		setsockopt(socketHandle, SOL_SOCKET, SO_RCVTIMEO, (const char*)&timeout, sizeof(timeout));
+		setsockopt(socketHandle, SOL_SOCKET, SO_SNDTIMEO, (const char*)&timeout, sizeof(timeout));
+
+		auto* ret = new HttpConnection();
+		ret->socket = socketHandle;
+		ret->key = address.key();
+
+#ifdef ONION_HTTP_TLS
+		if (address.secure)
+		{
+			ret->ssl = HttpTlsContext::GetInstance().connect(socketHandle, address);
+			if (!ret->ssl)
+			{
+				delete ret;
+				return nullptr;
+			}
+		}
+#endif
+
+		return ret;
+	}
+};
+
+//--
+
+static void PrintRequest(std::stringstream& f, const HttpRequest& request, const HttpAddress& address)
+{
+	f << request.method << " " << address.path << " HTTP/1.1\r\n";
+
+	f << "Host: " << address.host;
+	if (!address.defaultPort())
+		f << ":" << address.port;
+	f << "\r\n";
+
+	f << "User-Agent: onion\r\n";
+	f << "Connection: keep-alive\r\n";
+
+	for (const auto& header : request.headers)
+		f << header.first << ": " << header.second << "\r\n";
+
+	if (!request.body.empty() || request.method == "POST" || request.method == "PUT" || request.method == "PATCH")
+		f << "Content-Length: " << request.body.size() << "\r\n";
+
+	f << "\r\n";
+	f << request.body;
+}
+
+// NOTE: not using Trim() as it returns empty string for single character values ("Content-Length: 5")
+static std::string_view TrimHeaderPart(std::string_view txt)
+{
+	while (!txt.empty() && (txt.front() == ' ' || txt.front() == '\t'))
+		txt = txt.substr(1);
+	while (!txt.empty() && (txt.back() == ' ' || txt.back() == '\t'))
+		txt = txt.substr(0, txt.length() - 1);
+	return txt;
+}
+
+static bool ReadResponse(HttpConnection& connection, const HttpRequest& request, HttpResponse& outResponse, bool& outKeepAlive, bool& outReceivedAnything)
+{
+	std::string line;
+	bool http10 = false;
+
+	// status line, skip any interim "100 Continue" responses
+	for (;;)
+	{
+		if (!connection.readLine(line))
+			return false;
+
+		outReceivedAnything = true;
+
+		if (!BeginsWith(line, "HTTP/1."))
+		{
+			LogError() << "Invalid HTTP response status line '" << line << "'";
+			return false;
+		}
+
+		http10 = BeginsWith(line, "HTTP/1.0");
+		outResponse.status = atoi(std::string(PartAfter(line, " ")).c_str());
+		outResponse.headers.clear();
+
+		for (;;)
+		{
+			if (!connection.readLine(line))
+				return false;
+
+			if (line.empty())
+				break;
+
+			const auto separator = line.find(':');
+			if (separator != std::string::npos)
+			{
+				const auto name = ToLower(TrimHeaderPart(std::string_view(line).substr(0, separator)));
+				const auto value = TrimHeaderPart(std::string_view(line).substr(separator + 1));
+				outResponse.headers[name] = std::string(value);
+			}
+		}
+
+		if (outResponse.status != 100)
+			break;
+	}
+
+	// determine if connection can be reused
+	const auto connectionHeader = ToLower(outResponse.header("connection"));
+	if (http10)
+		outKeepAlive = (connectionHeader == "keep-alive");
+	else
+		outKeepAlive = (connectionHeader != "close");
+
+	// body
+	std::function<bool(const uint8_t*, uint64_t)> sink;
+	if (request.bodySink)
+	{
+		sink = request.bodySink;
+	}
+	else
+	{
+		sink = [&outResponse](const uint8_t* data, uint64_t size)
+		{
+			outResponse.body.append((const char*)data, size);
+			return true;
+		};
+	}
+
+	if (request.method == "HEAD" || outResponse.status == 204 || outResponse.status == 304 || (outResponse.status >= 100 && outResponse.status < 200))
+		return true;
+
+	if (ToLower(outResponse.header("transfer-encoding")).find("chunked") != std::string::npos)
+	{
+		for (;;)
+		{
+			if (!connection.readLine(line))
+				return false;
+
+			const auto size = strtoull(line.c_str(), nullptr, 16); // stops at chunk extensions
+			if (size == 0)
+			{
+				// trailers
+				for (;;)
+				{
+					if (!connection.readLine(line))
+						return false;
+					if (line.empty())
+						return true;
+				}
+			}
+
+			if (!connection.readBytes(size, sink))
+				return false;
+
+			if (!connection.readLine(line) || !line.empty())
+				return false;
+		}
+	}
+
+	const auto contentLength = outResponse.header("content-length");
+	if (!contentLength.empty())
+	{
+		const auto size = strtoull(std::string(contentLength).c_str(), nullptr, 10);
+		return connection.readBytes(size, sink);
+	}
+
+	outKeepAlive = false;
+	return connection.readUntilClosed(sink);
+}
+
+static bool SendWithConnection(HttpConnection* connection, const HttpRequest& request, const HttpAddress& address, HttpResponse& outResponse, bool& outKeepAlive, bool& outReceivedAnything)
+{
+	std::stringstream txt;
+	PrintRequest(txt, request, address);
+
+	if (!connection->writeAll(txt.str()))
+		return false;
+
+	connection->numRequests += 1;
+	return ReadResponse(*connection, request, outResponse, outKeepAlive, outReceivedAnything);
+}
+
+//--
+
+bool Http_CanHandleInProcess(std::string_view url)
+{
+	const char* forceCurl = std::getenv("ONION_HTTP_USE_CURL");
+	if (forceCurl && *forceCurl && *forceCurl != '0')
+		return false;
+
+	HttpAddress address;
+	if (!ParseHttpURL(url, address))
+		return false;
+
+	// curl knows how to go through a proxy, we don't
+	const char* proxyVariables[] = { address.secure ? "https_proxy" : "http_proxy", address.secure ? "HTTPS_PROXY" : "HTTP_PROXY", "all_proxy", "ALL_PROXY" };
+	for (const auto* name : proxyVariables)
+	{
+		const char* proxy = std::getenv(name);
+		if (proxy && *proxy)
+			return false;
+	}
+
+	return true;
+}
+
+bool Http_Send(const HttpRequest& request, HttpResponse& outResponse)
+{
+	HttpAddress address;
+	if (!ParseHttpURL(request.url, address))
+	{
+		LogError() << "URL '" << request.url << "' is not supported by the internal HTTP client";
+		return false;
+	}
+
+	auto& pool = HttpConnectionPool::GetInstance();
+
+	// idle connection may have been closed by the server in the mean time, in that case retry once on a fresh one
+	for (uint32_t attempt = 0; attempt < 2; ++attempt)
+	{
+		bool reused = false;
+		auto* connection = pool.acquire(address, reused);
+		if (!connection)
+			return false;
+
+		bool keepAlive = false;
+		bool receivedAnything = false;
+		outResponse = HttpResponse();
+		if (SendWithConnection(connection, request, address, outResponse, keepAlive, receivedAnything))
+		{
+			pool.release(connection, keepAlive);
+			return true;
+		}
+
+		pool.release(connection, false);
+
+		if (!reused || receivedAnything)
+			break;
+	}
+
+	LogError() << "HTTP request " << request.method << " '" << request.url << "' failed";
+	return false;
+}
+
+bool Http_SendPipelined(const std::vector<HttpRequest>& requests, std::vector<HttpResponse>& outResponses)
+{
+	outResponses.clear();
+	outResponses.resize(requests.size());
+
+	// group requests by host, only idempotent requests without streaming sinks are pipelined
+	std::vector<std::string> hostOrder;
+	std::unordered_map<std::string, std::vector<size_t>> hostRequests;
+	std::vector<size_t> serialRequests;
+	std::vector<HttpAddress> addresses(requests.size());
+
+	for (size_t i = 0; i < requests.size(); ++i)
+	{
+		const auto& request = requests[i];
+		if (!ParseHttpURL(request.url, addresses[i]))
+		{
+			LogError() << "URL '" << request.url << "' is not supported by the internal HTTP client";
+			return false;
+		}
+
+		if ((request.method == "GET" || request.method == "HEAD") && !request.bodySink)
+		{
+			const auto key = addresses[i].key();
+			auto& list = hostRequests[key];
+			if (list.empty())
+				hostOrder.push_back(key);
+			list.push_back(i);
+		}
+		else
+		{
+			serialRequests.push_back(i);
+		}
+	}
+
+	auto& pool = HttpConnectionPool::GetInstance();
+
+	for (const auto& key : hostOrder)
+	{
+		const auto& indices = hostRequests[key];
+
+		// write all requests at once, responses come back in the same order
+		bool reused = false;
+		auto* connection = pool.acquire(addresses[indices.front()], reused);
+
+		size_t numCompleted = 0;
+		if (connection)
+		{
+			std::stringstream txt;
+			for (const auto index : indices)
+				PrintRequest(txt, requests[index], addresses[index]);
+
+			bool keepAlive = connection->writeAll(txt.str());
+			while (numCompleted < indices.size() && keepAlive)
+			{
+				const auto index = indices[numCompleted];
+
+				bool receivedAnything = false;
+				if (!ReadResponse(*connection, requests[index], outResponses[index], keepAlive, receivedAnything))
+				{
+					outResponses[index] = HttpResponse();
+					keepAlive = false;
+					break;
+				}
+
+				connection->numRequests += 1;
+				numCompleted += 1;
+			}
+
+			pool.release(connection, keepAlive && numCompleted == indices.size());
+		}
+
+		// server closed the connection before answering everything (or it was a stale one), send the rest normally
+		for (size_t i = numCompleted; i < indices.size(); ++i)
+			serialRequests.push_back(indices[i]);
+	}
+
+	bool valid = true;
+	std::sort(serialRequests.begin(), serialRequests.end());
+	for (const auto index : serialRequests)
+		valid &= Http_Send(requests[index], outResponses[index]);
+
+	return valid;
+}
+
+bool Http_SendOrRunCurl(const HttpRequest& request, std::string_view curlCommand, std::stringstream& outResult)
+{
+	if (Http_CanHandleInProcess(request.url))
+	{
+		HttpResponse response;
+		if (Http_Send(request, response))
+		{
+			outResult << response.body;
+			return true;
+		}
+
+		LogWarning() << "Internal HTTP request to '" << request.url << "' failed, falling back to curl";
+	}
+
+	return RunWithArgsAndCaptureOutput(curlCommand, outResult);
+}
+
+//--
+
+static std::string FormatHttpDate(fs::file_time_type fileTime)
+{
+	const auto systemTime = std::chrono::time_point_cast<std::chrono::system_clock::duration>(fileTime - fs::file_time_type::clock::now() + std::chrono::system_clock::now());
+	const auto time = std::chrono::system_clock::to_time_t(systemTime);
+
+	tm utc;
+#ifdef _WIN32
+	gmtime_s(&utc, &time);
+#else
+	gmtime_r(&time, &utc);
+#endif
+
+	char txt[64];
+	strftime(txt, sizeof(txt), "%a, %d %b %Y %H:%M:%S GMT", &utc);
+	return txt;
+}
+
+bool Http_Download(std::string_view url, const fs::path& targetPath, bool onlyIfNewer)
+{
+	std::string currentUrl(url);
+
+	std::string modifiedSince;
+	if (onlyIfNewer)
+	{
+		std::error_code ec;
+		const auto fileTime = fs::last_write_time(targetPath, ec);
+		if (!ec)
+			modifiedSince = FormatHttpDate(fileTime);
+	}
+
+	const auto tempPath = fs::path(targetPath.u8string() + ".download");
+
+	for (uint32_t redirect = 0; redirect <= HTTP_MAX_REDIRECTS; ++redirect)
+	{
+		if (!Http_CanHandleInProcess(currentUrl))
+			return false;
+
+		std::ofstream file;
+		HttpResponse response;
+
+		HttpRequest request;
+		request.url = currentUrl;
+		if (!modifiedSince.empty())
+			request.headers.emplace_back("If-Modified-Since", modifiedSince);
+
+		request.bodySink = [&response, &file, &tempPath](const uint8_t* data, uint64_t size)
+		{
+			if (response.status != 200)
+				return true; // drain
+
+			if (!file.is_open())
+			{
+				file.open(tempPath, std::ios::out | std::ios::binary | std::ios::trunc);
+				if (!file.is_open())
+				{
+					LogError() << "Unable to open " << tempPath << " for writing";
+					return false;
+				}
+			}
+
+			file.write((const char*)data, size);
+			return !file.fail();
+		};
+
+		if (!Http_Send(request, response))
+			return false;
+
+		if (response.status == 301 || response.status == 302 || response.status == 303 || response.status == 307 || response.status == 308)
+		{
+			currentUrl = std::string(response.header("location"));
+			continue;
+		}
+
+		if (response.status == 304)
+			return true;
+
+		if (response.status != 200)
+		{
+			LogError() << "HTTP download of '" << currentUrl << "' failed with status " << response.status;
+			return false;
+		}
+
+		if (!file.is_open())
+			file.open(tempPath, std::ios::out | std::ios::binary | std::ios::trunc); // empty file
+
+		file.close();
+		if (file.fail())
+		{
+			LogError() << "Failed to write downloaded file " << tempPath;
+			return false;
+		}
+
+		std::error_code ec;
+		fs::rename(tempPath, targetPath, ec);
+		if (ec)
+		{
+			LogError() << "Failed to move downloaded file to " << targetPath << ", error: " << ec;
+			fs::remove(tempPath, ec);
+			return false;
+		}
+
+		return true;
+	}
+
+	LogError() << "Too many redirects when downloading '" << url << "'";
+	return false;
+}
+
+bool Http_DownloadToSink(std::string_view url, const std::function<bool(const uint8_t* data, uint64_t size)>& sink)
+{
+	std::string currentUrl(url);
+
+	for (uint32_t redirect = 0; redirect <= HTTP_MAX_REDIRECTS; ++redirect)
+	{
+		if (!Http_CanHandleInProcess(currentUrl))
+			return false;
+
+		HttpResponse response;
+
+		HttpRequest request;
+		request.url = currentUrl;
+		request.bodySink = [&response, &sink](const uint8_t* data, uint64_t size)
+		{
+			if (response.status != 200)
+				return true; // drain
+
+			return sink(data, size);
+		};
+
+		if (!Http_Send(request, response))
+			return false;
+
+		if (response.status == 301 || response.status == 302 || response.status == 303 || response.status == 307 || response.status == 308)
+		{
+			currentUrl = std::string(response.header("location"));
+			continue;
+		}
+
+		if (response.status != 200)
+		{
+			LogError() << "HTTP download of '" << currentUrl << "' failed with status " << response.status;
+			return false;
+		}
+
+		return true;
+	}
+
+	LogError() << "Too many redirects when downloading '" << url << "'";
+	return false;
+}
+
+//--
+
+std::string Http_BasicAuthorization(std::string_view userAndPassword)
+{
+	static const char* CHARS = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+	std::string ret = "Basic ";
+
+	const auto* data = (const uint8_t*)userAndPassword.data();
+	const auto size = userAndPassword.size();
+
+	for (size_t i = 0; i < size; i += 3)
+	{
+		const uint32_t a = data[i];
+		const uint32_t b = (i + 1 < size) ? data[i + 1] : 0;
+		const uint32_t c = (i + 2 < size) ? data[i + 2] : 0;
+		const uint32_t triple = (a << 16) | (b << 8) | c;
+
+		ret += CHARS[(triple >> 18) & 63];
+		ret += CHARS[(triple >> 12) & 63];
+		ret += (i + 1 < size) ? CHARS[(triple >> 6) & 63] : '=';
+		ret += (i + 2 < size) ? CHARS[triple & 63] : '=';
+	}
+
+	return ret;
+}
+
+void Http_CloseConnections()
+{
+	HttpConnectionPool::GetInstance().closeAll();
+}
+
+//--
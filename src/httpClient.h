@@ -0,0 +1,56 @@
+#pragma once
+
+#include <functional>
+
+//--
+
+// single HTTP request, the url must be a full "http://host[:port]/path?args" address ("https://" if onion was built with OpenSSL)
+struct HttpRequest
+{
+	std::string method = "GET";
+	std::string url;
+	std::vector<std::pair<std::string, std::string>> headers;
+	std::string body;
+
+	// optional streaming sink for the response body, if set the body is NOT stored in the response
+	std::function<bool(const uint8_t* data, uint64_t size)> bodySink;
+};
+
+struct HttpResponse
+{
+	int status = 0;
+	std::unordered_map<std::string, std::string> headers; // lower case header names
+	std::string body;
+
+	std::string_view header(std::string_view name) const; // name must be lower case
+};
+
+//--
+
+// returns true if request to given URL can be done by the internal client
+// https needs onion built with OpenSSL, requests that should go through a proxy (*_proxy environment variables) are left to curl
+extern bool Http_CanHandleInProcess(std::string_view url);
+
+// send single request, connections are kept alive and reused between calls to the same host
+extern bool Http_Send(const HttpRequest& request, HttpResponse& outResponse);
+
+// send a batch of requests, GET/HEAD requests to the same host are pipelined on one connection, responses are returned in the request order
+// requests the server did not answer on the shared connection are sent again one by one
+extern bool Http_SendPipelined(const std::vector<HttpRequest>& requests, std::vector<HttpResponse>& outResponses);
+
+// send request with the internal client if possible, if not fall back to running the given curl command line
+extern bool Http_SendOrRunCurl(const HttpRequest& request, std::string_view curlCommand, std::stringstream& outResult);
+
+// download file (follows redirects), if onlyIfNewer is set the file is only downloaded if it's newer on the server (same as curl -z)
+extern bool Http_Download(std::string_view url, const fs::path& targetPath, bool onlyIfNewer);
+
+// download data and pass it to the sink as it arrives (follows redirects), sink is only called for successful response
+extern bool Http_DownloadToSink(std::string_view url, const std::function<bool(const uint8_t* data, uint64_t size)>& sink);
+
+// build value for the "Authorization: Basic" header from "user:password" string
+extern std::string Http_BasicAuthorization(std::string_view userAndPassword);
+
+// close all pooled connections
+extern void Http_CloseConnections();
+
+//--
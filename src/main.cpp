@@ -11,6 +11,8 @@
 #include "toolGlueFiles.h"
 #include "toolTest.h"
 #include "toolDeploy.h"
+#include "toolBenchmark.h"
+#include "profiler.h"
 
 static bool NeedsQuotes(std::string_view txt)
 {
@@ -51,6 +53,9 @@ static std::string MergeCommandline(int argc, char** argv)
 static void PrintUsage()
 {
     LogInfo() << "";
+    LogInfo() << "Common options:";
+    LogInfo() << "  -trace=<file.json> - record time spent in each phase of the tool into Chrome/Perfetto trace file and print the summary";
+    LogInfo() << "  -profile - print the summary of time spent in each phase of the tool (without the trace file)";
     LogInfo() << "---------------------------------------------------------";
     ToolConfigure().printUsage();
     LogInfo() << "---------------------------------------------------------";
@@ -65,28 +70,12 @@ static void PrintUsage()
 	ToolDeploy().printUsage();
 	LogInfo() << "---------------------------------------------------------";
 	ToolTest().printUsage();
+	LogInfo() << "---------------------------------------------------------";
+	ToolBenchmark().printUsage();
 }
 
-int main(int argc, char** argv)
+static int RunTool(const Commandline& cmdLine)
 {
-#ifndef _WIN32
-    //setvbuf(stdout, NULL, _IONBF, 0);
-    //setvbuf(stderr, NULL, _IONBF, 0);
-#endif
-
-    Commandline cmdLine;
-    if (!cmdLine.parse(MergeCommandline(argc, argv)) || cmdLine.commands.size() != 1)
-    {
-		LogInfo() << "Build Tool v1.0";
-        PrintUsage();
-        return 1;
-    }
-
-    if (!cmdLine.has("nologo"))
-    {
-        LogInfo() << "Build Tool v1.0";
-    }
-
     const auto& tool = cmdLine.commands[0];
 	if (tool == "configure")
 	{
@@ -143,6 +132,11 @@ int main(int argc, char** argv)
 		ToolDeploy tool;
 		return tool.run(cmdLine);
 	}
+	else if (tool == "benchmark")
+	{
+		ToolBenchmark tool;
+		return tool.run(cmdLine);
+	}
     else
     {
         LogError() << "Unknown tool specified";
@@ -152,3 +146,40 @@ int main(int argc, char** argv)
 
     return 0;
 }
+
+int main(int argc, char** argv)
+{
+#ifndef _WIN32
+    //setvbuf(stdout, NULL, _IONBF, 0);
+    //setvbuf(stderr, NULL, _IONBF, 0);
+#endif
+
+    Commandline cmdLine;
+    if (!cmdLine.parse(MergeCommandline(argc, argv)) || cmdLine.commands.size() != 1)
+    {
+		LogInfo() << "Build Tool v1.0";
+        PrintUsage();
+        return 1;
+    }
+
+    if (!cmdLine.has("nologo"))
+    {
+        LogInfo() << "Build Tool v1.0";
+    }
+
+    // optional profiling of the whole tool run
+    const bool profile = cmdLine.has("trace") || cmdLine.has("profile");
+    if (profile)
+        Profiler_Start(fs::path(cmdLine.get("trace", "")));
+
+    int ret = 0;
+    {
+        PROFILE_SCOPE("RunTool");
+        ret = RunTool(cmdLine);
+    }
+
+    if (profile)
+        Profiler_Finish();
+
+    return ret;
+}
@@ -0,0 +1,222 @@
+#include "common.h"
+#include "utils.h"
+#include "makeFingerprint.h"
+#include "profiler.h"
+
+//--
+
+namespace prv
+{
+	static const char* FINGERPRINT_HEADER = "ONION_MAKE_FINGERPRINT 1";
+
+	// file systems with coarse time stamps may report modification made right after the start as made before it
+	static const auto FINGERPRINT_TIME_MARGIN = std::chrono::seconds(2);
+
+	// values may be empty so only the line end can be removed
+	static std::string_view TrimLineEnd(std::string_view line)
+	{
+		while (!line.empty() && (line.back() == '\r' || line.back() == '\n'))
+			line = line.substr(0, line.length() - 1);
+		return line;
+	}
+
+	// size and modification time of a file or directory, "missing" if it does not exist
+	static std::string QueryFileState(const fs::path& path, fs::file_time_type* outTime = nullptr)
+	{
+		std::error_code ec;
+		const auto status = fs::status(path, ec);
+		if (ec || !fs::exists(status))
+			return "missing";
+
+		const auto time = fs::last_write_time(path, ec);
+		if (ec)
+			return "missing";
+
+		uint64_t size = 0;
+		if (fs::is_regular_file(status))
+		{
+			size = fs::file_size(path, ec);
+			if (ec)
+				return "missing";
+		}
+
+		if (outTime)
+			*outTime = time;
+
+		return std::to_string(size) + ":" + std::to_string((int64_t)time.time_since_epoch().count());
+	}
+
+} // prv
+
+//--
+
+MakeFingerprint::MakeFingerprint()
+{}
+
+const char* MakeFingerprint::EntryTypeName(EntryType type)
+{
+	switch (type)
+	{
+	case EntryType::Value: return "VALUE";
+	case EntryType::File: return "FILE";
+	case EntryType::Directory: return "DIR";
+	case EntryType::Output: return "OUTPUT";
+	}
+
+	return "";
+}
+
+void MakeFingerprint::addEntry(EntryType type, std::string_view name, std::string_view value)
+{
+	auto key = std::string(EntryTypeName(type));
+	key += "\t";
+	key += name;
+
+	if (!m_entryKeys.insert(key).second)
+		return;
+
+	Entry entry;
+	entry.type = type;
+	entry.name = std::string(name);
+	entry.value = std::string(value);
+	m_entries.push_back(entry);
+}
+
+void MakeFingerprint::addValue(std::string_view name, std::string_view value)
+{
+	addEntry(EntryType::Value, name, value);
+}
+
+void MakeFingerprint::addFile(const fs::path& path)
+{
+	addEntry(EntryType::File, path.u8string(), "");
+}
+
+void MakeFingerprint::addDirectory(const fs::path& path)
+{
+	addEntry(EntryType::Directory, path.u8string(), "");
+}
+
+void MakeFingerprint::addOutput(const fs::path& path)
+{
+	addEntry(EntryType::Output, path.u8string(), "exists");
+}
+
+//--
+
+bool MakeFingerprint::isUpToDate(const fs::path& path) const
+{
+	PROFILE_SCOPE("MakeFingerprint::isUpToDate");
+
+	std::string txt;
+	if (!fs::is_regular_file(path) || !LoadFileToString(path, txt))
+	{
+		LogInfo() << "No make fingerprint found, full make is needed";
+		return false;
+	}
+
+	std::vector<std::string_view> lines;
+	SplitString(txt, "\n", lines);
+
+	if (lines.empty() || prv::TrimLineEnd(lines[0]) != prv::FINGERPRINT_HEADER)
+	{
+		LogInfo() << "Make fingerprint at " << path << " is not valid, full make is needed";
+		return false;
+	}
+
+	// all values we have must be in the stored fingerprint with the same value
+	std::unordered_map<std::string_view, std::string_view> currentValues;
+	for (const auto& entry : m_entries)
+		if (entry.type == EntryType::Value)
+			currentValues[entry.name] = entry.value;
+
+	uint32_t numMatchedValues = 0;
+	uint32_t numCheckedFiles = 0;
+	for (size_t i = 1; i < lines.size(); ++i)
+	{
+		const auto line = prv::TrimLineEnd(lines[i]);
+		if (line.empty())
+			continue;
+
+		std::string_view type, rest, name, value;
+		if (!SplitString(line, "\t", type, rest) || !SplitString(rest, "\t", name, value))
+		{
+			LogInfo() << "Make fingerprint at " << path << " is not valid, full make is needed";
+			return false;
+		}
+
+		if (type == "VALUE")
+		{
+			auto it = currentValues.find(name);
+			if (it == currentValues.end() || it->second != value)
+			{
+				LogInfo() << "Make settings changed (" << name << "), full make is needed";
+				return false;
+			}
+
+			numMatchedValues += 1;
+		}
+		else if (type == "FILE" || type == "DIR")
+		{
+			if (prv::QueryFileState(fs::path(name)) != value)
+			{
+				LogInfo() << "Input " << name << " changed, full make is needed";
+				return false;
+			}
+
+			numCheckedFiles += 1;
+		}
+		else if (type == "OUTPUT")
+		{
+			if (!fs::is_regular_file(fs::path(name)))
+			{
+				LogInfo() << "Output " << name << " is missing, full make is needed";
+				return false;
+			}
+
+			numCheckedFiles += 1;
+		}
+	}
+
+	if (numMatchedValues != currentValues.size())
+	{
+		LogInfo() << "Make settings changed, full make is needed";
+		return false;
+	}
+
+	LogInfo() << "Make fingerprint matches (" << numCheckedFiles << " files and directories checked)";
+	return true;
+}
+
+bool MakeFingerprint::save(const fs::path& path, fs::file_time_type startTime) const
+{
+	PROFILE_SCOPE("MakeFingerprint::save");
+
+	const auto timeLimit = startTime - prv::FINGERPRINT_TIME_MARGIN;
+
+	std::stringstream f;
+	writeln(f, prv::FINGERPRINT_HEADER);
+
+	for (const auto& entry : m_entries)
+	{
+		auto value = entry.value;
+
+		if (entry.type == EntryType::File || entry.type == EntryType::Directory)
+		{
+			fs::file_time_type time;
+			value = prv::QueryFileState(fs::path(entry.name), &time);
+
+			if (value != "missing" && time >= timeLimit)
+			{
+				LogInfo() << "Input " << entry.name << " was modified while running, make fingerprint not saved";
+				return true;
+			}
+		}
+
+		f << EntryTypeName(entry.type) << "\t" << entry.name << "\t" << value << "\n";
+	}
+
+	return SaveFileFromString(path, f.str(), true, false);
+}
+
+//--
@@ -0,0 +1,56 @@
+#pragma once
+
+//--
+
+// snapshot of everything the output of "onion make" depends on: manifests, directory listings, project files, configuration and the tool itself
+// stored after successful make, when nothing changed since then the next make can exit without doing any work
+class MakeFingerprint
+{
+public:
+	MakeFingerprint();
+
+	// value that must match exactly (command line, configuration name)
+	void addValue(std::string_view name, std::string_view value);
+
+	// file (or directory) tracked by size and modification time, it's fine if it does not exist
+	void addFile(const fs::path& path);
+
+	// directory listing tracked by the modification time of the directory (changes when entries are added, removed or renamed)
+	void addDirectory(const fs::path& path);
+
+	// generated file that must still exist
+	void addOutput(const fs::path& path);
+
+	//--
+
+	// check if fingerprint stored at given path matches the values added so far and the current state of all files recorded in it
+	bool isUpToDate(const fs::path& path) const;
+
+	// save fingerprint, NOTE: nothing is saved if any of the inputs was modified after the start time (we might have missed the change)
+	bool save(const fs::path& path, fs::file_time_type startTime) const;
+
+private:
+	enum class EntryType : uint8_t
+	{
+		Value,
+		File,
+		Directory,
+		Output,
+	};
+
+	struct Entry
+	{
+		EntryType type = EntryType::Value;
+		std::string name; // path for files
+		std::string value;
+	};
+
+	std::vector<Entry> m_entries;
+	std::unordered_set<std::string> m_entryKeys; // type + name, prevents duplicates
+
+	void addEntry(EntryType type, std::string_view name, std::string_view value);
+
+	static const char* EntryTypeName(EntryType type);
+};
+
+//--
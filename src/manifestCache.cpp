@@ -0,0 +1,309 @@
+#include "common.h"
+#include "utils.h"
+#include "manifestCache.h"
+#include "moduleManifest.h"
+#include "projectManifest.h"
+#include "externalLibrary.h"
+#include "configuration.h"
+#include "profiler.h"
+
+//--
+
+namespace prv
+{
+	static const uint32_t MANIFEST_CACHE_MAGIC = 0x434D4E4F; // "ONMC"
+	static const uint32_t MANIFEST_CACHE_VERSION = 1;
+
+	// paths checked while parsing the XML must still be there, otherwise we load the XML again so the proper errors are reported
+	static bool CheckDirectories(const std::vector<fs::path>& paths)
+	{
+		for (const auto& path : paths)
+			if (!fs::is_directory(path))
+				return false;
+		return true;
+	}
+
+	static bool CheckFiles(const std::vector<fs::path>& paths)
+	{
+		for (const auto& path : paths)
+			if (!fs::is_regular_file(path))
+				return false;
+		return true;
+	}
+
+	static bool CheckModulePaths(const ModuleManifest& manifest)
+	{
+		if (!CheckDirectories(manifest.globalIncludePaths))
+			return false;
+
+		for (const auto& data : manifest.moduleData)
+			if (!fs::is_directory(data.sourcePath))
+				return false;
+
+		for (const auto& source : manifest.librarySources)
+			if ((source.type == "packed" || source.type == "loose") && !fs::is_directory(fs::u8path(source.data)))
+				return false;
+
+		for (const auto* project : manifest.projects)
+		{
+			if (!fs::is_directory(project->rootPath))
+				return false;
+
+			if (!CheckDirectories(project->localIncludePaths) || !CheckDirectories(project->exportedIncludePaths))
+				return false;
+
+			if (!CheckFiles(project->thirdPartySourceFiles) || !CheckFiles(project->frozenDeployFiles) || !CheckFiles(project->frozenLibraryFiles))
+				return false;
+		}
+
+		return true;
+	}
+
+	static bool CheckLibraryPaths(const ExternalLibraryManifest& manifest)
+	{
+		if (!manifest.includeDirectory().empty() && !fs::is_directory(manifest.includeDirectory()))
+			return false;
+
+		return CheckFiles(manifest.allFiles);
+	}
+
+} // prv
+
+//--
+
+ManifestCache::ManifestCache(const Configuration& config)
+	: m_config(config)
+{}
+
+bool ManifestCache::HashFile(const fs::path& path, uint64_t& outHash)
+{
+	std::vector<uint8_t> data;
+	if (!LoadFileToBuffer(path, data))
+		return false;
+
+	outHash = Crc64(data.data(), data.size());
+	return true;
+}
+
+void ManifestCache::load(const fs::path& path)
+{
+	PROFILE_SCOPE("ManifestCache::load");
+
+	std::lock_guard<std::mutex> lock(m_lock);
+	m_entries.clear();
+
+	std::vector<uint8_t> data;
+	if (!fs::is_regular_file(path) || !LoadFileToBuffer(path, data))
+		return;
+
+	BinaryReader reader(data.data(), data.size());
+	if (reader.readU32() != prv::MANIFEST_CACHE_MAGIC || reader.readU32() != prv::MANIFEST_CACHE_VERSION)
+	{
+		LogWarning() << "Manifest cache at " << path << " is not valid, manifests will be parsed again";
+		return;
+	}
+
+	if (reader.readString() != m_config.mergedName())
+		return; // saved for different configuration
+
+	const auto numEntries = reader.readU32();
+	for (uint32_t i = 0; i < numEntries && reader.ok(); ++i)
+	{
+		const auto key = reader.readString();
+
+		Entry entry;
+		entry.hash = reader.readU64();
+
+		const auto numIncludedFiles = reader.readU32();
+		for (uint32_t j = 0; j < numIncludedFiles && reader.ok(); ++j)
+		{
+			auto& file = entry.includedFiles.emplace_back();
+			file.path = reader.readString();
+			file.hash = reader.readU64();
+		}
+
+		entry.data = reader.readString();
+
+		m_entries[key] = std::move(entry);
+	}
+
+	if (!reader.ok())
+	{
+		LogWarning() << "Manifest cache at " << path << " is not valid, manifests will be parsed again";
+		m_entries.clear();
+	}
+}
+
+bool ManifestCache::save(const fs::path& path) const
+{
+	PROFILE_SCOPE("ManifestCache::save");
+
+	std::lock_guard<std::mutex> lock(m_lock);
+
+	BinaryWriter writer;
+	writer.writeU32(prv::MANIFEST_CACHE_MAGIC);
+	writer.writeU32(prv::MANIFEST_CACHE_VERSION);
+	writer.writeString(m_config.mergedName());
+	writer.writeU32((uint32_t)m_entries.size());
+
+	for (const auto& it : m_entries)
+	{
+		writer.writeString(it.first);
+		writer.writeU64(it.second.hash);
+
+		writer.writeU32((uint32_t)it.second.includedFiles.size());
+		for (const auto& file : it.second.includedFiles)
+		{
+			writer.writeString(file.path);
+			writer.writeU64(file.hash);
+		}
+
+		writer.writeString(it.second.data);
+	}
+
+	return SaveFileFromBuffer(path, writer.data, false, false);
+}
+
+//--
+
+bool ManifestCache::findEntry(const std::string& key, uint64_t hash, Entry& outEntry)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+
+		auto it = m_entries.find(key);
+		if (it == m_entries.end() || it->second.hash != hash)
+			return false;
+
+		outEntry = it->second;
+	}
+
+	// all included files must be the same as well
+	for (const auto& file : outEntry.includedFiles)
+	{
+		uint64_t fileHash = 0;
+		if (!HashFile(fs::u8path(file.path), fileHash) || fileHash != file.hash)
+			return false;
+	}
+
+	return true;
+}
+
+void ManifestCache::storeEntry(const std::string& key, Entry&& entry)
+{
+	std::lock_guard<std::mutex> lock(m_lock);
+	m_entries[key] = std::move(entry);
+}
+
+//--
+
+ModuleManifest* ManifestCache::loadModule(const fs::path& manifestPath, std::string_view projectGroup)
+{
+	PROFILE_SCOPE("ManifestCache::loadModule");
+
+	std::string key = "module:";
+	key += projectGroup;
+	key += ":";
+	key += manifestPath.u8string();
+
+	uint64_t hash = 0;
+	const bool hasHash = HashFile(manifestPath, hash);
+	if (hasHash)
+	{
+		Entry entry;
+		if (findEntry(key, hash, entry))
+		{
+			auto ret = std::make_unique<ModuleManifest>();
+
+			BinaryReader reader((const uint8_t*)entry.data.data(), entry.data.size());
+			if (ret->readBinary(reader) && prv::CheckModulePaths(*ret))
+			{
+				m_numCached += 1;
+				return ret.release();
+			}
+
+			for (auto* project : ret->projects)
+				delete project;
+		}
+	}
+
+	auto* manifest = ModuleManifest::Load(manifestPath, projectGroup, m_config, true);
+	if (!manifest)
+		return nullptr;
+
+	m_numParsed += 1;
+
+	if (!hasHash)
+		return manifest; // not cached
+
+	Entry entry;
+	entry.hash = hash;
+
+	for (const auto& includedPath : manifest->includedManifests)
+	{
+		auto& file = entry.includedFiles.emplace_back();
+		file.path = includedPath.u8string();
+		if (!HashFile(includedPath, file.hash))
+			return manifest; // not cached
+	}
+
+	BinaryWriter writer;
+	manifest->writeBinary(writer);
+	entry.data.assign((const char*)writer.data.data(), writer.data.size());
+
+	storeEntry(key, std::move(entry));
+	return manifest;
+}
+
+std::unique_ptr<ExternalLibraryManifest> ManifestCache::loadLibrary(const fs::path& manifestPath)
+{
+	PROFILE_SCOPE("ManifestCache::loadLibrary");
+
+	const auto key = "library:" + manifestPath.u8string();
+
+	uint64_t hash = 0;
+	const bool hasHash = HashFile(manifestPath, hash);
+	if (hasHash)
+	{
+		Entry entry;
+		if (findEntry(key, hash, entry))
+		{
+			auto ret = std::make_unique<ExternalLibraryManifest>();
+
+			BinaryReader reader((const uint8_t*)entry.data.data(), entry.data.size());
+			if (ret->readBinary(reader) && prv::CheckLibraryPaths(*ret))
+			{
+				m_numCached += 1;
+				return ret;
+			}
+		}
+	}
+
+	auto manifest = ExternalLibraryManifest::Load(manifestPath);
+	if (!manifest)
+		return nullptr;
+
+	m_numParsed += 1;
+
+	if (!hasHash)
+		return manifest; // not cached
+
+	Entry entry;
+	entry.hash = hash;
+
+	BinaryWriter writer;
+	manifest->writeBinary(writer);
+	entry.data.assign((const char*)writer.data.data(), writer.data.size());
+
+	storeEntry(key, std::move(entry));
+	return manifest;
+}
+
+//--
+
+void ManifestCache::printStats() const
+{
+	LogInfo() << "Manifest cache: " << m_numCached.load() << " manifest(s) loaded from cache, " << m_numParsed.load() << " parsed";
+}
+
+//--
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <mutex>
+
+//--
+
+struct Configuration;
+struct ModuleManifest;
+struct ExternalLibraryManifest;
+
+// binary cache of parsed module (with projects) and library manifests, kept in the configuration's temp folder
+// entries are keyed by the hash of the manifest file (and all the files it includes) and the configuration name (filters depend on it)
+// NOTE: when the key does not match the manifest is loaded from XML as usual and the cache entry is replaced
+class ManifestCache
+{
+public:
+	ManifestCache(const Configuration& config);
+
+	// load previously saved cache, missing file or file saved for different configuration just means empty cache
+	void load(const fs::path& path);
+
+	// save all entries, NOTE: entries are replaced when a manifest changes so the cache does not grow unless manifests are removed
+	bool save(const fs::path& path) const;
+
+	//--
+
+	// load module manifest, from cache if the manifest and all included files did not change
+	ModuleManifest* loadModule(const fs::path& manifestPath, std::string_view projectGroup);
+
+	// load library manifest, from cache if the manifest did not change
+	std::unique_ptr<ExternalLibraryManifest> loadLibrary(const fs::path& manifestPath);
+
+	//--
+
+	// print how many manifests were served from cache
+	void printStats() const;
+
+private:
+	struct FileHash
+	{
+		std::string path;
+		uint64_t hash = 0;
+	};
+
+	struct Entry
+	{
+		uint64_t hash = 0; // hash of the manifest file
+		std::vector<FileHash> includedFiles; // included manifests (module only)
+		std::string data; // serialized manifest
+	};
+
+	const Configuration& m_config;
+
+	mutable std::mutex m_lock;
+	std::unordered_map<std::string, Entry> m_entries; // "type:group:path"
+
+	std::atomic<uint32_t> m_numCached = 0;
+	std::atomic<uint32_t> m_numParsed = 0;
+
+	bool findEntry(const std::string& key, uint64_t hash, Entry& outEntry);
+	void storeEntry(const std::string& key, Entry&& entry);
+
+	static bool HashFile(const fs::path& path, uint64_t& outHash);
+};
+
+//--
@@ -115,10 +115,55 @@ static bool IsValidProjectTag(std::string_view tag)
 	return false;
 }
 
-extern bool EvalPlatformFilters(const XMLNode* node, PlatformType platform);
+extern bool EvalPlatformFilters(const XMLNode* node, PlatformType platform, bool verbose);
 extern bool EvalSolutionFilters(const XMLNode* node, SolutionType solutionType);
 
-bool ModuleManifest::LoadKeySet(ModuleManifest* ret, const void* nodePtr, const Configuration& config, bool topLevel)
+// manifests included by a module, in the order of the Include directives (as evaluated with the current configuration)
+struct ModuleManifest::IncludeList
+{
+	struct Entry
+	{
+		fs::path path; // empty if directive has no path
+		std::string projectGroup; // group that was active at the directive
+		std::unique_ptr<ModuleManifest> manifest; // NULL if loading failed
+		bool loaded = false;
+	};
+
+	std::vector<Entry> entries;
+	size_t next = 0; // next entry to merge
+};
+
+void ModuleManifest::CollectIncludes(const void* nodePtr, const fs::path& manifestDirectory, const Configuration& config, std::string& projectGroup, IncludeList& outIncludes)
+{
+	XMLNodeIterate((const XMLNode*)nodePtr, [&](const XMLNode* node, std::string_view name)
+		{
+			if (name == "Include")
+			{
+				auto& entry = outIncludes.entries.emplace_back();
+				entry.projectGroup = projectGroup;
+
+				const std::string relativePath = std::string(XMLNodeValue(node));
+				if (!relativePath.empty())
+					entry.path = fs::weakly_canonical((manifestDirectory / relativePath).make_preferred());
+			}
+			else if (name == "FilterPlatform")
+			{
+				if (EvalPlatformFilters(node, config.platform, false))
+					CollectIncludes(node, manifestDirectory, config, projectGroup, outIncludes);
+			}
+			else if (name == "FilterSolutionType")
+			{
+				if (EvalSolutionFilters(node, config.solutionType))
+					CollectIncludes(node, manifestDirectory, config, projectGroup, outIncludes);
+			}
+			else if (name == "ProjectGroupName")
+			{
+				projectGroup = std::string(XMLNodeValue(node));
+			}
+		});
+}
+
+bool ModuleManifest::LoadKeySet(ModuleManifest* ret, const void* nodePtr, const Configuration& config, bool topLevel, IncludeList& includes)
 {
 	XMLNode* root = (XMLNode*)nodePtr;
 
@@ -132,6 +177,9 @@ bool ModuleManifest::LoadKeySet(ModuleManifest* ret, const void* nodePtr, const
 			// Include directive
 			if (name == "Include")
 			{
+				// every Include directive has an entry collected up front
+				auto* preloaded = (includes.next < includes.entries.size()) ? &includes.entries[includes.next++] : nullptr;
+
 				const std::string relativePath = std::string(XMLNodeValue(node));
 				if (relativePath.empty())
 				{
@@ -145,13 +193,27 @@ bool ModuleManifest::LoadKeySet(ModuleManifest* ret, const void* nodePtr, const
 
 					if (fs::is_regular_file(includeManifestPath))
 					{
-						if (auto* included = ModuleManifest::Load(includeManifestPath, ret->localProjectGroup, config, false))
+						std::unique_ptr<ModuleManifest> loadedHere;
+						ModuleManifest* included = nullptr;
+						if (preloaded && preloaded->loaded && preloaded->path == includeManifestPath && preloaded->projectGroup == ret->localProjectGroup)
+						{
+							included = preloaded->manifest.get();
+						}
+						else
+						{
+							loadedHere.reset(ModuleManifest::Load(includeManifestPath, ret->localProjectGroup, config, false));
+							included = loadedHere.get();
+						}
+
+						if (included)
 						{
 							ret->moduleData.insert(ret->moduleData.end(), included->moduleData.begin(), included->moduleData.end());
 							ret->moduleDependencies.insert(ret->moduleDependencies.end(), included->moduleDependencies.begin(), included->moduleDependencies.end());
 							ret->projects.insert(ret->projects.end(), included->projects.begin(), included->projects.end());
 							ret->globalIncludePaths.insert(ret->globalIncludePaths.end(), included->globalIncludePaths.begin(), included->globalIncludePaths.end());
 							ret->librarySources.insert(ret->librarySources.end(), included->librarySources.begin(), included->librarySources.end());
+							ret->includedManifests.push_back(includeManifestPath);
+							ret->includedManifests.insert(ret->includedManifests.end(), included->includedManifests.begin(), included->includedManifests.end());
 						}
 						else
 						{
@@ -171,9 +233,9 @@ bool ModuleManifest::LoadKeySet(ModuleManifest* ret, const void* nodePtr, const
 			// Filter by platform
 			else if (name == "FilterPlatform")
 			{
-				if (EvalPlatformFilters(node, config.platform))
+				if (EvalPlatformFilters(node, config.platform, true))
 				{
-					valid &= LoadKeySet(ret, node, config, topLevel);
+					valid &= LoadKeySet(ret, node, config, topLevel, includes);
 				}
 			}
 
@@ -182,7 +244,7 @@ bool ModuleManifest::LoadKeySet(ModuleManifest* ret, const void* nodePtr, const
 			{
 				if (EvalSolutionFilters(node, config.solutionType))
 				{
-					valid &= LoadKeySet(ret, node, config, topLevel);
+					valid &= LoadKeySet(ret, node, config, topLevel, includes);
 				}
 			}
 
@@ -385,7 +447,25 @@ ModuleManifest* ModuleManifest::Load(const fs::path& manifestPath, std::string_v
 	ret->guid = GuidFromText(manifestPath.u8string());
 	ret->localProjectGroup = projectGroup;
 
-	if (!LoadKeySet(ret.get(), root, config, topLevel))
+	// included manifests are loaded in parallel before this one is evaluated (serially if this module is already loaded on a worker thread), LoadKeySet merges them in the order of the Include directives
+	// so the result does not depend on which one finished first, all of them are loaded even if some fail so all errors are reported at once
+	IncludeList includes;
+	{
+		std::string currentProjectGroup = ret->localProjectGroup;
+		CollectIncludes(root, manifestPath.parent_path(), config, currentProjectGroup, includes);
+	}
+
+	RunParallel((uint32_t)includes.entries.size(), GetDefaultJobCount(), [&includes, &config](uint32_t index)
+		{
+			auto& entry = includes.entries[index];
+			if (!entry.path.empty() && fs::is_regular_file(entry.path))
+			{
+				entry.manifest.reset(ModuleManifest::Load(entry.path, entry.projectGroup, config, false));
+				entry.loaded = true;
+			}
+		});
+
+	if (!LoadKeySet(ret.get(), root, config, topLevel, includes))
 		return nullptr;
 
 
@@ -401,4 +481,92 @@ ModuleManifest* ModuleManifest::Load(const fs::path& manifestPath, std::string_v
 	return ret.release();
 }
 
+//--
+
+void ModuleManifest::writeBinary(BinaryWriter& writer) const
+{
+	writer.writeString(guid);
+	writer.writePath(path);
+	writer.writeString(globalNamespace);
+	writer.writeString(globalSolutionName);
+	writer.writeString(localProjectGroup);
+
+	writer.writeU32((uint32_t)projects.size());
+	for (const auto* project : projects)
+		project->writeBinary(writer);
+
+	writer.writeU32((uint32_t)moduleDependencies.size());
+	for (const auto& dep : moduleDependencies)
+	{
+		writer.writeString(dep.gitRepoPath);
+		writer.writeString(dep.localRelativePath);
+	}
+
+	writer.writeU32((uint32_t)moduleData.size());
+	for (const auto& data : moduleData)
+	{
+		writer.writeString(data.mountPath);
+		writer.writeString(data.localSourcePath);
+		writer.writePath(data.sourcePath);
+	}
+
+	writer.writeU32((uint32_t)librarySources.size());
+	for (const auto& source : librarySources)
+	{
+		writer.writeString(source.type);
+		writer.writeString(source.data);
+	}
+
+	writer.writePaths(globalIncludePaths);
+	writer.writePaths(includedManifests);
+}
+
+bool ModuleManifest::readBinary(BinaryReader& reader)
+{
+	guid = reader.readString();
+	path = reader.readPath();
+	globalNamespace = reader.readString();
+	globalSolutionName = reader.readString();
+	localProjectGroup = reader.readString();
+
+	const auto numProjects = reader.readU32();
+	for (uint32_t i = 0; i < numProjects && reader.ok(); ++i)
+	{
+		auto project = std::make_unique<ProjectManifest>();
+		if (!project->readBinary(reader))
+			return false;
+		projects.push_back(project.release());
+	}
+
+	const auto numDependencies = reader.readU32();
+	for (uint32_t i = 0; i < numDependencies && reader.ok(); ++i)
+	{
+		auto& dep = moduleDependencies.emplace_back();
+		dep.gitRepoPath = reader.readString();
+		dep.localRelativePath = reader.readString();
+	}
+
+	const auto numData = reader.readU32();
+	for (uint32_t i = 0; i < numData && reader.ok(); ++i)
+	{
+		auto& data = moduleData.emplace_back();
+		data.mountPath = reader.readString();
+		data.localSourcePath = reader.readString();
+		data.sourcePath = reader.readPath();
+	}
+
+	const auto numSources = reader.readU32();
+	for (uint32_t i = 0; i < numSources && reader.ok(); ++i)
+	{
+		auto& source = librarySources.emplace_back();
+		source.type = reader.readString();
+		source.data = reader.readString();
+	}
+
+	reader.readPaths(globalIncludePaths);
+	reader.readPaths(includedManifests);
+
+	return reader.ok();
+}
+
 //--
\ No newline at end of file
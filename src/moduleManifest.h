@@ -4,6 +4,8 @@
 
 struct Configuration;
 struct ProjectManifest;
+class BinaryWriter;
+class BinaryReader;
 
 // module dependency
 struct ModuleDepdencencyInfo
@@ -43,6 +45,7 @@ struct ModuleManifest
     std::vector<ModuleDataInfo> moduleData; // exposed data folders
 	std::vector<ModuleLibrarySource> librarySources; // source of third party libraries
     std::vector<fs::path> globalIncludePaths; // global include paths for source code (root source)
+    std::vector<fs::path> includedManifests; // all other manifest files included by this one (directly or not)
 
     mutable bool local = true;
 
@@ -53,10 +56,17 @@ struct ModuleManifest
 
     static ModuleManifest* Load(const fs::path& manifestPath, std::string_view projectGroup, const Configuration& config, bool topLevel = true);
 
+    // binary form of the loaded manifest (with all the projects), used by the manifest cache
+    void writeBinary(BinaryWriter& writer) const;
+    bool readBinary(BinaryReader& reader);
+
     //--  
 
 private:
-    static bool LoadKeySet(ModuleManifest* ret, const void* nodePtr, const Configuration& config, bool topLevel);
+    struct IncludeList; // included manifests loaded up front
+
+    static bool LoadKeySet(ModuleManifest* ret, const void* nodePtr, const Configuration& config, bool topLevel, IncludeList& includes);
+    static void CollectIncludes(const void* nodePtr, const fs::path& manifestDirectory, const Configuration& config, std::string& projectGroup, IncludeList& outIncludes);
 };
 
 //--
@@ -4,6 +4,8 @@
 #include "moduleManifest.h"
 #include "moduleRepository.h"
 #include "moduleConfiguration.h"
+#include "manifestCache.h"
+#include "profiler.h"
 
 //--
 
@@ -17,36 +19,77 @@ ModuleRepository::~ModuleRepository()
 		delete modul;
 }
 
-bool ModuleRepository::installConfiguredModule(const fs::path& absoluteModuleFilePath, std::string_view hash, bool local, bool verifyVersions)
+ModuleManifest* ModuleRepository::loadModuleManifest(const fs::path& absoluteModuleFilePath, bool local, ManifestCache* cache) const
 {
-	// load the manifest
-	auto* manifest = ModuleManifest::Load(absoluteModuleFilePath, local ? "" : "External", m_config, true);
-	if (!manifest)
-	{
-		LogError() << "Failed to load module manifest from " << absoluteModuleFilePath;
-		return false;
-	}
+	const auto projectGroup = local ? "" : "External";
+	return cache
+		? cache->loadModule(absoluteModuleFilePath, projectGroup)
+		: ModuleManifest::Load(absoluteModuleFilePath, projectGroup, m_config, true);
+}
 
+void ModuleRepository::installLoadedModule(ModuleManifest* manifest, const fs::path& absoluteModuleFilePath, bool local)
+{
 	// set the local flag
 	manifest->local = local;
 
 	// install the loaded module
 	LogInfo() << "Installed local module at " << absoluteModuleFilePath << " with " << manifest->projects.size() << " project(s)";
 	m_modules.push_back(manifest);
+}
+
+bool ModuleRepository::installConfiguredModule(const fs::path& absoluteModuleFilePath, std::string_view hash, bool local, bool verifyVersions, ManifestCache* cache)
+{
+	// load the manifest
+	auto* manifest = loadModuleManifest(absoluteModuleFilePath, local, cache);
+	if (!manifest)
+	{
+		LogError() << "Failed to load module manifest from " << absoluteModuleFilePath;
+		return false;
+	}
+
+	installLoadedModule(manifest, absoluteModuleFilePath, local);
 	return true;
 }
 
-bool ModuleRepository::installConfiguredModules(const ModuleConfigurationManifest& config, bool verifyVersions)
+bool ModuleRepository::installConfiguredModules(const ModuleConfigurationManifest& config, bool verifyVersions, ManifestCache* cache)
 {
-	bool valid = true;
+	PROFILE_SCOPE("ModuleRepository::installConfiguredModules");
 
+	const auto numModules = (uint32_t)config.modules.size();
+
+	std::vector<fs::path> paths;
+	paths.reserve(numModules);
 	for (const auto& entry : config.modules)
+		paths.push_back(fs::weakly_canonical((config.rootPath / entry.path).make_preferred()));
+
+	// manifests are loaded in parallel (mostly waiting for the file system) but installed in the configured order so the project order is always the same
+	std::vector<ModuleManifest*> manifests(numModules, nullptr);
+	RunParallel(numModules, GetDefaultJobCount(), [&](uint32_t index)
+		{
+			manifests[index] = loadModuleManifest(paths[index], config.modules[index].local, cache);
+		});
+
+	uint32_t numFailed = 0;
+	for (uint32_t i = 0; i < numModules; ++i)
+	{
+		if (manifests[i])
+		{
+			installLoadedModule(manifests[i], paths[i], config.modules[i].local);
+		}
+		else
+		{
+			LogError() << "Failed to load module manifest from " << paths[i];
+			numFailed += 1;
+		}
+	}
+
+	if (numFailed)
 	{
-		const auto absoluteModuleFilePath = fs::weakly_canonical((config.rootPath / entry.path).make_preferred());
-		valid &= installConfiguredModule(absoluteModuleFilePath, entry.hash, entry.local, verifyVersions);
+		LogError() << numFailed << " of " << numModules << " module manifest(s) failed to load";
+		return false;
 	}
 
-	return valid;
+	return true;
 }
 
 //--
@@ -8,6 +8,7 @@
 struct Configuration;
 struct ModuleManifest;
 struct ModuleConfigurationManifest;
+class ManifestCache;
 
 class ModuleRepository
 {
@@ -17,12 +18,16 @@ public:
 
 	inline const std::vector<const ModuleManifest*>& modules() const { return (const std::vector<const ModuleManifest*>&) m_modules; }
 
-	bool installConfiguredModule(const fs::path& absoluteModuleFilePath, std::string_view hash, bool local, bool verifyVersions);
-	bool installConfiguredModules(const ModuleConfigurationManifest& config, bool verifyVersions);
+	// manifests are loaded from the cache if given
+	bool installConfiguredModule(const fs::path& absoluteModuleFilePath, std::string_view hash, bool local, bool verifyVersions, ManifestCache* cache = nullptr);
+	bool installConfiguredModules(const ModuleConfigurationManifest& config, bool verifyVersions, ManifestCache* cache = nullptr);
 
 private:
 	std::vector<ModuleManifest*> m_modules; // selected modules for compilation
 	const Configuration& m_config;
+
+	ModuleManifest* loadModuleManifest(const fs::path& absoluteModuleFilePath, bool local, ManifestCache* cache) const;
+	void installLoadedModule(ModuleManifest* manifest, const fs::path& absoluteModuleFilePath, bool local);
 };
 
 //--
\ No newline at end of file
@@ -0,0 +1,265 @@
+#include "common.h"
+#include "utils.h"
+#include "profiler.h"
+
+#include <chrono>
+#include <mutex>
+
+//--
+
+namespace prv
+{
+	struct ProfilerEvent
+	{
+		const char* name = nullptr;
+		uint32_t threadIndex = 0;
+		uint64_t startTimeUs = 0;
+		uint64_t durationUs = 0;
+	};
+
+	struct ProfilerCounterSample
+	{
+		uint64_t timeUs = 0;
+		uint64_t values[(int)ProfilerCounter::MAX];
+	};
+
+	struct ProfilerZoneStats
+	{
+		uint64_t count = 0;
+		uint64_t totalUs = 0;
+		uint64_t selfUs = 0;
+	};
+
+	struct ProfilerState
+	{
+		std::atomic<bool> enabled = false;
+		std::chrono::steady_clock::time_point startTime;
+		fs::path tracePath;
+
+		std::atomic<uint64_t> counters[(int)ProfilerCounter::MAX];
+		std::atomic<uint32_t> numThreads = 0;
+
+		std::mutex lock;
+		std::vector<ProfilerEvent> events;
+		std::vector<ProfilerCounterSample> counterSamples;
+		std::unordered_map<std::string, ProfilerZoneStats> zoneStats; // by name, same literal may have different address in different files
+	};
+
+	struct ProfilerThreadState
+	{
+		bool hasIndex = false;
+		uint32_t index = 0; // 0 - first thread that recorded anything (main thread)
+		std::vector<uint64_t> childTimeStack; // time spent in child zones of each active zone
+	};
+
+	static ProfilerState GProfiler;
+	static thread_local ProfilerThreadState GProfilerThread;
+
+	static uint64_t ProfilerTimeUs()
+	{
+		return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - GProfiler.startTime).count();
+	}
+
+	static uint32_t ProfilerThreadIndex()
+	{
+		if (!GProfilerThread.hasIndex)
+		{
+			GProfilerThread.index = GProfiler.numThreads++;
+			GProfilerThread.hasIndex = true;
+		}
+
+		return GProfilerThread.index;
+	}
+
+	static const char* NameCounter(ProfilerCounter counter)
+	{
+		switch (counter)
+		{
+		case ProfilerCounter::FilesScanned: return "Files scanned";
+		case ProfilerCounter::BytesRead: return "Bytes read";
+		case ProfilerCounter::BytesWritten: return "Bytes written";
+		case ProfilerCounter::ProcessesSpawned: return "Processes spawned";
+		default: break;
+		}
+		return "";
+	}
+
+	static void WriteJsonString(std::stringstream& f, std::string_view txt)
+	{
+		f << "\"";
+		for (const auto ch : txt)
+		{
+			if (ch == '\"' || ch == '\\')
+				f << "\\" << ch;
+			else if ((uint8_t)ch < 32)
+				f << " ";
+			else
+				f << ch;
+		}
+		f << "\"";
+	}
+
+	static bool WriteTrace(const fs::path& path)
+	{
+		std::stringstream f;
+		f << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+		// thread names
+		const auto numThreads = GProfiler.numThreads.load();
+		for (uint32_t i = 0; i < numThreads; ++i)
+		{
+			f << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << i << ",\"args\":{\"name\":";
+			WriteJsonString(f, i == 0 ? std::string("main") : ("worker " + std::to_string(i)));
+			f << "}},\n";
+		}
+
+		// zones
+		for (const auto& evt : GProfiler.events)
+		{
+			f << "{\"name\":";
+			WriteJsonString(f, evt.name);
+			f << ",\"cat\":\"onion\",\"ph\":\"X\",\"pid\":1,\"tid\":" << evt.threadIndex << ",\"ts\":" << evt.startTimeUs << ",\"dur\":" << evt.durationUs << "},\n";
+		}
+
+		// counters, one track for each so they don't get stacked together
+		for (const auto& sample : GProfiler.counterSamples)
+		{
+			for (int i = 0; i < (int)ProfilerCounter::MAX; ++i)
+			{
+				f << "{\"name\":";
+				WriteJsonString(f, NameCounter((ProfilerCounter)i));
+				f << ",\"ph\":\"C\",\"pid\":1,\"ts\":" << sample.timeUs << ",\"args\":{\"value\":" << sample.values[i] << "}},\n";
+			}
+		}
+
+		// process name closes the list (no trailing comma)
+		f << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"onion\"}}\n";
+		f << "]}\n";
+
+		return SaveFileFromString(path, f.str(), true, false);
+	}
+
+	static void PrintSummary()
+	{
+		std::vector<std::pair<std::string, ProfilerZoneStats>> zones(GProfiler.zoneStats.begin(), GProfiler.zoneStats.end());
+		std::sort(zones.begin(), zones.end(), [](const auto& a, const auto& b) { return a.second.totalUs != b.second.totalUs ? a.second.totalUs > b.second.totalUs : a.first < b.first; });
+
+		char line[512];
+		LogInfo() << "Profile summary:";
+		snprintf(line, sizeof(line), "  %-56s %8s %12s %12s", "Zone", "Calls", "Total [ms]", "Self [ms]");
+		LogInfo() << line;
+
+		for (const auto& zone : zones)
+		{
+			snprintf(line, sizeof(line), "  %-56s %8llu %12.2f %12.2f", zone.first.c_str(), (unsigned long long)zone.second.count, zone.second.totalUs / 1000.0, zone.second.selfUs / 1000.0);
+			LogInfo() << line;
+		}
+
+		for (int i = 0; i < (int)ProfilerCounter::MAX; ++i)
+		{
+			snprintf(line, sizeof(line), "  %-56s %8llu", NameCounter((ProfilerCounter)i), (unsigned long long)GProfiler.counters[i].load());
+			LogInfo() << line;
+		}
+
+		LogInfo() << "  Threads: " << GProfiler.numThreads.load();
+	}
+
+} // prv
+
+//--
+
+void Profiler_Start(const fs::path& tracePath)
+{
+	std::lock_guard<std::mutex> lock(prv::GProfiler.lock);
+
+	prv::GProfiler.startTime = std::chrono::steady_clock::now();
+	prv::GProfiler.tracePath = tracePath;
+	prv::GProfiler.events.clear();
+	prv::GProfiler.counterSamples.clear();
+	prv::GProfiler.zoneStats.clear();
+
+	for (auto& counter : prv::GProfiler.counters)
+		counter = 0;
+
+	prv::ProfilerThreadIndex(); // calling thread is the main one
+	prv::GProfiler.enabled = true;
+}
+
+void Profiler_Finish()
+{
+	if (!prv::GProfiler.enabled.exchange(false))
+		return;
+
+	std::lock_guard<std::mutex> lock(prv::GProfiler.lock);
+
+	if (!prv::GProfiler.tracePath.empty())
+	{
+		if (prv::WriteTrace(prv::GProfiler.tracePath))
+			LogInfo() << "Trace with " << prv::GProfiler.events.size() << " zone(s) written to " << prv::GProfiler.tracePath;
+		else
+			LogWarning() << "Failed to write trace to " << prv::GProfiler.tracePath;
+	}
+
+	prv::PrintSummary();
+}
+
+void Profiler_AddCounter(ProfilerCounter counter, uint64_t value)
+{
+	if (prv::GProfiler.enabled.load(std::memory_order_relaxed))
+		prv::GProfiler.counters[(int)counter] += value;
+}
+
+//--
+
+ProfilerScope::ProfilerScope(const char* name)
+{
+	if (prv::GProfiler.enabled.load(std::memory_order_relaxed))
+	{
+		m_name = name;
+		m_startTimeUs = prv::ProfilerTimeUs();
+		prv::GProfilerThread.childTimeStack.push_back(0);
+	}
+}
+
+ProfilerScope::~ProfilerScope()
+{
+	if (!m_name)
+		return;
+
+	const auto durationUs = prv::ProfilerTimeUs() - m_startTimeUs;
+
+	// self time excludes the nested zones, our time is theirs parent's child time
+	auto& stack = prv::GProfilerThread.childTimeStack;
+	const auto childTimeUs = stack.back();
+	stack.pop_back();
+	if (!stack.empty())
+		stack.back() += durationUs;
+
+	const auto threadIndex = prv::ProfilerThreadIndex();
+
+	// profiler was finished while we were running
+	if (!prv::GProfiler.enabled.load(std::memory_order_relaxed))
+		return;
+
+	std::lock_guard<std::mutex> lock(prv::GProfiler.lock);
+
+	prv::ProfilerEvent evt;
+	evt.name = m_name;
+	evt.threadIndex = threadIndex;
+	evt.startTimeUs = m_startTimeUs;
+	evt.durationUs = durationUs;
+	prv::GProfiler.events.push_back(evt);
+
+	auto& stats = prv::GProfiler.zoneStats[m_name];
+	stats.count += 1;
+	stats.totalUs += durationUs;
+	stats.selfUs += (durationUs > childTimeUs) ? (durationUs - childTimeUs) : 0;
+
+	prv::ProfilerCounterSample sample;
+	sample.timeUs = m_startTimeUs + durationUs;
+	for (int i = 0; i < (int)ProfilerCounter::MAX; ++i)
+		sample.values[i] = prv::GProfiler.counters[i].load();
+	prv::GProfiler.counterSamples.push_back(sample);
+}
+
+//--
@@ -0,0 +1,45 @@
+#pragma once
+
+//--
+
+// global counters, updated from anywhere (thread safe), reported in the summary and as counter tracks in the trace
+enum class ProfilerCounter : uint8_t
+{
+	FilesScanned,
+	BytesRead,
+	BytesWritten,
+	ProcessesSpawned,
+
+	MAX,
+};
+
+// start collecting zones and counters, if trace path is not empty the Chrome/Perfetto trace (JSON) is written there in Profiler_Finish
+// NOTE: when the profiler is not started zones and counters cost only a check of a single flag
+extern void Profiler_Start(const fs::path& tracePath);
+
+// stop collecting, write the trace and print the summary table (time spent in each zone, counters)
+extern void Profiler_Finish();
+
+// add value to a counter
+extern void Profiler_AddCounter(ProfilerCounter counter, uint64_t value = 1);
+
+//--
+
+// timed zone, nested zones on the same thread form a hierarchy
+// NOTE: name must be a literal (or live until the profiler is finished)
+class ProfilerScope
+{
+public:
+	ProfilerScope(const char* name);
+	~ProfilerScope();
+
+private:
+	const char* m_name = nullptr;
+	uint64_t m_startTimeUs = 0;
+};
+
+#define PROFILER_CONCAT_INNER(a, b) a##b
+#define PROFILER_CONCAT(a, b) PROFILER_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name) ProfilerScope PROFILER_CONCAT(profilerScope, __LINE__)(name)
+
+//--
@@ -6,6 +6,8 @@
 #include "externalLibrary.h"
 #include "externalLibraryRepository.h"
 #include "utils.h"
+#include "profiler.h"
+#include "directoryScanner.h"
 
 //--
 
@@ -34,6 +36,24 @@ static ProjectFileType FileTypeForExtension(std::string_view ext)
 	return ProjectFileType::Unknown;
 }
 
+// names of the standard project directories, Windows file system is not case sensitive so neither are we there
+static bool IsKnownDirectoryName(std::string_view name, std::string_view knownName)
+{
+#ifdef _WIN32
+    return name.length() == knownName.length() && std::equal(name.begin(), name.end(), knownName.begin(),
+        [](char a, char b) { return tolower((uint8_t)a) == tolower((uint8_t)b); });
+#else
+    return name == knownName;
+#endif
+}
+
+static bool ListDirectoryWithCache(DirectoryListingCache* cache, const fs::path& directoryPath, std::vector<DirectoryEntry>& outEntries)
+{
+    if (cache)
+        return cache->list(directoryPath, outEntries);
+    return ListDirectory(directoryPath, outEntries);
+}
+
 //--
 
 ProjectInfo::ProjectInfo()
@@ -46,8 +66,10 @@ ProjectInfo::~ProjectInfo()
         delete file;
 }
 
-bool ProjectInfo::scanContent()
+bool ProjectInfo::scanContent(DirectoryListingCache* cache)
 {
+    PROFILE_SCOPE("ProjectInfo::scanContent");
+
     bool valid = true;
 
     if (manifest->optionThirdParty)
@@ -63,24 +85,24 @@ bool ProjectInfo::scanContent()
         }
 
         for (const auto& path : manifest->exportedIncludePaths)
-			valid &= scanFilesAtDir(manifest->loadPath, path, ScanType::PublicFiles, true);
+			valid &= scanFilesAtDir(cache, manifest->loadPath, path, ScanType::PublicFiles, true);
 
 		for (const auto& path : manifest->localIncludePaths)
-			valid &= scanFilesAtDir(manifest->loadPath, path, ScanType::PublicFiles, true);
+			valid &= scanFilesAtDir(cache, manifest->loadPath, path, ScanType::PublicFiles, true);
     }
     else if (manifest->optionLegacy)
     {
         if (manifest->legacySourceDirectories.empty())
         {
 			const auto publicFilePath = manifest->rootPath;
-			valid &= scanFilesAtDir(publicFilePath, publicFilePath, ScanType::PublicFiles, true);
+			valid &= scanFilesAtDir(cache, publicFilePath, publicFilePath, ScanType::PublicFiles, true);
         }
         else
         {
             for (const auto& localPath : manifest->legacySourceDirectories)
             {
 				const auto publicFilePath = manifest->rootPath / localPath;
-				valid &= scanFilesAtDir(publicFilePath, publicFilePath, ScanType::PublicFiles, false);
+				valid &= scanFilesAtDir(cache, publicFilePath, publicFilePath, ScanType::PublicFiles, false);
             }
         }
 
@@ -91,35 +113,7 @@ bool ProjectInfo::scanContent()
     }
     else
     {
-        {
-            const auto publicFilePath = manifest->rootPath / "include";
-            valid &= scanFilesAtDir(publicFilePath, publicFilePath, ScanType::PublicFiles, true);
-        }
-
-        {
-            const auto privateFilePath = manifest->rootPath / "src";
-            valid &= scanFilesAtDir(privateFilePath, privateFilePath, ScanType::PrivateFiles, true);
-        }
-
-        {
-            const auto privateFilePath = manifest->rootPath / "natvis";
-            valid &= scanFilesAtDir(privateFilePath, privateFilePath, ScanType::PrivateFiles, true);
-        }
-
-        {
-            const auto mediaFilePath = manifest->rootPath / "media";
-            valid &= scanFilesAtDir(mediaFilePath, mediaFilePath, ScanType::MediaFiles, true);
-        }
-
-        {
-            const auto mediaFilePath = manifest->rootPath / "res";
-            valid &= scanFilesAtDir(mediaFilePath, mediaFilePath, ScanType::ResourceFiles, true);
-        }
-
-        {
-            const auto mediaFilePath = manifest->rootPath;
-            valid &= scanFilesAtDir(mediaFilePath, mediaFilePath, ScanType::PrivateFiles, false);
-        }
+        valid &= scanProjectDirectory(cache);
     }
 
     return valid;
@@ -161,8 +155,8 @@ bool ProjectInfo::internalTryAddFileFromPath(const fs::path& scanRootPath, const
     file->type = type;
     file->absolutePath = absolutePath;
     file->name = shortName;
-    file->projectRelativePath = MakeGenericPathEx(fs::relative(absolutePath, rootPath));
-    file->scanRelativePath = MakeGenericPathEx(fs::relative(absolutePath, scanRootPath));
+    file->projectRelativePath = MakeRelativePathFast(absolutePath, rootPath);
+    file->scanRelativePath = MakeRelativePathFast(absolutePath, scanRootPath);
     file->originalProject = this;
     files.push_back(file);
 
@@ -171,29 +165,72 @@ bool ProjectInfo::internalTryAddFileFromPath(const fs::path& scanRootPath, const
     return true;    
 }
 
-bool ProjectInfo::scanFilesAtDir(const fs::path& scanRootPath, const fs::path& directoryPath, ScanType type, bool recursive)
+bool ProjectInfo::scanProjectDirectory(DirectoryListingCache* cache)
 {
-    bool valid = true;
+    // the project root is listed once, known sub directories are scanned recursively with their type and the loose files in the root are private files
+    // NOTE: sub directories are processed in fixed order so the file list does not depend on the order the file system returns the entries in
+    static const std::pair<const char*, ScanType> KnownDirectories[] = {
+        { "include", ScanType::PublicFiles },
+        { "src", ScanType::PrivateFiles },
+        { "natvis", ScanType::PrivateFiles },
+        { "media", ScanType::MediaFiles },
+        { "res", ScanType::ResourceFiles },
+    };
+
+    const auto& projectRootPath = manifest->rootPath;
+
+    std::vector<DirectoryEntry> entries;
+    if (!ListDirectoryWithCache(cache, projectRootPath, entries))
+        return false;
+
+    scannedDirectories.push_back(projectRootPath);
 
-    try
+    bool valid = true;
+    for (const auto& known : KnownDirectories)
     {
-        if (fs::is_directory(directoryPath))
+        for (const auto& entry : entries)
         {
-            for (const auto& entry : fs::directory_iterator(directoryPath))
+            if (entry.type == DirectoryEntryType::Directory && IsKnownDirectoryName(entry.name, known.first))
             {
-                const auto name = entry.path().filename().u8string();
-
-                if (entry.is_directory() && recursive)
-                    valid &= scanFilesAtDir(scanRootPath, entry.path(), type, recursive);
-                else if (entry.is_regular_file())
-                    valid &= internalTryAddFileFromPath(scanRootPath, entry.path(), type);
+                const auto directoryPath = projectRootPath / entry.name;
+                valid &= scanFilesAtDir(cache, directoryPath, directoryPath, known.second, true);
             }
         }
     }
-    catch (fs::filesystem_error& e)
+
+    for (const auto& entry : entries)
     {
-        LogError() << "Filesystem Error: " << e.what();
-        valid = false;
+        if (entry.type == DirectoryEntryType::File)
+        {
+            Profiler_AddCounter(ProfilerCounter::FilesScanned);
+            valid &= internalTryAddFileFromPath(projectRootPath, projectRootPath / entry.name, ScanType::PrivateFiles);
+        }
+    }
+
+    return valid;
+}
+
+bool ProjectInfo::scanFilesAtDir(DirectoryListingCache* cache, const fs::path& scanRootPath, const fs::path& directoryPath, ScanType type, bool recursive)
+{
+    std::vector<DirectoryEntry> entries;
+    if (!ListDirectoryWithCache(cache, directoryPath, entries))
+        return false;
+
+    scannedDirectories.push_back(directoryPath);
+
+    bool valid = true;
+    for (const auto& entry : entries)
+    {
+        if (entry.type == DirectoryEntryType::Directory)
+        {
+            if (recursive)
+                valid &= scanFilesAtDir(cache, scanRootPath, directoryPath / entry.name, type, recursive);
+        }
+        else if (entry.type == DirectoryEntryType::File)
+        {
+            Profiler_AddCounter(ProfilerCounter::FilesScanned);
+            valid &= internalTryAddFileFromPath(scanRootPath, directoryPath / entry.name, type);
+        }
     }
 
     return valid;
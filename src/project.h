@@ -2,6 +2,10 @@
 
 //--
 
+class DirectoryListingCache;
+
+//--
+
 enum class ProjectFileType : uint8_t
 {
 	Unknown,
@@ -53,6 +57,8 @@ struct ProjectInfo
 
     const ProjectManifest* manifest = nullptr; // original manifest
 	const ModuleManifest* parentModule = nullptr; // module this project is from (may be null for generated projects)
+
+	uint32_t index = 0; // index in the project collection, used as node index in the dependency graph
     
 	//--
 
@@ -61,13 +67,14 @@ struct ProjectInfo
 
 	std::vector<ProjectFileInfo*> files; // discovered FINAL project files
 	std::unordered_set<fs::path> filesPaths;
+	std::vector<fs::path> scannedDirectories; // all directories listed during the scan (their listing is part of the make fingerprint)
 
 	//--
 
     ProjectInfo();
 	~ProjectInfo();
 
-	bool scanContent(); // scan for actual files, fails if any of the hand-specified files are missing
+	bool scanContent(DirectoryListingCache* cache = nullptr); // scan for actual files, fails if any of the hand-specified files are missing, directory listings are reused from the cache if given
 	bool resolveDependencies(const ProjectCollection& projects, std::vector<std::string>* outMissingProjectDependencies);
 	bool resolveLibraries(ExternalLibraryReposistory& libs);
 
@@ -83,7 +90,8 @@ private:
 	};
 
 	bool internalTryAddFileFromPath(const fs::path& scanRootPath, const fs::path& absolutePath, ScanType type);
-	bool scanFilesAtDir(const fs::path& scanRootPath, const fs::path& directoryPath, ScanType type, bool recursive);
+	bool scanFilesAtDir(DirectoryListingCache* cache, const fs::path& scanRootPath, const fs::path& directoryPath, ScanType type, bool recursive);
+	bool scanProjectDirectory(DirectoryListingCache* cache);
 };
 
 //--
\ No newline at end of file
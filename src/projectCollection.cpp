@@ -6,10 +6,14 @@
 #include "project.h"
 #include "projectManifest.h"
 #include "utils.h"
+#include "profiler.h"
+#include "dependencyGraph.h"
 
 //--
 
 ProjectCollection::ProjectCollection()
+	: m_projectsPrefixIndex(std::make_unique<NamePrefixIndex>())
+	, m_graph(std::make_unique<DependencyGraph>())
 {}
 
 ProjectCollection::~ProjectCollection()
@@ -27,6 +31,8 @@ static std::string MakeProjectName(std::string_view rootPath)
 
 bool ProjectCollection::populateFromModules(const std::vector<const ModuleManifest*>& modules, const Configuration& config)
 {
+	PROFILE_SCOPE("ProjectCollection::populateFromModules");
+
 	bool valid = true;
 
 	for (const auto* mod : modules)
@@ -71,18 +77,48 @@ bool ProjectCollection::populateFromModules(const std::vector<const ModuleManife
 		}
 	}
 
+	updateProjectIndices();
 	return valid;
 }
 
+void ProjectCollection::updateProjectIndices()
+{
+	m_projectsPrefixIndex->clear();
+
+	for (uint32_t i = 0; i < m_projects.size(); ++i)
+	{
+		m_projects[i]->index = i;
+		m_projectsPrefixIndex->insert(m_projects[i]->name, i);
+	}
+
+	// any previous graph is no longer valid
+	m_graph->reset(0);
+}
+
 ProjectInfo* ProjectCollection::findProject(std::string_view name) const
 {
 	return Find<std::string, ProjectInfo*>(m_projectsMap, std::string(name), nullptr);
 }
 
+void ProjectCollection::collectAllDependents(const std::vector<const ProjectInfo*>& projects, std::vector<const ProjectInfo*>& outProjects) const
+{
+	std::vector<uint32_t> indices;
+	for (const auto* proj : projects)
+		indices.push_back(proj->index);
+
+	std::vector<uint32_t> dependentIndices;
+	m_graph->collectAllDependents(indices, dependentIndices);
+
+	for (const auto index : dependentIndices)
+		outProjects.push_back(m_projects[index]);
+}
+
 //--
 
-bool ProjectCollection::scanContent(uint32_t& outTotalFiles) const
+bool ProjectCollection::scanContent(uint32_t& outTotalFiles, DirectoryListingCache* cache) const
 {
+	PROFILE_SCOPE("ProjectCollection::scanContent");
+
 	std::atomic<bool> valid = true;
 	std::atomic<uint32_t> numFiles = 0;
 
@@ -91,7 +127,7 @@ bool ProjectCollection::scanContent(uint32_t& outTotalFiles) const
 	{
 		auto* project = m_projects[i];
 
-		if (!project->scanContent())
+		if (!project->scanContent(cache))
 			valid = false;
 
 		numFiles += (uint32_t)project->files.size();
@@ -108,18 +144,22 @@ bool ProjectCollection::resolveDependency(const std::string_view name, std::vect
 	if (EndsWith(name, "*"))
 	{
 		const auto pattern = name.substr(0, name.length() - 1);
-		for (auto* proj : m_projects)
+
+		// prefix index returns projects in the collection order
+		std::vector<uint32_t> matchingProjects;
+		m_projectsPrefixIndex->findByPrefix(pattern, matchingProjects);
+
+		for (const auto index : matchingProjects)
 		{
+			auto* proj = m_projects[index];
+
 			// we are only tracking libs
 			if (proj->manifest->type == ProjectType::SharedLibrary || proj->manifest->type == ProjectType::StaticLibrary)
 			{
-				if (BeginsWith(proj->name, pattern))
+				const auto remainingName = proj->name.substr(pattern.length());
+				if (remainingName.find('/') == std::string_view::npos)
 				{
-					const auto remainingName = proj->name.substr(pattern.length());
-					if (remainingName.find('/') == std::string_view::npos)
-					{
-						PushBackUnique(outProjects, proj);
-					}
+					PushBackUnique(outProjects, proj);
 				}
 			}
 		}
@@ -169,6 +209,8 @@ bool ProjectCollection::resolveDependency(const std::string_view name, std::vect
 
 bool ProjectCollection::filterProjects(const Configuration& config)
 {
+	PROFILE_SCOPE("ProjectCollection::filterProjects");
+
 	// clear old mapping
 	auto oldProjects = std::move(m_projects);
 	m_projects.clear();
@@ -186,6 +228,8 @@ bool ProjectCollection::filterProjects(const Configuration& config)
 		m_projectsMap[proj->name] = proj;
 	}
 
+	updateProjectIndices();
+
 	if (oldProjects.size() != m_projects.size())
 	{
 		const auto numRemoved = oldProjects.size() - m_projects.size();
@@ -197,12 +241,30 @@ bool ProjectCollection::filterProjects(const Configuration& config)
 
 bool ProjectCollection::resolveDependencies(const Configuration& config)
 {
+	PROFILE_SCOPE("ProjectCollection::resolveDependencies");
+
 	bool valid = true;
 
 	std::vector<std::string> missingProjectDependencies;
 	for (auto* proj : m_projects)
 		valid &= proj->resolveDependencies(*this, &missingProjectDependencies);
 
+	// build the dependency graph, all transitive queries are answered by it
+	m_graph->reset((uint32_t)m_projects.size());
+	for (const auto* proj : m_projects)
+		for (const auto* dep : proj->resolvedDependencies)
+			m_graph->addEdge(proj->index, dep->index);
+
+	std::vector<uint32_t> unorderedProjects;
+	if (!m_graph->build(&unorderedProjects))
+	{
+		valid = false;
+
+		LogError() << "Found " << unorderedProjects.size() << " project(s) with recursive dependencies (part of a dependency cycle or depending on one)";
+		for (const auto index : unorderedProjects)
+			LogError() << "  '" << m_projects[index]->name << "'";
+	}
+
 	if (!missingProjectDependencies.empty())
 	{
 		valid = false;
@@ -258,6 +320,8 @@ bool ProjectCollection::resolveDependencies(const Configuration& config)
 
 bool ProjectCollection::resolveLibraries(ExternalLibraryReposistory& libs)
 {
+	PROFILE_SCOPE("ProjectCollection::resolveLibraries");
+
 	bool valid = true;
 
 	for (auto* proj : m_projects)
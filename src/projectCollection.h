@@ -7,6 +7,9 @@ struct ProjectInfo;
 struct ExternalLibraryManifest;
 struct ModuleManifest;
 class ExternalLibraryReposistory;
+class DirectoryListingCache;
+class DependencyGraph;
+class NamePrefixIndex;
 
 class ProjectCollection
 {
@@ -21,13 +24,16 @@ public:
     inline const std::vector<fs::path>& rootIncludePaths() const { return m_rootIncludePaths; }
     inline const std::vector<ProjectInfo*>& projects() const { return m_projects; }
 
+    // graph of resolved dependencies, nodes are project indices (valid after resolveDependencies)
+    inline const DependencyGraph& dependencyGraph() const { return *m_graph; }
+
     //--
 
     bool populateFromModules(const std::vector<const ModuleManifest*>& modules, const Configuration& config);
     bool filterProjects(const Configuration& config);
     bool resolveDependencies(const Configuration& config);
     bool resolveLibraries(ExternalLibraryReposistory& libs);
-    bool scanContent(uint32_t& outTotalFiles) const;
+    bool scanContent(uint32_t& outTotalFiles, DirectoryListingCache* cache = nullptr) const;
 
     bool resolveDependency(const std::string_view name, std::vector<ProjectInfo*>& outProjects, bool soft, std::vector<std::string>* outMissingDependencies) const;
 
@@ -35,6 +41,9 @@ public:
 
     ProjectInfo* findProject(std::string_view name) const;
 
+    // given projects and all projects that depend on them, directly or not, in collection order
+    void collectAllDependents(const std::vector<const ProjectInfo*>& projects, std::vector<const ProjectInfo*>& outProjects) const;
+
     //--
 
 private:
@@ -44,6 +53,11 @@ private:
 
 	std::vector<ProjectInfo*> m_projects; // all discovered projects
 	std::unordered_map<std::string, ProjectInfo*> m_projectsMap; // projects by name
+	std::unique_ptr<NamePrefixIndex> m_projectsPrefixIndex; // project indices by name, for wildcard dependencies
+
+	std::unique_ptr<DependencyGraph> m_graph;
+
+	void updateProjectIndices();
 };
 
 //--
\ No newline at end of file
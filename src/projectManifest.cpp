@@ -297,6 +297,12 @@ bool ProjectManifest::LoadKey(const void* nodePtr, const fs::path& modulePath, P
 		ret->appSystemClasses.push_back(std::string(XMLNodeValue(node)));
 	else if (option == "AdvancedInstructionSet")
 		valid &= EvalAdvancedInstructionSet(ret->optionAdvancedInstructionSet, node);
+	else if (option == "UnityBuild")
+		ret->optionUnityBuild = XMLNodeValueBool(node, true) ? ProjectUnityBuildMode::Enabled : ProjectUnityBuildMode::Disabled;
+	else if (option == "UnityBatchSize")
+		ret->optionUnityBatchSize = XMLNodeValueInt(node, ret->optionUnityBatchSize);
+	else if (option == "UnityExclude")
+		ret->unityExcludedFiles.push_back(ReplaceAll(XMLNodeValue(node), "\\", "/"));
 	else
 	{
 		LogError() << "Unknown project's manifest option '" << option << "'";
@@ -306,11 +312,12 @@ bool ProjectManifest::LoadKey(const void* nodePtr, const fs::path& modulePath, P
 	return valid;
 }
 
-bool EvalPlatformFilters(const XMLNode* node, PlatformType platform)
+bool EvalPlatformFilters(const XMLNode* node, PlatformType platform, bool verbose)
 {
 	{
 		const auto txt = XMLNodeAttrbiute(node, "include");
-		LogInfo() << "Include filter '" << txt << "', platform: " << NameEnumOption(platform);
+		if (verbose)
+			LogInfo() << "Include filter '" << txt << "', platform: " << NameEnumOption(platform);
 		if (!txt.empty())
 		{
 			std::vector<std::string_view> options;
@@ -318,10 +325,12 @@ bool EvalPlatformFilters(const XMLNode* node, PlatformType platform)
 
 			for (const auto& opt : options)
 			{
-				LogInfo() << "Checking filter '" << opt << "'";
+				if (verbose)
+					LogInfo() << "Checking filter '" << opt << "'";
 				if (MatchesPlatform(platform, opt))
 				{
-					LogInfo() << "Matched filter '" << opt << "'";
+					if (verbose)
+						LogInfo() << "Matched filter '" << opt << "'";
 					return true;
 				}
 			}
@@ -391,7 +400,7 @@ bool ProjectManifest::LoadKeySet(const void* root, const fs::path& modulePath, P
 		{
 			if (option == "FilterPlatform")
 			{
-				if (EvalPlatformFilters(node, config.platform))
+				if (EvalPlatformFilters(node, config.platform, true))
 				{
 					valid &= LoadKeySet(node, modulePath, ret, config);
 				}
@@ -497,4 +506,148 @@ ProjectManifest* ProjectManifest::Load(const void* rootPtr, const fs::path& modu
 	return ret.release();
 }
 
+//--
+
+static void WriteDefines(BinaryWriter& writer, const std::vector<std::pair<std::string, std::string>>& defines)
+{
+	writer.writeU32((uint32_t)defines.size());
+	for (const auto& def : defines)
+	{
+		writer.writeString(def.first);
+		writer.writeString(def.second);
+	}
+}
+
+static void ReadDefines(BinaryReader& reader, std::vector<std::pair<std::string, std::string>>& outDefines)
+{
+	const auto count = reader.readU32();
+	outDefines.clear();
+	for (uint32_t i = 0; i < count && reader.ok(); ++i)
+	{
+		auto key = reader.readString();
+		auto value = reader.readString();
+		outDefines.emplace_back(std::move(key), std::move(value));
+	}
+}
+
+void ProjectManifest::writeBinary(BinaryWriter& writer) const
+{
+	writer.writeString(name);
+	writer.writeString(guid);
+	writer.writeString(solutionGroupName);
+	writer.writeString(localGroupName);
+	writer.writePath(loadPath);
+	writer.writePath(rootPath);
+
+	writer.writeU8((uint8_t)type);
+	writer.writeU8((uint8_t)optionLinkType);
+	writer.writeU8((uint8_t)optionSubstem);
+	writer.writeU8((uint8_t)optionTestFramework);
+	writer.writeU8((uint8_t)optionUnityBuild);
+
+	writer.writeU32((uint32_t)optionWarningLevel);
+	writer.writeU8(optionDetached);
+	writer.writeU8(optionUseStaticInit);
+	writer.writeU8(optionUsePrecompiledHeaders);
+	writer.writeU8(optionUseExceptions);
+	writer.writeU8(optionGenerateMain);
+	writer.writeU8(optionGenerateSymbols);
+	writer.writeU8(optionExportApplicataion);
+	writer.writeU8(optionSelfTest);
+	writer.writeU8(optionHasPreMain);
+	writer.writeU8(optionLegacy);
+	writer.writeU8(optionThirdParty);
+	writer.writeU8(optionFrozen);
+	writer.writeU8(optionEngineOnly);
+	writer.writeU8(optionHasInit);
+	writer.writeU8(optionHasPreInit);
+	writer.writeString(optionAdvancedInstructionSet);
+	writer.writeU32((uint32_t)optionUnityBatchSize);
+	writer.writeStrings(unityExcludedFiles);
+
+	writer.writeStrings(dependencies);
+	writer.writeStrings(optionalDependencies);
+	writer.writeStrings(libraryDependencies);
+
+	writer.writePaths(localIncludePaths);
+	writer.writeStrings(legacySourceDirectories);
+	writer.writePaths(exportedIncludePaths);
+
+	WriteDefines(writer, localDefines);
+	WriteDefines(writer, globalDefines);
+
+	writer.writePaths(frozenDeployFiles);
+	writer.writePaths(frozenLibraryFiles);
+
+	writer.writePaths(thirdPartySourceFiles);
+	writer.writeString(thirdPartySharedLocalBuildDefine);
+	writer.writeString(thirdPartySharedGlobalExportDefine);
+
+	writer.writeString(appClassName);
+	writer.writeString(appHeaderName);
+	writer.writeStrings(appSystemClasses);
+	writer.writeU8(appDisableLogOnStart);
+}
+
+bool ProjectManifest::readBinary(BinaryReader& reader)
+{
+	name = reader.readString();
+	guid = reader.readString();
+	solutionGroupName = reader.readString();
+	localGroupName = reader.readString();
+	loadPath = reader.readPath();
+	rootPath = reader.readPath();
+
+	type = (ProjectType)reader.readU8();
+	optionLinkType = (ProjectLibraryLinkType)reader.readU8();
+	optionSubstem = (ProjectAppSubsystem)reader.readU8();
+	optionTestFramework = (ProjectTestFramework)reader.readU8();
+	optionUnityBuild = (ProjectUnityBuildMode)reader.readU8();
+
+	optionWarningLevel = (int)reader.readU32();
+	optionDetached = reader.readU8() != 0;
+	optionUseStaticInit = reader.readU8() != 0;
+	optionUsePrecompiledHeaders = reader.readU8() != 0;
+	optionUseExceptions = reader.readU8() != 0;
+	optionGenerateMain = reader.readU8() != 0;
+	optionGenerateSymbols = reader.readU8() != 0;
+	optionExportApplicataion = reader.readU8() != 0;
+	optionSelfTest = reader.readU8() != 0;
+	optionHasPreMain = reader.readU8() != 0;
+	optionLegacy = reader.readU8() != 0;
+	optionThirdParty = reader.readU8() != 0;
+	optionFrozen = reader.readU8() != 0;
+	optionEngineOnly = reader.readU8() != 0;
+	optionHasInit = reader.readU8() != 0;
+	optionHasPreInit = reader.readU8() != 0;
+	optionAdvancedInstructionSet = reader.readString();
+	optionUnityBatchSize = (int)reader.readU32();
+	reader.readStrings(unityExcludedFiles);
+
+	reader.readStrings(dependencies);
+	reader.readStrings(optionalDependencies);
+	reader.readStrings(libraryDependencies);
+
+	reader.readPaths(localIncludePaths);
+	reader.readStrings(legacySourceDirectories);
+	reader.readPaths(exportedIncludePaths);
+
+	ReadDefines(reader, localDefines);
+	ReadDefines(reader, globalDefines);
+
+	reader.readPaths(frozenDeployFiles);
+	reader.readPaths(frozenLibraryFiles);
+
+	reader.readPaths(thirdPartySourceFiles);
+	thirdPartySharedLocalBuildDefine = reader.readString();
+	thirdPartySharedGlobalExportDefine = reader.readString();
+
+	appClassName = reader.readString();
+	appHeaderName = reader.readString();
+	reader.readStrings(appSystemClasses);
+	appDisableLogOnStart = reader.readU8() != 0;
+
+	return reader.ok();
+}
+
 //--
\ No newline at end of file
@@ -34,6 +34,13 @@ enum class ProjectAppSubsystem : uint8_t
 	Console, // typical console window app
 };
 
+enum class ProjectUnityBuildMode : uint8_t
+{
+	Auto, // follow the global -unity switch
+	Enabled, // always group source files into unity files
+	Disabled, // never use unity files
+};
+
 enum class ProjectTestFramework : uint8_t
 {
 	GTest, // Windows only - project does not have console window
@@ -41,6 +48,8 @@ enum class ProjectTestFramework : uint8_t
 };
 
 struct Configuration;
+class BinaryWriter;
+class BinaryReader;
 
 struct ProjectManifest
 {
@@ -57,6 +66,7 @@ struct ProjectManifest
     ProjectLibraryLinkType optionLinkType = ProjectLibraryLinkType::Auto; // how they library should be linked
     ProjectAppSubsystem optionSubstem = ProjectAppSubsystem::Console;
     ProjectTestFramework optionTestFramework = ProjectTestFramework::GTest;
+    ProjectUnityBuildMode optionUnityBuild = ProjectUnityBuildMode::Auto;
 
     int optionWarningLevel = 4;
     bool optionDetached = false; // dynamic library only - do not link directly
@@ -75,6 +85,8 @@ struct ProjectManifest
 	bool optionHasInit = false; // project has the initialization function called after reflection was established
 	bool optionHasPreInit = false; // project has the initialization function called before reflection was established
     std::string optionAdvancedInstructionSet;
+    int optionUnityBatchSize = 0; // target size of single unity file in KB, 0 - use global setting
+    std::vector<std::string> unityExcludedFiles; // file names or project relative paths (dir/ for whole directory) never put into unity files
 
     std::vector<std::string> dependencies; // dependencies on another projects
     std::vector<std::string> optionalDependencies; // soft dependencies on another projects (we may continue if projects is NOT available)
@@ -107,6 +119,10 @@ struct ProjectManifest
     //static ProjectManifest* Load(const fs::path& path, const Configuration& config);
     static ProjectManifest* Load(const void* node, const fs::path& modulePath, const Configuration& config);
 
+    // binary form of the loaded manifest, used by the manifest cache
+    void writeBinary(BinaryWriter& writer) const;
+    bool readBinary(BinaryReader& reader);
+
 private:
     static bool LoadKey(const void* node, const fs::path& modulePath, ProjectManifest* ret);
     static bool LoadKeySet(const void* node, const fs::path& modulePath, ProjectManifest* ret, const Configuration& config);
@@ -11,6 +11,8 @@
 #include "solutionGenerator.h"
 #include "toolEmbed.h"
 #include "toolReflection.h"
+#include "profiler.h"
+#include "dependencyGraph.h"
 
 //--
 
@@ -47,6 +49,7 @@ SolutionProject::~SolutionProject()
 SolutionGenerator::SolutionGenerator(FileRepository& files, const Configuration& config, std::string_view mainGroup)
     : m_config(config)
     , m_files(files)
+    , m_dependencyGraph(std::make_unique<DependencyGraph>())
 {
     m_rootGroup = new SolutionGroup;
     m_rootGroup->name = mainGroup;
@@ -64,52 +67,6 @@ SolutionGenerator::~SolutionGenerator()
     delete m_rootGroup;
 }
 
-struct OrderedGraphBuilder
-{
-    std::unordered_map<SolutionProject*, int> depthMap;    
-
-    bool insertProject(SolutionProject* p, int depth, std::vector<SolutionProject*>& stack)
-    {
-        if (find(stack.begin(), stack.end(), p) != stack.end())
-        {
-            LogInfo() << "Recursive project dependencies found when project '" << p->name << "' was encountered second time";
-            for (const auto* proj : stack)
-                LogInfo() << "  Reachable from '" << proj->name << "'";
-            return false;
-        }
-
-        auto currentDepth = depthMap[p];
-        if (depth > currentDepth)
-        {
-            depthMap[p] = depth;
-
-            stack.push_back(p);
-
-            for (auto* dep : p->directDependencies)
-                if (!insertProject(dep, depth + 1, stack))
-                    return false;
-
-            stack.pop_back();
-        }
-
-        return true;
-    }
-
-    void extractOrderedList(std::vector<SolutionProject*>& outList) const
-    {
-        std::vector<std::pair<SolutionProject*, int>> pairs;
-        std::copy(depthMap.begin(), depthMap.end(), std::back_inserter(pairs));
-        std::sort(pairs.begin(), pairs.end(), [](const auto& a, const auto& b) -> bool {
-            if (a.second != b.second)
-                return a.second > b.second;
-            return a.first->name < b.first->name;
-            });
-        
-        for (const auto& pair : pairs)
-            outList.push_back(pair.first);
-    }
-};
-
 SolutionGroup* SolutionGenerator::findOrCreateGroup(std::string_view name, SolutionGroup* parent)
 {
     for (auto* group : parent->children)
@@ -145,16 +102,39 @@ SolutionGroup* SolutionGenerator::createGroup(std::string_view name, SolutionGro
     return cur;
 }
 
-static bool HasDependency(const SolutionProject* project, std::string_view name)
+bool SolutionGenerator::buildDependencyGraph()
 {
-    for (const auto* dep : project->allDependencies)
-        if (dep->name == name)
-            return true;
+    for (uint32_t i = 0; i < m_projects.size(); ++i)
+        m_projects[i]->graphIndex = i;
+
+    m_dependencyGraph->reset((uint32_t)m_projects.size());
+    for (const auto* proj : m_projects)
+        for (const auto* dep : proj->directDependencies)
+            m_dependencyGraph->addEdge(proj->graphIndex, dep->graphIndex);
+
+    std::vector<uint32_t> unorderedProjects;
+    if (!m_dependencyGraph->build(&unorderedProjects))
+    {
+        LogError() << "Recursive project dependencies found, " << unorderedProjects.size() << " project(s) are part of a dependency cycle or depend on one";
+        for (const auto index : unorderedProjects)
+            LogError() << "  '" << m_projects[index]->name << "'";
+        return false;
+    }
+
+    return true;
+}
+
+bool SolutionGenerator::hasDependency(const SolutionProject* project, std::string_view name) const
+{
+    if (const auto* dep = findProject(name))
+        return m_dependencyGraph->dependsOn(project->graphIndex, dep->graphIndex);
     return false;
 }
 
 bool SolutionGenerator::extractProjects(const ProjectCollection& collection)
 {
+    PROFILE_SCOPE("SolutionGenerator::extractProjects");
+
     // cache folder
     {
         SolutionDataFolder data;
@@ -213,6 +193,20 @@ bool SolutionGenerator::extractProjects(const ProjectCollection& collection)
         generatorProject->optionAdvancedInstructionSet = proj->manifest->optionAdvancedInstructionSet;
         generatorProject->optionFrozen = proj->manifest->optionFrozen;
 		generatorProject->frozenLibraryFiles = proj->manifest->frozenLibraryFiles;
+        generatorProject->unityExcludedFiles = proj->manifest->unityExcludedFiles;
+
+        // unity build, third party and legacy code is not grouped unless explicitly asked for
+        if (proj->manifest->optionUnityBuild == ProjectUnityBuildMode::Auto)
+            generatorProject->optionUnityBuild = m_config.flagUnityBuild && !proj->manifest->optionThirdParty && !proj->manifest->optionLegacy && !proj->manifest->optionFrozen;
+        else
+            generatorProject->optionUnityBuild = (proj->manifest->optionUnityBuild == ProjectUnityBuildMode::Enabled);
+
+        if (proj->manifest->optionUnityBatchSize > 0)
+            generatorProject->optionUnityBatchSize = proj->manifest->optionUnityBatchSize;
+        else if (m_config.unityBatchSize > 0)
+            generatorProject->optionUnityBatchSize = m_config.unityBatchSize;
+        else
+            generatorProject->optionUnityBatchSize = 128;
 
         // if we have the "init.cpp" file enable the init and pre-init automatically
         for (const auto* file : proj->files)
@@ -312,50 +306,41 @@ bool SolutionGenerator::extractProjects(const ProjectCollection& collection)
         }
     }
 
-	// build merged dependencies
+	// build merged dependencies, the ones with the longest dependency path from the project go first
 	bool validDeps = true;
-	for (auto* proj : m_projects)
-	{
-		std::vector<SolutionProject*> stack;
-		stack.push_back(proj);
+	if (!buildDependencyGraph())
+		return false;
 
-		OrderedGraphBuilder graph;
-		for (auto* dep : proj->directDependencies)
-			validDeps &= graph.insertProject(dep, 1, stack);
-		graph.extractOrderedList(proj->allDependencies);
-	}
-
-    // build "global" dependency graph for the whole solution
-    // this represents overall project dependencies
-    {
-		OrderedGraphBuilder graph;
-
-        for (auto* proj : m_projects)
-        {
-            std::vector<SolutionProject*> stack;
-            stack.push_back(proj);
+	{
+		std::vector<uint32_t> depths, dependencies;
+		for (auto* proj : m_projects)
+		{
+			m_dependencyGraph->computeDependencyDepths(proj->graphIndex, depths);
 
-            for (auto* dep : proj->directDependencies)
-                validDeps &= graph.insertProject(dep, 1, stack);
-        }
+			dependencies.clear();
+			m_dependencyGraph->collectAllDependencies(proj->graphIndex, dependencies);
 
-        // use the ordered list as project list, so we always have projects from most basic to most complicated
-		graph.extractOrderedList(this->m_projects);
+			for (const auto index : dependencies)
+				proj->allDependencies.push_back(m_projects[index]);
 
-        for (const auto* proj : m_projects)
-            LogInfo() << proj->name;
-    }
+			std::sort(proj->allDependencies.begin(), proj->allDependencies.end(), [&depths](const SolutionProject* a, const SolutionProject* b) -> bool {
+				if (depths[a->graphIndex] != depths[b->graphIndex])
+					return depths[a->graphIndex] > depths[b->graphIndex];
+				return a->name < b->name;
+				});
+		}
+	}
 
 	// disable static initialization on projects that don't use the core
     for (auto* proj : m_projects)
     {
-        if (proj->optionUseReflection && !HasDependency(proj, "core_object") && proj->name != "core_object")
+        if (proj->optionUseReflection && !hasDependency(proj, "core_object") && proj->name != "core_object")
             proj->optionUseReflection = false;
 
-		if (proj->optionUseStaticInit && !HasDependency(proj, "core_system") && proj->name != "core_system")
+		if (proj->optionUseStaticInit && !hasDependency(proj, "core_system") && proj->name != "core_system")
 			proj->optionUseStaticInit = false;
 
-		if (proj->optionUseEmbeddedFiles && !HasDependency(proj, "core_file"))
+		if (proj->optionUseEmbeddedFiles && !hasDependency(proj, "core_file"))
 			proj->optionUseEmbeddedFiles = false;
     }
 
@@ -401,18 +386,25 @@ bool SolutionGenerator::extractProjects(const ProjectCollection& collection)
         }
     }
 
-    // build final project list
+    // build final project list, so we always have projects from most basic to most complicated
     {
-        auto temp = std::move(m_projects);
-		m_projects.clear();
+        if (!buildDependencyGraph())
+            return false;
+
+        std::vector<uint32_t> levels;
+        m_dependencyGraph->computeLevels(levels);
 
-        std::vector<SolutionProject*> stack;
+        std::sort(m_projects.begin(), m_projects.end(), [&levels](const SolutionProject* a, const SolutionProject* b) -> bool {
+            if (levels[a->graphIndex] != levels[b->graphIndex])
+                return levels[a->graphIndex] > levels[b->graphIndex];
+            return a->name < b->name;
+            });
 
-        OrderedGraphBuilder graph;
-        for (auto* proj : temp)
-            validDeps &= graph.insertProject(proj, 1, stack);
+        // graph indices must follow the final order
+        validDeps &= buildDependencyGraph();
 
-        graph.extractOrderedList(m_projects);
+        for (const auto* proj : m_projects)
+            LogInfo() << proj->name;
     }
 
     // extract base include directories (source code roots)
@@ -456,6 +448,8 @@ bool SolutionGenerator::extractProjects(const ProjectCollection& collection)
 
 bool SolutionGenerator::generateAutomaticCode(FileGenerator& fileGenerator)
 {
+    PROFILE_SCOPE("SolutionGenerator::generateAutomaticCode");
+
     std::atomic<bool> valid = true;
 
 	// TODO: fix
@@ -490,6 +484,8 @@ bool SolutionGenerator::generateAutomaticCode(FileGenerator& fileGenerator)
 
 bool SolutionGenerator::generateAutomaticCodeForProject(SolutionProject* project, FileGenerator& fileGenerator)
 {
+    PROFILE_SCOPE("SolutionGenerator::generateAutomaticCodeForProject");
+
     bool valid = true;
 
     // HACK
@@ -873,6 +869,16 @@ bool SolutionGenerator::generateAutomaticCodeForProject(SolutionProject* project
         }
 	}
 
+    // group source files into unity files
+    if (project->optionUnityBuild)
+    {
+        if (!generateProjectUnityFiles(project, fileGenerator))
+        {
+            LogError() << "Failed to generate unity files for project '" << project->name << "'";
+            valid = false;
+        }
+    }
+
 	// move build.cpp to the front of the file list
 	for (auto it = project->files.begin(); it != project->files.end(); ++it)
 	{
@@ -889,6 +895,192 @@ bool SolutionGenerator::generateAutomaticCodeForProject(SolutionProject* project
     return valid;
 }
 
+static bool IsFileExcludedFromUnityBuild(const SolutionProject* project, const SolutionProjectFile* file, std::string_view relativePath)
+{
+    for (const auto& pattern : project->unityExcludedFiles)
+    {
+        if (pattern == file->name || pattern == relativePath)
+            return true;
+
+        // whole directory
+        if (EndsWith(pattern, "/") && BeginsWith(relativePath, pattern))
+            return true;
+    }
+
+    return false;
+}
+
+struct UnityFileCandidate
+{
+    SolutionProjectFile* file = nullptr;
+    std::string relativePath;
+    uint64_t pathHash = 0;
+    uint64_t size = 0;
+};
+
+typedef std::vector<const UnityFileCandidate*> UnityBatch;
+
+// split batch that got too big at the secondary boundaries (different bits of the path hash), first with the same average number of files between cuts as
+// the primary boundaries and then halving it until every file is alone, only the boundaries inside the oversized batch are added so the rest of the batches stays as it was
+static void SplitOversizedUnityBatch(UnityBatch&& batch, uint64_t maxSize, uint64_t filesPerCut, std::vector<UnityBatch>& outBatches)
+{
+    uint64_t batchSize = 0;
+    for (const auto* candidate : batch)
+        batchSize += candidate->size;
+
+    if (batchSize <= maxSize || batch.size() < 2 || filesPerCut == 0)
+    {
+        outBatches.push_back(std::move(batch));
+        return;
+    }
+
+    UnityBatch currentBatch;
+    for (const auto* candidate : batch)
+    {
+        currentBatch.push_back(candidate);
+
+        if (((candidate->pathHash >> 32) % filesPerCut) == 0)
+        {
+            SplitOversizedUnityBatch(std::move(currentBatch), maxSize, filesPerCut / 2, outBatches);
+            currentBatch.clear();
+        }
+    }
+
+    if (!currentBatch.empty())
+        SplitOversizedUnityBatch(std::move(currentBatch), maxSize, filesPerCut / 2, outBatches);
+}
+
+bool SolutionGenerator::generateProjectUnityFiles(SolutionProject* project, FileGenerator& fileGenerator)
+{
+
+    // only the project's own C++ files can be grouped, generated files (build.cpp, reflection, main, embedded media) are always compiled alone
+    std::vector<UnityFileCandidate> candidates;
+    uint64_t totalSize = 0;
+    for (auto* file : project->files)
+    {
+        if (file->type != ProjectFileType::CppSource || !file->useInCurrentBuild)
+            continue;
+
+        const auto ext = file->absolutePath.extension().u8string();
+        if (ext != ".cpp" && ext != ".cxx" && ext != ".cc")
+            continue;
+
+        // unity file includes the precompiled header so only files compiled with it can be grouped
+        if (project->optionUsePrecompiledHeaders && !file->usePrecompiledHeader)
+            continue;
+
+        if (project->rootPath.empty())
+            continue;
+
+        std::error_code ec;
+        const auto relativePath = fs::relative(file->absolutePath, project->rootPath, ec).generic_u8string();
+        if (ec || relativePath.empty() || BeginsWith(relativePath, ".."))
+            continue;
+
+        if (IsFileExcludedFromUnityBuild(project, file, relativePath))
+            continue;
+
+        UnityFileCandidate candidate;
+        candidate.file = file;
+        candidate.relativePath = relativePath;
+        candidate.pathHash = Crc64((const uint8_t*)relativePath.c_str(), relativePath.length());
+        candidate.size = fs::file_size(file->absolutePath, ec);
+        if (ec)
+            continue;
+
+        totalSize += candidate.size;
+        candidates.push_back(candidate);
+    }
+
+    if (candidates.size() < 2)
+        return true;
+
+    // deterministic order that keeps files from the same directory together
+    std::sort(candidates.begin(), candidates.end(), [](const UnityFileCandidate& a, const UnityFileCandidate& b) { return a.relativePath < b.relativePath; });
+
+    // batch boundaries are chosen by the hash of the file path (content defined chunking) so adding, removing or editing a file
+    // only changes the batch it's in instead of shifting all the following ones, the file count is rounded to a power of two so it does not change with every edit
+    const uint64_t targetSize = (uint64_t)project->optionUnityBatchSize * 1024;
+    const uint64_t averageSize = std::max<uint64_t>(1, totalSize / candidates.size());
+
+    uint64_t filesPerBatch = 1;
+    while (filesPerBatch * 2 * averageSize <= targetSize)
+        filesPerBatch *= 2;
+
+    if (filesPerBatch < 2)
+        return true;
+
+    // batches that are too big (many files between boundaries or few very big files) are split further, never by the accumulated size that would shift the following boundaries
+    std::vector<UnityBatch> batches;
+    {
+        UnityBatch currentBatch;
+        for (const auto& candidate : candidates)
+        {
+            currentBatch.push_back(&candidate);
+
+            if ((candidate.pathHash % filesPerBatch) == 0)
+            {
+                SplitOversizedUnityBatch(std::move(currentBatch), targetSize * 2, filesPerBatch, batches);
+                currentBatch.clear();
+            }
+        }
+
+        if (!currentBatch.empty())
+            SplitOversizedUnityBatch(std::move(currentBatch), targetSize * 2, filesPerBatch, batches);
+    }
+
+    // generate the unity files, named after the first file in the batch so the names are stable as well
+    uint32_t numUnityFiles = 0;
+    uint32_t numGroupedFiles = 0;
+    for (const auto& batch : batches)
+    {
+        if (batch.size() < 2)
+            continue;
+
+        const auto nameHash = Crc64((const uint8_t*)batch.front()->relativePath.c_str(), batch.front()->relativePath.length());
+
+        char fileName[64];
+        snprintf(fileName, sizeof(fileName), "unity_%08x.cpp", (uint32_t)(nameHash & 0xFFFFFFFF));
+
+        auto* info = new SolutionProjectFile;
+        info->absolutePath = (project->generatedPath / fileName).make_preferred();
+        info->type = ProjectFileType::CppSource;
+        info->filterPath = "_unity";
+        info->name = fileName;
+        info->usePrecompiledHeader = project->optionUsePrecompiledHeaders;
+        project->files.push_back(info);
+
+        auto generatedFile = fileGenerator.createFile(info->absolutePath);
+        auto& f = generatedFile->content;
+
+        writeln(f, "/***");
+        writeln(f, "* Unity Build File");
+        writeln(f, "* Auto generated, do not modify");
+        writeln(f, "***/");
+        writeln(f, "");
+
+        if (project->optionUsePrecompiledHeaders)
+        {
+            writeln(f, "#include \"build.h\"");
+            writeln(f, "");
+        }
+
+        for (const auto* candidate : batch)
+        {
+            writelnf(f, "#include \"%s\"", MakeGenericPathEx(candidate->file->absolutePath).c_str());
+            candidate->file->useInCurrentBuild = false;
+        }
+
+        numUnityFiles += 1;
+        numGroupedFiles += (uint32_t)batch.size();
+    }
+
+    if (numUnityFiles)
+        LogInfo() << "Grouped " << numGroupedFiles << " source file(s) of project '" << project->name << "' into " << numUnityFiles << " unity file(s)";
+
+    return true;
+}
+
 bool SolutionGenerator::generateProjectAppMainSourceFile(const SolutionProject* project, std::stringstream& f)
 {
     writeln(f, "/***");
@@ -900,7 +1092,7 @@ bool SolutionGenerator::generateProjectAppMainSourceFile(const SolutionProject*
 
     writeln(f, "#include \"build.h\"");
 
-    const auto hasSystem = HasDependency(project, "core_system") || (project->name == "core_system");
+    const auto hasSystem = hasDependency(project, "core_system") || (project->name == "core_system");
 	const auto hasPreMain = project->optionUsePreMain;
 
     if (!project->appHeaderName.empty())
@@ -1109,8 +1301,8 @@ bool SolutionGenerator::generateProjectModuleSourceFile(const SolutionProject* p
     writeln(f, "#include \"build.h\"");
     writeln(f, "");
 
-	const auto hasSystem = HasDependency(project, "core_system") || (project->name == "core_system");
-    const auto hasFileSystem = HasDependency(project, "core_file");
+	const auto hasSystem = hasDependency(project, "core_system") || (project->name == "core_system");
+    const auto hasFileSystem = hasDependency(project, "core_file");
 
     // embedded files header
     if (project->optionUseEmbeddedFiles)
@@ -1125,17 +1317,13 @@ bool SolutionGenerator::generateProjectModuleSourceFile(const SolutionProject* p
         CollectDirectlyLinkedProjects(project, visited, staticallyLinkedProjects, 0, true);
 
         // collect in right order!
+        std::unordered_map<const SolutionProject*, const LinkedProject*> linkedProjectsMap;
+        for (const auto& linkedProject : staticallyLinkedProjects)
+            linkedProjectsMap[linkedProject.project] = &linkedProject;
+
         for (const auto* dep : project->allDependencies)
-        {
-            for (const auto& linkedProject : staticallyLinkedProjects)
-            {
-                if (linkedProject.project == dep)
-                {
-                    orderedStaticallyLinkedProjects.push_back(linkedProject);
-                    break;
-                }
-            }
-        }                
+            if (const auto* linkedProject = Find<const SolutionProject*, const LinkedProject*>(linkedProjectsMap, dep, nullptr))
+                orderedStaticallyLinkedProjects.push_back(*linkedProject);                
     }
 
     // determine if project requires static initialization (the apps and console apps require that)
@@ -1327,17 +1515,7 @@ bool SolutionGenerator::generateProjectModuleSourceFile(const SolutionProject* p
 					if (dep->type == ProjectType::HeaderLibrary)
 						continue;
 
-                    bool hasSystemDependency = false;
-                    for (const auto* subDep : dep->allDependencies)
-                    {
-                        if (subDep->name == "core_system")
-                        {
-                            hasSystemDependency = true;
-                            break;
-                        }
-                    }
-
-                    if (hasSystemDependency)
+                    if (hasDependency(dep, "core_system"))
                     {
                         if (!first) dependenciesString << ";";
                         first = false;
@@ -1944,6 +2122,64 @@ void SolutionGenerator::collectDefines(const SolutionProject* project, TDefines*
 	}
 }
 
+void SolutionGenerator::collectCompilerLauncherCommand(std::vector<std::string>* outCommand) const
+{
+    if (m_config.compilerLauncher.empty())
+        return;
+
+    const auto baseDir = m_config.moduleDirPath.generic_u8string();
+
+    if (m_config.compilerLauncher == "ccache")
+    {
+        outCommand->push_back("CCACHE_BASEDIR=" + baseDir);
+        outCommand->push_back("CCACHE_NOHASHDIR=true");
+        outCommand->push_back("CCACHE_SLOPPINESS=pch_defines,time_macros"); // required to cache files compiled with precompiled headers
+    }
+    else if (m_config.compilerLauncher == "sccache")
+    {
+        outCommand->push_back("SCCACHE_BASEDIRS=" + baseDir);
+    }
+
+    outCommand->push_back(m_config.compilerLauncher);
+}
+
+void SolutionGenerator::collectLinkOptionFlags(ConfigurationType configType, std::string* outCompilerFlags, std::string* outLinkerFlags) const
+{
+    if (!m_config.usesLinkOptions(configType))
+        return;
+
+    if (!m_config.linker.empty())
+        *outLinkerFlags += " -fuse-ld=" + m_config.linker;
+
+    // debug information in .dwo files next to the objects, the linker only sees the skeleton
+    if (m_config.flagSplitDwarf)
+        *outCompilerFlags += " -gsplit-dwarf";
+
+    // the public names are needed by the linker to build the index
+    if (m_config.flagGdbIndex)
+    {
+        *outCompilerFlags += " -ggnu-pubnames";
+        *outLinkerFlags += " -Wl,--gdb-index";
+    }
+
+    if (m_config.flagCompressDebugSections)
+    {
+        *outCompilerFlags += " -gz";
+        *outLinkerFlags += " -gz";
+    }
+}
+
+std::string SolutionGenerator::profileThinLTOLinkerFlag(ConfigurationType configType) const
+{
+    if (m_config.linker.empty())
+        return " -fuse-ld=lld";
+
+    if (m_config.usesLinkOptions(configType))
+        return "";
+
+    return " -fuse-ld=" + m_config.linker;
+}
+
 void SolutionGenerator::collectSourceRoots(const SolutionProject* project, std::vector<fs::path>* outPaths) const
 {
     for (const auto& sourceRoot : m_sourceRoots)
@@ -8,6 +8,7 @@ struct ProjectInfo;
 struct ExternalLibraryManifest;
 class ProjectCollection;
 class FileGenerator;
+class DependencyGraph;
 
 //--
 
@@ -19,6 +20,7 @@ struct SolutionProjectFile
 	std::string scanRelativePath;
 	fs::path absolutePath; // Z:\\projects\\crap\\module\\src\\win\\test.cpp
 	bool usePrecompiledHeader = false;
+	bool useInCurrentBuild = true; // false if file is compiled as part of a unity file
 
 	ProjectFileType type = ProjectFileType::Unknown;
 
@@ -67,8 +69,11 @@ struct SolutionProject
 	bool optionHasPreInit = false;
 	bool optionUseGtest = false;
 	bool optionFrozen = false;
+	bool optionUnityBuild = false;
 	int optionWarningLevel = 4;
+	uint32_t optionUnityBatchSize = 0; // KB
 	std::string optionAdvancedInstructionSet;
+	std::vector<std::string> unityExcludedFiles;
 
     SolutionGroup* group = nullptr;
 
@@ -88,7 +93,9 @@ struct SolutionProject
 	fs::path localReflectionFile; // generated/base_math/reflection.cpp
 
 	std::vector<SolutionProject*> directDependencies;
-	std::vector<SolutionProject*> allDependencies;
+	std::vector<SolutionProject*> allDependencies; // ordered from the most complicated to the most basic ones
+
+	uint32_t graphIndex = 0; // node in the solution dependency graph (index in the project list)
 	std::vector<const ExternalLibraryManifest*> libraryDependencies;
 
 	std::vector<SolutionProjectFile*> files; // may be empty
@@ -158,17 +165,23 @@ protected:
 	//std::unordered_map<const ProjectInfo*, SolutionProject*> m_projectMap;
 	std::unordered_map<std::string, SolutionProject*> m_projectNameMap;
 
+	std::unique_ptr<DependencyGraph> m_dependencyGraph; // direct dependencies between projects, rebuilt when project list changes
+
 	std::vector<fs::path> m_sourceRoots;
 	std::vector<SolutionDataFolder> m_dataFolders;
 
 	SolutionGroup* createGroup(std::string_view name, SolutionGroup* parent = nullptr);
 	SolutionProject* findProject(std::string_view name) const;
 
+	bool buildDependencyGraph(); // assigns graph indices, fails on recursive dependencies
+	bool hasDependency(const SolutionProject* project, std::string_view name) const; // direct or not
+
 	//---
 
     bool generateAutomaticCodeForProject(SolutionProject* project, FileGenerator& fileGenerator);
 
     bool processBisonFile(SolutionProject* project, const SolutionProjectFile* file);
+    bool generateProjectUnityFiles(SolutionProject* project, FileGenerator& fileGenerator);
 
 	bool generateProjectGlueHeaderFile(const SolutionProject* project, std::stringstream& outContent);
     bool generateProjectBuildSourceFile(const SolutionProject* project, std::stringstream& outContent);
@@ -187,6 +200,16 @@ protected:
 
 	void collectSourceRoots(const SolutionProject* project, std::vector<fs::path>* outPaths) const;
 
+	// environment assignments ("NAME=value") and the launcher executable to put in front of compiler invocations, empty if no launcher is used
+	// absolute paths inside the module directory are made relative for hashing so the cache can be shared between checkouts in different locations
+	void collectCompilerLauncherCommand(std::vector<std::string>* outCommand) const;
+
+	// extra compiler and linker flags (each with a leading space) for the link time options used in given configuration
+	void collectLinkOptionFlags(ConfigurationType configType, std::string* outCompilerFlags, std::string* outLinkerFlags) const;
+
+	// linker selection (with a leading space) for the ThinLTO linking of profile optimized Clang builds, the -linker if given or lld, empty if the link options already select it
+	std::string profileThinLTOLinkerFlag(ConfigurationType configType) const;
+
 	static void CollectDefineStringsFromSimpleList(std::string_view txt, TDefines* outDefines);
 	static void CollectDefineStrings(const TDefines& defs, TDefines* outDefines);
 	static void CollectDefineString(std::string_view name, std::string_view value, TDefines* outDefines);
@@ -7,6 +7,7 @@
 #include "fileGenerator.h"
 #include "fileRepository.h"
 #include "solutionGeneratorCMAKE.h"
+#include "profiler.h"
 
 SolutionGeneratorCMAKE::SolutionGeneratorCMAKE(FileRepository& files, const Configuration& config, std::string_view mainGroup)
     : SolutionGenerator(files, config, mainGroup)
@@ -60,6 +61,8 @@ bool SolutionGeneratorCMAKE::initializePlatform()
 
 bool SolutionGeneratorCMAKE::generateSolution(FileGenerator& gen, fs::path* outSolutionPath)
 {
+    PROFILE_SCOPE("SolutionGeneratorCMAKE::generateSolution");
+
     //if (!CheckVersion("cmake", "cmake version", "", "3.22.0"))
       //  return false;
 
@@ -78,6 +81,13 @@ bool SolutionGeneratorCMAKE::generateSolution(FileGenerator& gen, fs::path* outS
 	writeln(f, "cmake_minimum_required(VERSION 3.5)");
 	writeln(f, "");
 
+    // honor CMAKE_INTERPROCEDURAL_OPTIMIZATION for GCC/Clang
+    if (m_config.flagPGO)
+    {
+        writeln(f, "cmake_policy(SET CMP0069 NEW)");
+        writeln(f, "");
+    }
+
     if (!m_platformToolchainFile.empty())
     {
         writelnf(f, "set(CMAKE_TOOLCHAIN_FILE %s)", EscapePath(m_platformToolchainFile).c_str());
@@ -120,6 +130,30 @@ bool SolutionGeneratorCMAKE::generateSolution(FileGenerator& gen, fs::path* outS
 
     writeln(f, "");
 
+    // compiler launcher (ccache, sccache, distcc), the environment is passed via "cmake -E env" so it's part of the generated build
+    {
+        std::vector<std::string> launcherCommand;
+        collectCompilerLauncherCommand(&launcherCommand);
+
+        if (!launcherCommand.empty())
+        {
+            std::stringstream cmd;
+            if (launcherCommand.size() > 1)
+                cmd << "${CMAKE_COMMAND};-E;env;";
+
+            for (size_t i = 0; i < launcherCommand.size(); ++i)
+            {
+                if (i > 0)
+                    cmd << ";";
+                cmd << launcherCommand[i];
+            }
+
+            writelnf(f, "set(CMAKE_C_COMPILER_LAUNCHER \"%s\")", cmd.str().c_str());
+            writelnf(f, "set(CMAKE_CXX_COMPILER_LAUNCHER \"%s\")", cmd.str().c_str());
+            writeln(f, "");
+        }
+    }
+
     //writeln(f, "#include(cotire)");
     writeln(f, "#include(PrecompiledHeader)");
     writeln(f, "include(OptimizeForArchitecture)"); // Praise OpenSource!
@@ -134,6 +168,8 @@ bool SolutionGeneratorCMAKE::generateSolution(FileGenerator& gen, fs::path* outS
 
 bool SolutionGeneratorCMAKE::generateProjects(FileGenerator& gen)
 {
+    PROFILE_SCOPE("SolutionGeneratorCMAKE::generateProjects");
+
     bool valid = true;
 
     #pragma omp parallel for
@@ -257,6 +293,70 @@ bool SolutionGeneratorCMAKE::generateProjectFile(const SolutionProject* p, std::
 		writeln(f, "set( CMAKE_C_FLAGS_RELEASE \"${CMAKE_CXX_FLAGS} -g -O3 -msimd128 -fno-stack-protector\")");
 		writeln(f, "set( CMAKE_C_FLAGS_FINAL \"${CMAKE_CXX_FLAGS} -g -O3 -msimd128 -fno-stack-protector\")");
 		writeln(f, "set( CMAKE_C_FLAGS_PROFILE \"${CMAKE_CXX_FLAGS} -g -O3 -msimd128 -fno-stack-protector\")");
+
+        // profile guided optimization: "Profile" is instrumented, "Final" is optimized with the profile collected by running it ("onion build -pgoTrain=<command>")
+        // Clang writes a raw profile per process that is merged into single file, GCC writes a profile per object file so the build directory is stripped from the names
+        if (m_config.flagPGO)
+        {
+            const auto profilePath = MakeGenericPath((m_config.derivedProfilePathBase / p->name).u8string());
+            const auto mergedProfilePath = MakeGenericPath((m_config.derivedProfilePathBase / "merged.profdata").u8string());
+
+            writeln(f, "if (CMAKE_CXX_COMPILER_ID MATCHES \"Clang\")");
+            writelnf(f, "  set(PGO_GENERATE_FLAGS \"-fprofile-generate=%s\")", profilePath.c_str());
+            writelnf(f, "  set(PGO_USE_FLAGS \"-fprofile-use=%s -Wno-profile-instr-unprofiled -Wno-profile-instr-out-of-date\")", mergedProfilePath.c_str());
+            if (m_config.platform != PlatformType::Darwin && m_config.platform != PlatformType::DarwinArm && m_config.platform != PlatformType::iOS)
+            {
+                // ThinLTO needs a linker that understands LLVM bitcode, lld is used unless a different linker was selected
+                if (m_config.linker.empty())
+                {
+                    writeln(f, "  find_program(PGO_LLD_LINKER NAMES ld.lld)");
+                    writeln(f, "  if (NOT PGO_LLD_LINKER)");
+                    writeln(f, "    message(FATAL_ERROR \"Profile guided optimization with Clang needs the lld linker for the ThinLTO in Final configuration, install lld or select a linker with LTO support with -linker=gold|mold\")");
+                    writeln(f, "  endif()");
+                }
+
+                const auto linkerFlag = profileThinLTOLinkerFlag(ConfigurationType::Final);
+                if (!linkerFlag.empty())
+                    writelnf(f, "  set(PGO_USE_LINKER_FLAGS \"%s\")", linkerFlag.c_str() + 1);
+            }
+            writeln(f, "else()");
+            writelnf(f, "  set(PGO_GENERATE_FLAGS \"-fprofile-generate=%s -fprofile-update=atomic -fprofile-prefix-path=${CMAKE_BINARY_DIR}\")", profilePath.c_str());
+            writelnf(f, "  set(PGO_USE_FLAGS \"-fprofile-use=%s -fprofile-partial-training -fprofile-prefix-path=${CMAKE_BINARY_DIR} -Wno-missing-profile -Wno-error=coverage-mismatch\")", profilePath.c_str());
+            writeln(f, "endif()");
+
+            writeln(f, "set( CMAKE_CXX_FLAGS_PROFILE \"${CMAKE_CXX_FLAGS_PROFILE} ${PGO_GENERATE_FLAGS}\")");
+            writeln(f, "set( CMAKE_C_FLAGS_PROFILE \"${CMAKE_C_FLAGS_PROFILE} ${PGO_GENERATE_FLAGS}\")");
+            writeln(f, "set( CMAKE_EXE_LINKER_FLAGS_PROFILE \"${CMAKE_EXE_LINKER_FLAGS_PROFILE} -fprofile-generate\")");
+            writeln(f, "set( CMAKE_SHARED_LINKER_FLAGS_PROFILE \"${CMAKE_SHARED_LINKER_FLAGS_PROFILE} -fprofile-generate\")");
+
+            writeln(f, "set( CMAKE_CXX_FLAGS_FINAL \"${CMAKE_CXX_FLAGS_FINAL} ${PGO_USE_FLAGS}\")");
+            writeln(f, "set( CMAKE_C_FLAGS_FINAL \"${CMAKE_C_FLAGS_FINAL} ${PGO_USE_FLAGS}\")");
+            writeln(f, "set( CMAKE_EXE_LINKER_FLAGS_FINAL \"${CMAKE_EXE_LINKER_FLAGS_FINAL} ${PGO_USE_LINKER_FLAGS}\")");
+            writeln(f, "set( CMAKE_SHARED_LINKER_FLAGS_FINAL \"${CMAKE_SHARED_LINKER_FLAGS_FINAL} ${PGO_USE_LINKER_FLAGS}\")");
+
+            // link time optimization, CMake uses ThinLTO for Clang and parallel LTO (with gcc-ar for static libraries) for GCC
+            writeln(f, "set(CMAKE_INTERPROCEDURAL_OPTIMIZATION_FINAL ON)");
+        }
+
+        // link time options (faster linker, split debug info, etc), only in the configurations they were requested for
+        for (const auto configType : CONFIGURATIONS)
+        {
+            std::string compilerFlags, linkerFlags;
+            collectLinkOptionFlags(configType, &compilerFlags, &linkerFlags);
+
+            const auto configName = ToUpper(NameEnumOption(configType));
+            if (!compilerFlags.empty())
+            {
+                writelnf(f, "set( CMAKE_CXX_FLAGS_%s \"${CMAKE_CXX_FLAGS_%s}%s\")", configName.c_str(), configName.c_str(), compilerFlags.c_str());
+                writelnf(f, "set( CMAKE_C_FLAGS_%s \"${CMAKE_C_FLAGS_%s}%s\")", configName.c_str(), configName.c_str(), compilerFlags.c_str());
+            }
+
+            if (!linkerFlags.empty())
+            {
+                writelnf(f, "set( CMAKE_EXE_LINKER_FLAGS_%s \"${CMAKE_EXE_LINKER_FLAGS_%s}%s\")", configName.c_str(), configName.c_str(), linkerFlags.c_str());
+                writelnf(f, "set( CMAKE_SHARED_LINKER_FLAGS_%s \"${CMAKE_SHARED_LINKER_FLAGS_%s}%s\")", configName.c_str(), configName.c_str(), linkerFlags.c_str());
+            }
+        }
     }
 #if 0
     else
@@ -309,6 +409,23 @@ bool SolutionGeneratorCMAKE::generateProjectFile(const SolutionProject* p, std::
     }
     writeln(f, "");
 
+    {
+        bool hasUnityFiles = false;
+        for (const auto* pf : p->files)
+        {
+            if (pf->type == ProjectFileType::CppSource && !pf->useInCurrentBuild)
+            {
+                if (!hasUnityFiles)
+                    writeln(f, "# Files compiled as part of unity files");
+                writelnf(f, "set_source_files_properties(%s PROPERTIES HEADER_FILE_ONLY ON)", EscapePath(pf->absolutePath).c_str());
+                hasUnityFiles = true;
+            }
+        }
+
+        if (hasUnityFiles)
+            writeln(f, "");
+    }
+
     writeln(f, "# Project output");
     if (p->type == ProjectType::Application || p->type == ProjectType::TestApplication)
     {
@@ -457,6 +574,28 @@ bool SolutionGeneratorCMAKE::generateProjectFile(const SolutionProject* p, std::
 
     writeln(f, "");
 
+    // GCC/Clang precompiled header, CMake generates the wrapper and the -include flags for us
+    // NOTE: the PCH is never shared between projects (REUSE_FROM) - build.h and the PROJECT_NAME/exports defines are different for every project
+    if (m_config.platform != PlatformType::Windows && m_config.platform != PlatformType::UWP && p->optionUsePrecompiledHeaders && !p->localBuildHeader.empty())
+    {
+        writeln(f, "# Precompiled header setup");
+        writeln(f, "if (COMMAND target_precompile_headers)");
+        writelnf(f, "  target_precompile_headers(%s PRIVATE %s)", p->name.c_str(), EscapePath(p->localBuildHeader).c_str());
+
+        for (const auto* pf : p->files)
+        {
+            if (pf->type == ProjectFileType::CppSource)
+            {
+                // C files would need a separate C version of the PCH
+                if (pf->useInCurrentBuild && (!pf->usePrecompiledHeader || pf->absolutePath.extension() == ".c"))
+                    writelnf(f, "  set_source_files_properties(%s PROPERTIES SKIP_PRECOMPILE_HEADERS ON)", EscapePath(pf->absolutePath).c_str());
+            }
+        }
+
+        writeln(f, "endif()");
+        writeln(f, "");
+    }
+
     if (p->type == ProjectType::SharedLibrary)
     {
         writeln(f, "# Final copy of DLL to binary folder");
@@ -0,0 +1,841 @@
+#include "common.h"
+#include "project.h"
+#include "projectManifest.h"
+#include "utils.h"
+#include "externalLibrary.h"
+#include "configuration.h"
+#include "fileGenerator.h"
+#include "fileRepository.h"
+#include "solutionGeneratorNinja.h"
+#include "profiler.h"
+
+//--
+
+// path used in the "build" statements, spaces and colons have special meaning there
+static std::string NinjaPath(const fs::path& path)
+{
+    const auto txt = MakeGenericPathEx(path);
+
+    std::string ret;
+    ret.reserve(txt.length() + 8);
+
+    for (const auto ch : txt)
+    {
+        if (ch == '$' || ch == ' ' || ch == ':')
+            ret += '$';
+        ret += ch;
+    }
+
+    return ret;
+}
+
+// argument used in the command lines, quoted for the shell if needed
+static std::string NinjaArgument(std::string_view txt)
+{
+    const auto escaped = EscapeArgument(txt);
+
+    std::string ret;
+    ret.reserve(escaped.length() + 8);
+
+    for (const auto ch : escaped)
+    {
+        if (ch == '$')
+            ret += '$';
+        ret += ch;
+    }
+
+    return ret;
+}
+
+static std::string NinjaPathArgument(const fs::path& path)
+{
+    return NinjaArgument(MakeGenericPathEx(path));
+}
+
+// path written into the Makefile-style depfile
+static std::string DepfilePath(const fs::path& path)
+{
+    const auto txt = MakeGenericPathEx(path);
+
+    std::string ret;
+    ret.reserve(txt.length() + 8);
+
+    for (const auto ch : txt)
+    {
+        if (ch == ' ' || ch == '#')
+            ret += '\\';
+        else if (ch == '$')
+            ret += '$';
+        ret += ch;
+    }
+
+    return ret;
+}
+
+static std::string NinjaVariableName(std::string_view name)
+{
+    std::string ret;
+    ret.reserve(name.length());
+
+    for (const auto ch : name)
+    {
+        if ((ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') || (ch >= '0' && ch <= '9') || ch == '_')
+            ret += ch;
+        else
+            ret += '_';
+    }
+
+    return ret;
+}
+
+static bool IsInsideDirectory(const fs::path& path, const fs::path& directory, fs::path& outRelativePath)
+{
+    if (directory.empty())
+        return false;
+
+    std::error_code ec;
+    const auto relative = fs::relative(path, directory, ec);
+    if (ec || relative.empty())
+        return false;
+
+    const auto txt = relative.generic_u8string();
+    if (txt == "." || BeginsWith(txt, ".."))
+        return false;
+
+    outRelativePath = relative;
+    return true;
+}
+
+static const char* ConfigurationCompilerFlags(ConfigurationType configType)
+{
+    switch (configType)
+    {
+    case ConfigurationType::Debug: return "-O0 -DBUILD_DEBUG -D_DEBUG -DDEBUG";
+    case ConfigurationType::Checked: return "-O2 -DBUILD_CHECKED -DNDEBUG";
+    case ConfigurationType::Release: return "-O3 -DBUILD_RELEASE -DNDEBUG";
+    case ConfigurationType::Profile: return "-O3 -DBUILD_FINAL -DPROFILING -DNDEBUG";
+    case ConfigurationType::Final: return "-O3 -DBUILD_FINAL -DNDEBUG";
+    default: break;
+    }
+    return "";
+}
+
+static bool ShouldGenerateProject(const SolutionProject* p)
+{
+    return p->type == ProjectType::SharedLibrary || p->type == ProjectType::StaticLibrary || p->type == ProjectType::Application || p->type == ProjectType::TestApplication;
+}
+
+//--
+
+SolutionGeneratorNinja::SolutionGeneratorNinja(FileRepository& files, const Configuration& config, std::string_view mainGroup)
+    : SolutionGenerator(files, config, mainGroup)
+{
+}
+
+bool SolutionGeneratorNinja::initializeToolchain()
+{
+    if (m_config.platform == PlatformType::Windows || m_config.platform == PlatformType::UWP || m_config.platform == PlatformType::Prospero || m_config.platform == PlatformType::Scarlett)
+    {
+        LogError() << "Ninja generator supports only GCC/Clang toolchains, use the Visual Studio generator for platform '" << NameEnumOption(m_config.platform) << "'";
+        return false;
+    }
+
+    if (m_config.platform == PlatformType::Wasm)
+    {
+        const char* emSdk = std::getenv("EMSDK");
+        if (!emSdk || !*emSdk)
+        {
+            LogError() << "Emscripten SDK is not installed (no EMSDK environment variable found)";
+            LogError() << "Unable to generate WebAssembly solution";
+            return false;
+        }
+
+        m_platformIncludeDirectory = (fs::path(emSdk) / "upstream/emscripten/cache/sysroot/include").make_preferred();
+        if (!fs::is_directory(m_platformIncludeDirectory))
+        {
+            LogError() << "Unable to find Emscripten SDK include directory at " << m_platformIncludeDirectory;
+            LogError() << "Please make sure the Emscripten SDK is installed and EMSDK environment variable points to it (restart may be required)";
+            return false;
+        }
+
+        m_cCompiler = "emcc";
+        m_cxxCompiler = "em++";
+        m_archiver = "emar";
+    }
+    else
+    {
+        const bool apple = (m_config.platform == PlatformType::Darwin || m_config.platform == PlatformType::DarwinArm);
+        m_cCompiler = apple ? "clang" : "cc";
+        m_cxxCompiler = apple ? "clang++" : "c++";
+        m_archiver = "ar";
+    }
+
+    // same environment overrides as CMake uses
+    if (const char* cc = std::getenv("CC"); cc && *cc)
+        m_cCompiler = cc;
+    if (const char* cxx = std::getenv("CXX"); cxx && *cxx)
+        m_cxxCompiler = cxx;
+    if (const char* ar = std::getenv("AR"); ar && *ar)
+        m_archiver = ar;
+
+    // precompiled headers are produced differently by GCC and Clang
+    {
+        ProcessRunResult result;
+        if (RunProcess(m_cxxCompiler, { "--version" }, fs::current_path(), 0, result) && result.exitCode == 0)
+            m_compilerIsClang = (result.output.find("clang") != std::string::npos);
+        else
+            m_compilerIsClang = (m_cxxCompiler.find("clang") != std::string::npos) || m_config.platform == PlatformType::Wasm;
+    }
+
+    // static libraries of the LTO optimized "Final" configuration contain GCC's intermediate code, the plain "ar" may not know how to index it
+    if (m_config.flagPGO && !m_compilerIsClang && m_archiver == "ar")
+        m_archiver = "gcc-ar";
+
+    // ThinLTO of the profile optimized "Final" configuration needs a linker that understands LLVM bitcode, lld is used unless a different linker was selected
+    const bool apple = (m_config.platform == PlatformType::Darwin || m_config.platform == PlatformType::DarwinArm);
+    if (m_config.flagPGO && m_compilerIsClang && !apple && m_config.linker.empty())
+    {
+        ProcessRunResult result;
+        if (!RunProcess("ld.lld", { "--version" }, fs::current_path(), 10000, result) || result.exitCode != 0)
+        {
+            LogError() << "Profile guided optimization with Clang needs the lld linker for the ThinLTO in \"Final\" configuration but 'ld.lld' was not found in PATH";
+            LogError() << "Install lld or select a linker with LTO support with -linker=gold|mold";
+            return false;
+        }
+    }
+
+    LogInfo() << "Using C++ compiler '" << m_cxxCompiler << "'" << (m_compilerIsClang ? " (clang)" : "");
+    return true;
+}
+
+std::string SolutionGeneratorNinja::profileCompilerFlags(const SolutionProject* p, ConfigurationType configType) const
+{
+    if (!m_config.flagPGO)
+        return "";
+
+    const auto profilePath = NinjaPathArgument(m_config.derivedProfilePathBase / p->name);
+
+    // GCC writes profile per object file (named after the relative object path), the configuration's object directory is stripped from the names so "Final" finds what "Profile" wrote
+    const auto objectRootPath = NinjaPathArgument(m_config.derivedSolutionPathBase / "obj" / ToLower(NameEnumOption(configType)));
+
+    std::stringstream flags;
+    if (configType == ConfigurationType::Profile)
+    {
+        flags << " -fprofile-generate=" << profilePath;
+        if (!m_compilerIsClang)
+            flags << " -fprofile-update=atomic -fprofile-prefix-path=" << objectRootPath;
+    }
+    else if (configType == ConfigurationType::Final)
+    {
+        // Clang uses the raw profiles of all processes merged into one file by "onion build -pgoTrain=<command>"
+        if (m_compilerIsClang)
+            flags << " -fprofile-use=" << NinjaPathArgument(m_config.derivedProfilePathBase / "merged.profdata") << " -Wno-profile-instr-unprofiled -Wno-profile-instr-out-of-date -flto=thin";
+        else
+            flags << " -fprofile-use=" << profilePath << " -fprofile-partial-training -fprofile-prefix-path=" << objectRootPath << " -Wno-missing-profile -Wno-error=coverage-mismatch -flto=auto -fno-fat-lto-objects";
+    }
+
+    return flags.str();
+}
+
+std::string SolutionGeneratorNinja::profileLinkerFlags(ConfigurationType configType) const
+{
+    if (!m_config.flagPGO)
+        return "";
+
+    if (configType == ConfigurationType::Profile)
+        return " -fprofile-generate";
+
+    if (configType == ConfigurationType::Final)
+    {
+        if (!m_compilerIsClang)
+            return " -flto=auto";
+
+        // ThinLTO needs a linker that understands LLVM bitcode
+        const bool apple = (m_config.platform == PlatformType::Darwin || m_config.platform == PlatformType::DarwinArm);
+        return apple ? " -flto=thin" : " -flto=thin" + profileThinLTOLinkerFlag(configType);
+    }
+
+    return "";
+}
+
+fs::path SolutionGeneratorNinja::projectLibraryPath(const SolutionProject* p, ConfigurationType configType) const
+{
+    const auto libDir = m_config.derivedSolutionPathBase / "lib" / ToLower(NameEnumOption(configType));
+
+    if (p->type == ProjectType::StaticLibrary)
+        return (libDir / ("lib" + p->name + ".a")).make_preferred();
+
+#ifdef __APPLE__
+    return (libDir / ("lib" + p->name + ".dylib")).make_preferred();
+#else
+    return (libDir / ("lib" + p->name + ".so")).make_preferred();
+#endif
+}
+
+fs::path SolutionGeneratorNinja::projectOutputPath(const SolutionProject* p, ConfigurationType configType) const
+{
+    const auto binDir = m_config.derivedBinaryPathBase / ToLower(NameEnumOption(configType));
+
+    if (p->type == ProjectType::Application || p->type == ProjectType::TestApplication)
+    {
+        if (m_config.platform == PlatformType::Wasm)
+            return (binDir / (p->name + ".html")).make_preferred();
+        return (binDir / p->name).make_preferred();
+    }
+
+    // shared libraries are copied next to the executables, static ones stay where they were built
+    if (p->type == ProjectType::SharedLibrary)
+        return (binDir / projectLibraryPath(p, configType).filename()).make_preferred();
+
+    return projectLibraryPath(p, configType);
+}
+
+bool SolutionGeneratorNinja::generateSolution(FileGenerator& gen, fs::path* outSolutionPath)
+{
+    PROFILE_SCOPE("SolutionGeneratorNinja::generateSolution");
+
+    const auto solutionPath = (m_config.derivedSolutionPathBase / "build.ninja").make_preferred();
+    if (outSolutionPath)
+        *outSolutionPath = solutionPath;
+
+    if (!initializeToolchain())
+        return false;
+
+    auto* file = gen.createFile(solutionPath);
+    auto& f = file->content;
+
+    writeln(f, "# Onion Build");
+    writeln(f, "# AutoGenerated file. Please DO NOT MODIFY.");
+    writeln(f, "");
+    writeln(f, "ninja_required_version = 1.7");
+    writeln(f, "");
+
+    writelnf(f, "cc = %s", m_cCompiler.c_str());
+    writelnf(f, "cxx = %s", m_cxxCompiler.c_str());
+    writelnf(f, "ar = %s", m_archiver.c_str());
+
+    // compiler launcher (ccache, sccache, distcc), empty if not used
+    {
+        std::vector<std::string> launcherCommand;
+        collectCompilerLauncherCommand(&launcherCommand);
+
+        std::stringstream cmd;
+        if (launcherCommand.size() > 1)
+            cmd << "env";
+
+        for (const auto& part : launcherCommand)
+        {
+            if (cmd.tellp() > 0)
+                cmd << " ";
+            cmd << NinjaArgument(part);
+        }
+
+        writelnf(f, "launcher = %s", cmd.str().c_str());
+    }
+
+    writeln(f, "");
+
+    // compilation, dependencies on headers are discovered by the compiler
+    writeln(f, "rule cc");
+    writeln(f, "  command = $launcher $cc $pchflags $cflags -MD -MF $out.d -c $in -o $out");
+    writeln(f, "  depfile = $out.d");
+    writeln(f, "  deps = gcc");
+    writeln(f, "  description = CC $in");
+    writeln(f, "");
+
+    writeln(f, "rule cxx");
+    writeln(f, "  command = $launcher $cxx $pchflags $cflags $cxxflags -MD -MF $out.d -c $in -o $out");
+    writeln(f, "  depfile = $out.d");
+    writeln(f, "  deps = gcc");
+    writeln(f, "  description = CXX $in");
+    writeln(f, "");
+
+    writeln(f, "rule pch");
+    writeln(f, "  command = $launcher $cxx $cflags $cxxflags -x c++-header -MD -MF $out.d -c $in -o $out");
+    writeln(f, "  depfile = $out.d");
+    writeln(f, "  deps = gcc");
+    writeln(f, "  description = PCH $in");
+    writeln(f, "");
+
+    // linking
+    writeln(f, "rule ar");
+    writeln(f, "  command = rm -f $out && $ar crs $out $in");
+    writeln(f, "  description = AR $out");
+    writeln(f, "");
+
+    writeln(f, "rule link");
+    writeln(f, "  command = $cxx $ldflags -o $out $in $libs");
+    writeln(f, "  description = LINK $out");
+    writeln(f, "");
+
+    writeln(f, "rule copy");
+    writeln(f, "  command = cp -f $in $out");
+    writeln(f, "  description = COPY $out");
+    writeln(f, "");
+
+    // the build files are regenerated by "onion make" whenever any of the inputs of the static content generation changes
+    // reflection, embedded media and bison parsers are all produced there so the depfile lists everything they read
+    {
+        std::stringstream cmd;
+        cmd << NinjaPathArgument(m_config.executablePath) << " make";
+        cmd << " -config=" << m_config.mergedName();
+        cmd << " -module=" << NinjaPathArgument(m_config.moduleFilePath);
+        cmd << " -tempPath=" << NinjaPathArgument(m_config.tempPath);
+        cmd << " -cachePath=" << NinjaPathArgument(m_config.cachePath);
+        if (m_config.flagUnityBuild)
+            cmd << " -unity";
+        if (m_config.unityBatchSize > 0)
+            cmd << " -unityBatchSize=" << m_config.unityBatchSize;
+        if (m_config.flagPGO)
+            cmd << " -pgo";
+        if (!m_config.compilerLauncher.empty())
+            cmd << " -launcher=" << m_config.compilerLauncher;
+
+        if (m_config.linkOptionsConfigurationMask)
+        {
+            if (!m_config.linker.empty())
+                cmd << " -linker=" << m_config.linker;
+            if (m_config.flagSplitDwarf)
+                cmd << " -splitDwarf";
+            if (m_config.flagGdbIndex)
+                cmd << " -gdbIndex";
+            if (m_config.flagCompressDebugSections)
+                cmd << " -compressDebugSections";
+
+            std::string configs;
+            for (const auto configType : CONFIGURATIONS)
+            {
+                if (m_config.usesLinkOptions(configType))
+                {
+                    if (!configs.empty())
+                        configs += ",";
+                    configs += ToLower(NameEnumOption(configType));
+                }
+            }
+            cmd << " -linkOptionsConfigs=" << configs;
+        }
+
+        writeln(f, "rule regenerate");
+        writelnf(f, "  command = %s", cmd.str().c_str());
+        writeln(f, "  depfile = build.ninja.d");
+        writeln(f, "  description = Regenerating build files");
+        writeln(f, "  generator = 1");
+        writeln(f, "  restat = 1");
+        writeln(f, "");
+
+        std::stringstream outputs;
+        outputs << "build.ninja";
+        for (const auto configType : CONFIGURATIONS)
+            outputs << " " << NinjaPath(m_config.derivedSolutionPathBase / "ninja" / (ToLower(NameEnumOption(configType)) + ".ninja"));
+
+        writelnf(f, "build %s: regenerate", outputs.str().c_str());
+        writeln(f, "");
+
+        auto* depFile = gen.createFile(m_config.derivedSolutionPathBase / "build.ninja.d");
+        generateRegenerationDepfile(depFile->content);
+    }
+
+    // configurations
+    std::stringstream allConfigurations;
+    for (const auto configType : CONFIGURATIONS)
+    {
+        const auto configurationName = ToLower(NameEnumOption(configType));
+        writelnf(f, "subninja %s", NinjaPath(m_config.derivedSolutionPathBase / "ninja" / (configurationName + ".ninja")).c_str());
+        allConfigurations << " " << configurationName;
+    }
+    writeln(f, "");
+
+    writelnf(f, "build all: phony%s", allConfigurations.str().c_str());
+    writeln(f, "default release");
+
+    return true;
+}
+
+void SolutionGeneratorNinja::generateRegenerationDepfile(std::stringstream& f) const
+{
+    std::set<std::string> inputs;
+
+    inputs.insert(DepfilePath(m_config.moduleFilePath));
+    inputs.insert(DepfilePath(m_config.platformConfigurationFile()));
+
+    for (const auto* p : m_projects)
+    {
+        // directories are listed as well so adding or removing a file triggers the regeneration
+        if (!p->rootPath.empty())
+        {
+            std::error_code ec;
+            if (fs::is_directory(p->rootPath, ec))
+                inputs.insert(DepfilePath(p->rootPath));
+        }
+
+        for (const auto* pf : p->files)
+        {
+            // skip everything we've generated ourselves
+            fs::path relativePath;
+            if (IsInsideDirectory(pf->absolutePath, m_config.derivedSolutionPathBase, relativePath))
+                continue;
+
+            bool isInput = false;
+            if (pf->type == ProjectFileType::BuildScript || pf->type == ProjectFileType::MediaFile || pf->type == ProjectFileType::Bison)
+                isInput = true;
+            else if (p->optionUseReflection && pf->type == ProjectFileType::CppSource)
+                isInput = true;
+
+            if (isInput)
+                inputs.insert(DepfilePath(pf->absolutePath));
+
+            std::error_code ec;
+            const auto directory = pf->absolutePath.parent_path();
+            if (fs::is_directory(directory, ec))
+                inputs.insert(DepfilePath(directory));
+        }
+    }
+
+    f << "build.ninja:";
+    for (const auto& path : inputs)
+        f << " \\\n  " << path;
+    f << "\n";
+}
+
+bool SolutionGeneratorNinja::generateProjects(FileGenerator& gen)
+{
+    PROFILE_SCOPE("SolutionGeneratorNinja::generateProjects");
+
+    bool valid = true;
+
+    // precompiled headers are built from a wrapper, compiling the build.h directly makes GCC complain about the #pragma once
+    for (const auto* p : m_projects)
+    {
+        if (ShouldGenerateProject(p) && p->optionUsePrecompiledHeaders && !p->localBuildHeader.empty())
+        {
+            auto* file = gen.createFile(p->generatedPath / "build_pch.h");
+            writeln(file->content, "// Precompiled header wrapper");
+            writeln(file->content, "// Auto generated, do not modify");
+            writeln(file->content, "#include \"build.h\"");
+        }
+    }
+
+    for (const auto configType : CONFIGURATIONS)
+    {
+        const auto configurationName = ToLower(NameEnumOption(configType));
+
+        auto* file = gen.createFile(m_config.derivedSolutionPathBase / "ninja" / (configurationName + ".ninja"));
+        valid &= generateConfigurationFile(configType, file->content);
+    }
+
+    return valid;
+}
+
+bool SolutionGeneratorNinja::generateConfigurationFile(ConfigurationType configType, std::stringstream& f) const
+{
+    const auto configurationName = ToLower(NameEnumOption(configType));
+
+    writeln(f, "# Onion Build");
+    writeln(f, "# AutoGenerated file. Please DO NOT MODIFY.");
+    writelnf(f, "# Configuration: %s", std::string(NameEnumOption(configType)).c_str());
+    writeln(f, "");
+
+    bool valid = true;
+
+    std::stringstream allOutputs;
+    for (const auto* p : m_projects)
+    {
+        if (ShouldGenerateProject(p))
+        {
+            valid &= generateProjectBuildStatements(p, configType, f);
+            allOutputs << " " << configurationName << "/" << p->name;
+        }
+    }
+
+    writelnf(f, "build %s: phony%s", configurationName.c_str(), allOutputs.str().c_str());
+
+    return valid;
+}
+
+bool SolutionGeneratorNinja::generateProjectBuildStatements(const SolutionProject* p, ConfigurationType configType, std::stringstream& f) const
+{
+    const auto configurationName = ToLower(NameEnumOption(configType));
+    const auto varName = NinjaVariableName(p->name);
+    // object files are relative to the build directory (ninja runs there), GCC names the per-object profile data after them
+    const auto objectDir = (fs::path("obj") / configurationName / p->name).make_preferred();
+
+    const bool apple = (m_config.platform == PlatformType::Darwin || m_config.platform == PlatformType::DarwinArm);
+    const bool isApp = (p->type == ProjectType::Application || p->type == ProjectType::TestApplication);
+
+    writelnf(f, "# Project %s", p->name.c_str());
+
+    // faster linker, split debug info, etc
+    std::string linkOptionCompilerFlags, linkOptionLinkerFlags;
+    collectLinkOptionFlags(configType, &linkOptionCompilerFlags, &linkOptionLinkerFlags);
+
+    // compiler flags, same set as the CMake generator produces
+    {
+        std::stringstream flags;
+        flags << "-DPROJECT_NAME=" << p->name;
+
+        if (p->type == ProjectType::StaticLibrary)
+        {
+            flags << " -DBUILD_AS_LIBS";
+        }
+        else
+        {
+            flags << " -D" << ToUpper(p->name) << "_EXPORTS";
+
+            if (p->type == ProjectType::SharedLibrary)
+                flags << " -DBUILD_DLL";
+        }
+
+        for (const auto* dep : p->allDependencies)
+            if (dep->type == ProjectType::SharedLibrary || dep->type == ProjectType::StaticLibrary)
+                flags << " -DHAS_" << ToUpper(dep->name);
+
+        if (m_config.solutionType == SolutionType::DevelopmentShared || m_config.solutionType == SolutionType::DevelopmentStatic)
+            flags << " -DBUILD_DEVELOPMENT";
+
+        {
+            TDefines defs;
+            collectDefines(p, &defs);
+
+            for (const auto& def : defs)
+            {
+                if (def.second.empty())
+                    flags << " " << NinjaArgument("-D" + def.first);
+                else
+                    flags << " " << NinjaArgument("-D" + def.first + "=" + def.second);
+            }
+        }
+
+        flags << " " << ConfigurationCompilerFlags(configType);
+        flags << profileCompilerFlags(p, configType);
+        flags << linkOptionCompilerFlags;
+
+        if (!m_platformIncludeDirectory.empty())
+            flags << " -I" << NinjaPathArgument(m_platformIncludeDirectory);
+
+        std::vector<fs::path> paths;
+        collectSourceRoots(p, &paths);
+
+        for (const auto* lib : p->libraryDependencies)
+            lib->collectIncludeDirectories(m_config.platform, &paths);
+
+        for (const auto& path : paths)
+            flags << " -I" << NinjaPathArgument(path);
+
+        flags << " -pthread -g -fno-stack-protector";
+
+        if (m_config.platform == PlatformType::Wasm)
+            flags << " -msimd128";
+        else
+            flags << " -fPIC";
+
+        writelnf(f, "%s_cflags = %s", varName.c_str(), flags.str().c_str());
+        writelnf(f, "%s_cxxflags = -std=c++17 %s", varName.c_str(), p->optionUseExceptions ? "-fexceptions" : "-fno-exceptions");
+    }
+
+    // precompiled header, built from the generated build.h with exactly the same flags as the sources that use it
+    fs::path pchPath;
+    std::string pchFlags;
+    if (p->optionUsePrecompiledHeaders && !p->localBuildHeader.empty())
+    {
+        if (m_compilerIsClang)
+        {
+            // clang needs the PCH to be named explicitly
+            pchPath = (objectDir / "pch" / "build.h.pch").make_preferred();
+            pchFlags = "-include-pch " + NinjaPathArgument(pchPath);
+        }
+        else
+        {
+            // GCC picks up the "build.h.gch" when the #include "build.h" is resolved, so the PCH directory goes first in the search path
+            pchPath = (objectDir / "pch" / "build.h.gch").make_preferred();
+            pchFlags = "-I" + NinjaPathArgument(pchPath.parent_path()) + " -Winvalid-pch";
+        }
+
+        writelnf(f, "build %s: pch %s", NinjaPath(pchPath).c_str(), NinjaPath(p->generatedPath / "build_pch.h").c_str());
+        writelnf(f, "  cflags = $%s_cflags", varName.c_str());
+        writelnf(f, "  cxxflags = $%s_cxxflags", varName.c_str());
+    }
+
+    // compile sources
+    std::vector<fs::path> objectFiles;
+    std::unordered_set<std::string> usedObjectNames;
+    for (const auto* pf : p->files)
+    {
+        if (pf->type != ProjectFileType::CppSource || !pf->useInCurrentBuild)
+            continue;
+
+        // headers listed as sources are not compiled on their own
+        const auto extension = pf->absolutePath.extension().u8string();
+        if (extension == ".h" || extension == ".hpp" || extension == ".hxx" || extension == ".inl")
+            continue;
+
+        // mirror the source layout in the object directory
+        fs::path relativePath;
+        if (IsInsideDirectory(pf->absolutePath, p->generatedPath, relativePath))
+            relativePath = fs::path("_generated") / relativePath;
+        else if (!IsInsideDirectory(pf->absolutePath, p->rootPath, relativePath))
+            relativePath = fs::path("_external") / pf->absolutePath.filename();
+
+        auto objectName = relativePath.generic_u8string();
+        for (uint32_t index = 1; usedObjectNames.count(objectName); ++index)
+            objectName = relativePath.generic_u8string() + "_" + std::to_string(index);
+        usedObjectNames.insert(objectName);
+
+        const auto objectPath = (objectDir / (objectName + ".o")).make_preferred();
+        objectFiles.push_back(objectPath);
+
+        const bool isC = (pf->absolutePath.extension() == ".c");
+        const bool usePch = !pchPath.empty() && !isC && pf->usePrecompiledHeader && pf->name != "build.cpp" && pf->name != "build.cxx";
+
+        if (usePch)
+            writelnf(f, "build %s: %s %s | %s", NinjaPath(objectPath).c_str(), isC ? "cc" : "cxx", NinjaPath(pf->absolutePath).c_str(), NinjaPath(pchPath).c_str());
+        else
+            writelnf(f, "build %s: %s %s", NinjaPath(objectPath).c_str(), isC ? "cc" : "cxx", NinjaPath(pf->absolutePath).c_str());
+
+        writelnf(f, "  cflags = $%s_cflags", varName.c_str());
+        if (!isC)
+            writelnf(f, "  cxxflags = $%s_cxxflags", varName.c_str());
+        if (usePch)
+            writelnf(f, "  pchflags = %s", pchFlags.c_str());
+    }
+
+    std::stringstream objectList;
+    for (const auto& path : objectFiles)
+        objectList << " " << NinjaPath(path);
+
+    // third party and system libraries, static libraries pass them to whoever links them in
+    std::vector<fs::path> libraryFiles;
+    std::vector<std::string> systemLibraries, systemFrameworks;
+    {
+        std::vector<const SolutionProject*> sources;
+        sources.push_back(p);
+
+        if (isApp)
+            for (const auto* dep : p->allDependencies)
+                if (dep->type == ProjectType::StaticLibrary)
+                    sources.push_back(dep);
+
+        if (m_config.platform == PlatformType::Linux || apple)
+        {
+            systemLibraries.push_back("dl");
+            if (m_config.platform == PlatformType::Linux)
+                systemLibraries.push_back("rt");
+            else
+                systemLibraries.push_back("stdc++");
+        }
+
+        for (const auto* source : sources)
+        {
+            for (const auto* lib : source->libraryDependencies)
+            {
+                std::vector<fs::path> paths;
+                lib->collectLibraries(m_config.platform, &paths);
+                for (const auto& path : paths)
+                    PushBackUnique(libraryFiles, path);
+
+                std::unordered_set<std::string> packages, frameworks;
+                lib->collectAdditionalSystemPackages(m_config.platform, &packages);
+                lib->collectAdditionalSystemFrameworks(m_config.platform, &frameworks);
+
+                std::vector<std::string> sortedPackages(packages.begin(), packages.end());
+                std::sort(sortedPackages.begin(), sortedPackages.end());
+                for (const auto& name : sortedPackages)
+                    PushBackUnique(systemLibraries, name);
+
+                std::vector<std::string> sortedFrameworks(frameworks.begin(), frameworks.end());
+                std::sort(sortedFrameworks.begin(), sortedFrameworks.end());
+                for (const auto& name : sortedFrameworks)
+                    PushBackUnique(systemFrameworks, name);
+            }
+        }
+    }
+
+    std::stringstream systemLibs;
+    for (const auto& path : libraryFiles)
+        systemLibs << " " << NinjaPathArgument(path);
+    for (const auto& name : systemLibraries)
+        systemLibs << " -l" << name;
+    if (apple)
+    {
+        for (const auto& name : systemFrameworks)
+            systemLibs << " -framework " << name;
+        if (!systemFrameworks.empty())
+            systemLibs << " -lobjc";
+    }
+
+    // link
+    const auto outputPath = projectOutputPath(p, configType);
+    const auto linkerFlags = profileLinkerFlags(configType) + linkOptionLinkerFlags;
+    std::stringstream phonyInputs;
+    phonyInputs << NinjaPath(outputPath);
+
+    if (p->type == ProjectType::StaticLibrary)
+    {
+        writelnf(f, "build %s: ar%s", NinjaPath(outputPath).c_str(), objectList.str().c_str());
+    }
+    else if (p->type == ProjectType::SharedLibrary)
+    {
+        const auto libraryPath = projectLibraryPath(p, configType);
+        const auto libraryName = libraryPath.filename().u8string();
+
+        writelnf(f, "build %s: link%s", NinjaPath(libraryPath).c_str(), objectList.str().c_str());
+        if (apple)
+            writelnf(f, "  ldflags = -dynamiclib -undefined dynamic_lookup -install_name @rpath/%s -pthread%s", libraryName.c_str(), linkerFlags.c_str());
+        else
+            writelnf(f, "  ldflags = -shared -Wl,-soname,%s -pthread%s", libraryName.c_str(), linkerFlags.c_str());
+        writelnf(f, "  libs =%s", systemLibs.str().c_str());
+
+        // final copy of the library next to the executables
+        writelnf(f, "build %s: copy %s", NinjaPath(outputPath).c_str(), NinjaPath(libraryPath).c_str());
+    }
+    else if (isApp)
+    {
+        // same link order as the CMake generator uses
+        auto orderedDeps = p->allDependencies;
+        std::reverse(orderedDeps.begin(), orderedDeps.end());
+
+        std::stringstream depLibs, depFiles, depRuntimeFiles;
+        for (const auto* dep : orderedDeps)
+        {
+            if (dep->type == ProjectType::StaticLibrary || dep->type == ProjectType::SharedLibrary)
+            {
+                const auto libraryPath = projectLibraryPath(dep, configType);
+                depLibs << " " << NinjaPathArgument(libraryPath);
+                depFiles << " " << NinjaPath(libraryPath);
+
+                if (dep->type == ProjectType::SharedLibrary)
+                    depRuntimeFiles << " " << NinjaPath(projectOutputPath(dep, configType));
+            }
+        }
+
+        std::stringstream libs;
+        if (m_config.platform == PlatformType::Linux && !depLibs.str().empty())
+            libs << " -Wl,--start-group" << depLibs.str() << " -Wl,--end-group"; // static libraries may reference each other
+        else
+            libs << depLibs.str();
+        libs << systemLibs.str();
+
+        if (depFiles.str().empty() && depRuntimeFiles.str().empty())
+            writelnf(f, "build %s: link%s", NinjaPath(outputPath).c_str(), objectList.str().c_str());
+        else if (depRuntimeFiles.str().empty())
+            writelnf(f, "build %s: link%s |%s", NinjaPath(outputPath).c_str(), objectList.str().c_str(), depFiles.str().c_str());
+        else
+            writelnf(f, "build %s: link%s |%s ||%s", NinjaPath(outputPath).c_str(), objectList.str().c_str(), depFiles.str().c_str(), depRuntimeFiles.str().c_str());
+
+        if (m_config.platform == PlatformType::Wasm)
+            writeln(f, "  ldflags = -pthread -sUSE_WEBGL2=1 -sFULL_ES3=1 -sOFFSCREENCANVAS_SUPPORT=1 -sTOTAL_MEMORY=1024MB -sPTHREAD_POOL_SIZE=32");
+        else if (apple)
+            writelnf(f, "  ldflags = -pthread -Wl,-rpath,@loader_path%s", linkerFlags.c_str());
+        else
+            writelnf(f, "  ldflags = -pthread '-Wl,-rpath,$$ORIGIN'%s", linkerFlags.c_str());
+        writelnf(f, "  libs =%s", libs.str().c_str());
+
+        phonyInputs << depRuntimeFiles.str();
+    }
+
+    writelnf(f, "build %s/%s: phony %s", configurationName.c_str(), p->name.c_str(), phonyInputs.str().c_str());
+    writeln(f, "");
+
+    return true;
+}
+
+//--
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "solutionGenerator.h"
+
+//--
+
+// writes build.ninja directly from the project structure, without the CMake configuration step in between
+// all configurations are written at once (one .ninja file per configuration), "ninja release" builds the release
+class SolutionGeneratorNinja : public SolutionGenerator
+{
+public:
+    SolutionGeneratorNinja(FileRepository& files, const Configuration& config, std::string_view mainGroup);
+
+	virtual bool generateSolution(FileGenerator& gen, fs::path* outSolutionPath) override final;
+	virtual bool generateProjects(FileGenerator& gen) override final;
+
+private:
+    std::string m_cCompiler;
+    std::string m_cxxCompiler;
+    std::string m_archiver;
+    bool m_compilerIsClang = false;
+
+    fs::path m_platformIncludeDirectory;
+
+    bool initializeToolchain();
+
+    bool generateConfigurationFile(ConfigurationType configType, std::stringstream& outContent) const;
+    bool generateProjectBuildStatements(const SolutionProject* project, ConfigurationType configType, std::stringstream& outContent) const;
+
+    void generateRegenerationDepfile(std::stringstream& outContent) const;
+
+    std::string profileCompilerFlags(const SolutionProject* project, ConfigurationType configType) const;
+    std::string profileLinkerFlags(ConfigurationType configType) const;
+
+    fs::path projectOutputPath(const SolutionProject* project, ConfigurationType configType) const;
+    fs::path projectLibraryPath(const SolutionProject* project, ConfigurationType configType) const;
+};
+
+//--
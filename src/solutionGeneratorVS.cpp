@@ -7,6 +7,7 @@
 #include "projectManifest.h"
 #include "solutionGeneratorVS.h"
 #include "externalLibrary.h"
+#include "profiler.h"
 
 SolutionGeneratorVS::SolutionGeneratorVS(FileRepository& files, const Configuration& config, std::string_view mainGroup)
     : SolutionGenerator(files, config, mainGroup)
@@ -115,6 +116,8 @@ static const char* NameVisualStudioPlatform(PlatformType config)
 
 bool SolutionGeneratorVS::generateSolution(FileGenerator& gen, fs::path* outSolutionPath)
 {
+    PROFILE_SCOPE("SolutionGeneratorVS::generateSolution");
+
     const auto solutionCoreName = ToLower(m_rootGroup->name);
     const auto solutionFileName = solutionCoreName + "." + m_config.mergedName() + ".sln";
 
@@ -124,6 +127,9 @@ bool SolutionGeneratorVS::generateSolution(FileGenerator& gen, fs::path* outSolu
     if (outSolutionPath)
         *outSolutionPath = (m_config.derivedSolutionPathBase / solutionFileName).make_preferred();
 
+    if (!m_config.compilerLauncher.empty())
+        LogWarning() << "Compiler launcher '" << m_config.compilerLauncher << "' is not supported by Visual Studio solutions and will not be used";
+
     writeln(f, "Microsoft Visual Studio Solution File, Format Version 12.00");
     /*if (toolset.equals("v140")) {
         writeln(f, "# Visual Studio 14");
@@ -199,6 +205,8 @@ bool SolutionGeneratorVS::generateSolution(FileGenerator& gen, fs::path* outSolu
 
 bool SolutionGeneratorVS::generateProjects(FileGenerator& gen)
 {
+    PROFILE_SCOPE("SolutionGeneratorVS::generateProjects");
+
     bool valid = true;
 
     for (const auto* p : m_projects)
@@ -550,8 +558,9 @@ bool SolutionGeneratorVS::generateSourcesProjectFileEntry(const SolutionProject*
                 writeln(f, "      <PrecompiledHeader>NotUsing</PrecompiledHeader>");
             }
 
-            /*if (!file->useInCurrentBuild)
-                writeln(f, "      <ExcludedFromBuild>true</ExcludedFromBuild>");*/
+            // compiled as part of a unity file
+            if (!file->useInCurrentBuild)
+                writeln(f, "      <ExcludedFromBuild>true</ExcludedFromBuild>");
 
             if (m_config.platform == PlatformType::UWP)
             {
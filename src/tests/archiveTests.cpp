@@ -0,0 +1,189 @@
+#include "common.h"
+#include "utils.h"
+#include "archive.h"
+#include "tests/tests.h"
+
+//--
+
+namespace prv
+{
+	// writes uncompressed ustar archives with hand picked entries (including the malicious ones no packing tool would produce)
+	class TestTarWriter
+	{
+	public:
+		void file(std::string_view name, std::string_view content)
+		{
+			header(name, '0', "", content.size());
+			m_data.append(content);
+			m_data.append((512 - (content.size() % 512)) % 512, '\0');
+		}
+
+		void directory(std::string_view name)
+		{
+			header(name, '5', "", 0);
+		}
+
+		void symlink(std::string_view name, std::string_view target)
+		{
+			header(name, '2', target, 0);
+		}
+
+		void hardlink(std::string_view name, std::string_view target)
+		{
+			header(name, '1', target, 0);
+		}
+
+		bool save(const fs::path& path) const
+		{
+			std::ofstream file(path, std::ios::out | std::ios::binary | std::ios::trunc);
+			file.write(m_data.data(), m_data.size());
+			file.write(std::string(1024, '\0').data(), 1024); // end of archive marker
+			return file.good();
+		}
+
+	private:
+		std::string m_data;
+
+		static void WriteOctal(char* ptr, uint32_t length, uint64_t value)
+		{
+			// the field is zero padded digits followed by a terminator, the terminator is already in the zeroed block
+			char digits[32];
+			snprintf(digits, sizeof(digits), "%0*llo", (int)(length - 1), (unsigned long long)value);
+			memcpy(ptr, digits, length - 1);
+		}
+
+		void header(std::string_view name, char type, std::string_view linkName, uint64_t size)
+		{
+			char block[512];
+			memset(block, 0, sizeof(block));
+
+			memcpy(block, name.data(), std::min<size_t>(name.size(), 100));
+			WriteOctal(block + 100, 8, 0644);
+			WriteOctal(block + 108, 8, 0);
+			WriteOctal(block + 116, 8, 0);
+			WriteOctal(block + 124, 12, size);
+			WriteOctal(block + 136, 12, 0);
+			block[156] = type;
+			memcpy(block + 157, linkName.data(), std::min<size_t>(linkName.size(), 100));
+			memcpy(block + 257, "ustar", 6);
+			memcpy(block + 263, "00", 2);
+
+			uint32_t checksum = 0;
+			memset(block + 148, ' ', 8);
+			for (uint32_t i = 0; i < 512; ++i)
+				checksum += (uint8_t)block[i];
+			WriteOctal(block + 148, 7, checksum);
+
+			m_data.append(block, sizeof(block));
+		}
+	};
+
+	static bool Extract(TestContext& context, const TestTarWriter& tar, const fs::path& targetPath)
+	{
+		const auto archivePath = context.tempPath / "test.tar";
+		if (!tar.save(archivePath))
+			return false;
+
+		return Archive_ExtractFile(archivePath, targetPath);
+	}
+
+} // prv
+
+//--
+
+TEST_CASE(ArchiveRejectsAbsoluteSymlink)
+{
+	const auto outsidePath = context.tempPath / "outside";
+	const auto targetPath = context.tempPath / "target";
+	TEST_CHECK(CreateDirectories(outsidePath));
+
+	prv::TestTarWriter tar;
+	tar.symlink("l", outsidePath.generic_u8string());
+	tar.file("l/evil.txt", "evil");
+
+	TEST_CHECK(!prv::Extract(context, tar, targetPath));
+	TEST_CHECK(!fs::exists(outsidePath / "evil.txt"));
+}
+
+TEST_CASE(ArchiveRejectsEscapingSymlink)
+{
+	const auto targetPath = context.tempPath / "target";
+
+	prv::TestTarWriter tar;
+	tar.directory("sub/");
+	tar.symlink("sub/l", "../../outside");
+	tar.file("sub/l/evil.txt", "evil");
+
+	TEST_CHECK(!prv::Extract(context, tar, targetPath));
+	TEST_CHECK(!fs::exists(context.tempPath / "outside"));
+
+	// the same through a hard link to a symlink that was fine in its original place
+	prv::TestTarWriter tar2;
+	tar2.directory("a/b/");
+	tar2.symlink("a/b/l", "../x.txt");
+	tar2.hardlink("l2", "a/b/l");
+
+	TEST_CHECK(!prv::Extract(context, tar2, context.tempPath / "target2"));
+}
+
+TEST_CASE(ArchiveRejectsWritesThroughSymlink)
+{
+	const auto targetPath = context.tempPath / "target";
+
+	// link itself stays inside but files can't be placed through it, the link may be replaced later by a file system change
+	prv::TestTarWriter tar;
+	tar.directory("sub/");
+	tar.symlink("d", "sub");
+	tar.file("d/evil.txt", "evil");
+
+	TEST_CHECK(!prv::Extract(context, tar, targetPath));
+	TEST_CHECK(!fs::exists(targetPath / "sub" / "evil.txt"));
+}
+
+TEST_CASE(ArchiveExtractsValidLinks)
+{
+	const auto targetPath = context.tempPath / "target";
+
+	prv::TestTarWriter tar;
+	tar.file("sub/a.txt", "content");
+	tar.symlink("lib/link.txt", "../sub/./a.txt");
+	tar.symlink("lib/self", ".");
+	tar.hardlink("copy.txt", "sub/a.txt");
+	tar.file("lib/link.txt", "replaced"); // replaces the link, not the file it points to
+
+	TEST_CHECK(prv::Extract(context, tar, targetPath));
+
+	std::string content;
+	TEST_CHECK(LoadFileToString(targetPath / "sub" / "a.txt", content));
+	TEST_CHECK(content == "content");
+	TEST_CHECK(LoadFileToString(targetPath / "copy.txt", content));
+	TEST_CHECK(content == "content");
+	TEST_CHECK(LoadFileToString(targetPath / "lib" / "link.txt", content));
+	TEST_CHECK(content == "replaced");
+
+	std::error_code ec;
+	if (fs::is_symlink(fs::symlink_status(targetPath / "lib" / "self", ec)))
+		TEST_CHECK(fs::read_symlink(targetPath / "lib" / "self", ec).generic_u8string() == ".");
+}
+
+//--
+
+TEST_CASE(Md5KnownAnswer)
+{
+	const auto md5 = [](std::string_view text)
+	{
+		Md5Context md5Context;
+		Md5Initialise(&md5Context);
+		Md5Update(&md5Context, text.data(), text.size());
+
+		MD5_HASH hash;
+		Md5Finalise(&md5Context, &hash);
+		return BytesToHexString(hash.bytes, sizeof(hash.bytes));
+	};
+
+	TEST_CHECK(md5("") == "d41d8cd98f00b204e9800998ecf8427e");
+	TEST_CHECK(md5("abc") == "900150983cd24fb0d6963f7d28e17f72");
+	TEST_CHECK(md5(std::string(1000, 'a')) == "cabe45dcc9ae5b66ba86600cca6b8ba8");
+}
+
+//--
@@ -0,0 +1,220 @@
+#include "common.h"
+#include "utils.h"
+#include "dependencyGraph.h"
+#include "tests/tests.h"
+
+//--
+
+namespace prv
+{
+	// random acyclic graph, node labels are shuffled so the index order is not a topological order
+	static void BuildRandomGraph(DependencyGraph& graph, uint32_t numNodes, uint32_t seed)
+	{
+		auto random = [&seed]() { seed = seed * 1664525u + 1013904223u; return seed >> 8; };
+
+		std::vector<uint32_t> labels(numNodes);
+		for (uint32_t i = 0; i < numNodes; ++i)
+			labels[i] = i;
+		for (uint32_t i = numNodes - 1; i > 0; --i)
+			std::swap(labels[i], labels[random() % (i + 1)]);
+
+		graph.reset(numNodes);
+		for (uint32_t i = 1; i < numNodes; ++i)
+		{
+			const auto numEdges = random() % 4;
+			for (uint32_t j = 0; j < numEdges; ++j)
+				graph.addEdge(labels[i], labels[random() % i]);
+		}
+	}
+
+	// the longest path search that was used to order the projects before the graph existed
+	static void InsertLongestPath(const DependencyGraph& graph, uint32_t node, uint32_t depth, std::unordered_map<uint32_t, uint32_t>& depthMap)
+	{
+		auto& currentDepth = depthMap[node];
+		if (depth > currentDepth)
+		{
+			currentDepth = depth;
+			for (const auto dep : graph.dependencies(node))
+				InsertLongestPath(graph, dep, depth + 1, depthMap);
+		}
+	}
+
+	static void CollectReachable(const DependencyGraph& graph, uint32_t node, std::vector<bool>& visited)
+	{
+		for (const auto dep : graph.dependencies(node))
+		{
+			if (!visited[dep])
+			{
+				visited[dep] = true;
+				CollectReachable(graph, dep, visited);
+			}
+		}
+	}
+
+} // prv
+
+//--
+
+TEST_CASE(DependencyGraphReportsCycles)
+{
+	DependencyGraph graph(6);
+	graph.addEdge(0, 1);
+	graph.addEdge(1, 2);
+	graph.addEdge(2, 1); // cycle
+	graph.addEdge(3, 2); // depends on the cycle
+	graph.addEdge(4, 5); // not affected
+
+	std::vector<uint32_t> unordered;
+	TEST_CHECK(!graph.build(&unordered));
+	TEST_CHECK(!graph.built());
+	TEST_CHECK(unordered == std::vector<uint32_t>({ 0, 1, 2, 3 }));
+
+	// self reference is a cycle too
+	DependencyGraph selfGraph(2);
+	selfGraph.addEdge(1, 1);
+	TEST_CHECK(!selfGraph.build(&unordered));
+	TEST_CHECK(unordered == std::vector<uint32_t>({ 1 }));
+}
+
+TEST_CASE(DependencyGraphClosuresCrossWords)
+{
+	// chain across several 64-bit words: each node depends on the next one
+	const uint32_t numNodes = 200;
+	DependencyGraph graph(numNodes);
+	for (uint32_t i = 0; i + 1 < numNodes; ++i)
+		graph.addEdge(i, i + 1);
+	TEST_CHECK(graph.build());
+
+	TEST_CHECK(graph.dependsOn(0, numNodes - 1));
+	TEST_CHECK(graph.dependsOn(63, 64));
+	TEST_CHECK(graph.dependsOn(64, 128));
+	TEST_CHECK(!graph.dependsOn(numNodes - 1, 0));
+	TEST_CHECK(!graph.dependsOn(70, 70));
+
+	std::vector<uint32_t> dependencies;
+	graph.collectAllDependencies(60, dependencies);
+	TEST_CHECK(dependencies.size() == numNodes - 61);
+	TEST_CHECK(!dependencies.empty() && dependencies.front() == 61 && dependencies.back() == numNodes - 1);
+	TEST_CHECK(std::is_sorted(dependencies.begin(), dependencies.end()));
+
+	std::vector<uint32_t> dependents;
+	graph.collectAllDependents({ 130 }, dependents);
+	TEST_CHECK(dependents.size() == 131);
+	TEST_CHECK(!dependents.empty() && dependents.front() == 0 && dependents.back() == 130);
+
+	// random graph, closures must match a plain graph walk
+	prv::BuildRandomGraph(graph, 300, 12345);
+	TEST_CHECK(graph.build());
+
+	bool closuresMatch = true;
+	for (uint32_t node = 0; node < graph.size(); ++node)
+	{
+		std::vector<bool> visited(graph.size(), false);
+		prv::CollectReachable(graph, node, visited);
+
+		std::vector<uint32_t> expected;
+		for (uint32_t i = 0; i < graph.size(); ++i)
+		{
+			if (visited[i])
+				expected.push_back(i);
+			closuresMatch &= (graph.dependsOn(node, i) == visited[i]);
+		}
+
+		std::vector<uint32_t> collected;
+		graph.collectAllDependencies(node, collected);
+		closuresMatch &= (collected == expected);
+	}
+
+	TEST_CHECK(closuresMatch);
+}
+
+TEST_CASE(DependencyGraphOrderPutsDependenciesFirst)
+{
+	DependencyGraph graph;
+	prv::BuildRandomGraph(graph, 150, 777);
+	TEST_CHECK(graph.build());
+	TEST_CHECK(graph.order().size() == graph.size());
+
+	std::vector<uint32_t> position(graph.size(), UINT32_MAX);
+	for (uint32_t i = 0; i < graph.order().size(); ++i)
+		position[graph.order()[i]] = i;
+
+	bool ordered = true;
+	for (uint32_t node = 0; node < graph.size(); ++node)
+		for (const auto dep : graph.dependencies(node))
+			ordered &= (position[dep] < position[node]);
+
+	TEST_CHECK(ordered);
+}
+
+TEST_CASE(DependencyGraphDepthsMatchLongestPath)
+{
+	DependencyGraph graph;
+	prv::BuildRandomGraph(graph, 150, 4242);
+	TEST_CHECK(graph.build());
+
+	// depths of dependencies of each node, same as the per project ordering did
+	bool depthsMatch = true;
+	for (uint32_t node = 0; node < graph.size(); ++node)
+	{
+		std::unordered_map<uint32_t, uint32_t> depthMap;
+		for (const auto dep : graph.dependencies(node))
+			prv::InsertLongestPath(graph, dep, 1, depthMap);
+
+		std::vector<uint32_t> depths;
+		graph.computeDependencyDepths(node, depths);
+
+		for (uint32_t i = 0; i < graph.size(); ++i)
+			depthsMatch &= (depths[i] == Find<uint32_t, uint32_t>(depthMap, i, 0));
+	}
+
+	TEST_CHECK(depthsMatch);
+
+	// levels of all nodes, same as the solution wide ordering did (it started counting from 1)
+	std::unordered_map<uint32_t, uint32_t> levelMap;
+	for (uint32_t node = 0; node < graph.size(); ++node)
+		prv::InsertLongestPath(graph, node, 1, levelMap);
+
+	std::vector<uint32_t> levels;
+	graph.computeLevels(levels);
+
+	bool levelsMatch = (levels.size() == graph.size());
+	for (uint32_t i = 0; i < graph.size() && levelsMatch; ++i)
+		levelsMatch &= (levels[i] + 1 == levelMap[i]);
+
+	TEST_CHECK(levelsMatch);
+}
+
+TEST_CASE(NamePrefixIndexFindsSortedValues)
+{
+	NamePrefixIndex index;
+	index.insert("core_math", 7);
+	index.insert("core", 3);
+	index.insert("core_io", 1);
+	index.insert("editor", 0);
+	index.insert("core_io_async", 9);
+	index.insert("corelib", 5);
+
+	std::vector<uint32_t> values;
+	index.findByPrefix("core_", values);
+	TEST_CHECK(values == std::vector<uint32_t>({ 1, 7, 9 }));
+
+	values.clear();
+	index.findByPrefix("core", values);
+	TEST_CHECK(values == std::vector<uint32_t>({ 1, 3, 5, 7, 9 }));
+
+	values.clear();
+	index.findByPrefix("", values);
+	TEST_CHECK(values == std::vector<uint32_t>({ 0, 1, 3, 5, 7, 9 }));
+
+	values.clear();
+	index.findByPrefix("game", values);
+	TEST_CHECK(values.empty());
+
+	// results are appended, values already in the list are not touched
+	values = { 100 };
+	index.findByPrefix("e", values);
+	TEST_CHECK(values == std::vector<uint32_t>({ 100, 0 }));
+}
+
+//--
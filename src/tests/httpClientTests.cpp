@@ -0,0 +1,589 @@
+#include "common.h"
+#include "utils.h"
+#include "httpClient.h"
+#include "tests/tests.h"
+
+#include <thread>
+#include <mutex>
+
+#ifdef _WIN32
+	#include <winsock2.h>
+	#include <ws2tcpip.h>
+	typedef SOCKET TestSocket;
+	#define INVALID_TEST_SOCKET INVALID_SOCKET
+	#define CloseTestSocket closesocket
+#else
+	#include <sys/types.h>
+	#include <sys/socket.h>
+	#include <netinet/in.h>
+	#include <arpa/inet.h>
+	#include <unistd.h>
+	typedef int TestSocket;
+	#define INVALID_TEST_SOCKET -1
+	#define CloseTestSocket close
+#endif
+
+#ifdef ONION_HTTP_TLS
+	#include <openssl/ssl.h>
+	#include <openssl/pem.h>
+	#include <openssl/x509v3.h>
+#endif
+
+//--
+
+namespace prv
+{
+	// certificate presented by the stand-in server
+	enum class LoopbackCertificate : uint8_t
+	{
+		None, // plain http
+		Trusted, // https, "localhost" certificate trusted by the client
+		WrongHost, // https, trusted certificate issued for a different host
+		Untrusted, // https, "localhost" certificate the client does not know
+	};
+
+#ifdef ONION_HTTP_TLS
+	// self signed certificates for the stand-in server, the trusted ones are given to the client through SSL_CERT_FILE
+	// NOTE: the client reads the trusted certificates once when making its first https connection, so this must be set up before that
+	class TestCertificates
+	{
+	public:
+		static TestCertificates& GetInstance(const fs::path& tempPath)
+		{
+			static TestCertificates theInstance(tempPath);
+			return theInstance;
+		}
+
+		SSL_CTX* serverContext(LoopbackCertificate type) const
+		{
+			return m_contexts[(int)type];
+		}
+
+	private:
+		SSL_CTX* m_contexts[4] = {};
+
+		TestCertificates(const fs::path& tempPath)
+		{
+			auto* trustedKey = GenerateKey();
+			auto* trusted = GenerateCertificate(trustedKey, "localhost", 1);
+			auto* wrongHost = GenerateCertificate(trustedKey, "other.example", 2);
+			auto* untrusted = GenerateCertificate(trustedKey, "localhost", 3);
+
+			const auto trustPath = tempPath / "trusted.pem";
+			auto* file = BIO_new_file(trustPath.u8string().c_str(), "w");
+			PEM_write_bio_X509(file, trusted);
+			PEM_write_bio_X509(file, wrongHost);
+			BIO_free(file);
+
+#ifdef _WIN32
+			_putenv_s("SSL_CERT_FILE", trustPath.u8string().c_str());
+#else
+			setenv("SSL_CERT_FILE", trustPath.u8string().c_str(), 1);
+#endif
+
+			m_contexts[(int)LoopbackCertificate::Trusted] = CreateServerContext(trusted, trustedKey);
+			m_contexts[(int)LoopbackCertificate::WrongHost] = CreateServerContext(wrongHost, trustedKey);
+			m_contexts[(int)LoopbackCertificate::Untrusted] = CreateServerContext(untrusted, trustedKey);
+		}
+
+		static EVP_PKEY* GenerateKey()
+		{
+			EVP_PKEY* key = nullptr;
+			auto* keyContext = EVP_PKEY_CTX_new_id(EVP_PKEY_EC, nullptr);
+			EVP_PKEY_keygen_init(keyContext);
+			EVP_PKEY_CTX_set_ec_paramgen_curve_nid(keyContext, NID_X9_62_prime256v1);
+			EVP_PKEY_keygen(keyContext, &key);
+			EVP_PKEY_CTX_free(keyContext);
+			return key;
+		}
+
+		static X509* GenerateCertificate(EVP_PKEY* key, const std::string& hostName, long serial)
+		{
+			auto* cert = X509_new();
+			X509_set_version(cert, 2);
+			ASN1_INTEGER_set(X509_get_serialNumber(cert), serial);
+			X509_gmtime_adj(X509_getm_notBefore(cert), -3600);
+			X509_gmtime_adj(X509_getm_notAfter(cert), 24 * 3600);
+			X509_set_pubkey(cert, key);
+
+			auto* name = X509_get_subject_name(cert);
+			X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, (const unsigned char*)hostName.c_str(), -1, -1, 0);
+			X509_set_issuer_name(cert, name);
+
+			X509V3_CTX extensionContext;
+			X509V3_set_ctx_nodb(&extensionContext);
+			X509V3_set_ctx(&extensionContext, cert, cert, nullptr, nullptr, 0);
+
+			const auto alternativeName = "DNS:" + hostName;
+			auto* extension = X509V3_EXT_conf_nid(nullptr, &extensionContext, NID_subject_alt_name, alternativeName.c_str());
+			X509_add_ext(cert, extension, -1);
+			X509_EXTENSION_free(extension);
+
+			X509_sign(cert, key, EVP_sha256());
+			return cert;
+		}
+
+		static SSL_CTX* CreateServerContext(X509* cert, EVP_PKEY* key)
+		{
+			auto* ret = SSL_CTX_new(TLS_server_method());
+			SSL_CTX_use_certificate(ret, cert);
+			SSL_CTX_use_PrivateKey(ret, key);
+			return ret;
+		}
+	};
+#endif
+
+	// stand-in HTTP server on the loopback interface, serves one connection at a time (pipelined requests are answered in order)
+	// responses are picked by the request path:
+	//   /plain - "hello" with Content-Length
+	//   /chunked - "hello chunked world" in chunks, with chunk extension and a trailer
+	//   /close - "closed body" without Content-Length, connection is closed after it
+	//   /drop - "dropped" with Content-Length and keep-alive, but the connection is closed right after (stale idle connection)
+	class LoopbackHttpServer
+	{
+	public:
+		LoopbackHttpServer(const TestContext& context, LoopbackCertificate certificate = LoopbackCertificate::None)
+			: m_secure(certificate != LoopbackCertificate::None)
+		{
+#ifdef ONION_HTTP_TLS
+			if (m_secure)
+				m_tls = TestCertificates::GetInstance(context.tempPath).serverContext(certificate);
+#else
+			(void)context;
+#endif
+
+			m_socket = ::socket(AF_INET, SOCK_STREAM, 0);
+
+			sockaddr_in address;
+			memset(&address, 0, sizeof(address));
+			address.sin_family = AF_INET;
+			address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+			address.sin_port = 0; // any free port
+
+			socklen_t addressSize = sizeof(address);
+			if (0 == ::bind(m_socket, (const sockaddr*)&address, sizeof(address)) && 0 == ::listen(m_socket, 4) && 0 == ::getsockname(m_socket, (sockaddr*)&address, &addressSize))
+			{
+				m_port = ntohs(address.sin_port);
+				m_thread = std::thread([this]() { serve(); });
+			}
+		}
+
+		~LoopbackHttpServer()
+		{
+			if (m_thread.joinable())
+			{
+				m_stop = true;
+
+				// wake up the accept()
+				auto wakeSocket = ::socket(AF_INET, SOCK_STREAM, 0);
+
+				sockaddr_in address;
+				memset(&address, 0, sizeof(address));
+				address.sin_family = AF_INET;
+				address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+				address.sin_port = htons(m_port);
+				::connect(wakeSocket, (const sockaddr*)&address, sizeof(address));
+				CloseTestSocket(wakeSocket);
+
+				m_thread.join();
+			}
+
+			CloseTestSocket(m_socket);
+		}
+
+		inline bool valid() const { return m_port != 0; }
+
+		inline std::string url(std::string_view path) const
+		{
+			if (m_secure)
+				return "https://localhost:" + std::to_string(m_port) + std::string(path);
+
+			return "http://127.0.0.1:" + std::to_string(m_port) + std::string(path);
+		}
+
+		inline uint32_t numConnections() const { return m_numConnections.load(); }
+		inline uint32_t numRequests() const { return m_numRequests.load(); }
+		inline uint32_t numResumedSessions() const { return m_numResumedSessions.load(); }
+
+	private:
+		TestSocket m_socket = INVALID_TEST_SOCKET;
+		uint16_t m_port = 0;
+		bool m_secure = false;
+		std::thread m_thread;
+		std::atomic<bool> m_stop = false;
+		std::atomic<uint32_t> m_numConnections = 0;
+		std::atomic<uint32_t> m_numRequests = 0;
+		std::atomic<uint32_t> m_numResumedSessions = 0;
+
+#ifdef ONION_HTTP_TLS
+		SSL_CTX* m_tls = nullptr;
+#endif
+
+		// accepted connection, plain or TLS
+		struct Connection
+		{
+			TestSocket socket = INVALID_TEST_SOCKET;
+#ifdef ONION_HTTP_TLS
+			SSL* ssl = nullptr;
+#endif
+
+			int receive(char* data, int size)
+			{
+#ifdef ONION_HTTP_TLS
+				if (ssl)
+					return SSL_read(ssl, data, size);
+#endif
+				return (int)::recv(socket, data, size, 0);
+			}
+
+			bool sendAll(std::string_view data)
+			{
+				while (!data.empty())
+				{
+#ifdef ONION_HTTP_TLS
+					const auto written = ssl ? SSL_write(ssl, data.data(), (int)data.size()) : (int)::send(socket, data.data(), (int)data.size(), 0);
+#else
+					const auto written = (int)::send(socket, data.data(), (int)data.size(), 0);
+#endif
+					if (written <= 0)
+						return false;
+					data = data.substr(written);
+				}
+
+				return true;
+			}
+		};
+
+		void serve()
+		{
+			for (;;)
+			{
+				auto connection = ::accept(m_socket, nullptr, nullptr);
+				if (m_stop)
+				{
+					CloseTestSocket(connection);
+					return;
+				}
+
+				if (connection == INVALID_TEST_SOCKET)
+					continue;
+
+				m_numConnections += 1;
+
+				Connection wrapper;
+				wrapper.socket = connection;
+
+#ifdef ONION_HTTP_TLS
+				if (m_tls)
+				{
+					wrapper.ssl = SSL_new(m_tls);
+					SSL_set_fd(wrapper.ssl, (int)connection);
+					if (1 == SSL_accept(wrapper.ssl))
+					{
+						if (SSL_session_reused(wrapper.ssl))
+							m_numResumedSessions += 1;
+
+						serveConnection(wrapper);
+						SSL_shutdown(wrapper.ssl);
+					}
+
+					SSL_free(wrapper.ssl);
+					CloseTestSocket(connection);
+					continue;
+				}
+#endif
+
+				serveConnection(wrapper);
+				CloseTestSocket(connection);
+			}
+		}
+
+		void serveConnection(Connection& connection)
+		{
+			std::string buffer;
+			for (;;)
+			{
+				// requests have no body so the header end is the request end
+				const auto end = buffer.find("\r\n\r\n");
+				if (end == std::string::npos)
+				{
+					char temp[4096];
+					const auto received = connection.receive(temp, sizeof(temp));
+					if (received <= 0)
+						return;
+
+					buffer.append(temp, received);
+					continue;
+				}
+
+				const auto request = buffer.substr(0, end);
+				buffer.erase(0, end + 4);
+
+				m_numRequests += 1;
+
+				const auto path = PartBefore(PartAfter(request, " "), " ");
+				if (path == "/plain")
+				{
+					if (!connection.sendAll("HTTP/1.1 200 OK\r\nContent-Length: 5\r\n\r\nhello"))
+						return;
+				}
+				else if (path == "/chunked")
+				{
+					if (!connection.sendAll("HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n6;ext=1\r\nhello \r\n"))
+						return;
+					if (!connection.sendAll("8\r\nchunked \r\n5\r\nworld\r\n0\r\nX-Trailer: yes\r\n\r\n"))
+						return;
+				}
+				else if (path == "/close")
+				{
+					connection.sendAll("HTTP/1.1 200 OK\r\nConnection: close\r\n\r\nclosed body");
+					return;
+				}
+				else if (path == "/drop")
+				{
+					connection.sendAll("HTTP/1.1 200 OK\r\nContent-Length: 7\r\n\r\ndropped");
+					return;
+				}
+				else
+				{
+					if (!connection.sendAll("HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\n\r\n"))
+						return;
+				}
+			}
+		}
+	};
+
+	static bool Get(const std::string& url, HttpResponse& outResponse)
+	{
+		HttpRequest request;
+		request.url = url;
+		return Http_Send(request, outResponse);
+	}
+
+} // prv
+
+//--
+
+TEST_CASE(HttpKeepAliveReusesConnection)
+{
+	Http_CloseConnections(); // also initializes sockets on Windows
+
+	prv::LoopbackHttpServer server(context);
+	TEST_CHECK(server.valid());
+
+	HttpResponse response;
+	TEST_CHECK(prv::Get(server.url("/plain"), response));
+	TEST_CHECK(response.status == 200);
+	TEST_CHECK(response.body == "hello");
+
+	TEST_CHECK(prv::Get(server.url("/plain"), response));
+	TEST_CHECK(response.body == "hello");
+
+	TEST_CHECK(prv::Get(server.url("/missing"), response));
+	TEST_CHECK(response.status == 404);
+	TEST_CHECK(response.body.empty());
+
+	TEST_CHECK(server.numRequests() == 3);
+	TEST_CHECK(server.numConnections() == 1);
+
+	Http_CloseConnections();
+}
+
+TEST_CASE(HttpChunkedBody)
+{
+	Http_CloseConnections(); // also initializes sockets on Windows
+
+	prv::LoopbackHttpServer server(context);
+	TEST_CHECK(server.valid());
+
+	HttpResponse response;
+	TEST_CHECK(prv::Get(server.url("/chunked"), response));
+	TEST_CHECK(response.status == 200);
+	TEST_CHECK(response.body == "hello chunked world");
+
+	// trailer must be fully consumed so the connection can be reused for the next request
+	TEST_CHECK(prv::Get(server.url("/plain"), response));
+	TEST_CHECK(response.body == "hello");
+	TEST_CHECK(server.numConnections() == 1);
+
+	// streaming sink gets the same data
+	std::string streamed;
+	HttpRequest request;
+	request.url = server.url("/chunked");
+	request.bodySink = [&streamed](const uint8_t* data, uint64_t size)
+	{
+		streamed.append((const char*)data, size);
+		return true;
+	};
+
+	TEST_CHECK(Http_Send(request, response));
+	TEST_CHECK(streamed == "hello chunked world");
+	TEST_CHECK(response.body.empty());
+
+	Http_CloseConnections();
+}
+
+TEST_CASE(HttpConnectionClose)
+{
+	Http_CloseConnections(); // also initializes sockets on Windows
+
+	prv::LoopbackHttpServer server(context);
+	TEST_CHECK(server.valid());
+
+	// body without length is read until the server closes the connection, which is not reused
+	HttpResponse response;
+	TEST_CHECK(prv::Get(server.url("/close"), response));
+	TEST_CHECK(response.body == "closed body");
+
+	TEST_CHECK(prv::Get(server.url("/plain"), response));
+	TEST_CHECK(response.body == "hello");
+	TEST_CHECK(server.numConnections() == 2);
+
+	Http_CloseConnections();
+}
+
+TEST_CASE(HttpStaleConnectionIsRetried)
+{
+	Http_CloseConnections(); // also initializes sockets on Windows
+
+	prv::LoopbackHttpServer server(context);
+	TEST_CHECK(server.valid());
+
+	// server closes the idle connection without telling us, the next request must transparently use a new one
+	HttpResponse response;
+	TEST_CHECK(prv::Get(server.url("/drop"), response));
+	TEST_CHECK(response.body == "dropped");
+
+	TEST_CHECK(prv::Get(server.url("/plain"), response));
+	TEST_CHECK(response.status == 200);
+	TEST_CHECK(response.body == "hello");
+	TEST_CHECK(server.numConnections() == 2);
+
+	Http_CloseConnections();
+}
+
+TEST_CASE(HttpPipelinedRequests)
+{
+	Http_CloseConnections(); // also initializes sockets on Windows
+
+	prv::LoopbackHttpServer server(context);
+	TEST_CHECK(server.valid());
+
+	std::vector<HttpRequest> requests(4);
+	requests[0].url = server.url("/plain");
+	requests[1].url = server.url("/chunked");
+	requests[2].url = server.url("/missing");
+	requests[3].url = server.url("/plain");
+	requests[3].method = "POST"; // not pipelined, sent after the others
+
+	std::vector<HttpResponse> responses;
+	TEST_CHECK(Http_SendPipelined(requests, responses));
+	TEST_CHECK(responses.size() == 4);
+	TEST_CHECK(responses.size() == 4 && responses[0].body == "hello" && responses[1].body == "hello chunked world" && responses[2].status == 404 && responses[3].body == "hello");
+	TEST_CHECK(server.numRequests() == 4);
+	TEST_CHECK(server.numConnections() == 1);
+
+	Http_CloseConnections();
+}
+
+TEST_CASE(HttpPipelinedRequestsAfterClose)
+{
+	Http_CloseConnections(); // also initializes sockets on Windows
+
+	prv::LoopbackHttpServer server(context);
+	TEST_CHECK(server.valid());
+
+	// server closes the connection in the middle of the batch, requests it did not answer are sent again
+	std::vector<HttpRequest> requests(4);
+	requests[0].url = server.url("/plain");
+	requests[1].url = server.url("/drop");
+	requests[2].url = server.url("/chunked");
+	requests[3].url = server.url("/plain");
+
+	std::vector<HttpResponse> responses;
+	TEST_CHECK(Http_SendPipelined(requests, responses));
+	TEST_CHECK(responses.size() == 4 && responses[0].body == "hello" && responses[1].body == "dropped" && responses[2].body == "hello chunked world" && responses[3].body == "hello");
+	TEST_CHECK(server.numConnections() == 2);
+
+	Http_CloseConnections();
+}
+
+TEST_CASE(HttpProxyIsLeftToCurl)
+{
+	const auto url = std::string("http://127.0.0.1:1/path");
+	TEST_CHECK(Http_CanHandleInProcess(url));
+
+#ifdef _WIN32
+	_putenv_s("http_proxy", "http://proxy:3128");
+	TEST_CHECK(!Http_CanHandleInProcess(url));
+	_putenv_s("http_proxy", "");
+#else
+	setenv("http_proxy", "http://proxy:3128", 1);
+	TEST_CHECK(!Http_CanHandleInProcess(url));
+	unsetenv("http_proxy");
+#endif
+
+	TEST_CHECK(Http_CanHandleInProcess(url));
+}
+
+#ifdef ONION_HTTP_TLS
+
+TEST_CASE(HttpsKeepAliveAndSessionReuse)
+{
+	Http_CloseConnections(); // also initializes sockets on Windows
+
+	prv::LoopbackHttpServer server(context, prv::LoopbackCertificate::Trusted);
+	TEST_CHECK(server.valid());
+	TEST_CHECK(Http_CanHandleInProcess(server.url("/plain")));
+
+	HttpResponse response;
+	TEST_CHECK(prv::Get(server.url("/plain"), response));
+	TEST_CHECK(response.body == "hello");
+
+	TEST_CHECK(prv::Get(server.url("/chunked"), response));
+	TEST_CHECK(response.body == "hello chunked world");
+	TEST_CHECK(server.numConnections() == 1);
+
+	// new connection to the same host resumes the TLS session instead of a full handshake
+	Http_CloseConnections();
+
+	std::vector<HttpRequest> requests(3);
+	requests[0].url = server.url("/plain");
+	requests[1].url = server.url("/missing");
+	requests[2].url = server.url("/plain");
+
+	std::vector<HttpResponse> responses;
+	TEST_CHECK(Http_SendPipelined(requests, responses));
+	TEST_CHECK(responses.size() == 3 && responses[0].body == "hello" && responses[1].status == 404 && responses[2].body == "hello");
+	TEST_CHECK(server.numConnections() == 2);
+	TEST_CHECK(server.numResumedSessions() == 1);
+
+	Http_CloseConnections();
+}
+
+TEST_CASE(HttpsRejectsUnverifiedServers)
+{
+	Http_CloseConnections(); // also initializes sockets on Windows
+
+	HttpResponse response;
+
+	{
+		prv::LoopbackHttpServer server(context, prv::LoopbackCertificate::Untrusted);
+		TEST_CHECK(server.valid());
+		TEST_CHECK(!prv::Get(server.url("/plain"), response));
+		TEST_CHECK(server.numRequests() == 0);
+	}
+
+	{
+		prv::LoopbackHttpServer server(context, prv::LoopbackCertificate::WrongHost);
+		TEST_CHECK(server.valid());
+		TEST_CHECK(!prv::Get(server.url("/plain"), response));
+		TEST_CHECK(server.numRequests() == 0);
+	}
+
+	Http_CloseConnections();
+}
+
+#endif
+
+//--
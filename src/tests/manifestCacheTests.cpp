@@ -0,0 +1,319 @@
+#include "common.h"
+#include "utils.h"
+#include "projectManifest.h"
+#include "moduleManifest.h"
+#include "externalLibrary.h"
+#include "tests/tests.h"
+
+//--
+
+namespace prv
+{
+	// every field gets a value different from its default so a field missing from either side of the serialization shows up
+	static void FillProject(ProjectManifest& project, std::string_view name)
+	{
+		project.name = name;
+		project.guid = "{5E1F3B7A-0C2D-4E6F-8A9B-1C2D3E4F5A6B}";
+		project.solutionGroupName = "engine";
+		project.localGroupName = "core";
+		project.loadPath = fs::path("/work/module/src") / name / "build.xml";
+		project.rootPath = fs::path("/work/module/src") / name;
+
+		project.type = ProjectType::SharedLibrary;
+		project.optionLinkType = ProjectLibraryLinkType::AlwaysDetachedDynamic;
+		project.optionSubstem = ProjectAppSubsystem::Windows;
+		project.optionTestFramework = ProjectTestFramework::Catch2;
+		project.optionUnityBuild = ProjectUnityBuildMode::Disabled;
+
+		project.optionWarningLevel = 3;
+		project.optionDetached = true;
+		project.optionUseStaticInit = false;
+		project.optionUsePrecompiledHeaders = false;
+		project.optionUseExceptions = true;
+		project.optionGenerateMain = true;
+		project.optionGenerateSymbols = false;
+		project.optionExportApplicataion = false;
+		project.optionSelfTest = true;
+		project.optionHasPreMain = true;
+		project.optionLegacy = true;
+		project.optionThirdParty = true;
+		project.optionFrozen = true;
+		project.optionEngineOnly = true;
+		project.optionHasInit = true;
+		project.optionHasPreInit = true;
+		project.optionAdvancedInstructionSet = "avx2";
+		project.optionUnityBatchSize = 256;
+		project.unityExcludedFiles = { "gen/", "slow.cpp" };
+
+		project.dependencies = { "core", "math" };
+		project.optionalDependencies = { "profiler" };
+		project.libraryDependencies = { "zlib", "curl" };
+
+		project.localIncludePaths = { "/work/module/src/include" };
+		project.legacySourceDirectories = { "code", "extra" };
+		project.exportedIncludePaths = { "/work/module/src/public", "/work/module/src/api" };
+
+		project.localDefines = { { "BUILD_LOCAL", "1" }, { "EMPTY", "" } };
+		project.globalDefines = { { "HAS_EDITOR", "1" } };
+
+		project.frozenDeployFiles = { "/work/module/bin/core.so" };
+		project.frozenLibraryFiles = { "/work/module/lib/core.a" };
+
+		project.thirdPartySourceFiles = { "/work/module/src/third/a.c", "/work/module/src/third/b.c" };
+		project.thirdPartySharedLocalBuildDefine = "THIRD_BUILD";
+		project.thirdPartySharedGlobalExportDefine = "THIRD_EXPORT";
+
+		project.appClassName = "EditorApp";
+		project.appHeaderName = "editorApp.h";
+		project.appSystemClasses = { "Renderer", "Audio" };
+		project.appDisableLogOnStart = true;
+	}
+
+	static bool SameProject(const ProjectManifest& a, const ProjectManifest& b)
+	{
+		return a.name == b.name
+			&& a.guid == b.guid
+			&& a.solutionGroupName == b.solutionGroupName
+			&& a.localGroupName == b.localGroupName
+			&& a.loadPath == b.loadPath
+			&& a.rootPath == b.rootPath
+			&& a.type == b.type
+			&& a.optionLinkType == b.optionLinkType
+			&& a.optionSubstem == b.optionSubstem
+			&& a.optionTestFramework == b.optionTestFramework
+			&& a.optionUnityBuild == b.optionUnityBuild
+			&& a.optionWarningLevel == b.optionWarningLevel
+			&& a.optionDetached == b.optionDetached
+			&& a.optionUseStaticInit == b.optionUseStaticInit
+			&& a.optionUsePrecompiledHeaders == b.optionUsePrecompiledHeaders
+			&& a.optionUseExceptions == b.optionUseExceptions
+			&& a.optionGenerateMain == b.optionGenerateMain
+			&& a.optionGenerateSymbols == b.optionGenerateSymbols
+			&& a.optionExportApplicataion == b.optionExportApplicataion
+			&& a.optionSelfTest == b.optionSelfTest
+			&& a.optionHasPreMain == b.optionHasPreMain
+			&& a.optionLegacy == b.optionLegacy
+			&& a.optionThirdParty == b.optionThirdParty
+			&& a.optionFrozen == b.optionFrozen
+			&& a.optionEngineOnly == b.optionEngineOnly
+			&& a.optionHasInit == b.optionHasInit
+			&& a.optionHasPreInit == b.optionHasPreInit
+			&& a.optionAdvancedInstructionSet == b.optionAdvancedInstructionSet
+			&& a.optionUnityBatchSize == b.optionUnityBatchSize
+			&& a.unityExcludedFiles == b.unityExcludedFiles
+			&& a.dependencies == b.dependencies
+			&& a.optionalDependencies == b.optionalDependencies
+			&& a.libraryDependencies == b.libraryDependencies
+			&& a.localIncludePaths == b.localIncludePaths
+			&& a.legacySourceDirectories == b.legacySourceDirectories
+			&& a.exportedIncludePaths == b.exportedIncludePaths
+			&& a.localDefines == b.localDefines
+			&& a.globalDefines == b.globalDefines
+			&& a.frozenDeployFiles == b.frozenDeployFiles
+			&& a.frozenLibraryFiles == b.frozenLibraryFiles
+			&& a.thirdPartySourceFiles == b.thirdPartySourceFiles
+			&& a.thirdPartySharedLocalBuildDefine == b.thirdPartySharedLocalBuildDefine
+			&& a.thirdPartySharedGlobalExportDefine == b.thirdPartySharedGlobalExportDefine
+			&& a.appClassName == b.appClassName
+			&& a.appHeaderName == b.appHeaderName
+			&& a.appSystemClasses == b.appSystemClasses
+			&& a.appDisableLogOnStart == b.appDisableLogOnStart;
+	}
+
+	template< typename T >
+	static std::vector<uint8_t> Serialize(const T& manifest)
+	{
+		BinaryWriter writer;
+		manifest.writeBinary(writer);
+		return std::move(writer.data);
+	}
+
+} // prv
+
+//--
+
+TEST_CASE(BinaryReaderRoundTripsValues)
+{
+	const std::vector<std::string> strings = { "a", "", "longer string with spaces" };
+	const std::vector<fs::path> paths = { "/root/dir/file.txt", "relative/path" };
+
+	BinaryWriter writer;
+	writer.writeU8(0xAB);
+	writer.writeU32(0xDEADBEEF);
+	writer.writeU64(0x0123456789ABCDEFull);
+	writer.writeString("");
+	writer.writeString("text");
+	writer.writePath("/some/path");
+	writer.writeStrings(strings);
+	writer.writePaths(paths);
+
+	BinaryReader reader(writer.data.data(), writer.data.size());
+	TEST_CHECK(reader.readU8() == 0xAB);
+	TEST_CHECK(reader.readU32() == 0xDEADBEEF);
+	TEST_CHECK(reader.readU64() == 0x0123456789ABCDEFull);
+	TEST_CHECK(reader.readString() == "");
+	TEST_CHECK(reader.readString() == "text");
+	TEST_CHECK(reader.readPath() == fs::path("/some/path"));
+
+	std::vector<std::string> readStrings;
+	reader.readStrings(readStrings);
+	TEST_CHECK(readStrings == strings);
+
+	std::vector<fs::path> readPaths;
+	reader.readPaths(readPaths);
+	TEST_CHECK(readPaths == paths);
+
+	TEST_CHECK(reader.ok());
+	TEST_CHECK(reader.atEnd());
+
+	// reading past the end is reported, not garbage
+	reader.readU32();
+	TEST_CHECK(!reader.ok());
+}
+
+TEST_CASE(BinaryReaderRejectsTruncatedData)
+{
+	BinaryWriter writer;
+	writer.writeString("a string that will not fully fit");
+
+	BinaryReader reader(writer.data.data(), writer.data.size() - 4);
+	reader.readString();
+	TEST_CHECK(!reader.ok());
+}
+
+TEST_CASE(ProjectManifestBinaryRoundTrip)
+{
+	ProjectManifest project;
+	prv::FillProject(project, "editor");
+
+	const auto data = prv::Serialize(project);
+
+	ProjectManifest loaded;
+	BinaryReader reader(data.data(), data.size());
+	TEST_CHECK(loaded.readBinary(reader));
+	TEST_CHECK(reader.atEnd());
+	TEST_CHECK(prv::SameProject(project, loaded));
+	TEST_CHECK(prv::Serialize(loaded) == data);
+}
+
+TEST_CASE(ModuleManifestBinaryRoundTrip)
+{
+	ModuleManifest module;
+	module.guid = "{0A1B2C3D-4E5F-6071-8293-A4B5C6D7E8F9}";
+	module.path = "/work/module/build.xml";
+	module.globalNamespace = "game";
+	module.globalSolutionName = "Game";
+	module.localProjectGroup = "engine";
+
+	for (const auto* name : { "core", "editor" })
+	{
+		auto* project = new ProjectManifest();
+		prv::FillProject(*project, name);
+		module.projects.push_back(project);
+	}
+
+	module.moduleDependencies.push_back({ "https://github.com/org/base.git", "modules/base/" });
+	module.moduleData.push_back({ "/data/core/", "data/core", "/work/module/data/core" });
+	module.librarySources.push_back({ "github", "org/libraries" });
+	module.globalIncludePaths = { "/work/module/src", "/work/module/include" };
+	module.includedManifests = { "/work/module/common.xml" };
+
+	const auto data = prv::Serialize(module);
+
+	ModuleManifest loaded;
+	BinaryReader reader(data.data(), data.size());
+	TEST_CHECK(loaded.readBinary(reader));
+	TEST_CHECK(reader.atEnd());
+
+	TEST_CHECK(loaded.guid == module.guid);
+	TEST_CHECK(loaded.path == module.path);
+	TEST_CHECK(loaded.globalNamespace == module.globalNamespace);
+	TEST_CHECK(loaded.globalSolutionName == module.globalSolutionName);
+	TEST_CHECK(loaded.localProjectGroup == module.localProjectGroup);
+
+	TEST_CHECK(loaded.projects.size() == module.projects.size());
+	for (size_t i = 0; i < loaded.projects.size() && i < module.projects.size(); ++i)
+		TEST_CHECK(prv::SameProject(*module.projects[i], *loaded.projects[i]));
+
+	TEST_CHECK(loaded.moduleDependencies.size() == 1);
+	TEST_CHECK(loaded.moduleDependencies.size() == 1 && loaded.moduleDependencies[0].gitRepoPath == "https://github.com/org/base.git" && loaded.moduleDependencies[0].localRelativePath == "modules/base/");
+	TEST_CHECK(loaded.moduleData.size() == 1 && loaded.moduleData[0].mountPath == "/data/core/" && loaded.moduleData[0].localSourcePath == "data/core" && loaded.moduleData[0].sourcePath == fs::path("/work/module/data/core"));
+	TEST_CHECK(loaded.librarySources.size() == 1 && loaded.librarySources[0].type == "github" && loaded.librarySources[0].data == "org/libraries");
+	TEST_CHECK(loaded.globalIncludePaths == module.globalIncludePaths);
+	TEST_CHECK(loaded.includedManifests == module.includedManifests);
+
+	TEST_CHECK(prv::Serialize(loaded) == data);
+
+	for (auto* project : module.projects)
+		delete project;
+	for (auto* project : loaded.projects)
+		delete project;
+}
+
+TEST_CASE(ExternalLibraryManifestBinaryRoundTrip)
+{
+	const auto libraryPath = context.tempPath / "zlib";
+	TEST_CHECK(CreateDirectories(libraryPath / "include"));
+	TEST_CHECK(CreateDirectories(libraryPath / "lib"));
+	TEST_CHECK(SaveFileFromString(libraryPath / "lib" / "libz.a", "lib", true, false));
+	TEST_CHECK(SaveFileFromString(libraryPath / "lib" / "libz.so", "so", true, false));
+	TEST_CHECK(SaveFileFromString(libraryPath / "README", "readme", true, false));
+
+	std::stringstream txt;
+	txt << "<ExternalLibrary name=\"zlib\" hash=\"1234abcd\">\n";
+	txt << "<File>README</File>\n";
+	txt << "<Link>lib/libz.a</Link>\n";
+	txt << "<Deploy>lib/libz.so</Deploy>\n";
+	txt << "<AdditionalSystemLibrary>m</AdditionalSystemLibrary>\n";
+	txt << "<AdditionalSystemPackage>zlib1g</AdditionalSystemPackage>\n";
+	txt << "<AdditionalSystemFramework>Security</AdditionalSystemFramework>\n";
+	txt << "<Platform platform=\"linux\"/>\n";
+	txt << "</ExternalLibrary>\n";
+	TEST_CHECK(SaveFileFromString(libraryPath / "LIBRARY", txt.str(), true, false));
+
+	const auto library = ExternalLibraryManifest::Load(libraryPath / "LIBRARY");
+	TEST_CHECK(library != nullptr);
+	if (!library)
+		return;
+
+	library->platform = "linux";
+
+	const auto data = prv::Serialize(*library);
+
+	ExternalLibraryManifest loaded;
+	BinaryReader reader(data.data(), data.size());
+	TEST_CHECK(loaded.readBinary(reader));
+	TEST_CHECK(reader.atEnd());
+
+	TEST_CHECK(loaded.rootPath == library->rootPath);
+	TEST_CHECK(loaded.name == "zlib");
+	TEST_CHECK(loaded.platform == "linux");
+	TEST_CHECK(loaded.hash == "1234abcd");
+	TEST_CHECK(loaded.allFiles == library->allFiles);
+	TEST_CHECK(loaded.includeDirectory() == library->includeDirectory());
+	TEST_CHECK(!loaded.includeDirectory().empty());
+
+	for (const auto platform : { PlatformType::Linux, PlatformType::Windows })
+	{
+		std::vector<fs::path> libraries, loadedLibraries;
+		library->collectLibraries(platform, &libraries);
+		loaded.collectLibraries(platform, &loadedLibraries);
+		TEST_CHECK(!loadedLibraries.empty());
+		TEST_CHECK(loadedLibraries == libraries);
+
+		std::unordered_set<std::string> packages, loadedPackages;
+		library->collectAdditionalSystemPackages(platform, &packages);
+		loaded.collectAdditionalSystemPackages(platform, &loadedPackages);
+		TEST_CHECK(loadedPackages.count("zlib1g") == 1);
+		TEST_CHECK(loadedPackages == packages);
+
+		std::unordered_set<std::string> frameworks, loadedFrameworks;
+		library->collectAdditionalSystemFrameworks(platform, &frameworks);
+		loaded.collectAdditionalSystemFrameworks(platform, &loadedFrameworks);
+		TEST_CHECK(loadedFrameworks == frameworks);
+	}
+
+	TEST_CHECK(prv::Serialize(loaded) == data);
+}
+
+//--
@@ -0,0 +1,113 @@
+#include "common.h"
+#include "utils.h"
+#include "tests/tests.h"
+
+// unit tests of the parts of the tool that can be checked without a full workspace (network client, archive extraction)
+// whole workflows are tested by building the modules in the "tests" directory
+
+//--
+
+namespace prv
+{
+	struct RegisteredTest
+	{
+		const char* name = "";
+		TTestFunction func = nullptr;
+	};
+
+	static std::vector<RegisteredTest>& GetRegisteredTests()
+	{
+		static std::vector<RegisteredTest> theTests;
+		return theTests;
+	}
+
+	static void PrintUsage()
+	{
+		LogInfo() << "onion_tests [options]";
+		LogInfo() << "";
+		LogInfo() << "  -filter=<text> - run only tests with given text in the name";
+		LogInfo() << "";
+	}
+
+} // prv
+
+//--
+
+void TestContext::fail(const char* file, int line, const char* expression)
+{
+	LogError() << testName << ": check failed at " << file << "(" << line << "): " << expression;
+	numFailedChecks += 1;
+}
+
+TestRegistration::TestRegistration(const char* name, TTestFunction func)
+{
+	prv::RegisteredTest test;
+	test.name = name;
+	test.func = func;
+	prv::GetRegisteredTests().push_back(test);
+}
+
+//--
+
+int main(int argc, char** argv)
+{
+	std::string args;
+	for (int i = 1; i < argc; ++i)
+	{
+		args += " ";
+		args += argv[i];
+	}
+
+	Commandline cmdLine;
+	if (!cmdLine.parse(args) || !cmdLine.commands.empty() || cmdLine.has("help"))
+	{
+		prv::PrintUsage();
+		return 1;
+	}
+
+	const auto filter = cmdLine.get("filter");
+	const auto tempPath = fs::temp_directory_path() / "onion_tests";
+
+	uint32_t numTests = 0;
+	uint32_t numFailedTests = 0;
+	for (const auto& test : prv::GetRegisteredTests())
+	{
+		if (!filter.empty() && std::string_view(test.name).find(filter) == std::string_view::npos)
+			continue;
+
+		TestContext context;
+		context.testName = test.name;
+		context.tempPath = tempPath / test.name;
+
+		std::error_code ec;
+		fs::remove_all(context.tempPath, ec);
+		if (!CreateDirectories(context.tempPath))
+		{
+			LogError() << "Unable to create temporary directory " << context.tempPath;
+			return 1;
+		}
+
+		test.func(context);
+
+		fs::remove_all(context.tempPath, ec);
+
+		numTests += 1;
+		if (context.numFailedChecks)
+		{
+			LogError() << "FAILED: " << test.name << " (" << context.numFailedChecks << " failed check(s))";
+			numFailedTests += 1;
+		}
+		else
+		{
+			LogInfo() << "Passed: " << test.name;
+		}
+	}
+
+	std::error_code ec;
+	fs::remove_all(tempPath, ec);
+
+	LogInfo() << numTests - numFailedTests << " of " << numTests << " test(s) passed";
+	return numFailedTests ? 2 : 0;
+}
+
+//--
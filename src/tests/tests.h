@@ -0,0 +1,32 @@
+#pragma once
+
+//--
+
+// minimal self registering test cases for the onion_tests executable, each test is a function that reports failed checks
+// tests run in the order of registration, a failed check does not stop the test (so all problems are reported at once)
+
+struct TestContext
+{
+	const char* testName = "";
+	uint32_t numFailedChecks = 0;
+	fs::path tempPath; // empty directory created for the test, removed after it
+
+	void fail(const char* file, int line, const char* expression);
+};
+
+typedef void (*TTestFunction)(TestContext& context);
+
+struct TestRegistration
+{
+	TestRegistration(const char* name, TTestFunction func);
+};
+
+#define TEST_CASE(name) \
+	static void Test_##name(TestContext& context); \
+	static TestRegistration TestRegistration_##name(#name, &Test_##name); \
+	static void Test_##name(TestContext& context)
+
+#define TEST_CHECK(expr) \
+	do { if (!(expr)) context.fail(__FILE__, __LINE__, #expr); } while (0)
+
+//--
@@ -0,0 +1,92 @@
+#include "common.h"
+#include "utils.h"
+#include "tests/tests.h"
+
+#include <thread>
+#include <mutex>
+
+//--
+
+TEST_CASE(RunParallelCallsEveryIndexOnce)
+{
+	std::vector<std::atomic<uint32_t>> calls(100);
+	RunParallel((uint32_t)calls.size(), 8, [&calls](uint32_t index) { calls[index] += 1; });
+
+	bool allOnce = true;
+	for (const auto& count : calls)
+		allOnce &= (count.load() == 1);
+
+	TEST_CHECK(allOnce);
+}
+
+TEST_CASE(RunParallelNestedCallsStayOnWorker)
+{
+	std::mutex lock;
+	std::unordered_set<std::thread::id> threads;
+	bool nestedOnSameThread = true;
+
+	RunParallel(4, 4, [&](uint32_t)
+		{
+			const auto outerThread = std::this_thread::get_id();
+
+			RunParallel(8, 8, [&](uint32_t)
+				{
+					std::lock_guard<std::mutex> guard(lock);
+					threads.insert(std::this_thread::get_id());
+					nestedOnSameThread &= (std::this_thread::get_id() == outerThread);
+				});
+		});
+
+	TEST_CHECK(nestedOnSameThread);
+	TEST_CHECK(threads.size() <= 4);
+}
+
+TEST_CASE(LogErrorCaptureRecordsOnlyItsThread)
+{
+	LogErrorCapture capture;
+	LogInfo() << "Not an error";
+	LogError() << "Failed to open " << fs::path("a.txt") << " (" << 42 << ")";
+
+	std::thread([]() { LogError() << "Error from other thread"; }).join();
+
+	{
+		LogErrorCapture inner;
+		LogError() << "Inner error";
+		TEST_CHECK(inner.errors().size() == 1);
+	}
+
+	TEST_CHECK(capture.errors().size() == 1);
+	TEST_CHECK(!capture.errors().empty() && capture.errors().front() == "Failed to open \"a.txt\" (42)");
+}
+
+TEST_CASE(CloneNewerFileCreatesSeparateFile)
+{
+	const auto sourcePath = context.tempPath / "source.bin";
+	const auto targetPath = context.tempPath / "deploy" / "target.bin";
+
+	std::string content;
+	for (uint32_t i = 0; i < 100000; ++i)
+		content += (char)('a' + (i % 26));
+	TEST_CHECK(SaveFileFromString(sourcePath, content, true, false));
+
+	bool copied = false;
+	TEST_CHECK(CloneNewerFile(sourcePath, targetPath, &copied));
+	TEST_CHECK(copied);
+
+	std::string targetContent;
+	TEST_CHECK(LoadFileToString(targetPath, targetContent));
+	TEST_CHECK(targetContent == content);
+	TEST_CHECK(!fs::equivalent(sourcePath, targetPath));
+
+	// up to date target is left alone
+	TEST_CHECK(CloneNewerFile(sourcePath, targetPath, &copied));
+	TEST_CHECK(!copied);
+
+	// writing to the clone does not change the source
+	TEST_CHECK(SaveFileFromString(targetPath, "changed", true, false));
+	std::string sourceContent;
+	TEST_CHECK(LoadFileToString(sourcePath, sourceContent));
+	TEST_CHECK(sourceContent == content);
+}
+
+//--
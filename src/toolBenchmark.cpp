@@ -0,0 +1,910 @@
+#include "common.h"
+#include "utils.h"
+#include "json.h"
+#include "toolBenchmark.h"
+
+#include <random>
+
+//--
+
+ToolBenchmark::ToolBenchmark()
+{}
+
+void ToolBenchmark::printUsage()
+{
+	LogInfo() << "onion benchmark [options]";
+	LogInfo() << "";
+	LogInfo() << "Workspace options:";
+	LogInfo() << "  -workspace=<path> - directory for the synthetic workspace (defaults to onion_benchmark in the system temp directory), it's recreated on every run";
+	LogInfo() << "  -modules=<number> - number of modules, each depends on the previous one (default 4)";
+	LogInfo() << "  -projects=<number> - total number of projects, spread evenly across modules (default 100)";
+	LogInfo() << "  -sources=<number> - source files (with a header each) in every project (default 20)";
+	LogInfo() << "  -lines=<number> - approximate number of lines in every source file (default 200)";
+	LogInfo() << "  -fanout=<number> - direct dependencies of every project on other projects (default 4)";
+	LogInfo() << "  -media=<number> - media files embedded in every project (default 2)";
+	LogInfo() << "  -mediaSize=<KB> - size of every media file (default 16)";
+	LogInfo() << "  -bison=<number> - number of projects with a bison grammar (default 5)";
+	LogInfo() << "  -seed=<number> - seed for the dependency structure (default 1)";
+	LogInfo() << "  -generateOnly - only synthesize the workspace, do not run anything";
+	LogInfo() << "";
+	LogInfo() << "Benchmark options:";
+	LogInfo() << "  -onion=<path> - onion executable to benchmark (defaults to this one)";
+	LogInfo() << "  -repeat=<number> - how many times every stage is run, median is reported (default 3)";
+	LogInfo() << "  -config=<build configuration string> - passed to configure and make";
+	LogInfo() << "  -unity - passed to make";
+	LogInfo() << "  -json=<path> - where to write the results (defaults to benchmark.json in the current directory)";
+	LogInfo() << "  -compare=<path> - results of previous run to compare against";
+	LogInfo() << "  -threshold=<percent> - slowdown of the median reported as regression when comparing (default 10)";
+	LogInfo() << "  -failOnRegression - return error if any stage regressed";
+	LogInfo() << "";
+}
+
+//--
+
+namespace prv
+{
+	static const char* BENCHMARK_MARKER_FILE = ".onion_benchmark";
+	static const char* BENCHMARK_GLOBAL_NAMESPACE = "bench";
+
+	static const char* BENCHMARK_STAGES[] = {
+		"configure", "make_cold", "make_warm", "reflection", "embed"
+	};
+
+	static const uint32_t NUM_BENCHMARK_STAGES = sizeof(BENCHMARK_STAGES) / sizeof(BENCHMARK_STAGES[0]);
+
+	struct BenchmarkSettings
+	{
+		uint32_t numModules = 4;
+		uint32_t numProjects = 100;
+		uint32_t numSourcesPerProject = 20;
+		uint32_t numLinesPerSource = 200;
+		uint32_t dependencyFanOut = 4;
+		uint32_t numMediaFilesPerProject = 2;
+		uint32_t mediaFileSizeKB = 16;
+		uint32_t numBisonProjects = 5;
+		uint32_t seed = 1;
+	};
+
+	struct BenchmarkProject
+	{
+		std::string name;
+		uint32_t moduleIndex = 0;
+		fs::path rootPath; // directory with the build.xml
+		std::vector<uint32_t> dependencies;
+		std::vector<std::string> mediaFiles; // relative to the media directory
+		bool hasBison = false;
+		bool application = false;
+	};
+
+	struct BenchmarkWorkspace
+	{
+		fs::path rootPath; // where the modules are
+		fs::path mainModulePath; // directory of the last module (the one we run the tools in)
+		fs::path outputPath; // where the stages not run by make put their files
+
+		std::vector<BenchmarkProject> projects;
+
+		uint32_t numFiles = 0;
+		uint64_t numBytes = 0;
+	};
+
+	struct BenchmarkStage
+	{
+		std::vector<uint64_t> runTimesMs;
+		uint64_t peakMemoryBytes = 0;
+		uint32_t numProcesses = 0;
+	};
+
+	//--
+
+	static uint32_t GetNumberOption(const Commandline& cmdLine, std::string_view name, uint32_t defaultValue, uint32_t minValue)
+	{
+		if (!cmdLine.has(name))
+			return defaultValue;
+
+		return (uint32_t)std::max<int>(minValue, atoi(std::string(cmdLine.get(name)).c_str()));
+	}
+
+	static std::string PrintNumbered(std::string_view prefix, uint32_t index)
+	{
+		char txt[64];
+		snprintf(txt, sizeof(txt), "%04u", index);
+		return std::string(prefix) + txt;
+	}
+
+	static std::string ModuleGuid(uint32_t moduleIndex)
+	{
+		const auto guid = GuidFromText(PrintNumbered("onion_benchmark_module_", moduleIndex));
+		return ToLower(ReplaceAll(ReplaceAll(guid, "{", ""), "}", ""));
+	}
+
+	static std::string TypeName(const BenchmarkProject& project)
+	{
+		return "Bench" + ReplaceAll(PartAfter(project.name, "bench_"), "_", "");
+	}
+
+	//--
+
+	class BenchmarkWorkspaceGenerator
+	{
+	public:
+		BenchmarkWorkspaceGenerator(const BenchmarkSettings& settings, BenchmarkWorkspace& workspace)
+			: m_settings(settings)
+			, m_workspace(workspace)
+			, m_random(settings.seed)
+		{}
+
+		bool generate()
+		{
+			buildStructure();
+
+			bool valid = true;
+			for (uint32_t i = 0; i < m_settings.numModules; ++i)
+				valid &= writeModule(i);
+
+			for (const auto& project : m_workspace.projects)
+				valid &= writeProject(project);
+
+			return valid;
+		}
+
+	private:
+		const BenchmarkSettings& m_settings;
+		BenchmarkWorkspace& m_workspace;
+
+		std::mt19937 m_random; // only the raw output is used so the structure is the same on every platform
+
+		fs::path modulePath(uint32_t moduleIndex) const
+		{
+			return m_workspace.rootPath / PrintNumbered("module_", moduleIndex);
+		}
+
+		void buildStructure()
+		{
+			const auto numProjects = m_settings.numProjects;
+
+			m_workspace.mainModulePath = modulePath(m_settings.numModules - 1);
+
+			for (uint32_t i = 0; i < numProjects; ++i)
+			{
+				BenchmarkProject project;
+
+				// first project is the core everybody depends on (enables the reflection in make), last one is the application
+				if (i == 0)
+					project.name = "core_object";
+				else if (i == numProjects - 1)
+					project.name = "bench_app";
+				else
+					project.name = PrintNumbered("bench_", i);
+
+				project.application = (i == numProjects - 1) && (i > 0);
+
+				// projects are split into continuous blocks so dependencies go to the same or one of the previous modules
+				project.moduleIndex = (uint32_t)(((uint64_t)i * m_settings.numModules) / numProjects);
+				project.rootPath = modulePath(project.moduleIndex) / "code" / PrintNumbered("group_", i / 16) / project.name;
+
+				if (i > 0)
+				{
+					project.dependencies.push_back(0);
+
+					// pick random earlier projects, prefer the close ones so the graph is deep and not only wide
+					const auto maxDependencies = std::min<uint32_t>(m_settings.dependencyFanOut, i - 1);
+					for (uint32_t j = 0; j < maxDependencies * 4 && project.dependencies.size() <= maxDependencies; ++j)
+					{
+						const auto window = (m_random() & 1) ? std::min<uint32_t>(i - 1, 8) : (i - 1);
+						const auto dep = i - 1 - (m_random() % window);
+
+						if (std::find(project.dependencies.begin(), project.dependencies.end(), dep) == project.dependencies.end())
+							project.dependencies.push_back(dep);
+					}
+				}
+
+				for (uint32_t j = 0; j < m_settings.numMediaFilesPerProject; ++j)
+					project.mediaFiles.push_back((j & 1) ? PrintNumbered("data/file_", j) + ".txt" : PrintNumbered("file_", j) + ".txt");
+
+				m_workspace.projects.push_back(project);
+			}
+
+			// bison grammars are spread evenly
+			const auto numBisonProjects = std::min<uint32_t>(m_settings.numBisonProjects, numProjects);
+			for (uint32_t i = 0; i < numBisonProjects; ++i)
+				m_workspace.projects[numProjects - 1 - (uint32_t)(((uint64_t)i * numProjects) / numBisonProjects)].hasBison = true;
+		}
+
+		bool writeFile(const fs::path& path, std::string_view content)
+		{
+			m_workspace.numFiles += 1;
+			m_workspace.numBytes += content.size();
+			return SaveFileFromString(path, content, true, false);
+		}
+
+		bool writeModule(uint32_t moduleIndex)
+		{
+			std::stringstream f;
+			writeln(f, "<?xml version=\"1.0\" encoding=\"utf-8\" standalone=\"yes\" ?>");
+			writelnf(f, "<Module guid=\"%s\">", ModuleGuid(moduleIndex).c_str());
+			writelnf(f, "	<GlobalNamespace>%s</GlobalNamespace>", BENCHMARK_GLOBAL_NAMESPACE);
+			writeln(f, "	<GlobalSolutionName>bench</GlobalSolutionName>");
+			writeln(f, "	<GlobalIncludePath>code/</GlobalIncludePath>");
+
+			if (moduleIndex > 0)
+				writelnf(f, "	<ModuleDependency path=\"../%s\"/>", PrintNumbered("module_", moduleIndex - 1).c_str());
+
+			const auto moduleRootPath = modulePath(moduleIndex);
+			for (const auto& project : m_workspace.projects)
+			{
+				if (project.moduleIndex == moduleIndex)
+				{
+					const auto relativePath = fs::relative(project.rootPath / "build.xml", moduleRootPath);
+					writelnf(f, "	<Include>%s</Include>", MakeGenericPathEx(relativePath).c_str());
+				}
+			}
+
+			writeln(f, "</Module>");
+
+			return writeFile(moduleRootPath / "build.xml", f.str());
+		}
+
+		bool writeProject(const BenchmarkProject& project)
+		{
+			bool valid = true;
+
+			// manifest
+			{
+				const auto* tag = project.application ? "Application" : "Library";
+
+				std::stringstream f;
+				writeln(f, "<?xml version=\"1.0\" encoding=\"utf-8\" standalone=\"yes\" ?>");
+				writeln(f, "<Module>");
+				writelnf(f, "	<%s>", tag);
+				writelnf(f, "		<Name>%s</Name>", project.name.c_str());
+				writeln(f, "		<SourceRoot>.</SourceRoot>");
+
+				for (const auto dep : project.dependencies)
+					writelnf(f, "		<Dependency>%s</Dependency>", m_workspace.projects[dep].name.c_str());
+
+				writelnf(f, "	</%s>", tag);
+				writeln(f, "</Module>");
+
+				valid &= writeFile(project.rootPath / "build.xml", f.str());
+			}
+
+			// sources
+			for (uint32_t i = 0; i < m_settings.numSourcesPerProject; ++i)
+			{
+				const auto fileName = PrintNumbered("file_", i);
+
+				std::stringstream header, source;
+				writeHeader(project, i, header);
+				writeSource(project, i, source);
+
+				valid &= writeFile(project.rootPath / "include" / (fileName + ".h"), header.str());
+				valid &= writeFile(project.rootPath / "src" / (fileName + ".cpp"), source.str());
+			}
+
+			// application entry point
+			if (project.application)
+			{
+				std::stringstream f;
+				writeln(f, "#include \"build.h\"");
+				writeln(f, "");
+				writeln(f, "int main()");
+				writeln(f, "{");
+				writeln(f, "	return 0;");
+				writeln(f, "}");
+
+				valid &= writeFile(project.rootPath / "src" / "main.cpp", f.str());
+			}
+
+			// media
+			for (const auto& mediaFile : project.mediaFiles)
+			{
+				std::stringstream f;
+				writeMedia(f);
+				valid &= writeFile(project.rootPath / "media" / mediaFile, f.str());
+			}
+
+			// parser
+			if (project.hasBison)
+			{
+				std::stringstream f;
+				writeGrammar(project, f);
+				valid &= writeFile(project.rootPath / "src" / "grammar.bison", f.str());
+			}
+
+			return valid;
+		}
+
+		void writeHeader(const BenchmarkProject& project, uint32_t index, std::stringstream& f) const
+		{
+			const auto typeName = TypeName(project) + PrintNumbered("_", index);
+			const auto numFunctions = std::max<uint32_t>(1, m_settings.numLinesPerSource / 8);
+
+			writeln(f, "#pragma once");
+			writeln(f, "");
+			writelnf(f, "BEGIN_NAMESPACE_EX(%s)", project.name.c_str());
+			writeln(f, "");
+			writelnf(f, "enum class %sMode : uint8_t", typeName.c_str());
+			writeln(f, "{");
+			writeln(f, "	First,");
+			writeln(f, "	Second,");
+			writeln(f, "	Third,");
+			writeln(f, "};");
+			writeln(f, "");
+			writelnf(f, "class %sObject : public IObject", typeName.c_str());
+			writeln(f, "{");
+			writelnf(f, "	RTTI_DECLARE_VIRTUAL_CLASS(%sObject, IObject);", typeName.c_str());
+			writeln(f, "");
+			writeln(f, "public:");
+			writeln(f, "	int m_value = 0;");
+			writeln(f, "	float m_weight = 1.0f;");
+			writelnf(f, "	%sMode m_mode = %sMode::First;", typeName.c_str(), typeName.c_str());
+			writeln(f, "");
+
+			for (uint32_t i = 0; i < numFunctions; ++i)
+				writelnf(f, "	int compute%u(int x) const;", i);
+
+			writeln(f, "};");
+			writeln(f, "");
+			writelnf(f, "END_NAMESPACE_EX(%s)", project.name.c_str());
+		}
+
+		void writeSource(const BenchmarkProject& project, uint32_t index, std::stringstream& f) const
+		{
+			const auto typeName = TypeName(project) + PrintNumbered("_", index);
+			const auto numFunctions = std::max<uint32_t>(1, m_settings.numLinesPerSource / 8);
+
+			writeln(f, "#include \"build.h\"");
+			writelnf(f, "#include \"%s\"", (PrintNumbered("file_", index) + ".h").c_str());
+			writeln(f, "");
+			writelnf(f, "BEGIN_NAMESPACE_EX(%s)", project.name.c_str());
+			writeln(f, "");
+			writelnf(f, "RTTI_BEGIN_TYPE_ENUM(%sMode);", typeName.c_str());
+			writeln(f, "	RTTI_ENUM_OPTION(First);");
+			writeln(f, "	RTTI_ENUM_OPTION(Second);");
+			writeln(f, "	RTTI_ENUM_OPTION(Third);");
+			writeln(f, "RTTI_END_TYPE();");
+			writeln(f, "");
+			writelnf(f, "RTTI_BEGIN_TYPE_CLASS(%sObject);", typeName.c_str());
+			writeln(f, "	RTTI_PROPERTY(m_value);");
+			writeln(f, "	RTTI_PROPERTY(m_weight);");
+			writeln(f, "	RTTI_PROPERTY(m_mode);");
+			writeln(f, "RTTI_END_TYPE();");
+
+			for (uint32_t i = 0; i < numFunctions; ++i)
+			{
+				writeln(f, "");
+				writelnf(f, "int %sObject::compute%u(int x) const", typeName.c_str(), i);
+				writeln(f, "{");
+				writelnf(f, "	const auto y = x * %u + m_value; // \"string\" with 'quotes' and /* comment */", i + 3);
+				writelnf(f, "	return (m_mode == %sMode::Second) ? y : (y - %u);", typeName.c_str(), i);
+				writeln(f, "}");
+			}
+
+			writeln(f, "");
+			writelnf(f, "END_NAMESPACE_EX(%s)", project.name.c_str());
+		}
+
+		void writeMedia(std::stringstream& f)
+		{
+			static const char* Words[] = { "alpha", "beta", "gamma", "delta", "onion", "module", "project", "media", "embedded", "file" };
+
+			const uint64_t size = m_settings.mediaFileSizeKB * 1024ULL;
+
+			uint64_t written = 0;
+			for (uint32_t i = 1; written < size; ++i)
+			{
+				const auto* word = Words[m_random() % (sizeof(Words) / sizeof(Words[0]))];
+				f << word << ((i % 12) ? " " : "\n");
+				written += strlen(word) + 1;
+			}
+		}
+
+		static void writeGrammar(const BenchmarkProject& project, std::stringstream& f)
+		{
+			writeln(f, "%{");
+			writelnf(f, "static int %s_lex(int* outValue)", project.name.c_str());
+			writeln(f, "{");
+			writeln(f, "    (void)outValue;");
+			writeln(f, "    return -1;");
+			writeln(f, "}");
+			writeln(f, "");
+			writelnf(f, "static int %s_error(const char* txt)", project.name.c_str());
+			writeln(f, "{");
+			writeln(f, "    (void)txt;");
+			writeln(f, "    return 0;");
+			writeln(f, "}");
+			writeln(f, "%}");
+			writeln(f, "");
+			writeln(f, "%require \"3.0\"");
+			writeln(f, "%defines");
+			writeln(f, "%define api.pure full");
+			writelnf(f, "%%define api.prefix {%s_};", project.name.c_str());
+			writeln(f, "%define api.value.type {int}");
+			writeln(f, "%define parse.error verbose");
+			writeln(f, "");
+			writeln(f, "%token TOKEN_INT_NUMBER");
+			writeln(f, "");
+			writeln(f, "%%");
+			writeln(f, "");
+			writeln(f, "expression");
+			writeln(f, "    : additive_expression");
+			writeln(f, "    ;");
+			writeln(f, "");
+			writeln(f, "additive_expression");
+			writeln(f, "    : multiplicative_expression");
+			writeln(f, "    | additive_expression '+' multiplicative_expression { $$ = $1 + $3; }");
+			writeln(f, "    | additive_expression '-' multiplicative_expression { $$ = $1 - $3; }");
+			writeln(f, "    ;");
+			writeln(f, "");
+			writeln(f, "multiplicative_expression");
+			writeln(f, "    : primary_expression");
+			writeln(f, "    | multiplicative_expression '*' primary_expression { $$ = $1 * $3; }");
+			writeln(f, "    | multiplicative_expression '/' primary_expression { $$ = $1 / $3; }");
+			writeln(f, "    ;");
+			writeln(f, "");
+			writeln(f, "primary_expression");
+			writeln(f, "    : TOKEN_INT_NUMBER");
+			writeln(f, "    | '(' expression ')' { $$ = $2; }");
+			writeln(f, "    ;");
+			writeln(f, "");
+			writeln(f, "%%");
+		}
+	};
+
+	//--
+
+	static bool PrepareWorkspaceDirectory(const fs::path& path)
+	{
+		std::error_code ec;
+		if (fs::exists(path, ec))
+		{
+			// never delete directories we did not create
+			if (!fs::is_regular_file(path / BENCHMARK_MARKER_FILE))
+			{
+				LogError() << "Directory " << path << " already exists and is not a benchmark workspace, specify different -workspace";
+				return false;
+			}
+
+			fs::remove_all(path, ec);
+			if (ec)
+			{
+				LogError() << "Failed to remove previous benchmark workspace " << path << ": " << ec;
+				return false;
+			}
+		}
+
+		return SaveFileFromString(path / BENCHMARK_MARKER_FILE, "onion benchmark workspace, deleted on next run\n", true, false);
+	}
+
+	static bool RemoveDirectory(const fs::path& path)
+	{
+		std::error_code ec;
+		fs::remove_all(path, ec);
+		if (ec)
+		{
+			LogError() << "Failed to remove " << path << ": " << ec;
+			return false;
+		}
+
+		return true;
+	}
+
+	// remove everything make produced but keep the configuration so the next make starts from scratch
+	static bool CleanMakeOutputs(const fs::path& modulePath)
+	{
+		bool valid = true;
+
+		std::error_code ec;
+		const auto tempPath = modulePath / ".temp";
+		if (fs::is_directory(tempPath, ec))
+		{
+			for (const auto& entry : fs::directory_iterator(tempPath, ec))
+				if (entry.is_directory())
+					valid &= RemoveDirectory(entry.path());
+		}
+
+		return valid;
+	}
+
+	//--
+
+	class BenchmarkRunner
+	{
+	public:
+		BenchmarkRunner(const fs::path& onionPath, const BenchmarkWorkspace& workspace)
+			: m_onionPath(onionPath)
+			, m_workspace(workspace)
+		{}
+
+		std::vector<std::string> configureArgs;
+		std::vector<std::string> makeArgs;
+
+		BenchmarkStage stages[NUM_BENCHMARK_STAGES];
+
+		bool runIteration(uint32_t iteration)
+		{
+			LogInfo() << "Benchmark run " << (iteration + 1) << ":";
+
+			if (!runStage(0, "configure", configureArgs))
+				return false;
+
+			if (!CleanMakeOutputs(m_workspace.mainModulePath))
+				return false;
+
+			if (!runStage(1, "make", makeArgs))
+				return false;
+
+			if (!runStage(2, "make", makeArgs))
+				return false;
+
+			if (!runReflection(3))
+				return false;
+
+			if (!runEmbed(4))
+				return false;
+
+			return true;
+		}
+
+	private:
+		fs::path m_onionPath;
+		const BenchmarkWorkspace& m_workspace;
+
+		bool runOnion(std::string_view tool, const std::vector<std::string>& extraArgs, ProcessRunResult& outResult) const
+		{
+			std::vector<std::string> args;
+			args.push_back(std::string(tool));
+			args.push_back("-nologo");
+			for (const auto& arg : extraArgs)
+				args.push_back(arg);
+
+			if (RunProcess(m_onionPath, args, m_workspace.mainModulePath, 0, outResult))
+				return true;
+
+			LogError() << "Benchmarked 'onion " << tool << "' failed with code " << outResult.exitCode << ", output:";
+			LogInfo() << outResult.output;
+			return false;
+		}
+
+		void printStageTime(uint32_t stageIndex, uint64_t timeMs) const
+		{
+			const auto& stage = stages[stageIndex];
+
+			char txt[256];
+			snprintf(txt, sizeof(txt), "  %-12s %10llu ms (%u process(es))", BENCHMARK_STAGES[stageIndex], (unsigned long long)timeMs, stage.numProcesses);
+			LogInfo() << txt;
+		}
+
+		bool runStage(uint32_t stageIndex, std::string_view tool, const std::vector<std::string>& args)
+		{
+			ProcessRunResult result;
+			if (!runOnion(tool, args, result))
+				return false;
+
+			auto& stage = stages[stageIndex];
+			stage.runTimesMs.push_back(result.wallTimeMs);
+			stage.peakMemoryBytes = std::max(stage.peakMemoryBytes, result.peakMemoryBytes);
+			stage.numProcesses = 1;
+
+			printStageTime(stageIndex, result.wallTimeMs);
+			return true;
+		}
+
+		// reflection of all projects at once, the same way the generated solutions run it
+		bool runReflection(uint32_t stageIndex)
+		{
+			const auto outputPath = m_workspace.outputPath / "reflection";
+			if (!RemoveDirectory(outputPath))
+				return false;
+
+			std::stringstream f;
+			for (const auto& project : m_workspace.projects)
+			{
+				writeln(f, "PROJECT");
+				writeln(f, project.name);
+				writeln(f, BENCHMARK_GLOBAL_NAMESPACE);
+				writeln(f, "");
+				writeln(f, (project.rootPath / "build.xml").make_preferred().u8string());
+				writeln(f, (project.rootPath / "src").make_preferred().u8string());
+				writeln(f, (outputPath / ("reflection_" + project.name + ".cpp")).make_preferred().u8string());
+			}
+
+			const auto listPath = outputPath / "reflection.txt";
+			if (!SaveFileFromString(listPath, f.str(), true, false))
+				return false;
+
+			ProcessRunResult result;
+			if (!runOnion("reflection", { "-list=" + listPath.u8string() }, result))
+				return false;
+
+			auto& stage = stages[stageIndex];
+			stage.runTimesMs.push_back(result.wallTimeMs);
+			stage.peakMemoryBytes = std::max(stage.peakMemoryBytes, result.peakMemoryBytes);
+			stage.numProcesses = 1;
+
+			printStageTime(stageIndex, result.wallTimeMs);
+			return true;
+		}
+
+		// every media file is embedded by separate tool run, the same way the generated solutions run it
+		bool runEmbed(uint32_t stageIndex)
+		{
+			const auto outputPath = m_workspace.outputPath / "embed";
+			if (!RemoveDirectory(outputPath))
+				return false;
+
+			auto& stage = stages[stageIndex];
+			stage.numProcesses = 0;
+
+			uint64_t totalTimeMs = 0;
+			for (const auto& project : m_workspace.projects)
+			{
+				for (const auto& mediaFile : project.mediaFiles)
+				{
+					std::vector<std::string> args;
+					args.push_back("-source=" + (project.rootPath / "media" / mediaFile).make_preferred().u8string());
+					args.push_back("-project=" + project.name);
+					args.push_back("-output=" + (outputPath / project.name / (mediaFile + ".cxx")).make_preferred().u8string());
+					args.push_back("-relative=" + mediaFile);
+
+					ProcessRunResult result;
+					if (!runOnion("embed", args, result))
+						return false;
+
+					totalTimeMs += result.wallTimeMs;
+					stage.peakMemoryBytes = std::max(stage.peakMemoryBytes, result.peakMemoryBytes);
+					stage.numProcesses += 1;
+				}
+			}
+
+			stage.runTimesMs.push_back(totalTimeMs);
+
+			printStageTime(stageIndex, totalTimeMs);
+			return true;
+		}
+	};
+
+	//--
+
+	struct BenchmarkStageSummary
+	{
+		uint64_t minMs = 0;
+		uint64_t maxMs = 0;
+		uint64_t medianMs = 0;
+	};
+
+	static BenchmarkStageSummary SummarizeStage(const BenchmarkStage& stage)
+	{
+		BenchmarkStageSummary ret;
+
+		auto times = stage.runTimesMs;
+		if (!times.empty())
+		{
+			std::sort(times.begin(), times.end());
+			ret.minMs = times.front();
+			ret.maxMs = times.back();
+			ret.medianMs = (times.size() & 1) ? times[times.size() / 2] : (times[times.size() / 2 - 1] + times[times.size() / 2]) / 2;
+		}
+
+		return ret;
+	}
+
+	static bool WriteResults(const fs::path& path, const fs::path& onionPath, const BenchmarkSettings& settings, const BenchmarkWorkspace& workspace, const BenchmarkRunner& runner, uint32_t repeat)
+	{
+		std::stringstream f;
+		writeln(f, "{");
+		f << "  \"onion\": \"" << ReplaceAll(ReplaceAll(onionPath.u8string(), "\\", "\\\\"), "\"", "\\\"") << "\",\n";
+		writeln(f, "  \"workspace\": {");
+		writelnf(f, "    \"modules\": %u,", settings.numModules);
+		writelnf(f, "    \"projects\": %u,", settings.numProjects);
+		writelnf(f, "    \"sourcesPerProject\": %u,", settings.numSourcesPerProject);
+		writelnf(f, "    \"linesPerSource\": %u,", settings.numLinesPerSource);
+		writelnf(f, "    \"fanOut\": %u,", settings.dependencyFanOut);
+		writelnf(f, "    \"mediaPerProject\": %u,", settings.numMediaFilesPerProject);
+		writelnf(f, "    \"mediaSizeKB\": %u,", settings.mediaFileSizeKB);
+		writelnf(f, "    \"bisonProjects\": %u,", settings.numBisonProjects);
+		writelnf(f, "    \"seed\": %u,", settings.seed);
+		writelnf(f, "    \"files\": %u,", workspace.numFiles);
+		writelnf(f, "    \"bytes\": %llu", (unsigned long long)workspace.numBytes);
+		writeln(f, "  },");
+		writelnf(f, "  \"repeat\": %u,", repeat);
+		writeln(f, "  \"stages\": {");
+
+		for (uint32_t i = 0; i < NUM_BENCHMARK_STAGES; ++i)
+		{
+			const auto& stage = runner.stages[i];
+			const auto summary = SummarizeStage(stage);
+
+			f << "    \"" << BENCHMARK_STAGES[i] << "\": {";
+			f << "\"medianMs\": " << summary.medianMs << ", ";
+			f << "\"minMs\": " << summary.minMs << ", ";
+			f << "\"maxMs\": " << summary.maxMs << ", ";
+			f << "\"peakMemoryBytes\": " << stage.peakMemoryBytes << ", ";
+			f << "\"processes\": " << stage.numProcesses << ", ";
+			f << "\"runsMs\": [";
+			for (size_t j = 0; j < stage.runTimesMs.size(); ++j)
+				f << (j ? ", " : "") << stage.runTimesMs[j];
+			f << "]}" << ((i + 1 < NUM_BENCHMARK_STAGES) ? "," : "") << "\n";
+		}
+
+		writeln(f, "  }");
+		writeln(f, "}");
+
+		return SaveFileFromString(path, f.str(), true);
+	}
+
+	static void PrintSummary(const BenchmarkRunner& runner)
+	{
+		char txt[256];
+		LogInfo() << "Benchmark summary:";
+		snprintf(txt, sizeof(txt), "  %-12s %12s %12s %12s %14s", "Stage", "Median [ms]", "Min [ms]", "Max [ms]", "Peak mem [MB]");
+		LogInfo() << txt;
+
+		for (uint32_t i = 0; i < NUM_BENCHMARK_STAGES; ++i)
+		{
+			const auto& stage = runner.stages[i];
+			const auto summary = SummarizeStage(stage);
+
+			snprintf(txt, sizeof(txt), "  %-12s %12llu %12llu %12llu %14.1f", BENCHMARK_STAGES[i],
+				(unsigned long long)summary.medianMs, (unsigned long long)summary.minMs, (unsigned long long)summary.maxMs, stage.peakMemoryBytes / (1024.0 * 1024.0));
+			LogInfo() << txt;
+		}
+	}
+
+	// compare medians with previous results, stages slower by more than the threshold are counted as regressions
+	static bool CompareResults(const fs::path& previousPath, const BenchmarkSettings& settings, const BenchmarkRunner& runner, double thresholdPercent, uint32_t& outNumRegressions)
+	{
+		std::string txt;
+		if (!LoadFileToString(previousPath, txt))
+		{
+			LogError() << "Unable to load previous benchmark results from " << previousPath;
+			return false;
+		}
+
+		const auto root = SimpleJsonToken(SimpleJson::Parse(txt));
+		if (!root || !root["stages"])
+		{
+			LogError() << "File " << previousPath << " does not contain benchmark results";
+			return false;
+		}
+
+		if (root["workspace"]["projects"].str() != std::to_string(settings.numProjects) || root["workspace"]["sourcesPerProject"].str() != std::to_string(settings.numSourcesPerProject))
+			LogWarning() << "Previous results in " << previousPath << " were collected on a different workspace, comparison is not meaningful";
+
+		char line[256];
+		LogInfo() << "Comparison with " << previousPath << ":";
+		snprintf(line, sizeof(line), "  %-12s %14s %14s %10s", "Stage", "Previous [ms]", "Current [ms]", "Change");
+		LogInfo() << line;
+
+		outNumRegressions = 0;
+		for (uint32_t i = 0; i < NUM_BENCHMARK_STAGES; ++i)
+		{
+			const auto previous = root["stages"][BENCHMARK_STAGES[i]]["medianMs"];
+			if (!previous)
+				continue;
+
+			const auto previousMs = atof(previous.str().c_str());
+			const auto currentMs = (double)SummarizeStage(runner.stages[i]).medianMs;
+			const auto change = (previousMs > 0.0) ? ((currentMs - previousMs) * 100.0 / previousMs) : 0.0;
+
+			snprintf(line, sizeof(line), "  %-12s %14.0f %14.0f %+9.1f%%", BENCHMARK_STAGES[i], previousMs, currentMs, change);
+
+			if (change > thresholdPercent)
+			{
+				LogWarning() << line << " REGRESSION";
+				outNumRegressions += 1;
+			}
+			else
+			{
+				LogInfo() << line;
+			}
+		}
+
+		return true;
+	}
+
+} // prv
+
+//--
+
+int ToolBenchmark::run(const Commandline& cmdline)
+{
+	prv::BenchmarkSettings settings;
+	settings.numModules = prv::GetNumberOption(cmdline, "modules", settings.numModules, 1);
+	settings.numProjects = prv::GetNumberOption(cmdline, "projects", settings.numProjects, 1);
+	settings.numSourcesPerProject = prv::GetNumberOption(cmdline, "sources", settings.numSourcesPerProject, 1);
+	settings.numLinesPerSource = prv::GetNumberOption(cmdline, "lines", settings.numLinesPerSource, 1);
+	settings.dependencyFanOut = prv::GetNumberOption(cmdline, "fanout", settings.dependencyFanOut, 0);
+	settings.numMediaFilesPerProject = prv::GetNumberOption(cmdline, "media", settings.numMediaFilesPerProject, 0);
+	settings.mediaFileSizeKB = prv::GetNumberOption(cmdline, "mediaSize", settings.mediaFileSizeKB, 1);
+	settings.numBisonProjects = prv::GetNumberOption(cmdline, "bison", settings.numBisonProjects, 0);
+	settings.seed = prv::GetNumberOption(cmdline, "seed", settings.seed, 0);
+
+	// every module needs at least one project
+	settings.numModules = std::min(settings.numModules, settings.numProjects);
+
+	prv::BenchmarkWorkspace workspace;
+	workspace.rootPath = fs::weakly_canonical(fs::absolute(fs::path(cmdline.get("workspace", (fs::temp_directory_path() / "onion_benchmark").u8string()))));
+
+	// synthesize the workspace
+	{
+		LogInfo() << "Generating benchmark workspace at " << workspace.rootPath;
+
+		if (!prv::PrepareWorkspaceDirectory(workspace.rootPath))
+			return 1;
+
+		prv::BenchmarkWorkspaceGenerator generator(settings, workspace);
+		if (!generator.generate())
+		{
+			LogError() << "Failed to generate benchmark workspace";
+			return 1;
+		}
+
+		workspace.outputPath = workspace.mainModulePath / ".temp" / "benchmark";
+
+		LogInfo() << "Generated " << workspace.numFiles << " files (" << (workspace.numBytes >> 10) << " KB) in " << settings.numProjects << " projects and " << settings.numModules << " modules";
+	}
+
+	if (cmdline.has("generateOnly"))
+		return 0;
+
+	// tool to benchmark
+	const auto onionPath = fs::path(cmdline.get("onion", GetExecutablePath())).make_preferred();
+	if (!fs::is_regular_file(onionPath))
+	{
+		LogError() << "Onion executable " << onionPath << " does not exist";
+		return 1;
+	}
+
+	prv::BenchmarkRunner runner(onionPath, workspace);
+	runner.configureArgs.push_back("-module=" + (workspace.mainModulePath / "build.xml").make_preferred().u8string());
+
+	if (cmdline.has("config"))
+	{
+		runner.configureArgs.push_back("-config=" + cmdline.get("config"));
+		runner.makeArgs.push_back("-config=" + cmdline.get("config"));
+	}
+
+	if (cmdline.has("unity"))
+		runner.makeArgs.push_back("-unity");
+
+	// run the stages
+	const auto repeat = prv::GetNumberOption(cmdline, "repeat", 3, 1);
+	for (uint32_t i = 0; i < repeat; ++i)
+	{
+		if (!runner.runIteration(i))
+		{
+			LogError() << "Benchmark failed";
+			return 2;
+		}
+	}
+
+	prv::PrintSummary(runner);
+
+	// results
+	const auto resultsPath = fs::absolute(fs::path(cmdline.get("json", "benchmark.json")));
+	if (!prv::WriteResults(resultsPath, onionPath, settings, workspace, runner, repeat))
+		return 3;
+
+	// comparison with previous run
+	if (cmdline.has("compare"))
+	{
+		const auto thresholdPercent = atof(std::string(cmdline.get("threshold", "10")).c_str());
+
+		uint32_t numRegressions = 0;
+		if (!prv::CompareResults(fs::absolute(fs::path(cmdline.get("compare"))), settings, runner, thresholdPercent, numRegressions))
+			return 3;
+
+		if (numRegressions > 0)
+		{
+			LogWarning() << numRegressions << " stage(s) regressed by more than " << cmdline.get("threshold", "10") << "%";
+			if (cmdline.has("failOnRegression"))
+				return 4;
+		}
+	}
+
+	return 0;
+}
+
+//--
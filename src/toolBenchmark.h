@@ -0,0 +1,18 @@
+#pragma once
+
+//--
+
+// synthesizes a large workspace (modules, projects, sources with reflection, media and bison files)
+// and times the configure/make/reflection/embed stages on it, results are written as JSON so they can be compared between versions of the tool
+class ToolBenchmark
+{
+public:
+    ToolBenchmark();
+
+    int run(const Commandline& cmdline);
+	void printUsage();
+
+private:
+};
+
+//--
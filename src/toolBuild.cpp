@@ -2,40 +2,325 @@
 #include "utils.h"
 #include "toolBuild.h"
 #include "configuration.h"
+#include "json.h"
 
 //--
 
-static bool BuildConfigurationCmake(const Configuration& cfg, const Commandline& cmdLine)
+static bool IsNinjaAvailable()
 {
-	// test if cmake exists
-	if (0 != std::system("cmake --version"))
+	ProcessRunResult result;
+	return RunProcess("ninja", { "--version" }, fs::current_path(), 0, result);
+}
+
+struct CompilerCacheStats
+{
+	uint64_t hits = 0;
+	uint64_t misses = 0;
+};
+
+static std::string LoadCompilerLauncher(const Configuration& cfg)
+{
+	if (!cfg.compilerLauncher.empty())
+		return cfg.compilerLauncher;
+
+	// written by "onion make"
+	std::string txt;
+	if (LoadFileToString(cfg.derivedSolutionPathBase / "compiler_launcher.txt", txt))
+		return std::string(Trim(txt));
+
+	return "";
+}
+
+static bool QueryCompilerCacheStats(std::string_view launcher, CompilerCacheStats& outStats)
+{
+	ProcessRunResult result;
+
+	if (launcher == "ccache")
+	{
+		// ccache 3.7+ prints machine readable "key<TAB>value" lines
+		if (!RunProcess("ccache", { "--print-stats" }, fs::current_path(), 10000, result))
+			return false;
+
+		std::vector<std::string_view> lines;
+		SplitString(result.output, "\n", lines);
+
+		for (const auto& line : lines)
+		{
+			std::vector<std::string_view> parts;
+			SplitString(line, "\t", parts);
+			if (parts.size() != 2)
+				continue;
+
+			const auto key = Trim(parts[0]);
+			const auto value = (uint64_t)std::strtoull(std::string(Trim(parts[1])).c_str(), nullptr, 10);
+
+			if (key == "direct_cache_hit" || key == "preprocessed_cache_hit" || key == "cache_hit_direct" || key == "cache_hit_cpp")
+				outStats.hits += value;
+			else if (key == "cache_miss")
+				outStats.misses += value;
+		}
+
+		return true;
+	}
+	else if (launcher == "sccache")
+	{
+		if (!RunProcess("sccache", { "--show-stats", "--stats-format=json" }, fs::current_path(), 10000, result))
+			return false;
+
+		const SimpleJsonToken json(SimpleJson::Parse(result.output));
+		if (!json)
+			return false;
+
+		const auto stats = json["stats"];
+		outStats.hits = std::strtoull(stats["cache_hits"]["counts"]["C/C++"].str().c_str(), nullptr, 10);
+		outStats.misses = std::strtoull(stats["cache_misses"]["counts"]["C/C++"].str().c_str(), nullptr, 10);
+		return true;
+	}
+
+	// distcc does not cache anything
+	return false;
+}
+
+static void ReportCompilerCacheStats(std::string_view launcher, const CompilerCacheStats& before, const CompilerCacheStats& after)
+{
+	const auto hits = (after.hits >= before.hits) ? (after.hits - before.hits) : after.hits; // stats may have been zeroed in the mean time
+	const auto misses = (after.misses >= before.misses) ? (after.misses - before.misses) : after.misses;
+	const auto total = hits + misses;
+
+	if (total == 0)
 	{
-		LogError() << "Could not detect CMAKE";
+		LogInfo() << "Compiler cache (" << launcher << "): nothing was compiled";
+		return;
+	}
+
+	char rate[32];
+	snprintf(rate, sizeof(rate), "%.1f%%", (100.0 * hits) / total);
+	LogInfo() << "Compiler cache (" << launcher << "): " << hits << " hits, " << misses << " misses, hit rate " << rate;
+}
+
+//--
+
+struct BuildStepTimes
+{
+	uint32_t count = 0;
+	uint64_t totalMs = 0;
+};
+
+static uint64_t FileSizeOrZero(const fs::path& path)
+{
+	std::error_code ec;
+	const auto size = fs::file_size(path, ec);
+	return ec ? 0 : (uint64_t)size;
+}
+
+// ninja records the start/end time of every build step in the .ninja_log, only the entries appended by this build are looked at
+static void ReportLinkTimes(const fs::path& ninjaLogPath, uint64_t logOffsetBeforeBuild)
+{
+	std::string txt;
+	if (!LoadFileToString(ninjaLogPath, txt))
+	{
+		LogWarning() << "No build log found at " << ninjaLogPath << ", link time report is only available when building with Ninja";
+		return;
+	}
+
+	// log was recompacted at the start of the build
+	if (logOffsetBeforeBuild > txt.size())
+		logOffsetBeforeBuild = 0;
+
+	std::vector<std::string_view> lines;
+	SplitString(std::string_view(txt).substr(logOffsetBeforeBuild), "\n", lines);
+
+	BuildStepTimes compileTimes, archiveTimes, linkTimes;
+	std::vector<std::pair<uint64_t, std::string>> linkSteps;
+	for (const auto& line : lines)
+	{
+		if (BeginsWith(line, "#"))
+			continue;
+
+		// start, end, mtime, output, command hash
+		std::vector<std::string_view> parts;
+		SplitString(line, "\t", parts);
+		if (parts.size() < 4)
+			continue;
+
+		const auto startMs = std::strtoull(std::string(parts[0]).c_str(), nullptr, 10);
+		const auto endMs = std::strtoull(std::string(parts[1]).c_str(), nullptr, 10);
+		const auto timeMs = (endMs > startMs) ? (endMs - startMs) : 0;
+		const auto output = std::string(Trim(parts[3]));
+		const auto extension = fs::path(output).extension().u8string();
+
+		if (extension == ".o" || extension == ".obj" || extension == ".gch" || extension == ".pch" || extension == ".dwo")
+		{
+			compileTimes.count += 1;
+			compileTimes.totalMs += timeMs;
+		}
+		else if (extension == ".a" || extension == ".lib")
+		{
+			archiveTimes.count += 1;
+			archiveTimes.totalMs += timeMs;
+		}
+		else if (extension != ".ninja" && !EndsWith(output, "CMakeLists.txt"))
+		{
+			linkTimes.count += 1;
+			linkTimes.totalMs += timeMs;
+			linkSteps.emplace_back(timeMs, output);
+		}
+	}
+
+	if (compileTimes.count == 0 && archiveTimes.count == 0 && linkTimes.count == 0)
+	{
+		LogInfo() << "Link time report: nothing was built";
+		return;
+	}
+
+	// slowest first
+	std::sort(linkSteps.begin(), linkSteps.end(), [](const auto& a, const auto& b) { return a.first != b.first ? a.first > b.first : a.second < b.second; });
+
+	const auto formatTime = [](uint64_t timeMs) {
+		char txt[32];
+		snprintf(txt, sizeof(txt), "%.2fs", timeMs / 1000.0);
+		return std::string(txt);
+	};
+
+	LogInfo() << "Link time report:";
+	LogInfo() << "  Compilation: " << compileTimes.count << " step(s), " << formatTime(compileTimes.totalMs);
+	LogInfo() << "  Archiving: " << archiveTimes.count << " step(s), " << formatTime(archiveTimes.totalMs);
+	LogInfo() << "  Linking: " << linkTimes.count << " step(s), " << formatTime(linkTimes.totalMs);
+
+	const size_t maxReportedSteps = 10;
+	for (size_t i = 0; i < linkSteps.size() && i < maxReportedSteps; ++i)
+		LogInfo() << "    " << formatTime(linkSteps[i].first) << " " << linkSteps[i].second;
+}
+
+//--
+
+static std::string ComputeCmakeInputsFingerprint(const fs::path& solutionDir)
+{
+	// generated files are only written when their content changes so timestamps are stable between "onion make" runs
+	std::vector<std::string> entries;
+
+	std::error_code ec;
+	for (fs::recursive_directory_iterator it(solutionDir, fs::directory_options::skip_permission_denied, ec), end; !ec && it != end; it.increment(ec))
+	{
+		const auto name = it->path().filename().u8string();
+
+		// skip build trees from in-source builds
+		if (it->is_directory(ec))
+		{
+			if (name == "CMakeFiles")
+				it.disable_recursion_pending();
+			continue;
+		}
+
+		if (name != "CMakeLists.txt" && !EndsWith(name, ".cmake"))
+			continue;
+
+		if (name == "cmake_install.cmake")
+			continue;
+
+		std::stringstream entry;
+		entry << fs::relative(it->path(), solutionDir, ec).generic_u8string() << ":";
+		entry << it->file_size(ec) << ":";
+		entry << (uint64_t)it->last_write_time(ec).time_since_epoch().count();
+		entries.push_back(entry.str());
+	}
+
+	std::sort(entries.begin(), entries.end());
+
+	std::stringstream txt;
+	for (const auto& entry : entries)
+		txt << entry << "\n";
+
+	return Sha256OfText(txt.str());
+}
+
+static fs::path CmakeBuildDirectory(const Configuration& cfg, std::string_view configurationName)
+{
+	// each configuration has its own build tree so switching between them does not invalidate anything
+	return (cfg.derivedConfigurationPathBase / "cmake" / ToLower(configurationName)).make_preferred();
+}
+
+static bool BuildConfigurationCmake(const Configuration& cfg, const Commandline& cmdLine, std::string_view configurationName)
+{
+	// build tool, prefer ninja if we have it
+	std::string buildTool(cmdLine.get("buildTool", ""));
+	if (buildTool.empty())
+		buildTool = IsNinjaAvailable() ? "ninja" : "make";
+
+	std::string generatorName;
+	if (buildTool == "ninja")
+		generatorName = "Ninja";
+	else if (buildTool == "make")
+		generatorName = "Unix Makefiles";
+	else
+	{
+		LogError() << "Unknown build tool '" << buildTool << "', expected 'ninja' or 'make'";
 		return false;
 	}
 
-	// configuration
-	const auto configurationName = cmdLine.get("config", "Release");
+	const auto solutionDir = cfg.derivedSolutionPathBase;
+	const auto buildDir = CmakeBuildDirectory(cfg, configurationName);
+	const auto stampPath = buildDir / "onion_configure.stamp";
+
+	// the configuration step is needed only if something changed since last time
+	std::stringstream stamp;
+	stamp << "generator=" << generatorName << "\n";
+	stamp << "config=" << configurationName << "\n";
+	stamp << "solution=" << solutionDir.u8string() << "\n";
+	stamp << "inputs=" << ComputeCmakeInputsFingerprint(solutionDir) << "\n";
 
-	// generate cmake file
+	std::string previousStamp;
+	const auto hasCache = fs::is_regular_file(buildDir / "CMakeCache.txt");
+	const auto upToDate = hasCache && LoadFileToString(stampPath, previousStamp) && previousStamp == stamp.str() && !cmdLine.has("reconfigure");
+
+	if (upToDate)
+	{
+		LogInfo() << "CMake build tree at " << buildDir << " is up to date, skipping configuration";
+	}
+	else
 	{
+		// test if cmake exists
+		if (0 != std::system("cmake --version"))
+		{
+			LogError() << "Could not detect CMAKE";
+			return false;
+		}
+
+		// generator can't be changed in existing build tree
+		if (hasCache && (previousStamp.empty() || !BeginsWith(previousStamp, "generator=" + generatorName + "\n")))
+		{
+			LogInfo() << "Build tree at " << buildDir << " was created with different generator, cleaning it";
+			std::error_code ec;
+			fs::remove(buildDir / "CMakeCache.txt", ec);
+			fs::remove_all(buildDir / "CMakeFiles", ec);
+		}
+
+		std::error_code ec;
+		fs::create_directories(buildDir, ec);
+
 		std::stringstream cmd;
-		cmd << "cmake . -DCMAKE_BUILD_TYPE=" << configurationName;
-		if (0 != std::system(cmd.str().c_str()))
+		cmd << "cmake -S " << EscapeArgument(solutionDir.u8string());
+		cmd << " -B " << EscapeArgument(buildDir.u8string());
+		cmd << " -G \"" << generatorName << "\"";
+		cmd << " -DCMAKE_BUILD_TYPE=" << configurationName;
+		if (!RunWithArgs(cmd.str()))
 		{
 			LogError() << "Could not run CMAKE config";
 			return false;
 		}
+
+		SaveFileFromString(stampPath, stamp.str(), false, false);
 	}
 
-	// build cmake file
+	// build, cmake re-runs the configuration by itself if any of the CMakeLists.txt changed
 	{
 		std::stringstream cmd;
-		cmd << "cmake --build . --config " << configurationName;
-		cmd << " -- -j`nproc`";
-		if (0 != std::system(cmd.str().c_str()))
+		cmd << "cmake --build " << EscapeArgument(buildDir.u8string()) << " --config " << configurationName;
+		if (buildTool != "ninja") // ninja uses all cores by default
+			cmd << " --parallel " << GetDefaultJobCount();
+		if (!RunWithArgs(cmd.str()))
 		{
-			LogError() << "Could not run CMAKE config";
+			LogError() << "Could not run CMAKE build";
 			return false;
 		}
 	}
@@ -44,6 +329,36 @@ static bool BuildConfigurationCmake(const Configuration& cfg, const Commandline&
 	return true;
 }
 
+static bool BuildConfigurationNinja(const Configuration& cfg, std::string_view configurationName)
+{
+
+	if (!IsNinjaAvailable())
+	{
+		LogError() << "Could not detect Ninja, it's required to build solutions generated with the Ninja generator";
+		return false;
+	}
+
+	const auto solutionPath = (cfg.derivedSolutionPathBase / "build.ninja").make_preferred();
+	if (!fs::is_regular_file(solutionPath))
+	{
+		LogError() << "Ninja build file " << solutionPath << " does not exist, did you run \"onion make\"?";
+		return false;
+	}
+
+	// each configuration has its own top level target in the generated build.ninja
+	// ninja regenerates the build files by itself (via "onion make") if any of the inputs changed
+	std::stringstream cmd;
+	cmd << "ninja -C " << EscapeArgument(cfg.derivedSolutionPathBase.u8string()) << " " << ToLower(configurationName);
+	if (!RunWithArgs(cmd.str()))
+	{
+		LogError() << "Could not run Ninja build";
+		return false;
+	}
+
+	// built
+	return true;
+}
+
 static bool FindSolution(const fs::path& solutionDir, fs::path& outSolutionDir)
 {
 	bool valid = true;
@@ -73,7 +388,7 @@ static bool FindSolution(const fs::path& solutionDir, fs::path& outSolutionDir)
 	return valid;
 }
 
-static bool BuildConfigurationVS(const Configuration& cfg, const Commandline& cmdLine)
+static bool BuildConfigurationVS(const Configuration& cfg, std::string_view configurationName)
 {
 	// get the path to the ms build
 	std::stringstream msBuildPathStr;
@@ -107,9 +422,6 @@ static bool BuildConfigurationVS(const Configuration& cfg, const Commandline& cm
 		LogSuccess() << "Solution found at " << solutionFilePath;
 	}
 
-	// configuration
-	std::string config(cmdLine.get("config", "Release"));
-
 	// compile the solution
 	std::stringstream args;
 	args << EscapeArgument(msBuildPath.u8string());
@@ -119,7 +431,7 @@ static bool BuildConfigurationVS(const Configuration& cfg, const Commandline& cm
 		args << "/p:Platform=Prospero ";
 	else if (cfg.platform == PlatformType::Scarlett)
 		args << "/p:Platform=Scarlett ";
-	args << "/p:Configuration=" << config << " ";
+	args << "/p:Configuration=" << configurationName << " ";
 	args << EscapeArgument(solutionFilePath.u8string());
 	const auto cmd = args.str();
 	LogInfo() << "Running: '" << cmd << "'";
@@ -134,7 +446,7 @@ static bool BuildConfigurationVS(const Configuration& cfg, const Commandline& cm
 }
 
 
-static bool BuildConfiguration(const Configuration& cfg, const Commandline& cmdLine)
+static bool BuildConfiguration(const Configuration& cfg, const Commandline& cmdLine, std::string_view configurationName)
 {
 	// info
 	LogInfo() << "Building '" << cfg.mergedName() << "'";
@@ -156,17 +468,34 @@ static bool BuildConfiguration(const Configuration& cfg, const Commandline& cmdL
 		return false;
 	}
 
+	// snapshot the compiler cache statistics so we can tell how much this build got from the cache
+	const auto launcher = LoadCompilerLauncher(cfg);
+	CompilerCacheStats cacheStatsBefore;
+	const bool hasCacheStats = !launcher.empty() && QueryCompilerCacheStats(launcher, cacheStatsBefore);
+
+	// remember where the build log ends so only steps from this build are reported
+	fs::path ninjaLogPath;
+	if (cfg.generator == GeneratorType::Ninja)
+		ninjaLogPath = cfg.derivedSolutionPathBase / ".ninja_log";
+	else if (cfg.generator == GeneratorType::CMake)
+		ninjaLogPath = CmakeBuildDirectory(cfg, configurationName) / ".ninja_log";
+	const auto ninjaLogOffset = FileSizeOrZero(ninjaLogPath);
+
 	// build with generator
 	bool valid = true;
 	try
 	{
 		if (cfg.generator == GeneratorType::CMake)
 		{
-			valid = BuildConfigurationCmake(cfg, cmdLine);
+			valid = BuildConfigurationCmake(cfg, cmdLine, configurationName);
+		}
+		else if (cfg.generator == GeneratorType::Ninja)
+		{
+			valid = BuildConfigurationNinja(cfg, configurationName);
 		}
 		else if (cfg.generator == GeneratorType::VisualStudio19 || cfg.generator == GeneratorType::VisualStudio22)
 		{
-			valid = BuildConfigurationVS(cfg, cmdLine);
+			valid = BuildConfigurationVS(cfg, configurationName);
 		}
 		else
 		{
@@ -185,6 +514,15 @@ static bool BuildConfiguration(const Configuration& cfg, const Commandline& cmdL
 		valid = false;
 	}
 
+	// report where the time went
+	if (valid && cmdLine.has("linkReport"))
+		ReportLinkTimes(ninjaLogPath, ninjaLogOffset);
+
+	// report compiler cache usage
+	CompilerCacheStats cacheStatsAfter;
+	if (valid && hasCacheStats && QueryCompilerCacheStats(launcher, cacheStatsAfter))
+		ReportCompilerCacheStats(launcher, cacheStatsBefore, cacheStatsAfter);
+
 	// change back the path
 	fs::current_path(rootPath, er);
 	return valid;
@@ -192,6 +530,146 @@ static bool BuildConfiguration(const Configuration& cfg, const Commandline& cmdL
 
 //--
 
+static void CollectProfileFiles(const fs::path& profilePath, std::string_view extension, std::vector<fs::path>& outFiles)
+{
+	std::error_code ec;
+	for (fs::recursive_directory_iterator it(profilePath, fs::directory_options::skip_permission_denied, ec), end; !ec && it != end; it.increment(ec))
+		if (it->is_regular_file(ec) && it->path().extension().u8string() == extension)
+			outFiles.push_back(it->path());
+
+	std::sort(outFiles.begin(), outFiles.end());
+}
+
+static bool HasProfileData(const Configuration& cfg)
+{
+	// Clang - merged profile, GCC - profile for each object file
+	if (fs::is_regular_file(cfg.derivedProfilePathBase / "merged.profdata"))
+		return true;
+
+	std::vector<fs::path> files;
+	CollectProfileFiles(cfg.derivedProfilePathBase, ".gcda", files);
+	return !files.empty();
+}
+
+static bool ClearProfileData(const Configuration& cfg)
+{
+	// profiles of the old instrumented binaries don't match the new ones
+	std::error_code ec;
+	fs::remove_all(cfg.derivedProfilePathBase, ec);
+	if (ec)
+	{
+		LogError() << "Failed to remove old profile data from " << cfg.derivedProfilePathBase << ", error: " << ec;
+		return false;
+	}
+
+	return true;
+}
+
+static bool RunProfileTraining(const Configuration& cfg, std::string_view trainingCommand)
+{
+	// the training runs the instrumented binaries from the "Profile" configuration
+	const auto binaryPath = (cfg.derivedBinaryPathBase / "profile").make_preferred();
+	if (!fs::is_directory(binaryPath))
+	{
+		LogError() << "Instrumented binaries not found at " << binaryPath << ", did you run \"onion build -pgoInstrument\"?";
+		return false;
+	}
+
+	std::error_code ec;
+	const auto rootPath = fs::current_path();
+	fs::current_path(binaryPath, ec);
+	if (ec)
+	{
+		LogError() << "Failed to change directory to " << binaryPath << ", error: " << ec;
+		return false;
+	}
+
+	LogInfo() << "Running profile training '" << trainingCommand << "' in " << binaryPath;
+	const auto valid = RunWithArgs(std::string(trainingCommand));
+	fs::current_path(rootPath, ec);
+
+	if (!valid)
+	{
+		LogError() << "Profile training command failed";
+		return false;
+	}
+
+	// Clang writes raw profile for each process, they are merged into one file used by all projects
+	std::vector<fs::path> rawProfiles;
+	CollectProfileFiles(cfg.derivedProfilePathBase, ".profraw", rawProfiles);
+	if (!rawProfiles.empty())
+	{
+		std::vector<std::string> args;
+		args.push_back("merge");
+		args.push_back("-output=" + (cfg.derivedProfilePathBase / "merged.profdata").u8string());
+		for (const auto& path : rawProfiles)
+			args.push_back(path.u8string());
+
+		ProcessRunResult result;
+		if (!RunProcess("llvm-profdata", args, cfg.derivedProfilePathBase, 0, result))
+		{
+			LogError() << "Failed to merge " << rawProfiles.size() << " raw profile(s) with llvm-profdata:\n" << result.output;
+			return false;
+		}
+
+		LogInfo() << "Merged " << rawProfiles.size() << " raw profile(s)";
+	}
+
+	if (!HasProfileData(cfg))
+	{
+		LogError() << "Training did not produce any profile data in " << cfg.derivedProfilePathBase << ", was the solution generated with \"onion make -pgo\"?";
+		return false;
+	}
+
+	LogSuccess() << "Profile data collected in " << cfg.derivedProfilePathBase;
+	return true;
+}
+
+static bool BuildProfileGuided(const Configuration& cfg, const Commandline& cmdLine)
+{
+	const auto trainingCommand = cmdLine.get("pgoTrain");
+
+	if (cmdLine.has("pgoInstrument") && cmdLine.has("pgoUse"))
+	{
+		LogError() << "Instrumented and optimized builds have to be done in separate steps (with training in between)";
+		return false;
+	}
+
+	// instrumented build, old profiles are removed so the training starts from scratch
+	if (cmdLine.has("pgoInstrument"))
+	{
+		if (!ClearProfileData(cfg))
+			return false;
+
+		if (!BuildConfiguration(cfg, cmdLine, "Profile"))
+			return false;
+	}
+
+	// training
+	if (!trainingCommand.empty())
+	{
+		if (!RunProfileTraining(cfg, trainingCommand))
+			return false;
+	}
+
+	// optimized build
+	if (cmdLine.has("pgoUse"))
+	{
+		if (!HasProfileData(cfg))
+		{
+			LogError() << "No profile data found in " << cfg.derivedProfilePathBase << ", run \"onion build -pgoInstrument -pgoTrain=<command>\" first";
+			return false;
+		}
+
+		if (!BuildConfiguration(cfg, cmdLine, "Final"))
+			return false;
+	}
+
+	return true;
+}
+
+//--
+
 ToolBuild::ToolBuild()
 {}
 
@@ -208,6 +686,15 @@ void ToolBuild::printUsage()
 	LogInfo() << "  -module=<module to build>";
 	LogInfo() << "  -config=<release|debug|final|profile|checked> - configuration to build (defaults to Release)";
 	LogInfo() << "  -platform=" << str.str() << "";
+	LogInfo() << "  -buildTool=<ninja|make> - build tool used with CMake solutions (defaults to ninja if installed)";
+	LogInfo() << "  -reconfigure - force CMake configuration step even if nothing changed";
+	LogInfo() << "  -launcher=<ccache|sccache|distcc|auto|none> - compiler cache to report the hit rate for (defaults to the one chosen in \"onion make\")";
+	LogInfo() << "  -linkReport - report time spent compiling, archiving and linking (slowest link steps first), requires Ninja";
+	LogInfo() << "";
+	LogInfo() << "Profile guided optimization (solution has to be generated with \"onion make -pgo\"):";
+	LogInfo() << "  -pgoInstrument - build the instrumented Profile configuration (previous profile data is discarded)";
+	LogInfo() << "  -pgoTrain=<command> - run the training command in the Profile binary directory and collect the profile data";
+	LogInfo() << "  -pgoUse - build the Final configuration optimized with the collected profile data";
 	LogInfo() << "";
 }
 
@@ -217,7 +704,15 @@ int ToolBuild::run(const Commandline& cmdline)
 	if (!Configuration::Parse(cmdline, config))
 		return 1;
 
-	if (!BuildConfiguration(config, cmdline))
+	if (cmdline.has("pgoInstrument") || cmdline.has("pgoTrain") || cmdline.has("pgoUse"))
+	{
+		if (!BuildProfileGuided(config, cmdline))
+			return 1;
+
+		return 0;
+	}
+
+	if (!BuildConfiguration(config, cmdline, cmdline.get("config", "Release")))
 		return 1;
 
 	return 0;
@@ -9,6 +9,8 @@
 #include "externalLibrary.h"
 #include "externalLibraryInstaller.h"
 
+#include <thread>
+
 //--
 
 ModuleResolver::ModuleInfo::~ModuleInfo()
@@ -18,9 +20,10 @@ ModuleResolver::ModuleInfo::~ModuleInfo()
 
 //--
 
-ModuleResolver::ModuleResolver(const Configuration& config, const fs::path& cachePath)
+ModuleResolver::ModuleResolver(const Configuration& config, const fs::path& cachePath, uint32_t downloadJobs)
 	: m_cachePath(cachePath)
 	, m_config(config)
+	, m_downloadJobs(std::max<uint32_t>(1, downloadJobs))
 {
 }
 
@@ -382,13 +385,58 @@ bool ModuleResolver::processUnresolvedRemoteDepndencies(bool& hadUnresolvedDepen
 	std::vector<RemoteDependency*> deps;
 	hadUnresolvedDependnecies |= collectUnresolvedRemoteDependencies(deps);
 
+	// process in stable order, the map order is random
+	std::sort(deps.begin(), deps.end(), [](const RemoteDependency* a, const RemoteDependency* b)
+		{
+			if (a->gitRepository != b->gitRepository)
+				return a->gitRepository < b->gitRepository;
+			return a->gitRelativePath < b->gitRelativePath;
+		});
+
+	// collect repositories that were not yet downloaded, all repositories from the same dependency level can be fetched at the same time
+	std::vector<std::string> repositoriesToFetch;
+	{
+		std::unordered_set<std::string> visitedRepositories;
+		for (const auto* dep : deps)
+		{
+			const auto key = ToLower(dep->gitRepository);
+			if (!Contains(m_downloadedRepositories, key) && visitedRepositories.insert(key).second)
+				repositoriesToFetch.push_back(dep->gitRepository);
+		}
+	}
+
+	// fetch (clone or pull) all of them
+	const auto numRepositories = (uint32_t)repositoriesToFetch.size();
+	std::vector<fs::path> fetchedPaths(numRepositories);
+	std::vector<uint8_t> fetchedValid(numRepositories, 0);
+	RunParallel(numRepositories, m_downloadJobs, [&](uint32_t index)
+		{
+			fetchedValid[index] = fetchRepository(repositoriesToFetch[index], fetchedPaths[index]);
+		});
+
+	// store repository placement
 	bool valid = true;
-	for (const auto& dep : deps)
+	for (uint32_t i = 0; i < numRepositories; ++i)
 	{
-		fs::path cachedDownloadPath;
-		if (ensureRepositoryDownloaded(dep->gitRepository, cachedDownloadPath))
+		if (fetchedValid[i])
+		{
+			auto* info = new DownloadedRepository;
+			info->repository = repositoriesToFetch[i];
+			info->localPath = fetchedPaths[i];
+			m_downloadedRepositories[ToLower(repositoriesToFetch[i])] = info;
+		}
+		else
 		{
-			dep->localPath = fs::weakly_canonical((cachedDownloadPath / dep->gitRelativePath / "build.xml").make_preferred());
+			valid = false;
+		}
+	}
+
+	// load modules from downloaded repositories, this is done in the same order every time
+	for (auto* dep : deps)
+	{
+		if (const auto* repo = Find<std::string, DownloadedRepository*>(m_downloadedRepositories, ToLower(dep->gitRepository), nullptr))
+		{
+			dep->localPath = fs::weakly_canonical((repo->localPath / dep->gitRelativePath / "build.xml").make_preferred());
 			valid &= processSingleModuleFile(dep->localPath, false /*local*/);
 		}
 	}
@@ -457,7 +505,7 @@ bool ModuleResolver::listRepositoryBranches(std::string_view repoPath, std::unor
 			continue;
 
 		LogInfo() << "Found branch '" << branchName << "' as ref " << hash << " in repository " << repoPath;
-		outBranchNamesWithHashes[std::string(branchName)] = std::string(branchName);
+		outBranchNamesWithHashes[std::string(branchName)] = std::string(hash);
 	}
 
 	return true;
@@ -479,7 +527,7 @@ static std::string MakeNameList(const std::unordered_map<std::string, std::strin
 	return txt.str();
 }
 
-bool ModuleResolver::getRepositoryBranchName(std::string_view repoPath, std::string& outBranchNameToDownload) const
+bool ModuleResolver::getRepositoryBranchName(std::string_view repoPath, std::string& outBranchNameToDownload, std::string& outBranchHash) const
 {
 	std::unordered_map<std::string, std::string> branches;
 	if (!listRepositoryBranches(repoPath, branches))
@@ -488,48 +536,95 @@ bool ModuleResolver::getRepositoryBranchName(std::string_view repoPath, std::str
 	// TODO: branch version override
 	// TODO: better logic
 
-	if (Contains<std::string, std::string>(branches, "latest"))
+	static const char* PreferredBranches[] = { "latest", "stable", "master", "main" };
+	for (const auto* name : PreferredBranches)
 	{
-		outBranchNameToDownload = "latest";
-		return true;
+		auto it = branches.find(name);
+		if (it != branches.end())
+		{
+			outBranchNameToDownload = it->first;
+			outBranchHash = it->second;
+			return true;
+		}
 	}
 
-	if (Contains<std::string, std::string>(branches, "stable"))
-	{
-		outBranchNameToDownload = "stable";
-		return true;
-	}
+	LogError() << "Failed to determine usable branch for repository " << repoPath << ", available branches: " << MakeNameList(branches);	
+	return false;
+}
 
-	if (Contains<std::string, std::string>(branches, "master"))
-	{
-		outBranchNameToDownload = "master";
-		return true;
-	}
+static bool ReadPackedRef(const fs::path& gitDir, std::string_view refName, std::string& outHash)
+{
+	std::string packedRefs;
+	if (!LoadFileToString(gitDir / "packed-refs", packedRefs))
+		return false;
 
-	if (Contains<std::string, std::string>(branches, "main"))
+	std::vector<std::string_view> lines;
+	SplitString(packedRefs, "\n", lines);
+
+	for (const auto& line : lines)
 	{
-		outBranchNameToDownload = "main";
-		return true;
+		// <hash> <refname>
+		const auto txt = Trim(line);
+		if (txt.empty() || txt[0] == '#' || txt[0] == '^')
+			continue;
+
+		std::string_view hash, name;
+		if (SplitString(txt, " ", hash, name) && Trim(name) == refName)
+		{
+			outHash = std::string(Trim(hash));
+			return true;
+		}
 	}
 
-	LogError() << "Failed to determine usable branch for repository " << repoPath << ", available branches: " << MakeNameList(branches);	
 	return false;
 }
 
-bool ModuleResolver::ensureRepositoryDownloaded(const std::string_view repoPath, fs::path& outDownloadPath)
+static bool ReadLocalRepositoryHead(const fs::path& repoPath, std::string& outHash)
 {
-	const auto key = ToLower(repoPath);
+	const auto gitDir = repoPath / ".git";
 
-	// repository already downloaded ?
-	if (auto* repo = Find<std::string, DownloadedRepository*>(m_downloadedRepositories, key, nullptr))
+	// read the .git files directly, much cheaper than running git
+	std::string head;
+	if (LoadFileToString(gitDir / "HEAD", head))
 	{
-		outDownloadPath = repo->localPath;
-		return true;
+		const auto headTxt = Trim(head);
+		if (BeginsWith(headTxt, "ref:"))
+		{
+			const auto refName = Trim(PartAfter(headTxt, "ref:"));
+
+			std::string ref;
+			if (LoadFileToString(gitDir / refName, ref) && !Trim(ref).empty())
+			{
+				outHash = std::string(Trim(ref));
+				return true;
+			}
+
+			if (ReadPackedRef(gitDir, refName, outHash))
+				return true;
+		}
+		else if (!headTxt.empty())
+		{
+			outHash = std::string(headTxt); // detached head
+			return true;
+		}
 	}
 
+	// ask git as a fallback
+	std::vector<std::string> lines;
+	if (RunWithArgsAndCaptureOutputIntoLines("git -C \"" + repoPath.u8string() + "\" rev-parse HEAD", lines) && !lines.empty())
+	{
+		outHash = std::string(Trim(lines[0]));
+		return !outHash.empty();
+	}
+
+	return false;
+}
+
+bool ModuleResolver::fetchRepository(const std::string_view repoPath, fs::path& outDownloadPath) const
+{
 	// ask for branch list
-	std::string branchName;
-	if (!getRepositoryBranchName(repoPath, branchName))
+	std::string branchName, branchHash;
+	if (!getRepositoryBranchName(repoPath, branchName, branchHash))
 		return false;
 
 	// info
@@ -543,19 +638,22 @@ bool ModuleResolver::ensureRepositoryDownloaded(const std::string_view repoPath,
 		return false;
 	}
 
-	// store repository placement
-	{
-		auto* info = new DownloadedRepository;
-		info->repository = repoPath;
-		info->localPath = downloadPath;
-		m_downloadedRepositories[key] = info;
-	}
-
 	// does the directory exit ?
 	if (fs::is_directory(downloadPath))
 	{
+		// nothing to pull if we already have the same commit as the remote
+		std::string localHash;
+		if (ReadLocalRepositoryHead(downloadPath, localHash) && localHash == branchHash)
+		{
+			LogInfo() << "Repository '" << repoPath << "' at branch '" << branchName << "' is up to date (" << branchHash << ")";
+			outDownloadPath = downloadPath;
+			return true;
+		}
+
 		// pull latest
-		if (!RunWithArgsInDirectory(downloadPath, "git pull"))
+		std::stringstream command;
+		command << "git -C \"" << downloadPath.u8string() << "\" pull -q";
+		if (!RunWithArgs(command.str()))
 		{
 			LogWarning() << "Failed to pull latest for repository '" << repoPath << "' at branch '" << branchName << "'";
 		}
@@ -577,14 +675,14 @@ bool ModuleResolver::ensureRepositoryDownloaded(const std::string_view repoPath,
 		}
 	}
 
-	// assemble a clone command
+	// assemble a clone command, blobless clone of a single branch, we only need the latest files
 	std::stringstream command;
-	command << "git clone --depth 1 --branch " << branchName << " ";
+	command << "git clone -q --depth 1 --filter=blob:none --single-branch --branch " << branchName << " ";
 	command << repoPath;
-	command << " " << branchName;
+	command << " \"" << downloadPath.u8string() << "\"";
 
 	// pull latest
-	if (!RunWithArgsInDirectory(parentCloneDir, command.str()))
+	if (!RunWithArgs(command.str()))
 	{
 		LogError() << "Failed to clone repository '" << repoPath << "' at branch '" << branchName << "'";
 		return false;
@@ -607,6 +705,8 @@ void ToolConfigure::printUsage()
 	LogInfo() << "General options:";
 	LogInfo() << "  -module=<path to module to configure>";
 	LogInfo() << "  -configPath=<path where the generated configuration should be written";
+	LogInfo() << "  -libraryJobs=<number of third-party libraries installed in parallel (defaults to number of cores)>";
+	LogInfo() << "  -moduleJobs=<number of module repositories downloaded in parallel (defaults to number of cores)>";
 	LogInfo() << "";
 }
 
@@ -720,7 +820,11 @@ int ToolConfigure::run(const Commandline& cmdline)
 	//--
 
 	// resolve all modules, download dependencies and libraries
-	ModuleResolver resolver(config, config.cachePath);
+	uint32_t numModuleJobs = GetDefaultJobCount();
+	if (cmdline.has("moduleJobs"))
+		numModuleJobs = std::max<int>(1, atoi(std::string(cmdline.get("moduleJobs")).c_str()));
+
+	ModuleResolver resolver(config, config.cachePath, numModuleJobs);
 	if (!resolver.processModuleFile(config.moduleFilePath, true))
 	{
 		LogError() << "Configuration failed";
@@ -777,19 +881,25 @@ int ToolConfigure::run(const Commandline& cmdline)
 	// install libraries
 	std::unordered_set<std::string> requiredSystemPacakges;
 	{
-		bool valid = true;
-		for (auto& lib : manifest.libraries)
+		std::vector<std::string> libraryNames;
+		for (const auto& lib : manifest.libraries)
+			libraryNames.push_back(lib.name);
+
+		uint32_t numJobs = GetDefaultJobCount();
+		if (cmdline.has("libraryJobs"))
+			numJobs = std::max<int>(1, atoi(std::string(cmdline.get("libraryJobs")).c_str()));
+
+		std::vector<LibraryInstallResult> results;
+		const auto valid = libraries.installMany(libraryNames, numJobs, results);
+
+		for (size_t i = 0; i < manifest.libraries.size(); ++i)
 		{
-			fs::path installPath;
-			std::string installVersion;
-			if (!libraries.install(lib.name, &installPath, &installVersion, &requiredSystemPacakges))
-			{
-				LogError() << "External third-party library '" << lib.name << "' failed to initialize";
-				valid = false;
-			}
+			auto& lib = manifest.libraries[i];
+			const auto& result = results[i];
 
-			lib.path = installPath;
-			lib.version = installVersion;
+			lib.path = result.installedPath;
+			lib.version = result.installedVersion;
+			requiredSystemPacakges.insert(result.requiredSystemPackages.begin(), result.requiredSystemPackages.end());
 		}
 
 		if (!valid)
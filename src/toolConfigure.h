@@ -21,7 +21,7 @@ struct ModuleReferencedLibrary
 class ModuleResolver
 {
 public:
-    ModuleResolver(const Configuration& config, const fs::path& cachePath);
+    ModuleResolver(const Configuration& config, const fs::path& cachePath, uint32_t downloadJobs = 1);
     ~ModuleResolver();
 
     inline const std::vector<fs::path>& globalIncludePaths() const { return m_globalIncludePaths; }
@@ -67,6 +67,8 @@ private:
 
     fs::path m_cachePath;
 
+    uint32_t m_downloadJobs = 1;
+
     std::string m_solutionName;
 
     std::vector<fs::path> m_globalIncludePaths;
@@ -85,11 +87,11 @@ private:
     bool collectUnresolvedLocalDependencies(std::vector<LocalDependency*>& outDeps) const;
     bool collectUnresolvedRemoteDependencies(std::vector<RemoteDependency*>& outDeps) const;
 
-    bool ensureRepositoryDownloaded(std::string_view repoPath, fs::path& outDownloadPath);
+    bool fetchRepository(std::string_view repoPath, fs::path& outDownloadPath) const; // thread safe, does not modify the resolver
 
     bool getRepositoryDownloadPath(std::string_view repoPath, std::string_view branchName, fs::path& outPath) const;
     bool listRepositoryBranches(std::string_view repoPath, std::unordered_map<std::string, std::string>& outBranchNamesWithHashes) const;
-    bool getRepositoryBranchName(std::string_view repoPath, std::string& outBranchNameToDownload) const;
+    bool getRepositoryBranchName(std::string_view repoPath, std::string& outBranchNameToDownload, std::string& outBranchHash) const;
 };
 
 //--
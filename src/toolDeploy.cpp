@@ -8,6 +8,7 @@
 #include "externalLibraryRepository.h"
 #include "moduleManifest.h"
 #include "externalLibrary.h"
+#include "manifestCache.h"
 
 #pragma optimize("", off)
 
@@ -83,25 +84,35 @@ private:
 
 	void exploreProject(const ProjectInfo* project)
 	{
-		// skip test apps, even if directly referenced somehow
-		if (project->manifest->type == ProjectType::TestApplication)
-			return;
+		// the project itself and everything it depends on, NOTE: not a plain dependency closure - whatever is reachable only through a test app is not deployed
+		std::vector<const ProjectInfo*> stack;
+		stack.push_back(project);
 
-		// add only once
-		if (!m_projectsToDeploy.insert(project).second)
-			return;
+		while (!stack.empty())
+		{
+			const auto* proj = stack.back();
+			stack.pop_back();
+
+			// skip test apps (and their dependencies), even if directly referenced somehow
+			if (proj->manifest->type == ProjectType::TestApplication)
+				continue;
 
-		// collect modules of projects (mostly for data lists)
-		if (project->parentModule)
-			m_modulesToDeploy.insert(project->parentModule);
+			// add only once
+			if (!m_projectsToDeploy.insert(proj).second)
+				continue;
 
-		// explore dependencies
-		for (const auto* dep : project->resolvedDependencies)
-			exploreProject(dep);
+			// collect modules of projects (mostly for data lists)
+			if (proj->parentModule)
+				m_modulesToDeploy.insert(proj->parentModule);
 
-		// collect libraries
-		for (const auto* dep : project->resolvedLibraryDependencies)
-			m_librariesToDeploy.insert(dep);
+			// explore dependencies
+			for (const auto* dep : proj->resolvedDependencies)
+				stack.push_back(dep);
+
+			// collect libraries
+			for (const auto* dep : proj->resolvedLibraryDependencies)
+				m_librariesToDeploy.insert(dep);
+		}
 	}
 
     bool collectFilesFromDirectory(const fs::path& sourcePath, const fs::path& destPath, std::vector<ProjectDeployFile>& outFiles) const
@@ -272,8 +283,13 @@ int ToolDeploy::run(const Commandline& cmdline)
 
     const bool verifyVersions = !cmdline.has("noverify");
 
+    const auto manifestCachePath = (config.derivedConfigurationPathBase / "manifest_cache.bin").make_preferred();
+
+    ManifestCache manifestCache(config);
+    manifestCache.load(manifestCachePath);
+
     ModuleRepository modules(config);
-    if (!modules.installConfiguredModules(*moduleConfig, verifyVersions))
+    if (!modules.installConfiguredModules(*moduleConfig, verifyVersions, &manifestCache))
     {
         LogError() << "Failed to verify configured module at \"" << config.moduleFilePath << "\"";
         return 1;
@@ -303,12 +319,14 @@ int ToolDeploy::run(const Commandline& cmdline)
     //--
 
 	ExternalLibraryReposistory libraries;
-    if (!libraries.installConfiguredLibraries(*moduleConfig))
+    if (!libraries.installConfiguredLibraries(*moduleConfig, &manifestCache))
     {
 		LogError() << "Failed to install configured third party libraries";
 		return 1;
     }
 
+    manifestCache.save(manifestCachePath);
+
 	if (!structure.resolveLibraries(libraries))
 	{
 		LogError() << "Failed to resolve third party libraries";
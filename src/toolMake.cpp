@@ -12,7 +12,13 @@
 #include "moduleRepository.h"
 #include "solutionGeneratorVS.h"
 #include "solutionGeneratorCMAKE.h"
+#include "solutionGeneratorNinja.h"
 #include "moduleConfiguration.h"
+#include "moduleManifest.h"
+#include "makeFingerprint.h"
+#include "directoryScanner.h"
+#include "manifestCache.h"
+#include "profiler.h"
 
 //--
 
@@ -22,10 +28,78 @@ static std::unique_ptr<SolutionGenerator> CreateSolutionGenerator(FileRepository
         return std::make_unique<SolutionGeneratorVS>(files, config, mainModuleName);
     else if (config.generator == GeneratorType::CMake)
         return std::make_unique<SolutionGeneratorCMAKE>(files, config, mainModuleName);
+    else if (config.generator == GeneratorType::Ninja)
+        return std::make_unique<SolutionGeneratorNinja>(files, config, mainModuleName);
     else
         return nullptr;
 }
 
+// options that don't change the generated files
+static bool IsOptionIgnoredInFingerprint(std::string_view name)
+{
+    return name == "force" || name == "open" || name == "nologo" || name == "trace" || name == "profile";
+}
+
+static std::string CommandlineFingerprint(const Commandline& cmdline)
+{
+    std::string ret;
+    for (const auto& arg : cmdline.args)
+    {
+        if (IsOptionIgnoredInFingerprint(arg.key))
+            continue;
+
+        if (!ret.empty())
+            ret += " ";
+
+        ret += "-";
+        ret += arg.key;
+
+        for (const auto& value : arg.values)
+        {
+            ret += "=";
+            ret += value;
+        }
+    }
+
+    return ret;
+}
+
+// record everything the generated files depend on
+static void CollectMakeInputs(const ModuleRepository& modules, const ModuleConfigurationManifest& moduleConfig, const ProjectCollection& structure, const FileGenerator& files, MakeFingerprint& fingerprint)
+{
+    PROFILE_SCOPE("CollectMakeInputs");
+
+    for (const auto* module : modules.modules())
+    {
+        fingerprint.addFile(module->path);
+        for (const auto& path : module->includedManifests)
+            fingerprint.addFile(path);
+    }
+
+    for (const auto& lib : moduleConfig.libraries)
+        fingerprint.addFile(lib.path);
+
+    for (const auto* project : structure.projects())
+    {
+        if (project->manifest)
+        {
+            fingerprint.addFile(project->manifest->loadPath);
+
+            for (const auto& path : project->manifest->frozenDeployFiles)
+                fingerprint.addFile(path);
+        }
+
+        for (const auto& path : project->scannedDirectories)
+            fingerprint.addDirectory(path);
+
+        for (const auto* file : project->files)
+            fingerprint.addFile(file->absolutePath);
+    }
+
+    for (const auto* file : files.generatedFiles())
+        fingerprint.addOutput(file->absolutePath);
+}
+
 //--
 
 ToolMake::ToolMake()
@@ -40,6 +114,16 @@ void ToolMake::printUsage()
 	LogInfo() << "  -build=<build configuration string>";
     LogInfo() << "  -tempDir=<custom temporary directory>";
     LogInfo() << "  -cacheDir=<custom library/module cache directory>";
+    LogInfo() << "  -unity - group project source files into unity files (projects can override it with <UnityBuild>)";
+    LogInfo() << "  -unityBatchSize=<KB> - target size of single unity file (default 128KB)";
+    LogInfo() << "  -pgo - profile guided optimization, Profile configuration is instrumented and Final uses the collected profile with LTO (CMake and Ninja generators)";
+    LogInfo() << "  -launcher=<ccache|sccache|distcc|auto|none> - compiler launcher used to cache or distribute compilation (CMake and Ninja generators)";
+    LogInfo() << "  -linker=<lld|mold|gold|default> - use faster linker (Linux)";
+    LogInfo() << "  -splitDwarf - keep debug information in .dwo files so the linker does not have to process it";
+    LogInfo() << "  -gdbIndex - let the linker write the .gdb_index section (needs lld, mold or gold)";
+    LogInfo() << "  -compressDebugSections - compress debug sections of objects and binaries";
+    LogInfo() << "  -linkOptionsConfigs=<list> - configurations the link options are used in (default: debug,checked,release,profile)";
+    LogInfo() << "  -force - always generate, even if nothing changed since last make";
 	LogInfo() << "";
 }
 
@@ -65,10 +149,49 @@ int ToolMake::run(const Commandline& cmdline)
 		return 1;
     }
 
+    // nothing changed since the last make - manifests, directories, files, configuration and the tool itself are the same
+    const auto fingerprintPath = (config.derivedSolutionPathBase / "make_fingerprint.txt").make_preferred();
+
+    MakeFingerprint fingerprint;
+    fingerprint.addValue("configuration", config.mergedName());
+    fingerprint.addValue("commandline", CommandlineFingerprint(cmdline));
+    fingerprint.addValue("launcher", config.compilerLauncher); // "-launcher=auto" depends on what's in PATH
+
+    // toolchain overrides read from the environment by the generators
+    for (const auto* name : { "CC", "CXX", "AR", "EMSDK" })
+    {
+        const char* value = std::getenv(name);
+        fingerprint.addValue(std::string("env.") + name, value ? value : "");
+    }
+    fingerprint.addFile(config.executablePath);
+    fingerprint.addFile(moduleConfigPath);
+
+    if (!cmdline.has("force") && !cmdline.has("open") && fingerprint.isUpToDate(fingerprintPath))
+    {
+        LogSuccess() << "Nothing changed since last make, generated files are up to date";
+        return 0;
+    }
+
+    // fingerprint is only valid after successful make
+    {
+        std::error_code ec;
+        fs::remove(fingerprintPath, ec);
+    }
+
+    const auto startTime = fs::file_time_type::clock::now();
+
+    //--
+
     const bool verifyVersions = !cmdline.has("noverify");
 
+    // parsed manifests are cached per configuration, only manifests that changed are parsed again
+    const auto manifestCachePath = (config.derivedConfigurationPathBase / "manifest_cache.bin").make_preferred();
+
+    ManifestCache manifestCache(config);
+    manifestCache.load(manifestCachePath);
+
     ModuleRepository modules(config);
-    if (!modules.installConfiguredModules(*moduleConfig, verifyVersions))
+    if (!modules.installConfiguredModules(*moduleConfig, verifyVersions, &manifestCache))
     {
         LogError() << "Failed to verify configured module at \"" << config.moduleFilePath << "\"";
         return 1;
@@ -98,12 +221,16 @@ int ToolMake::run(const Commandline& cmdline)
     //--
 
 	ExternalLibraryReposistory libraries;
-    if (!libraries.installConfiguredLibraries(*moduleConfig))
+    if (!libraries.installConfiguredLibraries(*moduleConfig, &manifestCache))
     {
 		LogError() << "Failed to install third party libraries";
 		return 1;
     }
 
+	manifestCache.printStats();
+	if (!manifestCache.save(manifestCachePath))
+		LogWarning() << "Failed to save manifest cache";
+
 	if (!structure.resolveLibraries(libraries))
 	{
 		LogError() << "Failed to resolve third party libraries";
@@ -111,6 +238,8 @@ int ToolMake::run(const Commandline& cmdline)
 	}
 
     {
+        PROFILE_SCOPE("DeployLibraryFiles");
+
         bool valid = true;
         for (const auto& configType : CONFIGURATIONS)
         {
@@ -143,13 +272,24 @@ int ToolMake::run(const Commandline& cmdline)
 
     //--
 
+    // directory listings are cached between runs per configuration (like the manifests), only directories that changed are listed again
+    // NOTE: the cache keeps only the directories used by the last run so it can't be shared by configurations that scan different projects
+    const auto directoryCachePath = (config.derivedConfigurationPathBase / "directory_cache.bin").make_preferred();
+
+    DirectoryListingCache directoryCache;
+    directoryCache.load(directoryCachePath);
+
     uint32_t totalFiles = 0;
-    if (!structure.scanContent(totalFiles))
+    if (!structure.scanContent(totalFiles, &directoryCache))
     {
         LogError() << "Failed to scan projects content";
         return 1;
     }
 
+    directoryCache.printStats();
+    if (!directoryCache.save(directoryCachePath))
+        LogWarning() << "Failed to save directory cache";
+
     LogInfo() << "Found " << totalFiles << " total file(s) across " << structure.projects().size() << " project(s) from " << modules.modules().size() << " module(s)";
 
     //--
@@ -205,6 +345,12 @@ int ToolMake::run(const Commandline& cmdline)
 		return 1;
 	}
 
+    // remember the compiler launcher so "onion build" can report the cache statistics
+    {
+        auto* file = files.createFile(config.derivedSolutionPathBase / "compiler_launcher.txt");
+        file->content << config.compilerLauncher;
+    }
+
     //--
 
     if (!files.saveFiles(false))
@@ -213,6 +359,10 @@ int ToolMake::run(const Commandline& cmdline)
         return 1;
     }
 
+    CollectMakeInputs(modules, *moduleConfig, structure, files, fingerprint);
+    if (!fingerprint.save(fingerprintPath, startTime))
+        LogWarning() << "Failed to save make fingerprint, next make will not be able to skip the work";
+
     //--
 
 	LogInfo() << "-------------------------------------------------------------------------------------------\n";
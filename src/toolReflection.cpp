@@ -1,6 +1,7 @@
 #include "common.h"
 #include "toolReflection.h"
 #include "fileGenerator.h"
+#include "directoryScanner.h"
 
 
 //--
@@ -165,7 +166,7 @@ bool ProjectReflection::LoadCompactProjectsFromFileList(const fs::path& inputFil
 }
 
 
-bool ProjectReflection::CollectSourcesFromDirectory(const fs::path& directoryPath, std::vector<fs::path>& outSources, fs::file_time_type& outTimeStamp)
+bool ProjectReflection::CollectSourcesFromDirectory(DirectoryListingCache& cache, const fs::path& directoryPath, std::vector<fs::path>& outSources, fs::file_time_type& outTimeStamp)
 {
 	bool valid = true;
 
@@ -175,21 +176,25 @@ bool ProjectReflection::CollectSourcesFromDirectory(const fs::path& directoryPat
 		{
             outTimeStamp = std::max(outTimeStamp, fs::last_write_time(directoryPath));
 
-			for (const auto& entry : fs::directory_iterator(directoryPath))
+            std::vector<DirectoryEntry> entries;
+            if (!cache.list(directoryPath, entries))
+                return false;
+
+			for (const auto& entry : entries)
 			{
-				const auto name = entry.path().filename().u8string();
+				const auto& name = entry.name;
                 if (name.c_str()[0] == '.')
                     continue; // skip the hidden crap
 
-                if (entry.is_directory())
+                if (entry.type == DirectoryEntryType::Directory)
                 {
-                    valid &= CollectSourcesFromDirectory(entry.path(), outSources, outTimeStamp);
+                    valid &= CollectSourcesFromDirectory(cache, directoryPath / name, outSources, outTimeStamp);
                 }
-                else if (entry.is_regular_file())
+                else if (entry.type == DirectoryEntryType::File)
                 {
                     if (EndsWith(name, ".cpp") && name != "reflection.cpp" && name != "build.cpp")
                     {
-                        auto path = fs::path(entry.path()).make_preferred();
+                        auto path = (directoryPath / name).make_preferred();
                         outSources.push_back(path);
 
                         outTimeStamp = std::max(outTimeStamp, fs::last_write_time(path));
@@ -303,11 +308,18 @@ bool ProjectReflection::extractFromCompactList(const fs::path& fileList, const f
     fileListExpanded += ".expanded";
     if (!CheckIfCompactListUpToDate(fileListExpanded, compactProjects) || !hasValidTlogs)
     {
+        // listings of directories that did not change since last expansion are reused
+        auto directoryCachePath = fileList;
+        directoryCachePath += ".dircache";
+
+        DirectoryListingCache directoryCache;
+        directoryCache.load(directoryCachePath);
+
         // expand the projects (basically collect source files)
         fs::file_time_type expandedTimestamp;
         for (auto& proj : compactProjects)
         {
-            if (!CollectSourcesFromDirectory(proj.sourceDirectoryPath, proj.sourceFiles, expandedTimestamp))
+            if (!CollectSourcesFromDirectory(directoryCache, proj.sourceDirectoryPath, proj.sourceFiles, expandedTimestamp))
                 return false;
 
             // make sure to include source directory and project file in the reflection BS
@@ -317,6 +329,9 @@ bool ProjectReflection::extractFromCompactList(const fs::path& fileList, const f
             std::sort(proj.sourceFiles.begin(), proj.sourceFiles.end());
         }
 
+        directoryCache.printStats();
+        directoryCache.save(directoryCachePath);
+
 		// write read tlog
 		if (!outputReadTlog.empty())
 		{
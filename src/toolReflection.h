@@ -5,6 +5,7 @@
 //--
 
 class FileGenerator;
+class DirectoryListingCache;
 
 struct ProjectReflection
 {
@@ -55,7 +56,7 @@ struct ProjectReflection
     static bool CheckIfCompactListUpToDate(const fs::path& outputFilePath, const std::vector<CompactProjectInfo>& compactProjects);
     static bool CheckFileUpToDate(const fs::file_time_type& referenceTime, const fs::path& path);
     static bool GetFileTime(const fs::path& path, fs::file_time_type& outLastWriteTime);
-    static bool CollectSourcesFromDirectory(const fs::path& dir, std::vector<fs::path>& outSources, fs::file_time_type& outTimeStamp);
+    static bool CollectSourcesFromDirectory(DirectoryListingCache& cache, const fs::path& dir, std::vector<fs::path>& outSources, fs::file_time_type& outTimeStamp);
     static void PrintExpandedFileList(std::stringstream& f, const std::vector<CompactProjectInfo>& compactProjects);
     static void PrintReadTlog(std::stringstream& f, const std::vector<CompactProjectInfo>& compactProjects);
     static void PrintWriteTlog(std::stringstream& f, const std::vector<CompactProjectInfo>& compactProjects);
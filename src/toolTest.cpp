@@ -3,10 +3,16 @@
 #include "toolTest.h"
 #include "moduleConfiguration.h"
 #include "moduleRepository.h"
+#include "moduleManifest.h"
 #include "configuration.h"
 #include "projectCollection.h"
 #include "project.h"
 #include "projectManifest.h"
+#include "manifestCache.h"
+#include "directoryScanner.h"
+
+#include <mutex>
+#include <chrono>
 
 //--
 
@@ -19,9 +25,16 @@ void ToolTest::printUsage()
 	LogInfo() << "";
 	LogInfo() << "General options:";
 	LogInfo() << "  -module=<path to module to configure>";
-	LogInfo() << "  -parallel - run all tests in parallel";
+	LogInfo() << "  -parallel - run all tests in parallel (same as -j=<number of cores>)";
+	LogInfo() << "  -j=<number of test binaries to run at the same time> (defaults to 1)";
+	LogInfo() << "  -timeout=<seconds> - kill test binaries that run longer than this (defaults to no timeout)";
 	LogInfo() << "  -fastfail - stop after first failure";
+	LogInfo() << "  -changedSince=<git ref|state file> - run only tests affected by projects changed since given git ref or since the state recorded in the file";
+	LogInfo() << "  -nocache - run tests even if the same binary with the same libraries and data already passed";
+	LogInfo() << "  -shards=<number> - split gtest/catch2 binaries into that many processes (defaults to automatic, based on previous run times, 1 until a binary has a recorded time)";
 	LogInfo() << "  -config=<release|debug|final|profile|checked> - configuration to run (defaults to Release)";
+	LogInfo() << "  -junit=<path> - write JUnit XML report";
+	LogInfo() << "  -json=<path> - write JSON report";
 	LogInfo() << "";
 }
 
@@ -76,6 +89,689 @@ static bool ProjectBinaryPath(const ProjectInfo* project, const Configuration& c
 	return true;
 }
 
+//--
+
+struct TestRunShard
+{
+	uint32_t index = 0;
+
+	bool executed = false;
+	bool passed = false;
+	ProcessRunResult result;
+};
+
+struct TestRunJob
+{
+	const ProjectInfo* project = nullptr;
+	fs::path binaryPath;
+	uint64_t expectedTimeMs = 0; // from previous runs (whole binary), 0 if not known
+
+	std::vector<TestRunShard> shards; // at least one
+
+	std::string cacheKey; // hash of the binary and all its inputs, empty if caching is disabled
+	bool cached = false; // same inputs already passed, test was not executed
+
+	// merged results of all shards
+	bool executed = false;
+	bool passed = false;
+	ProcessRunResult result;
+};
+
+// shard target time when splitting binaries automatically
+static const uint64_t TEST_SHARD_TARGET_TIME_MS = 10000;
+
+static bool IsShardableProject(const ProjectInfo* proj)
+{
+	// gtest and catch2 test applications can run a subset of the tests
+	return proj->manifest->type == ProjectType::TestApplication;
+}
+
+static uint32_t DetermineShardCount(const ProjectInfo* proj, uint64_t expectedTimeMs, uint32_t numJobs, int requestedShards)
+{
+	if (!IsShardableProject(proj))
+		return 1;
+
+	if (requestedShards > 0)
+		return (uint32_t)requestedShards;
+
+	// nothing to spread across
+	if (numJobs <= 1)
+		return 1;
+
+	// we don't know how long it takes yet, a single process costs the least if it's short (-shards covers the slow first run)
+	if (!expectedTimeMs)
+		return 1;
+
+	const auto count = (expectedTimeMs + TEST_SHARD_TARGET_TIME_MS - 1) / TEST_SHARD_TARGET_TIME_MS;
+	return (uint32_t)std::clamp<uint64_t>(count, 1, numJobs);
+}
+
+static void BuildShardArguments(const TestRunJob& job, const TestRunShard& shard, std::vector<std::string>& outArgs, std::vector<std::pair<std::string, std::string>>& outEnvironment)
+{
+	const auto count = (uint32_t)job.shards.size();
+	if (count <= 1)
+		return;
+
+	if (job.project->manifest->optionTestFramework == ProjectTestFramework::GTest)
+	{
+		// gtest partitions the test list by itself
+		outEnvironment.emplace_back("GTEST_TOTAL_SHARDS", std::to_string(count));
+		outEnvironment.emplace_back("GTEST_SHARD_INDEX", std::to_string(shard.index));
+	}
+	else if (job.project->manifest->optionTestFramework == ProjectTestFramework::Catch2)
+	{
+		// catch2 (v3) partitions the test list by itself, some shards may end up empty
+		outArgs.push_back("--shard-count");
+		outArgs.push_back(std::to_string(count));
+		outArgs.push_back("--shard-index");
+		outArgs.push_back(std::to_string(shard.index));
+		outArgs.push_back("--allow-running-no-tests");
+	}
+}
+
+static void MergeShardResults(TestRunJob& job)
+{
+	const auto count = (uint32_t)job.shards.size();
+
+	job.executed = false;
+	job.passed = true;
+	job.result = ProcessRunResult();
+	job.result.started = true;
+	job.result.exitCode = 0;
+
+	for (const auto& shard : job.shards)
+	{
+		job.executed |= shard.executed;
+		job.passed &= shard.executed && shard.passed;
+
+		job.result.started &= shard.result.started;
+		job.result.timedOut |= shard.result.timedOut;
+		if (job.result.exitCode == 0 && shard.executed && !shard.passed)
+			job.result.exitCode = shard.result.exitCode ? shard.result.exitCode : 1;
+
+		job.result.wallTimeMs += shard.result.wallTimeMs; // total time, shards may run in parallel
+		job.result.peakMemoryBytes = std::max(job.result.peakMemoryBytes, shard.result.peakMemoryBytes);
+
+		if (count > 1 && shard.executed)
+			job.result.output += "[shard " + std::to_string(shard.index + 1) + "/" + std::to_string(count) + "]\n";
+		job.result.output += shard.result.output;
+	}
+
+	if (!job.executed)
+		job.passed = false;
+}
+
+static fs::path TestTimingsPath(const Configuration& config, std::string_view runtimeConfig)
+{
+	return config.derivedConfigurationPathBase / ("test_timings." + ToLower(runtimeConfig) + ".txt");
+}
+
+static void LoadTestTimings(const fs::path& path, std::unordered_map<std::string, uint64_t>& outTimings)
+{
+	std::string txt;
+	if (!fs::is_regular_file(path) || !LoadFileToString(path, txt))
+		return;
+
+	std::vector<std::string_view> lines;
+	SplitString(txt, "\n", lines);
+
+	// <time in ms> <project name>
+	for (const auto& line : lines)
+	{
+		std::string_view time, name;
+		if (SplitString(Trim(line), " ", time, name) && !Trim(name).empty())
+			outTimings[std::string(Trim(name))] = strtoull(std::string(time).c_str(), nullptr, 10);
+	}
+}
+
+static void SaveTestTimings(const fs::path& path, const std::unordered_map<std::string, uint64_t>& timings)
+{
+	std::vector<std::string> names;
+	for (const auto& it : timings)
+		names.push_back(it.first);
+	std::sort(names.begin(), names.end());
+
+	std::stringstream txt;
+	for (const auto& name : names)
+		txt << Find<std::string, uint64_t>(timings, name, 0) << " " << name << "\n";
+
+	SaveFileFromString(path, txt.str(), false, false);
+}
+
+static std::string EscapeXmlText(std::string_view txt)
+{
+	std::string ret;
+	ret.reserve(txt.length());
+
+	for (const auto ch : txt)
+	{
+		switch (ch)
+		{
+		case '<': ret += "&lt;"; break;
+		case '>': ret += "&gt;"; break;
+		case '&': ret += "&amp;"; break;
+		case '"': ret += "&quot;"; break;
+		case '\'': ret += "&apos;"; break;
+		default:
+			if ((uint8_t)ch >= 32 || ch == '\n' || ch == '\t' || ch == '\r')
+				ret += ch;
+		}
+	}
+
+	return ret;
+}
+
+static std::string EscapeJsonText(std::string_view txt)
+{
+	std::string ret;
+	ret.reserve(txt.length());
+
+	for (const auto ch : txt)
+	{
+		switch (ch)
+		{
+		case '"': ret += "\\\""; break;
+		case '\\': ret += "\\\\"; break;
+		case '\n': ret += "\\n"; break;
+		case '\r': ret += "\\r"; break;
+		case '\t': ret += "\\t"; break;
+		default:
+			if ((uint8_t)ch >= 32)
+			{
+				ret += ch;
+			}
+			else
+			{
+				char code[8];
+				snprintf(code, sizeof(code), "\\u%04x", (uint8_t)ch);
+				ret += code;
+			}
+		}
+	}
+
+	return ret;
+}
+
+static std::string FormatSeconds(uint64_t ms)
+{
+	char txt[64];
+	snprintf(txt, sizeof(txt), "%.3f", ms / 1000.0);
+	return txt;
+}
+
+static const char* TestStatusName(const TestRunJob& job)
+{
+	if (job.cached)
+		return "cached";
+	if (!job.executed)
+		return "skipped";
+	if (job.result.timedOut)
+		return "timeout";
+	return job.passed ? "passed" : "failed";
+}
+
+static bool WriteJUnitReport(const fs::path& path, std::string_view suiteName, const std::vector<TestRunJob>& jobs, uint64_t totalTimeMs)
+{
+	uint32_t numFailures = 0, numSkipped = 0;
+	for (const auto& job : jobs)
+	{
+		if (job.cached)
+			continue;
+		else if (!job.executed)
+			numSkipped += 1;
+		else if (!job.passed)
+			numFailures += 1;
+	}
+
+	std::stringstream f;
+	writeln(f, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>");
+	writelnf(f, "<testsuites name=\"onion\" tests=\"%u\" failures=\"%u\" skipped=\"%u\" time=\"%s\">", (uint32_t)jobs.size(), numFailures, numSkipped, FormatSeconds(totalTimeMs).c_str());
+	writelnf(f, "  <testsuite name=\"%s\" tests=\"%u\" failures=\"%u\" skipped=\"%u\" time=\"%s\">", EscapeXmlText(suiteName).c_str(), (uint32_t)jobs.size(), numFailures, numSkipped, FormatSeconds(totalTimeMs).c_str());
+
+	for (const auto& job : jobs)
+	{
+		const auto name = EscapeXmlText(job.project->name);
+		writelnf(f, "    <testcase name=\"%s\" classname=\"%s\" time=\"%s\">", name.c_str(), name.c_str(), FormatSeconds(job.result.wallTimeMs).c_str());
+
+		if (job.cached)
+			writeln(f, "      <system-out>cached</system-out>");
+		else if (!job.executed)
+			writeln(f, "      <skipped/>");
+		else if (job.result.timedOut)
+			writelnf(f, "      <failure message=\"timeout\" type=\"timeout\"/>");
+		else if (!job.passed)
+			writelnf(f, "      <failure message=\"exit code %d\" type=\"failure\"/>", job.result.exitCode);
+
+		if (!job.result.output.empty())
+			f << "      <system-out>" << EscapeXmlText(job.result.output) << "</system-out>\n";
+
+		writeln(f, "    </testcase>");
+	}
+
+	writeln(f, "  </testsuite>");
+	writeln(f, "</testsuites>");
+
+	return SaveFileFromString(path, f.str(), true);
+}
+
+static bool WriteJsonReport(const fs::path& path, std::string_view suiteName, const std::vector<TestRunJob>& jobs, uint64_t totalTimeMs)
+{
+	std::stringstream f;
+	writeln(f, "{");
+	writelnf(f, "  \"suite\": \"%s\",", EscapeJsonText(suiteName).c_str());
+	writelnf(f, "  \"wallTimeMs\": %llu,", (unsigned long long)totalTimeMs);
+	writeln(f, "  \"tests\": [");
+
+	for (size_t i = 0; i < jobs.size(); ++i)
+	{
+		const auto& job = jobs[i];
+		f << "    {";
+		f << "\"name\": \"" << EscapeJsonText(job.project->name) << "\", ";
+		f << "\"status\": \"" << TestStatusName(job) << "\", ";
+		f << "\"shards\": " << job.shards.size() << ", ";
+		f << "\"exitCode\": " << job.result.exitCode << ", ";
+		f << "\"wallTimeMs\": " << job.result.wallTimeMs << ", ";
+		f << "\"peakMemoryBytes\": " << job.result.peakMemoryBytes << ", ";
+		f << "\"output\": \"" << EscapeJsonText(job.result.output) << "\"";
+		f << "}" << ((i + 1 < jobs.size()) ? "," : "") << "\n";
+	}
+
+	writeln(f, "  ]");
+	writeln(f, "}");
+
+	return SaveFileFromString(path, f.str(), true);
+}
+
+//--
+
+//--
+
+static bool IsPathInsideDirectory(const std::string& path, const std::string& directory)
+{
+	if (path.length() <= directory.length() || !BeginsWith(path, directory))
+		return false;
+
+	const auto ch = path[directory.length()];
+	return ch == '/' || ch == '\\' || EndsWith(directory, "/") || EndsWith(directory, "\\");
+}
+
+static std::string NormalizedPathString(const fs::path& path)
+{
+	auto ret = fs::weakly_canonical(path).make_preferred().u8string();
+#ifdef _WIN32
+	ret = ToLower(ret);
+#endif
+	return ret;
+}
+
+static const ProjectInfo* FindOwningProject(const std::vector<std::pair<std::string, const ProjectInfo*>>& projectRoots, const std::string& filePath)
+{
+	// projects may be nested, pick the deepest one
+	const ProjectInfo* ret = nullptr;
+	size_t bestLength = 0;
+
+	for (const auto& it : projectRoots)
+	{
+		if (it.first.length() > bestLength && IsPathInsideDirectory(filePath, it.first))
+		{
+			bestLength = it.first.length();
+			ret = it.second;
+		}
+	}
+
+	return ret;
+}
+
+static bool CollectChangedFilesFromGit(const fs::path& directory, std::string_view ref, std::vector<fs::path>& outFiles)
+{
+	const auto gitCommand = "git -C \"" + directory.u8string() + "\" ";
+
+	std::vector<std::string> rootLines;
+	if (!RunWithArgsAndCaptureOutputIntoLines(gitCommand + "rev-parse --show-toplevel", rootLines) || rootLines.empty())
+		return false;
+
+	const fs::path repositoryRoot = rootLines[0];
+
+	// committed and uncommitted changes against the ref
+	std::vector<std::string> lines;
+	if (!RunWithArgsAndCaptureOutputIntoLines(gitCommand + "diff --name-only " + std::string(ref) + " --", lines))
+		return false;
+
+	// new files
+	RunWithArgsAndCaptureOutputIntoLines(gitCommand + "ls-files --others --exclude-standard --full-name", lines);
+
+	for (const auto& line : lines)
+		outFiles.push_back((repositoryRoot / line).make_preferred());
+
+	return true;
+}
+
+static bool IsGitReference(const fs::path& directory, std::string_view ref)
+{
+	ProcessRunResult result;
+	return RunProcess("git", { "rev-parse", "--verify", "--quiet", std::string(ref) }, directory, 0, result);
+}
+
+// not shared with onion make - the cache keeps only the directories used by the last run and the two scan different directories
+static fs::path TestDirectoryCachePath(const Configuration& config)
+{
+	return (config.derivedConfigurationPathBase / "test_directory_cache.bin").make_preferred();
+}
+
+static void AccumulateDirectoryFingerprint(DirectoryListingCache& cache, const fs::path& rootDirectory, const fs::path& directory, uint64_t& outFingerprint)
+{
+	std::vector<DirectoryEntry> entries;
+	if (!cache.list(directory, entries))
+		return;
+
+	for (const auto& entry : entries)
+	{
+		const auto path = directory / entry.name;
+
+		if (entry.type == DirectoryEntryType::Directory)
+		{
+			AccumulateDirectoryFingerprint(cache, rootDirectory, path, outFingerprint);
+		}
+		else if (entry.type == DirectoryEntryType::File)
+		{
+			// listing does not change when a file is only written to, size and time stamp are always read
+			std::error_code ec;
+			const auto relativePath = MakeRelativePathFast(path, rootDirectory);
+			const uint64_t size = fs::file_size(path, ec);
+			const uint64_t time = (uint64_t)fs::last_write_time(path, ec).time_since_epoch().count();
+
+			uint64_t crc = Crc64((const uint8_t*)relativePath.c_str(), relativePath.length());
+			crc = Crc64(crc, (const uint8_t*)&size, sizeof(size));
+			crc = Crc64(crc, (const uint8_t*)&time, sizeof(time));
+			outFingerprint += crc;
+		}
+	}
+}
+
+static uint64_t ComputeDirectoryFingerprint(DirectoryListingCache& cache, const fs::path& directory)
+{
+	// cheap fingerprint of all files in the directory (names, sizes and timestamps), order independent
+	uint64_t ret = 0;
+	AccumulateDirectoryFingerprint(cache, directory, directory, ret);
+	return ret;
+}
+
+static void LoadProjectFingerprints(const fs::path& path, std::unordered_map<std::string, uint64_t>& outFingerprints)
+{
+	std::string txt;
+	if (!fs::is_regular_file(path) || !LoadFileToString(path, txt))
+		return;
+
+	std::vector<std::string_view> lines;
+	SplitString(txt, "\n", lines);
+
+	// <fingerprint> <project name>
+	for (const auto& line : lines)
+	{
+		std::string_view fingerprint, name;
+		if (SplitString(Trim(line), " ", fingerprint, name) && !Trim(name).empty())
+			outFingerprints[std::string(Trim(name))] = strtoull(std::string(fingerprint).c_str(), nullptr, 16);
+	}
+}
+
+static void SaveProjectFingerprints(const fs::path& path, const std::unordered_map<std::string, uint64_t>& fingerprints)
+{
+	std::vector<std::string> names;
+	for (const auto& it : fingerprints)
+		names.push_back(it.first);
+	std::sort(names.begin(), names.end());
+
+	std::stringstream txt;
+	for (const auto& name : names)
+	{
+		char hex[32];
+		snprintf(hex, sizeof(hex), "%016llx", (unsigned long long)Find<std::string, uint64_t>(fingerprints, name, 0));
+		txt << hex << " " << name << "\n";
+	}
+
+	SaveFileFromString(path, txt.str(), false, false);
+}
+
+struct TestImpactAnalysis
+{
+	bool runAll = true;
+	std::unordered_set<const ProjectInfo*> affectedProjects; // changed projects and everything that depends on them
+
+	fs::path stateFilePath; // empty if not used
+	std::unordered_map<std::string, uint64_t> currentFingerprints; // to save after successful run
+};
+
+static bool AnalyzeTestImpact(const ProjectCollection& structure, const Configuration& config, DirectoryListingCache& directoryCache, std::string_view changedSince, TestImpactAnalysis& outAnalysis)
+{
+	std::unordered_set<const ProjectInfo*> changedProjects;
+
+	if (!fs::is_regular_file(changedSince) && IsGitReference(config.moduleDirPath, changedSince))
+	{
+		std::vector<fs::path> changedFiles;
+		if (!CollectChangedFilesFromGit(config.moduleDirPath, changedSince, changedFiles))
+		{
+			LogError() << "Failed to list files changed since '" << changedSince << "'";
+			return false;
+		}
+
+		std::vector<std::pair<std::string, const ProjectInfo*>> projectRoots;
+		for (const auto* proj : structure.projects())
+			projectRoots.emplace_back(NormalizedPathString(proj->rootPath), proj);
+
+		std::vector<std::string> moduleRoots;
+		for (const auto* proj : structure.projects())
+			if (proj->parentModule)
+				PushBackUnique(moduleRoots, NormalizedPathString(proj->parentModule->path.parent_path()));
+
+		// generated and downloaded files are not sources
+		const auto tempRoot = NormalizedPathString(config.tempPath);
+		const auto cacheRoot = NormalizedPathString(config.cachePath);
+
+		uint32_t numChangedFiles = 0;
+		for (const auto& file : changedFiles)
+		{
+			const auto filePath = NormalizedPathString(file);
+			if (IsPathInsideDirectory(filePath, tempRoot) || IsPathInsideDirectory(filePath, cacheRoot))
+				continue;
+
+			numChangedFiles += 1;
+			if (const auto* proj = FindOwningProject(projectRoots, filePath))
+			{
+				changedProjects.insert(proj);
+				continue;
+			}
+
+			// file in module but outside any project (module manifest, data, shared files) - we can't tell what it affects
+			for (const auto& moduleRoot : moduleRoots)
+			{
+				if (IsPathInsideDirectory(filePath, moduleRoot))
+				{
+					LogInfo() << "Changed file " << file << " does not belong to any project, running all tests";
+					return true;
+				}
+			}
+		}
+
+		LogInfo() << "Found " << numChangedFiles << " file(s) changed since '" << changedSince << "' in " << changedProjects.size() << " project(s)";
+	}
+	else
+	{
+		outAnalysis.stateFilePath = fs::absolute(fs::path(changedSince));
+
+		std::unordered_map<std::string, uint64_t> previousFingerprints;
+		LoadProjectFingerprints(outAnalysis.stateFilePath, previousFingerprints);
+
+		for (const auto* proj : structure.projects())
+		{
+			const auto fingerprint = ComputeDirectoryFingerprint(directoryCache, proj->rootPath);
+			outAnalysis.currentFingerprints[proj->name] = fingerprint;
+
+			auto it = previousFingerprints.find(proj->name);
+			if (it == previousFingerprints.end() || it->second != fingerprint)
+				changedProjects.insert(proj);
+		}
+
+		if (previousFingerprints.empty())
+		{
+			LogInfo() << "No previous state in " << outAnalysis.stateFilePath << ", running all tests";
+			return true;
+		}
+
+		LogInfo() << "Found " << changedProjects.size() << " project(s) changed since state recorded in " << outAnalysis.stateFilePath;
+	}
+
+	// everything that (transitively) depends on changed projects is affected
+	std::vector<const ProjectInfo*> affectedProjects;
+	structure.collectAllDependents(std::vector<const ProjectInfo*>(changedProjects.begin(), changedProjects.end()), affectedProjects);
+	outAnalysis.affectedProjects.insert(affectedProjects.begin(), affectedProjects.end());
+
+	outAnalysis.runAll = false;
+	return true;
+}
+
+//--
+
+static fs::path TestCachePath(const Configuration& config, std::string_view runtimeConfig)
+{
+	return config.derivedConfigurationPathBase / ("test_cache." + ToLower(runtimeConfig) + ".txt");
+}
+
+// passed test runs, keyed by hash of the test binary and everything it loads
+class TestResultCache
+{
+public:
+	static const uint32_t MAX_ENTRIES_PER_PROJECT = 8;
+
+	void load(const fs::path& path)
+	{
+		std::string txt;
+		if (!fs::is_regular_file(path) || !LoadFileToString(path, txt))
+			return;
+
+		std::vector<std::string_view> lines;
+		SplitString(txt, "\n", lines);
+
+		// <key> <project name>
+		for (const auto& line : lines)
+		{
+			std::string_view key, name;
+			if (SplitString(Trim(line), " ", key, name) && !Trim(name).empty())
+				add(key, Trim(name));
+		}
+	}
+
+	void save(const fs::path& path) const
+	{
+		// keep only the most recent entries for each project
+		std::unordered_map<std::string, uint32_t> counts;
+		std::vector<const std::pair<std::string, std::string>*> keptEntries;
+		for (auto it = m_entries.rbegin(); it != m_entries.rend(); ++it)
+			if (counts[it->second]++ < MAX_ENTRIES_PER_PROJECT)
+				keptEntries.push_back(&(*it));
+
+		std::stringstream txt;
+		for (auto it = keptEntries.rbegin(); it != keptEntries.rend(); ++it)
+			txt << (*it)->first << " " << (*it)->second << "\n";
+
+		SaveFileFromString(path, txt.str(), false, false);
+	}
+
+	bool contains(std::string_view key) const
+	{
+		return m_keys.count(std::string(key)) != 0;
+	}
+
+	void add(std::string_view key, std::string_view projectName)
+	{
+		if (m_keys.insert(std::string(key)).second)
+			m_entries.emplace_back(key, projectName);
+	}
+
+private:
+	std::vector<std::pair<std::string, std::string>> m_entries; // in order of adding
+	std::unordered_set<std::string> m_keys;
+};
+
+static bool IsSharedLibraryFile(const fs::path& path)
+{
+	const auto name = ToLower(path.filename().u8string());
+	return EndsWith(name, ".dll") || EndsWith(name, ".so") || EndsWith(name, ".dylib") || (name.find(".so.") != std::string::npos);
+}
+
+static std::string ComputeSharedLibrariesDigest(const fs::path& binaryDirectory)
+{
+	// all shared libraries deployed next to the binary, that's what the loader will pick up
+	std::vector<fs::path> libraries;
+
+	std::error_code ec;
+	for (fs::directory_iterator it(binaryDirectory, ec), end; !ec && it != end; it.increment(ec))
+		if (it->is_regular_file(ec) && IsSharedLibraryFile(it->path()))
+			libraries.push_back(it->path());
+
+	std::sort(libraries.begin(), libraries.end());
+
+	std::stringstream txt;
+	for (const auto& path : libraries)
+	{
+		std::string hash;
+		if (!Sha256OfFile(path, hash))
+			hash = "?";
+		txt << path.filename().u8string() << ":" << hash << "\n";
+	}
+
+	return Sha256OfText(txt.str());
+}
+
+static std::string ComputeDataFoldersDigest(DirectoryListingCache& directoryCache, const fs::path& binaryDirectory)
+{
+	// data folders mounted by the binary are listed in the generated fstab.cfg
+	std::string fstab;
+	if (!LoadFileToString(binaryDirectory / "fstab.cfg", fstab))
+		return "nodata";
+
+	std::vector<std::string_view> lines;
+	SplitString(fstab, "\n", lines);
+
+	std::stringstream txt;
+	for (size_t i = 0; i + 2 < lines.size(); i += 3)
+	{
+		const auto type = Trim(lines[i]);
+		const auto mountPath = Trim(lines[i + 1]);
+		const auto dataPath = Trim(lines[i + 2]);
+
+		// the shared cache is written to by the applications themselves, it's not an input
+		if (mountPath == "/Cache/")
+			continue;
+
+		const auto fullPath = (type == "DATA_RELATIVE") ? (binaryDirectory / dataPath) : fs::path(dataPath);
+
+		char hex[32];
+		snprintf(hex, sizeof(hex), "%016llx", (unsigned long long)ComputeDirectoryFingerprint(directoryCache, fullPath));
+		txt << mountPath << ":" << dataPath << ":" << hex << "\n";
+	}
+
+	return Sha256OfText(txt.str());
+}
+
+static std::string ComputeTestCacheKey(const TestRunJob& job, DirectoryListingCache& directoryCache, std::unordered_map<std::string, std::string>& directoryDigests)
+{
+	std::string binaryHash;
+	if (!Sha256OfFile(job.binaryPath, binaryHash))
+		return "";
+
+	// libraries and data are shared by all tests in the same directory
+	const auto binaryDirectory = job.binaryPath.parent_path();
+	auto& directoryDigest = directoryDigests[binaryDirectory.u8string()];
+	if (directoryDigest.empty())
+		directoryDigest = ComputeSharedLibrariesDigest(binaryDirectory) + ":" + ComputeDataFoldersDigest(directoryCache, binaryDirectory);
+
+	std::stringstream txt;
+	txt << job.project->name << "\n";
+	txt << binaryHash << "\n";
+	txt << directoryDigest << "\n";
+	return Sha256OfText(txt.str());
+}
+
 static bool RunTestsForConfiguration(const ModuleRepository& modules, const Configuration& config, const Commandline& cmdLine)
 {
 	// configuration
@@ -96,27 +792,85 @@ static bool RunTestsForConfiguration(const ModuleRepository& modules, const Conf
 		return false;
 	}
 
+	// listings of project and data directories, reused between runs
+	const auto directoryCachePath = TestDirectoryCachePath(config);
+	DirectoryListingCache directoryCache;
+	directoryCache.load(directoryCachePath);
+
+	// test impact analysis
+	TestImpactAnalysis impact;
+	if (cmdLine.has("changedSince"))
+	{
+		if (!structure.resolveDependencies(config))
+		{
+			LogError() << "Failed to resolve project dependencies";
+			return false;
+		}
+
+		if (!AnalyzeTestImpact(structure, config, directoryCache, cmdLine.get("changedSince"), impact))
+			return false;
+	}
+
 	std::vector<const ProjectInfo*> testProjects;
+	uint32_t numSkippedTestProjects = 0;
 	for (const auto* proj : structure.projects())
+	{
 		if (IsTestableProject(proj))
-			testProjects.push_back(proj);
+		{
+			if (impact.runAll || impact.affectedProjects.count(proj))
+				testProjects.push_back(proj);
+			else
+				numSkippedTestProjects += 1;
+		}
+	}
+
+	if (numSkippedTestProjects)
+		LogInfo() << "Skipped " << numSkippedTestProjects << " test project(s) not affected by changes";
 
 	if (testProjects.empty())
 	{
 		LogInfo() << "No test projects found in configuration";
+
+		if (!impact.stateFilePath.empty())
+			SaveProjectFingerprints(impact.stateFilePath, impact.currentFingerprints);
+
+		directoryCache.save(directoryCachePath);
 		return true;
 	}
 
 	LogInfo() << "Collected " << testProjects.size() << " projects for testing";
 
+	// number of tests to run at the same time
+	uint32_t numJobs = 1;
+	if (cmdLine.has("parallel"))
+		numJobs = GetDefaultJobCount();
+	if (cmdLine.has("j"))
+		numJobs = std::max<int>(1, atoi(std::string(cmdLine.get("j")).c_str()));
+
+	uint64_t timeoutMs = 0;
+	if (cmdLine.has("timeout"))
+		timeoutMs = std::max<int>(0, atoi(std::string(cmdLine.get("timeout")).c_str())) * 1000ULL;
+
+	const auto fastFail = cmdLine.has("fastfail");
+	const auto useCache = !cmdLine.has("nocache");
+
+	int requestedShards = 0;
+	if (cmdLine.has("shards"))
+		requestedShards = std::max<int>(1, atoi(std::string(cmdLine.get("shards")).c_str()));
+
+	// durations from previous runs
+	const auto timingsPath = TestTimingsPath(config, runtimeConfig);
+	std::unordered_map<std::string, uint64_t> timings;
+	LoadTestTimings(timingsPath, timings);
+
+	// collect binaries to run
 	bool valid = true;
+	std::vector<TestRunJob> jobs;
 	for (const auto* proj : testProjects)
 	{
 		fs::path binaryPath;
 		if (ProjectBinaryPath(proj, config, runtimeConfig, binaryPath))
 		{
-			const auto binaryDirectory = binaryPath.parent_path();
-
 			if (!fs::is_regular_file(binaryPath))
 			{
 				LogError() << "Failed to find binary for project '" << proj->name << "' at " << binaryPath;
@@ -124,27 +878,196 @@ static bool RunTestsForConfiguration(const ModuleRepository& modules, const Conf
 				continue;
 			}
 
-			std::stringstream command;
-#ifndef _WIN32
-			command << std::string("./");
-#endif
-			command << binaryPath.filename().u8string();
+			TestRunJob job;
+			job.project = proj;
+			job.binaryPath = binaryPath;
+			job.expectedTimeMs = Find<std::string, uint64_t>(timings, proj->name, 0);
 
-			// TODO: self-test arguments
-
-			if (!RunWithArgsInDirectory(binaryDirectory, command.str()))
+			const auto numShards = DetermineShardCount(proj, job.expectedTimeMs, numJobs, requestedShards);
+			for (uint32_t i = 0; i < numShards; ++i)
 			{
-				LogError() << "Test for project '" << proj->name << "' failed!";
-				valid = false;
-				continue;
+				TestRunShard shard;
+				shard.index = i;
+				job.shards.push_back(shard);
 			}
-			else
+
+			jobs.push_back(job);
+		}
+	}
+
+	// skip tests that already passed with exactly the same inputs
+	const auto cachePath = TestCachePath(config, runtimeConfig);
+	TestResultCache cache;
+	if (useCache)
+	{
+		cache.load(cachePath);
+
+		std::unordered_map<std::string, std::string> directoryDigests;
+		uint32_t numCached = 0;
+		for (auto& job : jobs)
+		{
+			job.cacheKey = ComputeTestCacheKey(job, directoryCache, directoryDigests);
+			if (!job.cacheKey.empty() && cache.contains(job.cacheKey))
 			{
-				LogSuccess() << "Test for project '" << proj->name << "' succeeded!";
+				job.cached = true;
+				numCached += 1;
 			}
 		}
+
+		if (numCached)
+			LogInfo() << "Found " << numCached << " test binaries with cached results (use -nocache to run them anyway)";
 	}
 
+	directoryCache.printStats();
+	if (!directoryCache.save(directoryCachePath))
+		LogWarning() << "Failed to save directory cache";
+
+	// flat list of processes to run
+	struct ScheduledShard
+	{
+		TestRunJob* job = nullptr;
+		TestRunShard* shard = nullptr;
+		uint64_t expectedTimeMs = UINT64_MAX; // unknown tests are assumed to be long
+	};
+
+	std::vector<ScheduledShard> schedule;
+	for (auto& job : jobs)
+	{
+		if (job.cached)
+			continue;
+
+		for (auto& shard : job.shards)
+		{
+			ScheduledShard entry;
+			entry.job = &job;
+			entry.shard = &shard;
+			if (job.expectedTimeMs)
+				entry.expectedTimeMs = job.expectedTimeMs / job.shards.size();
+			schedule.push_back(entry);
+		}
+	}
+
+	// longest tests go first so they don't end up running alone at the end
+	std::sort(schedule.begin(), schedule.end(), [](const ScheduledShard& a, const ScheduledShard& b)
+		{
+			if (a.expectedTimeMs != b.expectedTimeMs)
+				return a.expectedTimeMs > b.expectedTimeMs;
+			if (a.job->project->name != b.job->project->name)
+				return a.job->project->name < b.job->project->name;
+			return a.shard->index < b.shard->index;
+		});
+
+	const auto numBinariesToRun = std::count_if(jobs.begin(), jobs.end(), [](const TestRunJob& job) { return !job.cached; });
+	LogInfo() << "Running " << (uint64_t)numBinariesToRun << " test binaries as " << schedule.size() << " process(es) using " << std::min<uint32_t>(numJobs, (uint32_t)schedule.size()) << " job(s)";
+
+	// run
+	std::mutex printLock;
+	std::atomic<uint32_t> numFinished = 0;
+	std::atomic<bool> hadFailure = false;
+	const auto startTime = std::chrono::steady_clock::now();
+
+	RunParallel((uint32_t)schedule.size(), numJobs, [&](uint32_t index)
+		{
+			const auto& job = *schedule[index].job;
+			auto& shard = *schedule[index].shard;
+			if (fastFail && hadFailure)
+				return;
+
+			// TODO: self-test arguments
+
+			std::vector<std::string> args;
+			std::vector<std::pair<std::string, std::string>> environment;
+			BuildShardArguments(job, shard, args, environment);
+
+			shard.executed = true;
+			shard.passed = RunProcess(job.binaryPath, args, job.binaryPath.parent_path(), timeoutMs, shard.result, environment);
+			if (!shard.passed)
+				hadFailure = true;
+
+			// print whole output at once so it's not mixed with other tests
+			std::lock_guard<std::mutex> lock(printLock);
+			const auto counter = ++numFinished;
+
+			const auto output = Trim(shard.result.output);
+			if (!output.empty())
+				LogInfo() << output;
+
+			std::stringstream info;
+			info << "[" << counter << "/" << schedule.size() << "] '" << job.project->name << "' ";
+			if (job.shards.size() > 1)
+				info << "shard " << (shard.index + 1) << "/" << job.shards.size() << " ";
+			info << "(" << shard.result.wallTimeMs << " ms, " << (shard.result.peakMemoryBytes >> 20) << " MB peak)";
+
+			if (shard.passed)
+				LogSuccess() << "Test " << info.str() << " succeeded!";
+			else if (shard.result.timedOut)
+				LogError() << "Test " << info.str() << " timed out!";
+			else if (!shard.result.started)
+				LogError() << "Test " << info.str() << " failed to start!";
+			else
+				LogError() << "Test " << info.str() << " failed with exit code " << shard.result.exitCode << "!";
+		});
+
+	const auto totalTimeMs = (uint64_t)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime).count();
+
+	// merge shards back into single result per binary
+	for (auto& job : jobs)
+	{
+		if (job.cached)
+		{
+			job.passed = true;
+			continue;
+		}
+
+		MergeShardResults(job);
+
+		if (job.passed && !job.cacheKey.empty())
+			cache.add(job.cacheKey, job.project->name);
+	}
+
+	// summary
+	uint32_t numPassed = 0;
+	for (const auto& job : jobs)
+	{
+		if (std::all_of(job.shards.begin(), job.shards.end(), [](const TestRunShard& shard) { return shard.executed; }))
+			timings[job.project->name] = std::max<uint64_t>(1, job.result.wallTimeMs);
+
+		if (job.passed)
+			numPassed += 1;
+		else if (job.executed)
+			valid = false;
+	}
+
+	LogInfo() << "Test summary: " << numPassed << "/" << jobs.size() << " passed in " << totalTimeMs << " ms";
+	for (const auto& job : jobs)
+	{
+		if (!job.passed)
+			LogError() << "  " << job.project->name << ": " << TestStatusName(job);
+		else if (job.cached)
+			LogInfo() << "  " << job.project->name << ": cached";
+		else
+			LogInfo() << "  " << job.project->name << ": " << job.result.wallTimeMs << " ms, " << (job.result.peakMemoryBytes >> 20) << " MB peak";
+	}
+
+	if (fastFail && hadFailure)
+		valid = false;
+
+	SaveTestTimings(timingsPath, timings);
+
+	if (useCache)
+		cache.save(cachePath);
+
+	// reports
+	const auto suiteName = config.mergedName() + "." + ToLower(runtimeConfig);
+	if (cmdLine.has("junit"))
+		valid &= WriteJUnitReport(fs::absolute(fs::path(cmdLine.get("junit"))), suiteName, jobs, totalTimeMs);
+	if (cmdLine.has("json"))
+		valid &= WriteJsonReport(fs::absolute(fs::path(cmdLine.get("json"))), suiteName, jobs, totalTimeMs);
+
+	// remember the state only if everything passed, otherwise failed tests must run again next time
+	if (valid && !impact.stateFilePath.empty())
+		SaveProjectFingerprints(impact.stateFilePath, impact.currentFingerprints);
+
 	return valid;
 }
 
@@ -166,13 +1089,20 @@ int ToolTest::run(const Commandline& cmdline)
 		return 1;
 	}
 
+	const auto manifestCachePath = (config.derivedConfigurationPathBase / "manifest_cache.bin").make_preferred();
+
+	ManifestCache manifestCache(config);
+	manifestCache.load(manifestCachePath);
+
 	ModuleRepository modules(config);
-	if (!modules.installConfiguredModules(*moduleConfig, false))
+	if (!modules.installConfiguredModules(*moduleConfig, false, &manifestCache))
 	{
 		LogError() << "Failed to verify configured module at \"" << moduleConfigPath << "\"";
 		return 1;
 	}
 
+	manifestCache.save(manifestCachePath);
+
 
 	//--
 
@@ -1,9 +1,11 @@
 #include "common.h"
 #include "utils.h"
+#include "profiler.h"
 #include <cwctype>
 #include <fstream>
 #include <sstream>
 #include <mutex>
+#include <thread>
 #include <string.h>
 #include <stdarg.h>
 #include "lz4/lz4.h"
@@ -21,6 +23,16 @@
 #include <Windows.h>
 #endif
 
+#if defined(__linux__)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <linux/fs.h>
+#elif defined(__APPLE__)
+#include <sys/clonefile.h>
+#endif
+
 //--
 
 namespace prv
@@ -1152,6 +1164,8 @@ bool LoadFileToString(const fs::path& path, std::string& outText)
         std::stringstream buffer;
         buffer << f.rdbuf();
         outText = buffer.str();
+
+        Profiler_AddCounter(ProfilerCounter::BytesRead, outText.size());
         return true;
     }
     catch (std::exception& e)
@@ -1175,6 +1189,7 @@ bool LoadFileToBuffer(const fs::path& path, std::vector<uint8_t>& outBuffer)
         outBuffer.resize(fileSize);
         file.read((char*)outBuffer.data(), fileSize);
 
+        Profiler_AddCounter(ProfilerCounter::BytesRead, outBuffer.size());
 		return true;
 	}
 	catch (std::exception& e)
@@ -1247,6 +1262,8 @@ bool SaveFileFromString(const fs::path& path, std::string_view txt, bool force /
     if (print)
         LogInfo() << "File " << path << " saved!";
 
+    Profiler_AddCounter(ProfilerCounter::BytesWritten, txt.size());
+
     if (outCounter)
         (*outCounter) += 1;
 
@@ -1300,6 +1317,8 @@ bool SaveFileFromBuffer(const fs::path& path, const std::vector<uint8_t>& buffer
 		return false;
 	}
 
+    Profiler_AddCounter(ProfilerCounter::BytesWritten, buffer.size());
+
 	if (outCounter)
 		(*outCounter) += 1;
 
@@ -1846,6 +1865,7 @@ std::string_view NameEnumOption(GeneratorType type)
     case GeneratorType::VisualStudio19: return "vs2019"; 
     case GeneratorType::VisualStudio22: return "vs2022";
     case GeneratorType::CMake: return "cmake";
+    case GeneratorType::Ninja: return "ninja";
     default: break;
     }
     return "";
@@ -1943,6 +1963,107 @@ bool CopyNewerFile(const fs::path& source, const fs::path& target, bool* outActu
     }
 }
 
+// create target as a clone of the source that shares the data blocks (copy on write), false if the file system can't do it
+// NOTE: target must not exist, nothing is left behind on failure
+static bool CloneFileData(const fs::path& source, const fs::path& target)
+{
+#if defined(__linux__)
+	const int sourceFd = open(source.c_str(), O_RDONLY | O_CLOEXEC);
+	if (sourceFd < 0)
+		return false;
+
+	struct stat info;
+	if (0 != fstat(sourceFd, &info))
+	{
+		close(sourceFd);
+		return false;
+	}
+
+	const int targetFd = open(target.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, info.st_mode & 0777);
+	if (targetFd < 0)
+	{
+		close(sourceFd);
+		return false;
+	}
+
+	// reflink (btrfs, xfs), otherwise an in-kernel copy that some file systems still turn into shared blocks or a server side copy
+	bool cloned = false;
+#ifdef FICLONE
+	cloned = (0 == ioctl(targetFd, FICLONE, sourceFd));
+#endif
+	if (!cloned)
+	{
+		off_t offset = 0;
+		while (offset < info.st_size)
+		{
+			const auto copied = copy_file_range(sourceFd, nullptr, targetFd, nullptr, (size_t)(info.st_size - offset), 0);
+			if (copied <= 0)
+				break;
+			offset += copied;
+		}
+
+		cloned = (offset == info.st_size);
+	}
+
+	if (cloned)
+		fchmod(targetFd, info.st_mode & 07777);
+
+	close(targetFd);
+	close(sourceFd);
+
+	if (!cloned)
+		unlink(target.c_str());
+
+	return cloned;
+#elif defined(__APPLE__)
+	// APFS
+	return 0 == clonefile(source.c_str(), target.c_str(), 0);
+#else
+	return false;
+#endif
+}
+
+bool CloneNewerFile(const fs::path& source, const fs::path& target, bool* outActuallyCopied/*= nullptr*/)
+{
+	try
+	{
+		if (!fs::is_regular_file(source))
+			return false;
+
+		if (fs::is_regular_file(target))
+		{
+			auto sourceTimestamp = fs::last_write_time(source);
+			auto targetTimestamp = fs::last_write_time(target);
+			if (targetTimestamp >= sourceTimestamp)
+			{
+				if (outActuallyCopied)
+					*outActuallyCopied = false;
+				return true;
+			}
+		}
+
+		fs::remove(target);
+		fs::create_directories(target.parent_path());
+
+		if (CloneFileData(source, target))
+		{
+			LogInfo() << "Cloning " << target;
+
+			if (outActuallyCopied)
+				*outActuallyCopied = true;
+
+			return true;
+		}
+	}
+	catch (std::exception & e)
+	{
+		LogError() << "Failed to clone file: " << e.what();
+		return false;
+	}
+
+	return CopyNewerFile(source, target, outActuallyCopied);
+}
+
 bool CopyFile(const fs::path& source, const fs::path& target)
 {
 	try
@@ -2166,6 +2287,50 @@ std::string GetCurrentWeeklyTimestamp()
 
 //--
 
+uint32_t GetDefaultJobCount()
+{
+	return std::max<uint32_t>(1, std::thread::hardware_concurrency());
+}
+
+static thread_local bool GIsParallelWorker = false;
+
+void RunParallel(uint32_t count, uint32_t maxJobs, const std::function<void(uint32_t index)>& func)
+{
+	// nested call (ie. included manifests of a module loaded in parallel) runs on the worker it came from, all the cores are already busy
+	const auto numThreads = GIsParallelWorker ? 1 : std::min<uint32_t>(count, std::max<uint32_t>(1, maxJobs));
+	if (numThreads <= 1)
+	{
+		for (uint32_t i = 0; i < count; ++i)
+			func(i);
+		return;
+	}
+
+	std::atomic<uint32_t> nextIndex = 0;
+	auto worker = [&]()
+	{
+		GIsParallelWorker = true;
+
+		for (;;)
+		{
+			const auto index = nextIndex++;
+			if (index >= count)
+				break;
+
+			func(index);
+		}
+	};
+
+	std::vector<std::thread> threads;
+	threads.reserve(numThreads);
+	for (uint32_t i = 0; i < numThreads; ++i)
+		threads.emplace_back(worker);
+
+	for (auto& thread : threads)
+		thread.join();
+}
+
+//--
+
 static const uint64_t crc64_tab[256] = {
 	UINT64_C(0x0000000000000000), UINT64_C(0x7ad870c830358979),
 	UINT64_C(0xf5b0e190606b12f2), UINT64_C(0x8f689158505e9b8b),
@@ -2315,6 +2480,131 @@ uint64_t Crc64(const uint8_t* s, uint64_t l)
 
 //--
 
+void BinaryWriter::writeRaw(const void* ptr, uint64_t size)
+{
+	const auto* bytes = (const uint8_t*)ptr;
+	data.insert(data.end(), bytes, bytes + size);
+}
+
+void BinaryWriter::writeU8(uint8_t value)
+{
+	data.push_back(value);
+}
+
+void BinaryWriter::writeU32(uint32_t value)
+{
+	writeRaw(&value, sizeof(value));
+}
+
+void BinaryWriter::writeU64(uint64_t value)
+{
+	writeRaw(&value, sizeof(value));
+}
+
+void BinaryWriter::writeString(std::string_view txt)
+{
+	writeU32((uint32_t)txt.length());
+	writeRaw(txt.data(), txt.length());
+}
+
+void BinaryWriter::writePath(const fs::path& path)
+{
+	writeString(path.u8string());
+}
+
+void BinaryWriter::writeStrings(const std::vector<std::string>& list)
+{
+	writeU32((uint32_t)list.size());
+	for (const auto& txt : list)
+		writeString(txt);
+}
+
+void BinaryWriter::writePaths(const std::vector<fs::path>& list)
+{
+	writeU32((uint32_t)list.size());
+	for (const auto& path : list)
+		writePath(path);
+}
+
+//--
+
+BinaryReader::BinaryReader(const uint8_t* data, uint64_t size)
+	: m_pos(data)
+	, m_end(data + size)
+{}
+
+bool BinaryReader::readRaw(void* outPtr, uint64_t size)
+{
+	if (m_error || (uint64_t)(m_end - m_pos) < size)
+	{
+		m_error = true;
+		memset(outPtr, 0, size);
+		return false;
+	}
+
+	memcpy(outPtr, m_pos, size);
+	m_pos += size;
+	return true;
+}
+
+uint8_t BinaryReader::readU8()
+{
+	uint8_t value = 0;
+	readRaw(&value, sizeof(value));
+	return value;
+}
+
+uint32_t BinaryReader::readU32()
+{
+	uint32_t value = 0;
+	readRaw(&value, sizeof(value));
+	return value;
+}
+
+uint64_t BinaryReader::readU64()
+{
+	uint64_t value = 0;
+	readRaw(&value, sizeof(value));
+	return value;
+}
+
+std::string BinaryReader::readString()
+{
+	const auto length = readU32();
+	if (m_error || (uint64_t)(m_end - m_pos) < length)
+	{
+		m_error = true;
+		return std::string();
+	}
+
+	auto ret = std::string((const char*)m_pos, length);
+	m_pos += length;
+	return ret;
+}
+
+fs::path BinaryReader::readPath()
+{
+	return fs::u8path(readString());
+}
+
+void BinaryReader::readStrings(std::vector<std::string>& outList)
+{
+	const auto count = readU32();
+	outList.clear();
+	for (uint32_t i = 0; i < count && ok(); ++i)
+		outList.push_back(readString());
+}
+
+void BinaryReader::readPaths(std::vector<fs::path>& outList)
+{
+	const auto count = readU32();
+	outList.clear();
+	for (uint32_t i = 0; i < count && ok(); ++i)
+		outList.push_back(readPath());
+}
+
+//--
+
 bool CompressLZ4(const std::vector<uint8_t>& uncompressedData, std::vector<uint8_t>& outBuffer)
 {
     return CompressLZ4(uncompressedData.data(), (uint32_t)uncompressedData.size(), outBuffer);
@@ -2659,6 +2949,125 @@ bool Sha256OfFile(const fs::path& path, std::string& outHashString)
     return true;
 }
 
+//--
+
+static const uint32_t MD5_SHIFTS[64] = {
+	7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22,
+	5, 9, 14, 20, 5, 9, 14, 20, 5, 9, 14, 20, 5, 9, 14, 20,
+	4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23,
+	6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21,
+};
+
+static const uint32_t MD5_CONSTANTS[64] = {
+	0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee, 0xf57c0faf, 0x4787c62a, 0xa8304613, 0xfd469501,
+	0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be, 0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821,
+	0xf61e2562, 0xc040b340, 0x265e5a51, 0xe9b6c7aa, 0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
+	0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed, 0xa9e3e905, 0xfcefa3f8, 0x676f02d9, 0x8d2a4c8a,
+	0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c, 0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70,
+	0x289b7ec6, 0xeaa127fa, 0xd4ef3085, 0x04881d05, 0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
+	0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039, 0x655b59c3, 0x8f0ccc92, 0xffeff47d, 0x85845dd1,
+	0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1, 0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391,
+};
+
+static void Md5TransformFunction(Md5Context* Context, const uint8_t* Block)
+{
+	uint32_t M[16];
+	for (uint32_t i = 0; i < 16; ++i)
+		M[i] = (uint32_t)Block[i * 4] | ((uint32_t)Block[i * 4 + 1] << 8) | ((uint32_t)Block[i * 4 + 2] << 16) | ((uint32_t)Block[i * 4 + 3] << 24);
+
+	uint32_t a = Context->state[0];
+	uint32_t b = Context->state[1];
+	uint32_t c = Context->state[2];
+	uint32_t d = Context->state[3];
+
+	for (uint32_t i = 0; i < 64; ++i)
+	{
+		uint32_t f, g;
+		if (i < 16) { f = (b & c) | (~b & d); g = i; }
+		else if (i < 32) { f = (d & b) | (~d & c); g = (5 * i + 1) & 15; }
+		else if (i < 48) { f = b ^ c ^ d; g = (3 * i + 5) & 15; }
+		else { f = c ^ (b | ~d); g = (7 * i) & 15; }
+
+		const auto temp = d;
+		d = c;
+		c = b;
+
+		const auto sum = a + f + MD5_CONSTANTS[i] + M[g];
+		b = b + ((sum << MD5_SHIFTS[i]) | (sum >> (32 - MD5_SHIFTS[i])));
+		a = temp;
+	}
+
+	Context->state[0] += a;
+	Context->state[1] += b;
+	Context->state[2] += c;
+	Context->state[3] += d;
+}
+
+void Md5Initialise(Md5Context* Context)
+{
+	Context->curlen = 0;
+	Context->length = 0;
+	Context->state[0] = 0x67452301UL;
+	Context->state[1] = 0xefcdab89UL;
+	Context->state[2] = 0x98badcfeUL;
+	Context->state[3] = 0x10325476UL;
+}
+
+void Md5Update(Md5Context* Context, void const* Buffer, uint64_t BufferSize)
+{
+	const auto* data = (const uint8_t*)Buffer;
+	Context->length += BufferSize * 8;
+
+	while (BufferSize > 0)
+	{
+		if (Context->curlen == 0 && BufferSize >= sizeof(Context->buf))
+		{
+			Md5TransformFunction(Context, data);
+			data += sizeof(Context->buf);
+			BufferSize -= sizeof(Context->buf);
+		}
+		else
+		{
+			const auto n = (uint32_t)std::min<uint64_t>(BufferSize, sizeof(Context->buf) - Context->curlen);
+			memcpy(Context->buf + Context->curlen, data, n);
+			Context->curlen += n;
+			data += n;
+			BufferSize -= n;
+
+			if (Context->curlen == sizeof(Context->buf))
+			{
+				Md5TransformFunction(Context, Context->buf);
+				Context->curlen = 0;
+			}
+		}
+	}
+}
+
+void Md5Finalise(Md5Context* Context, MD5_HASH* Digest)
+{
+	const auto length = Context->length;
+
+	Context->buf[Context->curlen++] = 0x80;
+	if (Context->curlen > 56)
+	{
+		while (Context->curlen < 64)
+			Context->buf[Context->curlen++] = 0;
+		Md5TransformFunction(Context, Context->buf);
+		Context->curlen = 0;
+	}
+
+	while (Context->curlen < 56)
+		Context->buf[Context->curlen++] = 0;
+
+	for (uint32_t i = 0; i < 8; ++i)
+		Context->buf[56 + i] = (uint8_t)(length >> (8 * i));
+	Md5TransformFunction(Context, Context->buf);
+
+	for (uint32_t i = 0; i < 4; ++i)
+		for (uint32_t j = 0; j < 4; ++j)
+			Digest->bytes[i * 4 + j] = (uint8_t)(Context->state[i] >> (8 * j));
+}
+
 
 //--
 
@@ -2937,14 +3346,45 @@ static void LeaveLog()
 }
 #endif
 
+static thread_local LogErrorCapture* GLogErrorCapture = nullptr;
+
+LogErrorCapture::LogErrorCapture()
+    : m_previous(GLogErrorCapture)
+{
+    GLogErrorCapture = this;
+}
+
+LogErrorCapture::~LogErrorCapture()
+{
+    GLogErrorCapture = m_previous;
+}
+
+template< typename T >
+void LogPrinter::capture(const T& val)
+{
+    if (m_captureIndex >= 0 && GLogErrorCapture && m_captureIndex < (int)GLogErrorCapture->m_errors.size())
+    {
+        std::stringstream txt;
+        txt << val;
+        GLogErrorCapture->m_errors[m_captureIndex] += txt.str();
+    }
+}
+
 LogPrinter::LogPrinter(int type)
 	: m_type(type)
 {
     EnterLog(m_type);
+
+    if (m_type == 3 && GLogErrorCapture)
+    {
+        m_captureIndex = (int)GLogErrorCapture->m_errors.size();
+        GLogErrorCapture->m_errors.emplace_back();
+    }
 }
 
 LogPrinter::LogPrinter(const LogPrinter& other)
     : m_type(other.m_type)
+    , m_captureIndex(other.m_captureIndex)
 {
     EnterLog(m_type);
 }
@@ -2955,6 +3395,7 @@ LogPrinter& LogPrinter::operator=(const LogPrinter& other)
     {
         LeaveLog();
         m_type = other.m_type;
+        m_captureIndex = other.m_captureIndex;
         EnterLog(m_type);
     }
 
@@ -2971,7 +3412,10 @@ LogPrinter& LogPrinter::operator<<(const char* str)
     if (m_type == 0 || m_type == 1)
         std::cout << str;
     else
+    {
         std::cerr << str;
+        capture(str);
+    }
     return *this;
 }
 
@@ -2980,7 +3424,10 @@ LogPrinter& LogPrinter::operator<<(const std::string& str)
 	if (m_type == 0 || m_type == 1)
 		std::cout << str;
 	else
+	{
 		std::cerr << str;
+		capture(str);
+	}
 	return *this;
 }
 
@@ -2989,7 +3436,10 @@ LogPrinter& LogPrinter::operator<<(const std::string_view& str)
 	if (m_type == 0 || m_type == 1)
 		std::cout << str;
 	else
+	{
 		std::cerr << str;
+		capture(str);
+	}
 	return *this;
 }
 
@@ -2998,7 +3448,10 @@ LogPrinter& LogPrinter::operator<<(const std::filesystem::path& str)
 	if (m_type == 0 || m_type == 1)
 		std::cout << str;
 	else
-		std::cerr<< str;
+	{
+		std::cerr << str;
+		capture(str);
+	}
 	return *this;
 }
 
@@ -3007,7 +3460,10 @@ LogPrinter& LogPrinter::operator<<(int val)
 	if (m_type == 0 || m_type == 1)
         std::cout << val;
 	else
+	{
 		std::cerr << val;
+		capture(val);
+	}
 	return *this;
 }
 
@@ -3016,7 +3472,10 @@ LogPrinter& LogPrinter::operator<<(uint32_t val)
 	if (m_type == 0 || m_type == 1)
 		std::cout << val;
 	else
+	{
 		std::cerr << val;
+		capture(val);
+	}
 	return *this;
 }
 
@@ -3025,7 +3484,10 @@ LogPrinter& LogPrinter::operator<<(uint64_t val)
 	if (m_type == 0 || m_type == 1)
 		std::cout << val;
 	else
+	{
 		std::cerr << val;
+		capture(val);
+	}
 	return *this;
 }
 
@@ -3035,7 +3497,10 @@ LogPrinter& LogPrinter::operator<<(size_t val)
 	if (m_type == 0 || m_type == 1)
 		std::cout << val;
 	else
+	{
 		std::cerr << val;
+		capture(val);
+	}
 	return *this;
 }
 #endif
@@ -3045,7 +3510,10 @@ LogPrinter& LogPrinter::operator<<(std::error_code val)
 	if (m_type == 0 || m_type == 1)
         std::cout << val.message();
 	else
+	{
 		std::cerr << val.message();
+		capture(val.message());
+	}
 	return *this;
 }
 
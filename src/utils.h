@@ -128,6 +128,27 @@ struct LogPrinter
 
 private:
     int m_type = 0;
+    int m_captureIndex = -1; // error message being recorded by the LogErrorCapture of this thread
+
+    template< typename T >
+    void capture(const T& val);
+};
+
+// records error messages printed by the current thread while alive, used to tell why a job running in parallel with others failed
+// NOTE: the messages are still printed, captures can be nested (the innermost one records)
+class LogErrorCapture
+{
+public:
+    LogErrorCapture();
+    ~LogErrorCapture();
+
+    inline const std::vector<std::string>& errors() const { return m_errors; }
+
+private:
+    std::vector<std::string> m_errors;
+    LogErrorCapture* m_previous = nullptr;
+
+    friend struct LogPrinter;
 };
 
 //--
@@ -152,6 +173,52 @@ extern uint64_t Crc64(const uint8_t* s, uint64_t l);
 
 //--
 
+// simple binary serialization for the caches kept in the temp folder
+// NOTE: native byte order, cache files are not meant to be moved between machines
+class BinaryWriter
+{
+public:
+	std::vector<uint8_t> data;
+
+	void writeU8(uint8_t value);
+	void writeU32(uint32_t value);
+	void writeU64(uint64_t value);
+	void writeString(std::string_view txt);
+	void writePath(const fs::path& path);
+	void writeStrings(const std::vector<std::string>& list);
+	void writePaths(const std::vector<fs::path>& list);
+
+private:
+	void writeRaw(const void* ptr, uint64_t size);
+};
+
+// reads data written by BinaryWriter, reading past the end sets the error flag and returns zero/empty values from then on
+class BinaryReader
+{
+public:
+	BinaryReader(const uint8_t* data, uint64_t size);
+
+	inline bool ok() const { return !m_error; }
+	inline bool atEnd() const { return m_pos == m_end; }
+
+	uint8_t readU8();
+	uint32_t readU32();
+	uint64_t readU64();
+	std::string readString();
+	fs::path readPath();
+	void readStrings(std::vector<std::string>& outList);
+	void readPaths(std::vector<fs::path>& outList);
+
+private:
+	const uint8_t* m_pos = nullptr;
+	const uint8_t* m_end = nullptr;
+	bool m_error = false;
+
+	bool readRaw(void* outPtr, uint64_t size);
+};
+
+//--
+
 extern bool CompressLZ4(const void* data, uint32_t size, std::vector<uint8_t>& outBuffer);
 extern bool CompressLZ4(const std::vector<uint8_t>& uncompressedData, std::vector<uint8_t>& outBuffer);
 
@@ -170,6 +237,23 @@ extern bool RunWithArgsInDirectoryAndCaptureOutput(const fs::path& dir, std::str
 
 extern bool RunWithArgsAndCaptureOutputIntoLines(std::string_view cmd, std::vector<std::string>& outLines, int* outCode = nullptr);
 
+struct ProcessRunResult
+{
+	bool started = false;
+	bool timedOut = false;
+	int exitCode = -1;
+	uint64_t wallTimeMs = 0;
+	uint64_t peakMemoryBytes = 0; // peak resident set size, 0 if not known
+	std::string output; // stdout and stderr, in order
+};
+
+// run executable directly (no shell) in given directory, plain executable names are searched in PATH without changing the current directory of this process (thread safe)
+// all output is captured, process (and its children) is killed if it runs longer than timeout (0 - no timeout)
+// environment of this process is inherited, variables from the "environment" list are added (or replaced)
+// returns true only if process ran and returned 0
+extern bool RunProcess(const fs::path& executable, const std::vector<std::string>& args, const fs::path& workingDirectory, uint64_t timeoutMs, ProcessRunResult& outResult,
+	const std::vector<std::pair<std::string, std::string>>& environment = {});
+
 extern bool CheckVersion(std::string_view app, std::string_view prefix, std::string_view postfix, std::string_view minVersion);
 
 extern bool OpenDefaultFileEditor(const fs::path& path);
@@ -218,6 +302,10 @@ extern bool CreateDirectories(const fs::path& path);
 
 extern bool CopyNewerFile(const fs::path& source, const fs::path& target, bool* outActuallyCopied = nullptr);
 
+// same as CopyNewerFile but the new file shares data blocks with the source where the file system allows it (reflink on Linux, clonefile on macOS)
+// the target is still a separate file - writing to it does not change the source, falls back to a normal copy
+extern bool CloneNewerFile(const fs::path& source, const fs::path& target, bool* outActuallyCopied = nullptr);
+
 extern bool CopyFile(const fs::path& source, const fs::path& target);
 
 extern bool CopyNewerFilesRecursive(const fs::path& sourceDir, const fs::path& targetDir, uint32_t* outActuallyCopied = nullptr);
@@ -234,6 +322,12 @@ extern std::string EscapeArgument(std::string_view txt);
 
 extern std::string GetCurrentWeeklyTimestamp(); // 2205 - 5th week of 2022
 
+extern uint32_t GetDefaultJobCount(); // number of cores, at least 1
+
+// call func(index) for every index in [0, count) using at most maxJobs threads, returns once all calls finished
+// NOTE: when called from inside of func the calls are done serially on the calling thread so nesting does not multiply the number of threads
+extern void RunParallel(uint32_t count, uint32_t maxJobs, const std::function<void(uint32_t index)>& func);
+
 extern LogPrinter LogInfo();
 
 extern LogPrinter LogWarning();
@@ -377,6 +471,26 @@ extern bool Sha256OfFile(const fs::path& path, std::string& outHashString);
 
 //--
 
+// MD5 is only used to check downloads against the ETag reported by S3 (MD5 of the object for single part uploads)
+typedef struct {
+	uint64_t length;
+	uint32_t state[4];
+	uint32_t curlen;
+	uint8_t buf[64];
+} Md5Context;
+
+#define MD5_HASH_SIZE (128 / 8)
+
+typedef struct {
+	uint8_t bytes[MD5_HASH_SIZE];
+} MD5_HASH;
+
+extern void Md5Initialise(Md5Context* Context);
+extern void Md5Update(Md5Context* Context, void const* Buffer, uint64_t BufferSize);
+extern void Md5Finalise(Md5Context* Context, MD5_HASH* Digest);
+
+//--
+
 // Amazon HMAC-SHA256 
 // Returns the number of bytes written to `out`
 extern size_t hmac_sha256(const void* key, const size_t keylen, const void* data, const size_t datalen, void* out,	const size_t outlen);